@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// =====================================================
+// Минимальный харнесс микробенчмарков
+// =====================================================
+//
+// Каждый бенчмарк параметризован размером. Для размера вызывается setup,
+// который готовит данные вне замера и возвращает тело итерации. Итерация
+// повторяется столько раз, чтобы один повтор длился не меньше minRepSeconds;
+// после прогрева снимается reps повторов, по ним считаются статистики.
+
+namespace bench {
+
+// Не даёт компилятору выбросить вычисленное значение
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+using Iteration = std::function<void()>;
+using Setup = std::function<Iteration(size_t size)>;
+
+struct Case {
+    std::string name;
+    std::vector<size_t> sizes;
+    Setup setup;
+    // Сколько «элементов» обрабатывает одна итерация (для items/s)
+    std::function<double(size_t size)> itemsPerIteration;
+};
+
+struct Result {
+    std::string name;
+    size_t size = 0;
+    size_t reps = 0;
+    size_t iterationsPerRep = 0;
+    double minNs = 0.0;
+    double medianNs = 0.0;
+    double meanNs = 0.0;
+    double p95Ns = 0.0;
+    double itemsPerSecond = 0.0;
+};
+
+struct Config {
+    size_t warmupReps = 3;
+    size_t reps = 15;
+    double minRepSeconds = 0.002;
+    std::string filter;
+    bool quick = false;     // только наименьший размер каждого бенчмарка
+};
+
+inline std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+inline void add(const std::string& name, std::vector<size_t> sizes, Setup setup,
+                std::function<double(size_t)> items = [](size_t size) { return double(size); }) {
+    registry().push_back(Case{name, std::move(sizes), std::move(setup), std::move(items)});
+}
+
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline Result runCase(const Case& benchCase, size_t size, const Config& config) {
+    Iteration iteration = benchCase.setup(size);
+
+    // Подбираем число итераций на повтор
+    size_t iterations = 1;
+    for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) iteration();
+        double elapsed = secondsSince(start);
+        if (elapsed >= config.minRepSeconds || iterations >= (1u << 24)) break;
+        iterations *= elapsed > 0.0 ? std::max<size_t>(2, size_t(config.minRepSeconds / elapsed)) : 16;
+    }
+
+    for (size_t rep = 0; rep < config.warmupReps; rep++) {
+        for (size_t i = 0; i < iterations; i++) iteration();
+    }
+
+    std::vector<double> samples;
+    samples.reserve(config.reps);
+    for (size_t rep = 0; rep < config.reps; rep++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) iteration();
+        samples.push_back(secondsSince(start) * 1e9 / iterations);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = benchCase.name;
+    result.size = size;
+    result.reps = samples.size();
+    result.iterationsPerRep = iterations;
+    result.minNs = samples.front();
+    result.medianNs = samples[samples.size() / 2];
+    result.p95Ns = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+    double sum = 0.0;
+    for (double sample : samples) sum += sample;
+    result.meanNs = sum / samples.size();
+    result.itemsPerSecond = benchCase.itemsPerIteration(size) / (result.medianNs * 1e-9);
+    return result;
+}
+
+inline std::vector<Result> runAll(const Config& config) {
+    std::vector<Result> results;
+    std::printf("%-36s %10s %14s %14s %14s %16s\n",
+                "benchmark", "size", "min, нс", "median, нс", "p95, нс", "items/s");
+
+    for (const auto& benchCase : registry()) {
+        if (!config.filter.empty() && benchCase.name.find(config.filter) == std::string::npos) continue;
+
+        for (size_t size : benchCase.sizes) {
+            Result result = runCase(benchCase, size, config);
+            std::printf("%-36s %10zu %14.0f %14.0f %14.0f %16.3e\n",
+                        result.name.c_str(), result.size, result.minNs,
+                        result.medianNs, result.p95Ns, result.itemsPerSecond);
+            std::fflush(stdout);
+            results.push_back(result);
+
+            if (config.quick) break;
+        }
+    }
+    return results;
+}
+
+inline bool writeJson(const std::string& filename, const std::vector<Result>& results,
+                      const std::string& buildType) {
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file) return false;
+
+    std::fprintf(file, "{\n  \"build_type\": \"%s\",\n  \"benchmarks\": [\n", buildType.c_str());
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::fprintf(file,
+                     "    {\"name\": \"%s\", \"size\": %zu, \"reps\": %zu, \"iterations\": %zu, "
+                     "\"min_ns\": %.1f, \"median_ns\": %.1f, \"mean_ns\": %.1f, \"p95_ns\": %.1f, "
+                     "\"items_per_second\": %.6e}%s\n",
+                     r.name.c_str(), r.size, r.reps, r.iterationsPerRep, r.minNs, r.medianNs,
+                     r.meanNs, r.p95Ns, r.itemsPerSecond, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+}
+
+} // namespace bench
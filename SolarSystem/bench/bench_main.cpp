@@ -0,0 +1,570 @@
+#include "allocation_tracker.h"
+#include "asteroid_belt.h"
+#include "bench.h"
+#include "camera.h"
+#include "checkpoint.h"
+#include "collision.h"
+#include "far_field.h"
+#include "frame_arena.h"
+#include "light_clusters.h"
+#include "obj_loader.h"
+#include "occlusion_culler.h"
+#include "picking.h"
+#include "scene_generator.h"
+#include "scene_loader.h"
+#include "solar_system.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+
+#ifndef SOLAR_BUILD_TYPE
+#define SOLAR_BUILD_TYPE "unknown"
+#endif
+
+namespace {
+
+std::string modelPath = "models/fish.obj";
+bool galaxyScenes = false;          // --galaxy: сцены бенчмарков - процедурная галактика
+
+std::shared_ptr<SolarSystem> makeGalaxy(size_t count) {
+    auto system = std::make_shared<SolarSystem>();
+    GalaxyParams params;
+    params.bodyCount = count;
+    generateGalaxy(params, *system, ThreadPool::shared());
+    return system;
+}
+
+std::filesystem::path benchDir() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "solar_bench";
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+// Сцена из count тел на разных орбитах
+std::shared_ptr<SolarSystem> makeSystem(size_t count) {
+    if (galaxyScenes) return makeGalaxy(count);
+    auto system = std::make_shared<SolarSystem>();
+    system->reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        CelestialBody body;
+        body.orbitRadius = 4.0f + (i % 1000) * 0.05f;
+        body.orbitSpeed = 0.5f + (i % 7) * 0.4f;
+        body.rotationSpeed = 1.0f + (i % 5) * 0.5f;
+        body.scale = 1.0f + (i % 3);
+        body.orbitAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+        body.orbitCenter = glm::vec3(0.0f);
+        body.currentOrbitAngle = (i * 37) % 360;
+        system->addBody(body);
+    }
+    return system;
+}
+
+// Плотный диск из count тел: радиусы орбит равномерно по площади, скорость
+// убывает с радиусом как у планет - соседние тела медленно обгоняют друг друга.
+// Площадь растёт с count, поэтому доля перекрытых тел от размера почти не зависит
+std::shared_ptr<SolarSystem> makeSwarm(size_t count) {
+    if (galaxyScenes) return makeGalaxy(count);
+    auto system = std::make_shared<SolarSystem>();
+    system->reserve(count);
+    const float innerRadius = 10.0f;
+    const float outerRadius = innerRadius + 2.0f * std::sqrt(static_cast<float>(count));
+    uint32_t state = 12345u;
+    auto next = [&state] {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) / 16777216.0f;
+    };
+    for (size_t i = 0; i < count; i++) {
+        CelestialBody body;
+        float radius2 = innerRadius * innerRadius +
+                        next() * (outerRadius * outerRadius - innerRadius * innerRadius);
+        body.orbitRadius = std::sqrt(radius2);
+        body.orbitSpeed = 50.0f / std::pow(body.orbitRadius, 1.5f);
+        body.rotationSpeed = 1.0f;
+        body.scale = 1.0f + 2.0f * next();
+        body.orbitAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+        body.orbitCenter = glm::vec3(0.0f);
+        body.currentOrbitAngle = 360.0f * next();
+        system->addBody(body);
+    }
+    return system;
+}
+
+// Сетка из квадов с форматом "v/vt/vn", примерно triangles треугольников
+std::string writeGridObj(size_t triangles) {
+    size_t side = 1;
+    while (2 * side * side < triangles) side++;
+
+    std::filesystem::path path = benchDir() / ("grid_" + std::to_string(triangles) + ".obj");
+    if (std::filesystem::exists(path)) return path.string();
+
+    std::ofstream file(path);
+    for (size_t y = 0; y <= side; y++) {
+        for (size_t x = 0; x <= side; x++) {
+            file << "v " << float(x) / side << ' ' << float(y) / side << " 0\n";
+            file << "vt " << float(x) / side << ' ' << float(y) / side << '\n';
+        }
+    }
+    file << "vn 0 0 1\n";
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            size_t a = y * (side + 1) + x + 1;
+            size_t b = a + 1;
+            size_t c = a + side + 1;
+            size_t d = c + 1;
+            file << "f " << a << '/' << a << "/1 " << b << '/' << b << "/1 "
+                 << d << '/' << d << "/1 " << c << '/' << c << "/1\n";
+        }
+    }
+    return path.string();
+}
+
+// UV-сфера радиуса radius примерно из triangles треугольников
+struct SphereMesh {
+    std::vector<OBJVertex> vertices;
+    std::vector<unsigned int> indices;
+
+    SoftMesh view() const {
+        return SoftMesh{vertices.data(), vertices.size(), indices.data(), indices.size()};
+    }
+};
+
+std::shared_ptr<SphereMesh> makeSphereMesh(size_t triangles, float radius) {
+    size_t rings = 2;
+    while (4 * rings * rings < triangles) rings++;
+    size_t segments = rings * 2;
+
+    auto mesh = std::make_shared<SphereMesh>();
+    for (size_t r = 0; r <= rings; r++) {
+        for (size_t s = 0; s <= segments; s++) {
+            float theta = 3.14159265f * r / rings;
+            float phi = 2.0f * 3.14159265f * s / segments;
+            OBJVertex vertex{};
+            vertex.normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta),
+                                      std::sin(theta) * std::sin(phi));
+            vertex.position = vertex.normal * radius;
+            mesh->vertices.push_back(vertex);
+        }
+    }
+    for (size_t r = 0; r < rings; r++) {
+        for (size_t s = 0; s < segments; s++) {
+            unsigned int a = static_cast<unsigned int>(r * (segments + 1) + s);
+            unsigned int c = static_cast<unsigned int>(a + segments + 1);
+            mesh->indices.insert(mesh->indices.end(), {a, c, a + 1, a + 1, c, c + 1});
+        }
+    }
+    return mesh;
+}
+
+std::string writeScene(size_t count, const char* extension) {
+    std::filesystem::path path = benchDir() / ((galaxyScenes ? "galaxy_" : "scene_") + std::to_string(count) + extension);
+    if (!std::filesystem::exists(path)) {
+        saveScene(path.string(), *makeSystem(count));
+    }
+    return path.string();
+}
+
+void registerBenchmarks() {
+    const std::vector<size_t> bodyCounts = {1000, 10000, 100000, 1000000};
+
+    // --- OBJ: только разбор, без setupBuffers (для него нужен GL-контекст) ---
+    bench::add("OBJModel::parse(grid)", {512, 2048, 8192}, [](size_t triangles) -> bench::Iteration {
+        std::string path = writeGridObj(triangles);
+        return [path] {
+            OBJModel model;
+            model.parse(path);
+            bench::doNotOptimize(model.indexCount);
+        };
+    });
+
+    bench::add("OBJModel::parse(model)", {1}, [](size_t) -> bench::Iteration {
+        return [] {
+            OBJModel model;
+            model.parse(modelPath);
+            bench::doNotOptimize(model.indexCount);
+        };
+    });
+
+    // --- Симуляция ---
+    bench::add("SolarSystem::update", bodyCounts, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        return [system] {
+            system->update(0.16f);
+            bench::doNotOptimize(system->getBodies().back().currentOrbitAngle);
+        };
+    });
+
+    bench::add("SolarSystem::getModelMatrices", bodyCounts, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        return [system] {
+            std::vector<glm::mat4> matrices = system->getModelMatrices();
+            bench::doNotOptimize(matrices.back());
+        };
+    });
+
+    // items/s = тел/с
+    bench::add("generateGalaxy", {10000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = std::make_shared<SolarSystem>();
+        return [system, count] {
+            GalaxyParams params;
+            params.bodyCount = count;
+            generateGalaxy(params, *system, ThreadPool::shared());
+            bench::doNotOptimize(system->getBodies().back().orbitCenter);
+        };
+    });
+
+    bench::add("CelestialBody::getModelMatrix", {1000, 100000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        return [system] {
+            for (const auto& body : system->getBodies()) {
+                glm::mat4 model = body.getModelMatrix();
+                bench::doNotOptimize(model);
+            }
+        };
+    });
+
+    // --- Камера ---
+    bench::add("Camera::getViewMatrix", {1000}, [](size_t calls) -> bench::Iteration {
+        auto camera = std::make_shared<Camera>(glm::vec3(0.0f, 10.0f, 30.0f));
+        return [camera, calls] {
+            for (size_t i = 0; i < calls; i++) {
+                camera->rotateYaw(0.01f);
+                glm::mat4 view = camera->getViewMatrix();
+                bench::doNotOptimize(view);
+            }
+        };
+    });
+
+    bench::add("Camera::getProjectionMatrix", {1000}, [](size_t calls) -> bench::Iteration {
+        auto camera = std::make_shared<Camera>();
+        return [camera, calls] {
+            for (size_t i = 0; i < calls; i++) {
+                glm::mat4 projection = camera->getProjectionMatrix(1.0f + i * 1e-6f);
+                bench::doNotOptimize(projection);
+            }
+        };
+    });
+
+    // --- Отсечение перекрытых тел: ближайшие крупные тела перекрывают остальные ---
+    bench::add("OcclusionCuller::cullBodies", {10000, 100000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        auto model = std::make_shared<OBJModel>();
+        model->parse(modelPath);
+        SoftMesh mesh{model->vertices.data(), model->vertices.size(),
+                      model->indices.data(), model->indices.size()};
+        float radius = meshBoundingRadius(mesh);
+        auto culler = std::make_shared<OcclusionCuller>(256, 160, ThreadPool::shared());
+        auto visible = std::make_shared<std::vector<uint32_t>>();
+        Camera camera(glm::vec3(0.0f, 10.0f, 30.0f));
+        glm::mat4 view = camera.getViewMatrix();
+        glm::mat4 projection = camera.getProjectionMatrix(1.5f);
+
+        return [system, model, mesh, radius, culler, visible, view, projection] {
+            const auto& bodies = system->getBodies();
+            culler->beginFrame(view, projection);
+            for (uint32_t index : culler->selectOccluders(bodies, radius, 4)) {
+                culler->addOccluder(mesh, bodies[index].getModelMatrix());
+            }
+            culler->buildPyramid();
+            culler->cullBodies(bodies, radius, *visible);
+            bench::doNotOptimize(visible->size());
+        };
+    });
+
+    // --- Разделение на меши и импосторы ---
+    bench::add("splitFarField", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        auto split = std::make_shared<FarFieldSplit>();
+        Camera camera(glm::vec3(0.0f, 10.0f, 30.0f));
+        glm::mat4 view = camera.getViewMatrix();
+        glm::mat4 projection = camera.getProjectionMatrix(1.5f);
+        return [system, split, view, projection] {
+            splitFarField(system->getBodies(), nullptr, 0.2f, view, projection, 800.0f,
+                          FarFieldSettings(), *split, ThreadPool::shared());
+            bench::doNotOptimize(split->impostors.size());
+        };
+    });
+
+    // Пояс астероидов на CPU - столько стоил бы буфер инстансов, которого нет
+    bench::add("asteroidModelMatrix", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        AsteroidBeltParams belt;
+        belt.count = static_cast<uint32_t>(count);
+        return [belt] {
+            float sum = 0.0f;
+            for (uint32_t i = 0; i < belt.count; i++) {
+                sum += asteroidModelMatrix(belt, i, 123.0f)[3].x;
+            }
+            bench::doNotOptimize(sum);
+        };
+    });
+
+    // --- Выбор тела лучом ---
+    bench::add("MeshBVH::build", {100000, 1000000}, [](size_t triangles) -> bench::Iteration {
+        auto sphere = makeSphereMesh(triangles, 0.2f);
+        auto bvh = std::make_shared<MeshBVH>();
+        return [sphere, bvh] {
+            bvh->build(sphere->view());
+            bench::doNotOptimize(bvh->getStats().nodes);
+        };
+    });
+
+    // Меш из 1M треугольников, тел - size; лучи по сетке 8x8 на экране
+    bench::add("BodyPicker::pick", {10000, 100000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        auto sphere = makeSphereMesh(1000000, 0.2f);
+        auto bvh = std::make_shared<MeshBVH>();
+        bvh->build(sphere->view());
+        auto picker = std::make_shared<BodyPicker>(ThreadPool::shared());
+
+        Camera camera(glm::vec3(0.0f, 10.0f, 30.0f));
+        auto rays = std::make_shared<std::vector<PickRay>>();
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) {
+                rays->push_back(screenRay(camera, 50.0f + x * 100.0f, 40.0f + y * 75.0f, 800.0f, 600.0f));
+            }
+        }
+        auto next = std::make_shared<size_t>(0);
+        return [system, bvh, picker, rays, next] {
+            const PickRay& ray = (*rays)[(*next)++ % rays->size()];
+            PickResult result = picker->pick(system->getBodies(), *bvh, 0.2f, ray);
+            bench::doNotOptimize(result.body);
+        };
+    }, [](size_t) { return 1.0; });
+
+    // --- Пересечения тел ---
+    // Шаг симуляции + широкая фаза с досортировкой: стоимость обновления за тик
+    bench::add("CollisionDetector::broadphase", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSwarm(count);
+        auto detector = std::make_shared<CollisionDetector>(ThreadPool::shared());
+        detector->broadphase(system->getBodies(), 0.2f);
+        return [system, detector] {
+            system->update(0.16f);
+            detector->broadphase(system->getBodies(), 0.2f);
+            bench::doNotOptimize(detector->getStats().candidates);
+        };
+    });
+
+    // То же с полной сортировкой каждый тик - для сравнения
+    bench::add("CollisionDetector::broadphase(rebuild)", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSwarm(count);
+        auto detector = std::make_shared<CollisionDetector>(ThreadPool::shared());
+        return [system, detector] {
+            system->update(0.16f);
+            detector->reset();
+            detector->broadphase(system->getBodies(), 0.2f);
+            bench::doNotOptimize(detector->getStats().candidates);
+        };
+    });
+
+    // Узкая фаза по неизменному набору пар: items/s = пар/с
+    static std::map<size_t, double> narrowphasePairs;
+    bench::add("CollisionDetector::narrowphase", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSwarm(count);
+        auto detector = std::make_shared<CollisionDetector>(ThreadPool::shared());
+        detector->broadphase(system->getBodies(), 0.2f);
+        narrowphasePairs[count] = static_cast<double>(detector->getStats().candidates);
+        std::printf("  %zu тел: %zu пар-кандидатов, %zu пересечений\n", count,
+                    detector->getStats().candidates, detector->narrowphase().size());
+        return [detector] {
+            bench::doNotOptimize(detector->narrowphase().size());
+        };
+    }, [](size_t count) { return narrowphasePairs[count]; });
+
+    // --- Кластерное освещение: каждое 10-е тело светится, items/s = источников/с ---
+    bench::add("buildLightClusters", {1000, 10000, 100000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSwarm(count * 10);
+        auto lights = std::make_shared<std::vector<PointLight>>();
+        std::vector<uint32_t> lightBodies;
+        selectLightBodies(system->getBodies(), 10, lightBodies);
+        gatherBodyLights(system->getBodies(), lightBodies, *lights);
+        auto clusters = std::make_shared<LightClusters>();
+        Camera camera(glm::vec3(0.0f, 40.0f, 120.0f));
+        glm::mat4 view = camera.getViewMatrix();
+        glm::mat4 projection = camera.getProjectionMatrix(16.0f / 9.0f);
+        float nearPlane = camera.nearPlane;
+        float farPlane = camera.farPlane;
+        return [lights, clusters, view, projection, nearPlane, farPlane] {
+            buildLightClusters(*lights, view, projection, nearPlane, farPlane, *clusters, ThreadPool::shared());
+            bench::doNotOptimize(clusters->stats.references);
+        };
+    });
+
+    // --- Загрузка сцен ---
+    bench::add("loadScene(text)", {10000, 100000, 1000000}, [](size_t count) -> bench::Iteration {
+        std::string path = writeScene(count, ".scene");
+        auto system = std::make_shared<SolarSystem>();
+        return [path, system] {
+            loadScene(path, *system);
+            bench::doNotOptimize(system->getBodyCount());
+        };
+    });
+
+    bench::add("loadScene(binary)", {10000, 100000, 1000000}, [](size_t count) -> bench::Iteration {
+        std::string path = writeScene(count, ".sscn");
+        auto system = std::make_shared<SolarSystem>();
+        return [path, system] {
+            loadScene(path, *system);
+            bench::doNotOptimize(system->getBodyCount());
+        };
+    });
+
+    // --- Контрольные точки: items/s = байт/с ---
+    auto checkpointBytes = [](size_t count) { return double(count) * SCENE_COLUMN_COUNT * sizeof(float); };
+
+    bench::add("saveCheckpoint", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        std::string path = (benchDir() / "checkpoint.sckp").string();
+        return [system, path] {
+            saveCheckpoint(path, *system, 1);
+        };
+    }, checkpointBytes);
+
+    // Дельта после одного шага: меняются только углы
+    bench::add("saveDeltaCheckpoint", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        auto system = makeSystem(count);
+        std::string basePath = (benchDir() / "checkpoint_base.sckp").string();
+        std::string path = (benchDir() / "checkpoint.sckp.delta").string();
+        saveCheckpoint(basePath, *system, 1);
+        system->update(0.16f);
+        auto base = std::make_shared<CheckpointReader>();
+        base->open(basePath);
+        return [system, base, path] {
+            saveDeltaCheckpoint(path, *system, *base, 2);
+        };
+    }, checkpointBytes);
+
+    bench::add("restoreCheckpoint", {100000, 1000000}, [](size_t count) -> bench::Iteration {
+        std::string path = (benchDir() / ("restore_" + std::to_string(count) + ".sckp")).string();
+        saveCheckpoint(path, *makeSystem(count), 1);
+        auto system = std::make_shared<SolarSystem>();
+        return [path, system] {
+            restoreCheckpoint(path, "", *system);
+            bench::doNotOptimize(system->getBodyCount());
+        };
+    }, checkpointBytes);
+}
+
+// CPU-часть кадра приложения без GL: обновление, отсечение, разделение на
+// меши и импосторы, матрицы в арене кадра. После прогрева ни один кадр не
+// должен обращаться к куче; false - хотя бы один обратился
+bool checkSteadyFrameAllocations(size_t bodyCount, size_t frames) {
+    if (!allocationTrackingAvailable()) {
+        std::cerr << "Проверка выделений недоступна: соберите с -DSOLAR_ALLOC_TRACKING=ON" << std::endl;
+        return false;
+    }
+
+    const size_t warmupFrames = 60;
+    auto system = makeSystem(bodyCount);
+    auto sphere = makeSphereMesh(2000, 0.2f);
+    SoftMesh mesh = sphere->view();
+    OcclusionCuller culler(256, 160, ThreadPool::shared());
+    FarFieldSplit split;
+    std::vector<uint32_t> visible;
+    FrameArena arena;
+    SteadyFrameChecker checker(warmupFrames);
+
+    Camera camera(glm::vec3(0.0f, 10.0f, 30.0f));
+    glm::mat4 view = camera.getViewMatrix();
+    glm::mat4 projection = camera.getProjectionMatrix(1.5f);
+
+    for (size_t frame = 0; frame < warmupFrames + frames; frame++) {
+        checker.beginFrame();
+        arena.reset();
+
+        system->update(0.016f);
+        const auto& bodies = system->getBodies();
+
+        culler.beginFrame(view, projection);
+        for (uint32_t index : culler.selectOccluders(bodies, 0.2f, 4)) {
+            culler.addOccluder(mesh, bodies[index].getModelMatrix());
+        }
+        culler.buildPyramid();
+        culler.cullBodies(bodies, 0.2f, visible);
+
+        splitFarField(bodies, &visible, 0.2f, view, projection, 800.0f,
+                      FarFieldSettings(), split, ThreadPool::shared());
+
+        glm::mat4* matrices = arena.allocateArray<glm::mat4>(bodies.size());
+        system->writeModelMatrices(matrices);
+        bench::doNotOptimize(matrices[0]);
+
+        checker.endFrame(false);
+    }
+
+    std::cout << "Выделения памяти (" << bodyCount << " тел): установившихся кадров "
+              << checker.getSteadyFrames() << ", из них с выделениями " << checker.getAllocatingFrames()
+              << " (" << checker.getSteadyAllocations() << " выделений, " << checker.getSteadyBytes()
+              << " байт); арена кадра " << arena.getPeakBytes() / 1024 << " КБ" << std::endl;
+    return checker.passed();
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " [параметры]" << std::endl;
+    std::cout << "  --filter <строка>  только бенчмарки, чьё имя содержит строку" << std::endl;
+    std::cout << "  --json <файл>      сохранить результаты в JSON" << std::endl;
+    std::cout << "  --reps <n>         число замеряемых повторов (по умолчанию 15)" << std::endl;
+    std::cout << "  --warmup <n>       число прогревочных повторов (по умолчанию 3)" << std::endl;
+    std::cout << "  --quick            только наименьший размер" << std::endl;
+    std::cout << "  --model <файл>     OBJ для OBJModel::parse(model)" << std::endl;
+    std::cout << "  --galaxy           сцены всех бенчмарков - процедурная галактика" << std::endl;
+    std::cout << "  --check-allocations <n>  вместо бенчмарков: n кадров без выделений после прогрева" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Config config;
+    std::string jsonPath;
+    size_t allocationCheckFrames = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--filter") == 0 && hasValue) config.filter = argv[++i];
+        else if (std::strcmp(arg, "--json") == 0 && hasValue) jsonPath = argv[++i];
+        else if (std::strcmp(arg, "--reps") == 0 && hasValue) config.reps = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "--warmup") == 0 && hasValue) config.warmupReps = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--model") == 0 && hasValue) modelPath = argv[++i];
+        else if (std::strcmp(arg, "--quick") == 0) config.quick = true;
+        else if (std::strcmp(arg, "--galaxy") == 0) galaxyScenes = true;
+        else if (std::strcmp(arg, "--check-allocations") == 0 && hasValue) {
+            allocationCheckFrames = std::max(1, std::atoi(argv[++i]));
+        }
+        else {
+            printUsage(argv[0]);
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+#if !defined(__OPTIMIZE__) && !defined(NDEBUG)
+    std::cerr << "Внимание: сборка без оптимизаций, цифры не показательны" << std::endl;
+#endif
+
+    if (allocationCheckFrames > 0) {
+        bool passed = true;
+        for (size_t count : {1000, 100000}) {
+            passed = checkSteadyFrameAllocations(count, allocationCheckFrames) && passed;
+        }
+        return passed ? 0 : 1;
+    }
+
+    registerBenchmarks();
+    std::vector<bench::Result> results = bench::runAll(config);
+
+    if (!jsonPath.empty()) {
+        if (!bench::writeJson(jsonPath, results, SOLAR_BUILD_TYPE)) {
+            std::cerr << "Не получилось записать " << jsonPath << std::endl;
+            return 1;
+        }
+        std::cout << "Результаты сохранены: " << jsonPath << std::endl;
+    }
+
+    return 0;
+}
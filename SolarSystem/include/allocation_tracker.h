@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =====================================================
+// Подсчёт выделений памяти
+// =====================================================
+//
+// При сборке с SOLAR_ALLOC_TRACKING глобальные operator new/delete
+// заменяются обёртками над malloc/free, которые считают вызовы и байты.
+// Счётчики у каждого потока свои (thread_local указатель на ячейку), кадру
+// засчитываются главный поток и рабочие пула. Фоновые потоки (запись
+// потока симуляции, сервер метрик) работают вне кадра и исключают себя
+// через excludeThreadFromAllocationCounts(). Разность счётчиков до и после
+// кадра - сколько раз кадр обратился к куче. Без SOLAR_ALLOC_TRACKING
+// замены нет, счётчики всегда нулевые. malloc напрямую (драйвер, libc)
+// не считается.
+
+struct AllocationCounters {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+
+    AllocationCounters operator-(const AllocationCounters& other) const {
+        return AllocationCounters{allocations - other.allocations, bytes - other.bytes};
+    }
+};
+
+bool allocationTrackingAvailable();
+
+// Счётчики с начала работы программы по всем потокам, кроме исключённых
+AllocationCounters allocationCounters();
+
+// Счётчики вызывающего потока
+AllocationCounters threadAllocationCounters();
+
+// Выделения вызывающего потока дальше не попадают в allocationCounters().
+// Вызывается в начале функции фонового потока
+void excludeThreadFromAllocationCounts();
+
+// Проверка «кадр без выделений»: кадр считается установившимся, если перед
+// ним было не меньше warmupFrames кадров без событий (ввода, снимков и т.п.)
+class SteadyFrameChecker {
+public:
+    explicit SteadyFrameChecker(size_t warmupFrames = 60) : warmupFrames(warmupFrames) {}
+
+    void beginFrame();
+    // eventful - в кадре было разовое действие, после него нужен новый прогрев
+    void endFrame(bool eventful);
+
+    size_t getFrames() const { return frames; }
+    uint64_t getTotalAllocations() const { return totalAllocations; }
+    size_t getSteadyFrames() const { return steadyFrames; }
+    size_t getAllocatingFrames() const { return allocatingFrames; }
+    uint64_t getSteadyAllocations() const { return steadyAllocations; }
+    uint64_t getSteadyBytes() const { return steadyBytes; }
+    uint64_t getFrameAllocations() const { return frameAllocations; }
+
+    bool passed() const { return allocatingFrames == 0; }
+
+private:
+    size_t warmupFrames;
+    size_t quietFrames = 0;
+    AllocationCounters frameStart;
+
+    uint64_t frameAllocations = 0;      // за последний кадр
+    size_t frames = 0;
+    uint64_t totalAllocations = 0;
+    size_t steadyFrames = 0;
+    size_t allocatingFrames = 0;
+    uint64_t steadyAllocations = 0;
+    uint64_t steadyBytes = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Параметры командной строки
+struct AppOptions {
+    std::string scenePath = "scenes/default.scene";
+    std::string exportScenePath;    // сохранить сцену в файл и выйти
+    size_t galaxyBodies = 0;        // процедурная галактика вместо файла сцены (0 - файл)
+    uint64_t galaxySeed = 1;
+    bool profile = false;
+    std::string tracePath;          // экспорт Chrome trace при выходе
+    double profileInterval = 5.0;   // период печати сводки, с
+    std::string recordPath;         // записать ввод в файл
+    std::string replayPath;         // воспроизвести записанный ввод
+    bool replayFast = false;        // воспроизводить без vsync, как можно быстрее
+    std::string frameTimesPath;     // CSV с временем каждого кадра
+    std::string checkpointPath = "checkpoint.sckp";
+    double checkpointInterval = 0.0; // период дельта-снимков, с (0 - только по F5)
+    bool resume = false;            // начать с сохранённого снимка
+    bool noOcclusion = false;       // начать с выключенным отсечением перекрытых тел
+    bool noImpostors = false;       // рисовать все тела мешем
+    float impostorPixels = 6.0f;    // радиус на экране, ниже которого тело - импостор
+    float orbitTolerancePixels = 0.5f; // отклонение ломаной орбиты от окружности на экране
+    unsigned trailLength = 64;      // отсчётов в следе каждого тела (0 - без следов)
+    std::string shaderCachePath = "shader_cache"; // бинарники программ (пусто - без кэша)
+    bool noSpecular = false;        // вариант шейдера без блика
+    bool noTexture = false;         // вариант шейдера без текстуры
+    bool compactInstances = false;  // инстанс - 3 строки матрицы вместо 4 столбцов
+    bool checkAllocations = false;  // код выхода 1, если установившийся кадр выделял память
+    bool clusteredLights = false;   // кластерное освещение от звёзд и светящихся тел
+    unsigned emissiveEvery = 0;     // каждое n-е тело светится (0 - только звёзды)
+    std::string metricsEndpoint;    // порт, 127.0.0.1:порт или unix:путь (пусто - без метрик)
+    bool collisions = false;        // искать пересечения тел после каждого шага
+    unsigned beltCount = 0;         // астероидов в поясе (0 - без пояса)
+    unsigned beltSeed = 1;
+    size_t gpuBudgetBytes = 0;      // бюджет буферов и текстур (0 - без ограничения)
+    size_t cpuBudgetBytes = 0;      // бюджет копий данных на CPU (0 - без ограничения)
+    bool releaseCpuCopies = false;  // освобождать копии на CPU после загрузки на GPU
+    bool memoryReport = false;      // напечатать отчёт о памяти ресурсов при выходе
+    bool governor = false;          // понижать качество, если кадр не укладывается в цель
+    double targetFps = 60.0;        // цель регулятора качества
+    unsigned substeps = 1;          // шагов симуляции за кадр (регулятор может уменьшить)
+    bool showHelp = false;
+};
+
+bool parseAppOptions(int argc, char** argv, AppOptions& options);
+void printUsage(const char* program);
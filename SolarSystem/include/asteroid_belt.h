@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =====================================================
+// Процедурный пояс астероидов
+// =====================================================
+//
+// Параметры орбиты каждого астероида выводятся из его номера и seed
+// целочисленным хешем, а положение - из общего времени симуляции.
+// Вершинный шейдер (BeltRenderer) повторяет эти функции по gl_InstanceID,
+// поэтому буфера инстансов нет: за кадр передаются только uniform'ы.
+// Функции ниже - эталон на CPU, по которому проверяется шейдер.
+
+struct AsteroidBeltParams {
+    uint32_t seed = 1;
+    uint32_t count = 0;
+    float innerRadius = 19.0f;
+    float outerRadius = 25.0f;
+    float thickness = 0.8f;         // разброс по высоте, +-
+    float minScale = 0.15f;
+    float maxScale = 0.5f;
+    float innerSpeed = 0.4f;        // градусы за единицу времени на внутреннем краю
+    glm::vec3 center = glm::vec3(0.0f);
+};
+
+// Орбита одного астероида
+struct AsteroidOrbit {
+    float radius;
+    float height;
+    float phase;                    // градусы
+    float speed;                    // градусы за единицу времени (по Кеплеру ~ r^-1.5)
+    float scale;
+    float spinPhase;                // градусы
+    float spinSpeed;
+    glm::vec3 spinAxis;
+};
+
+// Хеш lowbias32 - тот же в шейдере
+uint32_t beltHash(uint32_t x);
+
+// Число в [0, 1) из 24 старших бит - точно представимо и на GPU
+float beltRandom(uint32_t seed, uint32_t index, uint32_t channel);
+
+AsteroidOrbit asteroidOrbit(const AsteroidBeltParams& belt, uint32_t index);
+
+// Угол в градусах по модулю 360 - так же, как mod() в GLSL
+float wrapDegrees(float degrees);
+
+glm::vec3 asteroidPosition(const AsteroidBeltParams& belt, uint32_t index, float time);
+glm::mat4 asteroidModelMatrix(const AsteroidBeltParams& belt, uint32_t index, float time);
+
+// Низкополигональный камень: икосаэдр, разбитый один раз, со смещёнными вершинами.
+// Нормали по граням, вершины не общие.
+struct AsteroidVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+std::vector<AsteroidVertex> createAsteroidMesh(uint32_t seed);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "asteroid_belt.h"
+#include "resource_registry.h"
+#include <cstddef>
+
+// Отрисовка поясов астероидов без буфера инстансов: орбиты считаются
+// в вершинном шейдере по gl_InstanceID (см. asteroid_belt.h)
+class BeltRenderer {
+public:
+    ~BeltRenderer();
+
+    bool init(uint32_t meshSeed = 1);
+
+    // Один вызов отрисовки на пояс, на CPU - только uniform'ы
+    void render(const AsteroidBeltParams& belt, float time,
+                const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightPos);
+
+    // Сравнить положения из шейдера (transform feedback) с эталоном на CPU
+    // для первых sampleCount астероидов. Возвращает наибольшее отклонение.
+    float verify(const AsteroidBeltParams& belt, float time, size_t sampleCount);
+
+    void release();
+
+private:
+    void setBeltUniforms(const AsteroidBeltParams& belt, float time);
+
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    ResourceId vertexResource = NO_RESOURCE;
+    GLsizei vertexCount = 0;
+    glm::vec3 firstVertex = glm::vec3(0.0f);
+};
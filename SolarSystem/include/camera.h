@@ -37,6 +37,8 @@ public:
     glm::vec3 right;
 
     float fov = 45.0f; // угол обзора
+    float nearPlane = 0.1f;
+    float farPlane = 500.0f;
     float pitch = 0.0f; // угол наклона вверх/вниз
     float yaw = -90.0f; // угол поворота влево/вправо  
 
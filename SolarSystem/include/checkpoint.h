@@ -0,0 +1,121 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "scene_loader.h"
+#include "solar_system.h"
+#include <cstdint>
+#include <string>
+
+// =====================================================
+// Контрольные точки симуляции
+// =====================================================
+//
+// Полный снимок - колонки SceneColumn (float32, выравнивание 64 байта) плюс
+// время симуляции. Файл отображается в память, тела читаются кусками.
+// Дельта-снимок хранит только колонки, отличающиеся от полного снимка,
+// плотно или разреженно (индекс + значение) - что короче. Дельта всегда
+// относится к полному снимку, поэтому восстановление = база + одна дельта.
+
+const uint32_t CHECKPOINT_VERSION = 1;
+
+enum CheckpointKind : uint32_t {
+    CHECKPOINT_FULL = 0,
+    CHECKPOINT_DELTA = 1
+};
+
+enum CheckpointEncoding : uint32_t {
+    CHECKPOINT_DENSE = 0,
+    CHECKPOINT_SPARSE = 1
+};
+
+struct CheckpointHeader {
+    char magic[4];              // "SCKP"
+    uint32_t version;
+    uint32_t kind;
+    uint32_t columnCount;
+    uint64_t bodyCount;
+    uint64_t sequence;          // номер снимка
+    uint64_t baseSequence;      // для дельты - номер полного снимка
+    double simulationTime;
+};
+
+struct CheckpointColumnDesc {
+    uint32_t id;
+    uint32_t encoding;
+    uint64_t offset;            // плотная: значения; разреженная: индексы, затем значения
+    uint64_t count;             // число значений
+};
+
+struct CheckpointStats {
+    size_t bytes = 0;
+    size_t bodies = 0;
+    size_t columns = 0;
+    double seconds = 0.0;
+
+    double gigabytesPerSecond() const { return seconds > 0.0 ? bytes / seconds / 1e9 : 0.0; }
+};
+
+// Чтение снимка через mmap без копирования колонок
+class CheckpointReader {
+public:
+    bool open(const std::string& filename);
+    void close() { file.close(); }
+
+    bool isOpen() const { return file.isOpen(); }
+    const CheckpointHeader& getHeader() const { return header; }
+
+    // Колонка полного снимка или nullptr
+    const float* denseColumn(uint32_t column) const;
+
+    // Прочитать тела [first, first + count) - для ленивой загрузки больших сцен
+    size_t readBodies(size_t first, size_t count, CelestialBody* out) const;
+
+    // Перезаписать изменённые колонки (только для дельты)
+    bool applyDelta(SolarSystem& system) const;
+
+    size_t getFileSize() const { return file.size(); }
+
+private:
+    MappedFile file;
+    CheckpointHeader header = {};
+    CheckpointColumnDesc columns[SCENE_COLUMN_COUNT] = {};
+    bool present[SCENE_COLUMN_COUNT] = {};
+};
+
+bool saveCheckpoint(const std::string& filename, const SolarSystem& system,
+                    uint64_t sequence, CheckpointStats* stats = nullptr);
+
+// Дельта относительно открытого полного снимка base.
+// Если число тел изменилось, дельта невозможна - вернётся false.
+bool saveDeltaCheckpoint(const std::string& filename, const SolarSystem& system,
+                         const CheckpointReader& base, uint64_t sequence,
+                         CheckpointStats* stats = nullptr);
+
+// Полный снимок и (если есть и подходит) дельта к нему
+bool restoreCheckpoint(const std::string& fullPath, const std::string& deltaPath,
+                       SolarSystem& system, CheckpointStats* stats = nullptr);
+
+// Периодические дельты и ручные полные снимки
+class CheckpointManager {
+public:
+    // interval <= 0 - без автоматических дельт
+    void configure(const std::string& path, double intervalSeconds);
+
+    // Вызывается каждый кадр со временем кадра; true - в этом кадре записан снимок
+    // (дельта или, если её записать нельзя, полный)
+    bool update(const SolarSystem& system, float deltaTime);
+
+    bool saveFull(const SolarSystem& system);
+    bool saveDelta(const SolarSystem& system);
+    bool restore(SolarSystem& system);
+
+    const std::string& getPath() const { return fullPath; }
+    std::string getDeltaPath() const { return fullPath + ".delta"; }
+
+private:
+    std::string fullPath = "checkpoint.sckp";
+    double interval = 0.0;
+    double sinceLastSave = 0.0;
+    uint64_t sequence = 0;
+    CheckpointReader base;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "solar_system.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// =====================================================
+// Пересечения тел: sweep-and-prune + точная проверка сфер
+// =====================================================
+//
+// Тело - ограничивающая сфера (радиус меша * scale, как при выборе мышью).
+// Широкая фаза держит тела отсортированными по началу отрезка сферы на оси
+// развёртки. Между тиками орбиты почти не меняют порядок, поэтому массив
+// досортировывается вставками за O(n + перестановок); если перестановок
+// больше SWEEP_SWAP_BUDGET на тело (новая сцена, скачок времени), выполняется
+// полная сортировка. Ось выбирается по наибольшему разбросу центров при
+// перестроении. Развёртка и узкая фаза идут параллельно по кускам массива;
+// контакты упорядочены по (a, b), результат не зависит от числа потоков.
+
+struct BodyContact {
+    uint32_t a;                     // a < b
+    uint32_t b;
+    glm::vec3 normal;               // от a к b
+    float depth;                    // на сколько сферы заходят друг в друга
+};
+
+struct CollisionStats {
+    size_t bodies = 0;
+    size_t swaps = 0;               // перестановок при досортировке
+    size_t candidates = 0;          // пар после широкой фазы
+    size_t contacts = 0;
+    bool rebuilt = false;           // была полная сортировка
+    int axis = 0;
+    double sortSeconds = 0.0;       // обновление отрезков и досортировка
+    double sweepSeconds = 0.0;
+    double narrowSeconds = 0.0;
+
+    double broadphaseSeconds() const { return sortSeconds + sweepSeconds; }
+    double totalSeconds() const { return sortSeconds + sweepSeconds + narrowSeconds; }
+};
+
+class CollisionDetector {
+public:
+    explicit CollisionDetector(ThreadPool& pool);
+
+    // Обе фазы; ссылка действительна до следующего вызова
+    const std::vector<BodyContact>& detect(const std::vector<CelestialBody>& bodies, float meshRadius);
+
+    // Широкая фаза: пары, чьи AABB сфер пересекаются
+    void broadphase(const std::vector<CelestialBody>& bodies, float meshRadius);
+    // Узкая фаза по парам последней широкой фазы
+    const std::vector<BodyContact>& narrowphase();
+
+    // Следующая широкая фаза начнёт с полной сортировки
+    void reset() { entries.clear(); }
+
+    const std::vector<BodyContact>& getContacts() const { return contacts; }
+    const CollisionStats& getStats() const { return stats; }
+
+private:
+    // Отрезок тела на оси развёртки и его сфера - подряд в памяти для развёртки
+    struct SweepEntry {
+        float lower;
+        float upper;
+        glm::vec3 center;
+        float radius;
+        uint32_t body;
+    };
+
+    struct CandidatePair {
+        uint32_t first;             // индексы в entries
+        uint32_t second;
+    };
+
+    void rebuild(const std::vector<CelestialBody>& bodies, float meshRadius);
+    void refreshEntries(const std::vector<CelestialBody>& bodies, float meshRadius);
+    bool insertionSort(size_t swapBudget);
+
+    ThreadPool& pool;
+    int axis = 0;
+    std::vector<SweepEntry> entries;
+    std::vector<std::vector<CandidatePair>> workerCandidates;
+    std::vector<CandidatePair> candidates;
+    std::vector<std::vector<BodyContact>> workerContacts;
+    std::vector<BodyContact> contacts;
+    CollisionStats stats;
+};
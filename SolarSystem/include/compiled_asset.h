@@ -0,0 +1,122 @@
+#pragma once
+
+#include "obj_loader.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// =====================================================
+// Скомпилированные ассеты (.smesh, .stex)
+// =====================================================
+//
+// Готовые к загрузке на GPU файлы, которые пишет solar_assetc. Меш -
+// квантованные вершины (16 байт вместо 32 у OBJVertex) и индексы для
+// цепочки LOD; каждый LOD - свой отрезок вершин и индексов, индексы
+// относительно начала отрезка. Текстура - RGBA8 со всеми уровнями mip.
+// В заголовке - хэш исходного файла: по нему приложение отличает
+// устаревший файл, а компилятор пропускает неизменившиеся входы.
+
+const uint32_t COMPILED_ASSET_VERSION = 1;
+
+// Флаг CompiledMeshHeader::flags: у исходника нет материалов MTL, модель
+// рисуется одним белым материалом. Материалы в .smesh не хранятся - файл без
+// флага (многоматериальная модель или старый компилятор) приложение не берёт
+const uint32_t COMPILED_MESH_SINGLE_MATERIAL = 1;
+
+// FNV-1a, 64 бита; hash - продолжение предыдущего хэша
+uint64_t hashAssetBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+bool readWholeFile(const std::string& filename, std::vector<char>& data);
+
+// Положение и UV в рамке меша, нормаль - snorm8
+struct QuantizedVertex {
+    int16_t position[4];            // [3] всегда 0 - выравнивание до 8 байт
+    uint16_t texCoord[2];
+    int8_t normal[4];               // [3] всегда 0
+};
+
+struct MeshQuantization {
+    float positionOffset[3];        // position = offset + scale * snorm16
+    float positionScale[3];
+    float texCoordOffset[2];        // texCoord = offset + scale * unorm16
+    float texCoordScale[2];
+};
+
+struct CompiledMeshLod {
+    uint32_t vertexOffset;
+    uint32_t vertexCount;
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float cellSize;                 // ошибка упрощения, 0 - исходный меш
+    float cacheMissRatio;           // ACMR после переупорядочивания
+};
+
+struct CompiledMeshHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;            // хэш исходного OBJ
+    uint64_t settingsHash;          // версия и настройки компилятора
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    uint32_t indexSize;             // 2 или 4 байта
+    MeshQuantization quantization;
+    float boundingRadius;
+    uint32_t flags;                 // COMPILED_MESH_*
+};
+
+struct CompiledMesh {
+    CompiledMeshHeader header;
+    std::vector<CompiledMeshLod> lods;
+    std::vector<QuantizedVertex> vertices;
+    std::vector<uint32_t> indices;  // в памяти всегда 32 бита
+};
+
+struct CompiledTextureMip {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;                // от начала данных уровней (texels)
+    uint64_t size;
+};
+
+struct CompiledTextureHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t settingsHash;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t format;                // 0 - RGBA8 sRGB
+};
+
+struct CompiledTexture {
+    CompiledTextureHeader header;
+    std::vector<CompiledTextureMip> mips;
+    std::vector<unsigned char> texels;  // уровни подряд
+};
+
+MeshQuantization computeQuantization(const std::vector<OBJVertex>& vertices);
+QuantizedVertex quantizeVertex(const OBJVertex& vertex, const MeshQuantization& quantization);
+OBJVertex dequantizeVertex(const QuantizedVertex& vertex, const MeshQuantization& quantization);
+
+// Уровни mip RGBA8 фильтром 2x2 с усреднением в линейном пространстве
+// (из sRGB и обратно), альфа - линейно. levels[0] - копия исходника
+void buildMipChain(const unsigned char* rgba, uint32_t width, uint32_t height,
+                   std::vector<std::vector<unsigned char>>& levels);
+
+bool writeCompiledMesh(const std::string& filename, const CompiledMesh& mesh);
+bool readCompiledMesh(const std::string& filename, CompiledMesh& mesh);
+// Один LOD в формат OBJModel (для CPU-структур: BVH, отсечение)
+void unpackCompiledLod(const CompiledMesh& mesh, size_t lod,
+                       std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices);
+
+bool writeCompiledTexture(const std::string& filename, const CompiledTexture& texture);
+bool readCompiledTexture(const std::string& filename, CompiledTexture& texture);
+
+// Только заголовок: для проверки, не устарел ли файл. false - нет файла или не тот формат
+bool readCompiledHashes(const std::string& filename, uint64_t& sourceHash, uint64_t& settingsHash);
+
+// Скомпилированный файл есть и собран из текущей версии исходника
+bool compiledAssetIsCurrent(const std::string& compiledPath, const std::string& sourcePath);
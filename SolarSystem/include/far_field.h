@@ -0,0 +1,55 @@
+#pragma once
+
+#include "solar_system.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// =====================================================
+// Дальние тела: меш или импостор
+// =====================================================
+//
+// Тело, радиус которого на экране меньше порога, рисуется импостором -
+// квадратом с заранее отрендеренным видом меша. В полосе вокруг порога
+// рисуются оба представления с взаимодополняющим растровым (dither)
+// узором, поэтому переход плавный и не требует сортировки по глубине.
+
+struct FarFieldSettings {
+    bool enabled = true;
+    float thresholdPixels = 6.0f;   // радиус на экране, ниже - импостор
+    float fadeBand = 0.3f;          // полуширина полосы перехода, доля порога
+};
+
+// Данные инстанса импостора (две vec4 на тело)
+struct ImpostorInstance {
+    glm::vec4 positionRadius;       // центр и радиус ограничивающей сферы
+    glm::vec4 params;               // x - угол вращения (рад), y - растворение меша
+};
+
+// Результат разделения. dissolve: 0 - только меш, 1 - только импостор
+struct FarFieldSplit {
+    std::vector<glm::mat4> meshMatrices;
+    std::vector<float> meshDissolve;
+    std::vector<ImpostorInstance> impostors;
+
+    size_t crossfading = 0;         // тел, нарисованных обоими способами
+
+    // Рабочие буферы, переиспользуются между кадрами
+    std::vector<float> bodyDissolve;
+    std::vector<size_t> meshOffsets;
+    std::vector<size_t> impostorOffsets;
+};
+
+// Радиус тела на экране в пикселях (для viewportHeight пикселей по высоте)
+float projectedRadiusPixels(const glm::vec3& center, float radius, const glm::mat4& view,
+                            const glm::mat4& projection, float viewportHeight);
+
+// Разделить тела (indices - подмножество после отсечения, nullptr - все) на меши и импосторы.
+// Порядок тел внутри каждого списка сохраняется.
+void splitFarField(const std::vector<CelestialBody>& bodies, const std::vector<uint32_t>* indices,
+                   float meshRadius, const glm::mat4& view, const glm::mat4& projection,
+                   float viewportHeight, const FarFieldSettings& settings,
+                   FarFieldSplit& split, ThreadPool& pool);
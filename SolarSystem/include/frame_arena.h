@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// =====================================================
+// Арена кадра
+// =====================================================
+//
+// Линейный аллокатор для временных данных кадра: выделение - сдвиг
+// указателя, освобождение всего сразу - reset() в начале кадра. Если за
+// кадр не хватило первого блока, берутся дополнительные, а на reset() они
+// сливаются в один блок размером с пиковое использование. После прогрева
+// арена к куче не обращается. Деструкторы не вызываются, поэтому только
+// тривиально разрушаемые типы.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialBytes = 1 << 20);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena не вызывает деструкторы");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+    size_t getUsedBytes() const { return usedBytes; }
+    size_t getPeakBytes() const { return peakBytes; }
+    size_t getCapacity() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    void addBlock(size_t minBytes);
+
+    std::vector<Block> blocks;
+    size_t current = 0;             // блок, из которого сейчас выделяем
+    size_t offset = 0;              // занято в текущем блоке
+    size_t usedBytes = 0;           // за текущий кадр, с выравниванием
+    size_t peakBytes = 0;
+};
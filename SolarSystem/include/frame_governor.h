@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =====================================================
+// Регулятор качества по времени кадра
+// =====================================================
+//
+// С vsync медленный кадр просто ждёт следующего обновления экрана, поэтому
+// регулятор смотрит не на время между кадрами, а на занятость: время CPU
+// до отдачи кадра и время GPU по меткам времени. Обе величины сглаживаются
+// (экспоненциальное среднее) и сравниваются с целевым временем кадра.
+//
+// Качество меняется рычагами, у каждого - ступени от 0 (полное качество)
+// до maxLevel. Понижение выбирает рычаг по узкому месту (GPU или CPU),
+// повышение возвращает рычаги в обратном порядке. От колебаний защищают:
+//  - два порога: понижение выше цели, повышение заметно ниже неё;
+//  - выдержка: условие должно держаться непрерывно, а после решения
+//    следующее возможно только через cooldown;
+//  - если повышение пришлось откатить вскоре после него, выдержка перед
+//    следующим повышением удваивается.
+// Сам регулятор ничего не меняет - приложение применяет ступени рычагов.
+
+enum QualityLever : uint32_t {
+    QUALITY_MSAA = 0,               // 1 - без мультисэмплинга
+    QUALITY_IMPOSTORS,              // порог импосторов x2 за ступень
+    QUALITY_LOD,                    // на сколько LOD грубее модель
+    QUALITY_ORBITS,                 // допуск тесселяции орбит x2 за ступень
+    QUALITY_SUBSTEPS,               // подшагов симуляции вдвое меньше за ступень
+    QUALITY_LEVER_COUNT
+};
+
+// Короткое имя для журнала и метрик: "msaa", "impostors", ...
+const char* qualityLeverName(QualityLever lever);
+
+struct GovernorSettings {
+    double targetSeconds = 1.0 / 60.0;
+    double smoothing = 0.1;         // вес нового кадра в среднем
+    double downgradeRatio = 1.05;   // понижать, если занятость выше цели на 5%
+    double upgradeRatio = 0.7;      // повышать, если ниже 70% цели
+    double downgradeHold = 0.5;     // с, сколько держится перегрузка до понижения
+    double upgradeHold = 3.0;       // с, сколько держится запас до повышения
+    double cooldown = 1.0;          // с после любого решения
+    double maxUpgradeHold = 30.0;   // предел удвоения выдержки
+};
+
+struct GovernorDecision {
+    QualityLever lever = QUALITY_MSAA;
+    int level = 0;                  // новая ступень рычага
+    bool downgrade = false;
+    bool gpuBound = false;
+    double cpuSeconds = 0.0;        // сглаженные значения в момент решения
+    double gpuSeconds = 0.0;
+};
+
+class FrameGovernor {
+public:
+    // maxLevels - число ступеней каждого рычага (0 - рычаг недоступен)
+    void configure(const GovernorSettings& settings, const int maxLevels[QUALITY_LEVER_COUNT]);
+
+    // frameSeconds - время между кадрами (для выдержек), cpuSeconds - работа
+    // кадра на CPU, gpuSeconds - на GPU (0 - замера нет). true - принято решение
+    bool update(double frameSeconds, double cpuSeconds, double gpuSeconds, GovernorDecision& decision);
+
+    int getLevel(QualityLever lever) const { return levels[lever]; }
+    double getSmoothedCpu() const { return smoothedCpu; }
+    double getSmoothedGpu() const { return smoothedGpu; }
+    double getTarget() const { return settings.targetSeconds; }
+    size_t getDowngrades() const { return downgrades; }
+    size_t getUpgrades() const { return upgrades; }
+
+private:
+    bool downgrade(bool gpuBound, GovernorDecision& decision);
+    bool upgrade(GovernorDecision& decision);
+
+    GovernorSettings settings;
+    int levels[QUALITY_LEVER_COUNT] = {};
+    int maxLevels[QUALITY_LEVER_COUNT] = {};
+    std::vector<QualityLever> history;  // понижения по порядку; повышение снимает последнее
+
+    double smoothedCpu = 0.0;
+    double smoothedGpu = 0.0;
+    bool primed = false;
+    double overSeconds = 0.0;       // подряд выше порога понижения
+    double underSeconds = 0.0;      // подряд ниже порога повышения
+    double sinceDecision = 0.0;
+    double sinceUpgrade = 1e9;
+    double upgradeHold = 0.0;       // текущая выдержка повышения (с удвоениями)
+    size_t downgrades = 0;
+    size_t upgrades = 0;
+};
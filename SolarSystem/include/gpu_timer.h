@@ -0,0 +1,87 @@
+#pragma once
+
+#include <GL/glew.h>
+#include "profiler.h"
+#include <cstdint>
+#include <vector>
+
+// Замеры времени на GPU через GL_TIME_ELAPSED.
+// Результаты не ждём: запрос опрашивается в следующих кадрах и,
+// когда готов, передаётся в Profiler. Вложенные замеры не поддерживаются.
+class GpuTimer {
+public:
+    ~GpuTimer();
+
+    void begin(const char* name);
+    void end();
+
+    // Забрать готовые результаты, не блокируя конвейер
+    void poll();
+
+    void release();
+
+private:
+    struct Query {
+        GLuint id = 0;
+        const char* name = nullptr;
+        uint64_t cpuStartNs = 0;
+        bool pending = false;
+    };
+
+    // Ограничение на число запросов в полёте
+    static const size_t MAX_QUERIES = 64;
+
+    std::vector<Query> queries;
+    int active = -1;
+};
+
+// Время всего кадра на GPU по двум меткам времени (glQueryCounter). Работает
+// без профилировщика и не мешает замерам GpuTimer внутри кадра (GL_TIME_ELAPSED
+// не вкладываются, метки времени - можно). Результат приходит через несколько кадров
+class FrameGpuClock {
+public:
+    ~FrameGpuClock();
+
+    // begin() - перед первой отрисовкой кадра, после работы CPU над ним:
+    // иначе в замер попадает простой GPU, пока CPU готовит кадр
+    void begin();
+    void end();
+
+    // Последнее готовое время кадра, с; 0 - замеров ещё нет
+    double poll();
+
+    void release();
+
+private:
+    struct Frame {
+        GLuint start = 0;
+        GLuint end = 0;
+        bool pending = false;
+    };
+
+    static const size_t FRAMES_IN_FLIGHT = 4;
+
+    Frame frames[FRAMES_IN_FLIGHT];
+    size_t current = 0;
+    bool recording = false;
+    double lastSeconds = 0.0;
+};
+
+// RAII-замер участка на GPU
+class GpuScope {
+public:
+    GpuScope(GpuTimer& timer, const char* name) : timer(timer) { timer.begin(name); }
+    ~GpuScope() { timer.end(); }
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+    GpuTimer& timer;
+};
+
+#ifdef SOLAR_PROFILER
+#define GPU_PROFILE_SCOPE(timer, name) GpuScope PROFILE_CONCAT(gpuScope_, __LINE__)(timer, name)
+#else
+#define GPU_PROFILE_SCOPE(timer, name) ((void)0)
+#endif
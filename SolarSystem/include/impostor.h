@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "far_field.h"
+#include "obj_loader.h"
+#include <cstddef>
+
+// =====================================================
+// Импосторы дальних тел
+// =====================================================
+//
+// При запуске меш рендерится в атлас: AZIMUTH_CELLS x ELEVATION_CELLS видов
+// с разных направлений, в двух текстурах - цвет (альфа = покрытие) и нормаль
+// в координатах вида. Импостор - квадрат к камере, ячейка атласа выбирается
+// по направлению на камеру в системе координат тела, освещение то же, что
+// у меша (по нормали из атласа). Квадрат строится из gl_VertexID, на тело
+// передаются только две vec4 - ImpostorInstance.
+class ImpostorRenderer {
+public:
+    ~ImpostorRenderer();
+
+    // Запечь атлас меша (нужен GL-контекст и загруженные буферы модели)
+    bool init(const OBJModel& model, GLuint texture, float meshRadius);
+
+    void render(const ImpostorInstance* instances, size_t count,
+                const glm::mat4& view, const glm::mat4& projection,
+                const glm::vec3& cameraPos, const glm::vec3& lightPos);
+
+    void release();
+
+    GLuint getAlbedoAtlas() const { return albedoAtlas; }
+    GLuint getNormalAtlas() const { return normalAtlas; }
+
+    static const int CELL_SIZE = 64;
+    static const int AZIMUTH_CELLS = 16;
+    static const int ELEVATION_CELLS = 5;
+
+private:
+    bool bakeAtlas(const OBJModel& model, GLuint texture, float meshRadius);
+
+    GLuint program = 0;
+    GLuint albedoAtlas = 0;
+    GLuint normalAtlas = 0;
+    GLuint vao = 0;
+    GLuint instanceVBO = 0;
+    size_t capacity = 0;
+    ResourceId albedoResource = NO_RESOURCE;
+    ResourceId normalResource = NO_RESOURCE;
+    ResourceId instanceResource = NO_RESOURCE;
+};
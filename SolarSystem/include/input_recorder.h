@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// =====================================================
+// Запись и воспроизведение ввода
+// =====================================================
+//
+// Каждый кадр сохраняется как deltaTime (float32) и маска нажатых клавиш
+// (uint16) - 6 байт на кадр. При воспроизведении handleInput и update
+// получают ровно те же данные, поэтому сессию можно прогонять как бенчмарк.
+
+enum InputKey : uint16_t {
+    INPUT_FORWARD        = 1 << 0,
+    INPUT_BACKWARD       = 1 << 1,
+    INPUT_LEFT           = 1 << 2,
+    INPUT_RIGHT          = 1 << 3,
+    INPUT_UP             = 1 << 4,
+    INPUT_DOWN           = 1 << 5,
+    INPUT_PITCH_UP       = 1 << 6,
+    INPUT_PITCH_DOWN     = 1 << 7,
+    INPUT_YAW_LEFT       = 1 << 8,
+    INPUT_YAW_RIGHT      = 1 << 9,
+    INPUT_TOGGLE_ORBITS  = 1 << 10,
+    INPUT_RESET_CAMERA   = 1 << 11,
+    INPUT_TOGGLE_PROFILE = 1 << 12,
+    INPUT_SAVE_CHECKPOINT = 1 << 13,
+    INPUT_LOAD_CHECKPOINT = 1 << 14,
+    INPUT_TOGGLE_CULLING = 1 << 15,
+};
+
+struct InputFrame {
+    float deltaTime = 0.0f;
+    uint16_t keys = 0;
+
+    bool pressed(InputKey key) const { return (keys & key) != 0; }
+};
+
+const uint32_t INPUT_LOG_VERSION = 1;
+
+class InputRecorder {
+public:
+    ~InputRecorder();
+
+    // bodyCount сохраняется для проверки, что запись воспроизводится на той же сцене
+    bool open(const std::string& filename, uint64_t bodyCount);
+    void record(const InputFrame& frame);
+    void close();
+
+    bool isOpen() const { return file.is_open(); }
+
+private:
+    std::ofstream file;
+    uint64_t frameCount = 0;
+};
+
+class InputPlayer {
+public:
+    bool open(const std::string& filename);
+
+    // false, когда запись закончилась
+    bool next(InputFrame& frame);
+
+    uint64_t getFrameCount() const { return frames.size(); }
+    uint64_t getBodyCount() const { return bodyCount; }
+    bool isOpen() const { return opened; }
+
+private:
+    std::vector<InputFrame> frames;
+    size_t position = 0;
+    uint64_t bodyCount = 0;
+    bool opened = false;
+};
+
+// Сводка по времени кадров для сравнения сборок
+struct FrameTimeSummary {
+    size_t frames = 0;
+    double totalSeconds = 0.0;
+    double meanMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+FrameTimeSummary summarizeFrameTimes(std::vector<float> frameSeconds);
+void printFrameTimeSummary(const FrameTimeSummary& summary);
+
+// CSV: номер кадра и время кадра в мс
+bool writeFrameTimes(const std::string& filename, const std::vector<float>& frameSeconds);
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "solar_system.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// =====================================================
+// Кластерное освещение: списки источников по кластерам
+// =====================================================
+//
+// Пирамида видимости делится на CLUSTER_X x CLUSTER_Y плиток экрана и
+// CLUSTER_Z срезов по глубине; срезы экспоненциальные (одинаковы в
+// логарифме глубины), поэтому вблизи камеры кластеры мельче. Для каждого
+// кластера на CPU строится список источников, чья сфера действия задевает
+// его AABB в координатах экрана и глубины. Фрагментный шейдер перебирает
+// только список своего кластера. Список обрезается до
+// MAX_LIGHTS_PER_CLUSTER ближайших к камере источников - стоимость
+// фрагмента ограничена при любом числе источников в сцене.
+
+const uint32_t CLUSTER_X = 16;
+const uint32_t CLUSTER_Y = 9;
+const uint32_t CLUSTER_Z = 24;
+const uint32_t CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+const uint32_t MAX_LIGHTS_PER_CLUSTER = 64;
+
+// Звёзды светят на всю сцену, светящиеся тела - на EMISSIVE_RANGE_SCALE * scale
+const float STAR_LIGHT_RANGE = 10000.0f;
+const float EMISSIVE_RANGE_SCALE = 4.0f;
+
+struct PointLight {
+    glm::vec3 position;
+    float range;                    // за этим расстоянием вклад ровно 0
+    glm::vec3 color;                // уже умножен на яркость
+    float padding;
+};
+
+// Тела-источники: звёзды (orbitRadius == 0, центр своей системы) и, при
+// emissiveEvery > 0, каждое emissiveEvery-е из остальных тел
+void selectLightBodies(const std::vector<CelestialBody>& bodies, unsigned emissiveEvery,
+                       std::vector<uint32_t>& lightBodies);
+
+// Источники в текущих положениях тел; цвет светящегося тела - по его номеру
+void gatherBodyLights(const std::vector<CelestialBody>& bodies, const std::vector<uint32_t>& lightBodies,
+                      std::vector<PointLight>& lights);
+
+struct ClusterStats {
+    size_t lights = 0;
+    size_t visibleLights = 0;       // задели хотя бы один кластер
+    size_t references = 0;          // элементов во всех списках
+    size_t maxPerCluster = 0;       // до обрезки
+    size_t overflowClusters = 0;    // кластеров, где список обрезан
+    double seconds = 0.0;
+};
+
+// Диапазон кластеров источника включительно; пустой - xBegin > xEnd
+struct ClusterBounds {
+    uint8_t xBegin, xEnd;
+    uint8_t yBegin, yEnd;
+    uint8_t zBegin, zEnd;
+};
+
+// Готовые к загрузке в texture buffer данные
+struct LightClusters {
+    std::vector<PointLight> lights;         // отсортированы по расстоянию до камеры
+    std::vector<uint32_t> ranges;           // на кластер: смещение и число в lightIndices
+    std::vector<uint32_t> lightIndices;     // номера в lights
+    ClusterStats stats;
+
+    // Рабочие буферы, переиспользуются между кадрами
+    std::vector<uint32_t> order;
+    std::vector<float> distances;
+    std::vector<ClusterBounds> bounds;
+    std::vector<uint32_t> counts;
+};
+
+// Номер среза для глубины в координатах камеры (та же формула в шейдере)
+uint32_t clusterSlice(float depth, float nearPlane, float farPlane);
+
+// Списки кластеров; view/projection - камеры кадра, near/far - её плоскости
+void buildLightClusters(const std::vector<PointLight>& lights, const glm::mat4& view,
+                        const glm::mat4& projection, float nearPlane, float farPlane,
+                        LightClusters& clusters, ThreadPool& pool);
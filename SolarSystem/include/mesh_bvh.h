@@ -0,0 +1,66 @@
+#pragma once
+
+#include "soft_rasterizer.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =====================================================
+// BVH по треугольникам меша
+// =====================================================
+//
+// Строится один раз на меш в его собственных координатах. Разбиение по
+// SAH с корзинами (BUILD_BINS на ось, по центроидам): узел делится, пока
+// это дешевле листа. Треугольники после построения переупорядочены в
+// порядке листьев и хранятся как (v0, e1, e2) для теста Мёллера - Трумбора.
+// Обход - стек, сначала ближний потомок; поддерево пропускается, если его
+// AABB дальше уже найденного пересечения.
+
+struct MeshHit {
+    float distance = 0.0f;          // параметр луча: origin + direction * distance
+    uint32_t triangle = 0;          // номер треугольника в исходном меше
+    float u = 0.0f, v = 0.0f;       // барицентрические координаты
+};
+
+struct MeshBVHStats {
+    size_t nodes = 0;
+    size_t leaves = 0;
+    size_t maxDepth = 0;
+    size_t maxLeafTriangles = 0;
+    double buildSeconds = 0.0;
+};
+
+class MeshBVH {
+public:
+    void build(const SoftMesh& mesh);
+
+    // Ближайшее пересечение с distance в (0, maxDistance); direction можно не нормировать
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction,
+                   float maxDistance, MeshHit& hit) const;
+
+    bool empty() const { return nodes.empty(); }
+    size_t getTriangleCount() const { return triangles.size(); }
+    const MeshBVHStats& getStats() const { return stats; }
+
+    static const int BUILD_BINS = 16;
+    static const size_t MAX_LEAF_TRIANGLES = 4;
+    static const uint32_t MAX_DEPTH = 64;   // глубже - лист, чтобы стек обхода был фиксированным
+
+private:
+    struct Node {
+        glm::vec3 boundsMin;
+        uint32_t leftFirst;         // лист: первый треугольник, иначе левый потомок (правый - следующий)
+        glm::vec3 boundsMax;
+        uint32_t triangleCount;     // 0 - внутренний узел
+    };
+
+    struct Triangle {
+        glm::vec3 v0, edge1, edge2;
+        uint32_t original;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Triangle> triangles;
+    MeshBVHStats stats;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "obj_loader.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+// =====================================================
+// Подготовка меша к загрузке на GPU
+// =====================================================
+//
+// Всё на CPU и без обращений к OpenGL - используется офлайн-компилятором
+// ассетов (solar_assetc):
+//  - deduplicateVertices: побайтно равные вершины сливаются (после
+//    квантования совпадают и те, что отличались ниже точности формата);
+//  - optimizeVertexCache: порядок треугольников по Форсайту под кэш
+//    вершинного шейдера (LRU на VERTEX_CACHE_SIZE вершин);
+//  - optimizeVertexFetch: вершины в порядке первого использования, чтобы
+//    выборка атрибутов шла по памяти подряд;
+//  - simplifyByClustering: LOD кластеризацией вершин по сетке.
+
+const size_t VERTEX_CACHE_SIZE = 32;
+
+// Среднее число промахов FIFO-кэша на треугольник (ACMR): 3 - без
+// переиспользования, около 0.6-0.7 - хороший порядок для сетки
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount,
+                            size_t cacheSize = 16);
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+// Упрощённый меш: вершины одной ячейки сетки gridResolution^3 по рамке меша
+// (и одной полусферы нормали) сливаются в среднюю, вырожденные треугольники
+// выбрасываются. Возвращает размер ячейки - оценку геометрической ошибки
+float simplifyByClustering(const std::vector<OBJVertex>& vertices, const std::vector<unsigned int>& indices,
+                           unsigned gridResolution,
+                           std::vector<OBJVertex>& outVertices, std::vector<unsigned int>& outIndices);
+
+// Vertex - тривиально копируемый тип без паддинга (сравнение побайтное)
+template <typename Vertex>
+size_t deduplicateVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    std::vector<unsigned int> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0u);
+    auto less = [&](unsigned int a, unsigned int b) {
+        int cmp = std::memcmp(&vertices[a], &vertices[b], sizeof(Vertex));
+        return cmp < 0 || (cmp == 0 && a < b);
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    // Первая по номеру вершина группы остаётся, остальные ссылаются на неё
+    std::vector<unsigned int> remap(vertices.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        bool same = i > 0 && std::memcmp(&vertices[order[i]], &vertices[order[i - 1]], sizeof(Vertex)) == 0;
+        remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+    }
+
+    std::vector<unsigned int> compact(vertices.size(), ~0u);
+    std::vector<Vertex> unique;
+    unique.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        if (remap[i] == i) {
+            compact[i] = static_cast<unsigned int>(unique.size());
+            unique.push_back(vertices[i]);
+        }
+    }
+    for (unsigned int& index : indices) {
+        index = compact[remap[index]];
+    }
+    vertices.swap(unique);
+    return vertices.size();
+}
+
+// Вершины в порядке первого упоминания в indices; неиспользуемые выбрасываются
+template <typename Vertex>
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    std::vector<unsigned int> remap(vertices.size(), ~0u);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int& index : indices) {
+        if (remap[index] == ~0u) {
+            remap[index] = static_cast<unsigned int>(ordered.size());
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
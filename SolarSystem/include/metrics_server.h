@@ -0,0 +1,107 @@
+#pragma once
+
+#include "frame_governor.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// =====================================================
+// Метрики кадра и симуляции для Prometheus
+// =====================================================
+//
+// Поток кадра копит значения в MetricsSnapshot и раз в кадр публикует
+// копию в MetricsServer. Публикация - запись в тройной буфер без
+// блокировок и выделений памяти: поток кадра никогда не ждёт читателя.
+// Фоновый поток сервера принимает HTTP-запросы на localhost или на
+// Unix-сокете, забирает последний опубликованный снимок и отвечает
+// на GET /metrics текстом в формате Prometheus. Только POSIX; на других
+// платформах start() сообщает об ошибке.
+
+// Верхние границы корзин гистограммы времени кадра, с (+Inf - отдельно)
+const double FRAME_TIME_BUCKETS[] = {0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1, 0.25, 1.0};
+const size_t FRAME_TIME_BUCKET_COUNT = sizeof(FRAME_TIME_BUCKETS) / sizeof(FRAME_TIME_BUCKETS[0]);
+
+// Только числа фиксированного размера - копируется присваиванием
+struct MetricsSnapshot {
+    // Счётчики с начала работы
+    uint64_t frames = 0;
+    double frameSecondsSum = 0.0;
+    uint64_t frameTimeBuckets[FRAME_TIME_BUCKET_COUNT + 1] = {};  // не накопительные, последняя - +Inf
+    uint64_t drawCallsTotal = 0;
+    uint64_t uploadBytesTotal = 0;
+    uint64_t simulationTicks = 0;
+    double simulationTickSeconds = 0.0;     // время CPU на шаги симуляции
+
+    // Значения последнего кадра
+    double lastFrameSeconds = 0.0;
+    uint64_t drawCalls = 0;
+    uint64_t uploadBytes = 0;
+    uint64_t bodies = 0;
+    uint64_t visibleBodies = 0;
+    uint64_t occludedBodies = 0;
+    uint64_t frustumCulledBodies = 0;
+    uint64_t meshInstances = 0;
+    uint64_t impostors = 0;
+    uint64_t lights = 0;
+    uint64_t collisionContacts = 0;
+    uint64_t orbitSegments = 0;
+    uint64_t gpuMemoryBytes = 0;            // по реестру ресурсов
+    uint64_t cpuMemoryBytes = 0;            // копии данных, загруженных на GPU
+    uint64_t memoryDemotions = 0;           // понижений качества из-за бюджетов, с начала работы
+    uint64_t qualityLevels[QUALITY_LEVER_COUNT] = {};  // ступени регулятора качества
+    uint64_t qualityDowngrades = 0;         // решений регулятора с начала работы
+    uint64_t qualityUpgrades = 0;
+    double governorCpuSeconds = 0.0;        // сглаженная работа кадра на CPU
+    double governorGpuSeconds = 0.0;        // и на GPU (0 - замера нет)
+    bool governorEnabled = false;
+    double simulationTime = 0.0;
+    bool orbitsVisible = false;
+    bool occlusionEnabled = false;
+};
+
+void recordFrameTime(MetricsSnapshot& metrics, double seconds);
+
+// Текстовый формат Prometheus 0.0.4; scrapes - число ответов сервера
+std::string formatPrometheusMetrics(const MetricsSnapshot& metrics, uint64_t scrapes);
+
+class MetricsServer {
+public:
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // endpoint: "9100", "127.0.0.1:9100", "localhost:9100" или "unix:/путь/к/сокету".
+    // TCP слушает только 127.0.0.1
+    bool start(const std::string& endpoint);
+    void stop();
+
+    bool isRunning() const { return thread.joinable(); }
+    const std::string& getEndpoint() const { return endpoint; }
+    uint64_t getScrapes() const { return scrapes.load(std::memory_order_relaxed); }
+
+    // Поток кадра; не блокируется и не выделяет память
+    void publish(const MetricsSnapshot& metrics);
+
+private:
+    void serve();
+    void handleClient(int client);
+    const MetricsSnapshot& latest();
+
+    // Тройной буфер: back - у писателя, front - у читателя, средний - в ready
+    static const uint32_t FRESH = 4;
+    MetricsSnapshot buffers[3];
+    std::atomic<uint32_t> ready{1};
+    uint32_t back = 0;
+    uint32_t front = 2;
+
+    std::string endpoint;
+    std::string socketPath;                 // Unix-сокет удаляется при остановке
+    int listenSocket = -1;
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> scrapes{0};
+};
@@ -8,6 +8,10 @@
 #include <sstream>
 #include <iostream>
 #include <unordered_map>
+#include <map>
+#include <array>
+#include <cstdlib>
+#include "resource_registry.h"
 
 struct OBJVertex {
     glm::vec3 position;
@@ -21,25 +25,83 @@ struct OBJVertex {
     }
 };
 
+// Материал из .mtl (Kd и map_Kd); у модели без .mtl - один белый материал
+struct OBJMaterial {
+    std::string name;
+    glm::vec3 diffuse = glm::vec3(1.0f);
+    std::string diffuseTexture;     // путь относительно .obj; пусто - текстура модели по умолчанию
+};
+
+// Непрерывный отрезок indices одного материала. Отрезки идут в порядке
+// материалов, на каждый материал - не больше одного
+struct OBJSubmesh {
+    unsigned int material = 0;
+    size_t firstIndex = 0;
+    size_t indexCount = 0;
+};
+
 class OBJModel {
 public:
     std::vector<OBJVertex> vertices;
     std::vector<GLuint> indices;
+    std::vector<OBJMaterial> materials;
+    std::vector<OBJSubmesh> submeshes;
+    size_t groupCount = 0;          // объектов и групп (o/g) в файле; на отрисовку не влияют
     
     GLuint VAO = 0, VBO = 0, EBO = 0;
-    size_t indexCount = 0;
+    size_t indexCount = 0;          // индексов в буфере на GPU
+    std::string name = "model";     // для учёта памяти: файл, из которого разобрана модель
     
     bool load(const std::string& filename) {
         std::cout << "Загружаем модель из " << filename << std::endl;
         
+        if (!parse(filename)) {
+            return createFallbackModel();
+        }
+        
+        setupBuffers();
+        
+        std::cout << "Модель загружена: " << vertices.size() << " вершин, "
+                  << indexCount << " индексов" << std::endl;
+        
+        return true;
+    }
+    
+    // Только разбор файла в vertices/indices, без обращений к OpenGL.
+    // deduplicate = false - каждая вершина грани отдельно (слияние делает
+    // компилятор ассетов, см. mesh_optimizer.h).
+    // Грани раскладываются по материалам (usemtl) в submeshes. Граням без
+    // нормалей нормали считаются: при "s off" - плоские, в группе сглаживания -
+    // средние по граням группы с общей вершиной
+    bool parse(const std::string& filename, bool deduplicate = true) {
+        vertices.clear();
+        indices.clear();
+        materials.clear();
+        submeshes.clear();
+        groupCount = 0;
+        indexCount = 0;
+        name = filename;
+        
         std::vector<glm::vec3> positions;
         std::vector<glm::vec2> texCoords;
         std::vector<glm::vec3> normals;
+
+        const std::string directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+        std::vector<std::vector<GLuint>> materialIndices;
+        unsigned int currentMaterial = 0;
+        bool materialSelected = false;
+        unsigned int smoothingGroup = 0;
+
+        // Вершины без нормали в группе сглаживания: нормаль зависит только от
+        // позиции и группы, поэтому вершина определяется (позиция, UV, группа)
+        std::map<std::array<unsigned int, 3>, unsigned int> smoothVertices;
+        std::map<std::array<unsigned int, 2>, glm::vec3> smoothNormals;
+        std::vector<std::array<unsigned int, 3>> pendingNormals;   // вершина, позиция, группа
         
         std::ifstream file(filename);
         if (!file.is_open()) {
             std::cerr << "Не получилось открыть файл: " << filename << std::endl;
-            return createFallbackModel();
+            return false;
         }
         
         std::string line;
@@ -65,9 +127,29 @@ public:
                 iss >> x >> y >> z;
                 normals.push_back(glm::normalize(glm::vec3(x, y, z)));
             }
+            else if (type == "mtllib") {
+                std::string library;
+                while (iss >> library) {
+                    loadMaterialLibrary(directory, library);
+                }
+            }
+            else if (type == "usemtl") {
+                std::string materialName;
+                iss >> materialName;
+                currentMaterial = findMaterial(materialName);
+                materialSelected = true;
+            }
+            else if (type == "o" || type == "g") {
+                groupCount++;
+            }
+            else if (type == "s") {
+                std::string group;
+                iss >> group;
+                smoothingGroup = (group == "off") ? 0 : static_cast<unsigned int>(std::strtoul(group.c_str(), nullptr, 10));
+            }
             else if (type == "f") {
                 std::string vertex;
-                std::vector<unsigned int> faceIndices;
+                std::vector<std::array<unsigned int, 3>> corners;
                 
                 while (iss >> vertex) {
                     unsigned int posIdx = 0, texIdx = 0, normIdx = 0;
@@ -97,20 +179,54 @@ public:
                         }
                     }
                     
+                    corners.push_back({posIdx, texIdx, normIdx});
+                }
+                if (corners.size() < 3) continue;
+
+                // Нормаль грани (по первому треугольнику) - для граней без vn
+                glm::vec3 faceNormal = glm::cross(positions[corners[1][0] - 1] - positions[corners[0][0] - 1],
+                                                  positions[corners[2][0] - 1] - positions[corners[0][0] - 1]);
+                
+                std::vector<unsigned int> faceIndices;
+                for (const std::array<unsigned int, 3>& corner : corners) {
+                    unsigned int posIdx = corner[0], texIdx = corner[1], normIdx = corner[2];
                     OBJVertex v;
                     v.position = positions[posIdx - 1];
                     v.texCoord = texIdx > 0 ? texCoords[texIdx - 1] : glm::vec2(0.0f);
-                    v.normal = normIdx > 0 ? normals[normIdx - 1] : glm::vec3(0.0f, 1.0f, 0.0f);
+                    v.normal = normIdx > 0 ? normals[normIdx - 1] : safeNormalize(faceNormal);
                     
-                    unsigned int idx = addVertex(v);
+                    unsigned int idx;
+                    if (normIdx == 0 && smoothingGroup != 0) {
+                        // Нормаль станет известна после всего файла; нулевая до тех
+                        // пор - чтобы с этой вершиной не слилась вершина с vn
+                        v.normal = glm::vec3(0.0f);
+                        smoothNormals[{posIdx, smoothingGroup}] += faceNormal;
+                        auto found = smoothVertices.find({posIdx, texIdx, smoothingGroup});
+                        if (deduplicate && found != smoothVertices.end()) {
+                            idx = found->second;
+                        } else {
+                            idx = appendVertex(v);
+                            smoothVertices[{posIdx, texIdx, smoothingGroup}] = idx;
+                            pendingNormals.push_back({idx, posIdx, smoothingGroup});
+                        }
+                    } else {
+                        idx = deduplicate ? addVertex(v) : appendVertex(v);
+                    }
                     faceIndices.push_back(idx);
                 }
+
+                if (!materialSelected) {
+                    currentMaterial = findMaterial("default");
+                    materialSelected = true;
+                }
+                if (materialIndices.size() <= currentMaterial) materialIndices.resize(currentMaterial + 1);
+                std::vector<GLuint>& target = materialIndices[currentMaterial];
                 
                 // Триангуляция
                 for (size_t i = 1; i < faceIndices.size() - 1; i++) {
-                    indices.push_back(faceIndices[0]);
-                    indices.push_back(faceIndices[i]);
-                    indices.push_back(faceIndices[i + 1]);
+                    target.push_back(faceIndices[0]);
+                    target.push_back(faceIndices[i]);
+                    target.push_back(faceIndices[i + 1]);
                 }
             }
         }
@@ -119,19 +235,61 @@ public:
         
         if (vertices.empty()) {
             std::cerr << "Модель пуста!" << std::endl;
-            return createFallbackModel();
+            return false;
+        }
+
+        for (const std::array<unsigned int, 3>& pending : pendingNormals) {
+            vertices[pending[0]].normal = safeNormalize(smoothNormals[{pending[1], pending[2]}]);
+        }
+
+        // Отрезки материалов подряд в одном буфере индексов
+        for (unsigned int material = 0; material < materialIndices.size(); material++) {
+            const std::vector<GLuint>& source = materialIndices[material];
+            if (source.empty()) continue;
+            OBJSubmesh submesh;
+            submesh.material = material;
+            submesh.firstIndex = indices.size();
+            submesh.indexCount = source.size();
+            submeshes.push_back(submesh);
+            indices.insert(indices.end(), source.begin(), source.end());
         }
         
         indexCount = indices.size();
-        setupBuffers();
-        
-        std::cout << "Модель загружена: " << vertices.size() << " вершин, "
-                  << indexCount << " индексов" << std::endl;
-        
         return true;
     }
+
+    // Модели нужны материалы MTL: несколько отрезков или единственный
+    // материал не белый либо с текстурой
+    bool usesMaterials() const {
+        if (submeshes.size() > 1) return true;
+        for (const OBJSubmesh& submesh : submeshes) {
+            const OBJMaterial& material = materials[submesh.material];
+            if (material.diffuse != glm::vec3(1.0f) || !material.diffuseTexture.empty()) return true;
+        }
+        return false;
+    }
+
+    // Один белый материал на весь буфер индексов - для моделей не из OBJ
+    // (.smesh, куб) и после загрузки другого LOD
+    void setSingleMaterial(size_t count) {
+        if (materials.empty()) {
+            materials.push_back(OBJMaterial());
+            materials.back().name = "default";
+        }
+        submeshes.assign(1, OBJSubmesh());
+        submeshes[0].indexCount = count;
+    }
     
+    // vertices/indices - на GPU; копия на CPU остаётся до releaseCpuCopy()
     void setupBuffers() {
+        uploadBuffers(vertices, indices);
+        ResourceRegistry::shared().track(cpuResource, (name + ": вершины и индексы").c_str(), RESOURCE_CPU_MIRROR,
+                                         vertices.capacity() * sizeof(OBJVertex) + indices.capacity() * sizeof(GLuint));
+    }
+
+    // Другие данные в те же буферы (например, грубее LOD); на CPU ничего не меняется.
+    // Отрезки материалов не трогаются - после другого LOD их задаёт вызывающий
+    void uploadBuffers(const std::vector<OBJVertex>& gpuVertices, const std::vector<GLuint>& gpuIndices) {
         if (VAO == 0) {
             glGenVertexArrays(1, &VAO);
             glGenBuffers(1, &VBO);
@@ -142,15 +300,22 @@ public:
         
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, 
-                    vertices.size() * sizeof(OBJVertex),
-                    vertices.data(),
+                    gpuVertices.size() * sizeof(OBJVertex),
+                    gpuVertices.data(),
                     GL_STATIC_DRAW);
         
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                    indices.size() * sizeof(GLuint),
-                    indices.data(),
+                    gpuIndices.size() * sizeof(GLuint),
+                    gpuIndices.data(),
                     GL_STATIC_DRAW);
+        indexCount = gpuIndices.size();
+
+        ResourceRegistry& registry = ResourceRegistry::shared();
+        registry.track(vertexResource, (name + ": вершины").c_str(), RESOURCE_BUFFER,
+                       gpuVertices.size() * sizeof(OBJVertex));
+        registry.track(indexResource, (name + ": индексы").c_str(), RESOURCE_BUFFER,
+                       gpuIndices.size() * sizeof(GLuint));
         
         // Layout
         // Position
@@ -183,13 +348,28 @@ public:
         glBindVertexArray(0);
     }
     
+    // Освободить vertices/indices после загрузки; буферы на GPU остаются
+    void releaseCpuCopy() {
+        std::vector<OBJVertex>().swap(vertices);
+        std::vector<GLuint>().swap(indices);
+        ResourceRegistry::shared().untrack(cpuResource);
+    }
+
+    bool hasCpuCopy() const { return !vertices.empty(); }
+
     void release() {
         if (EBO != 0) glDeleteBuffers(1, &EBO);
         if (VBO != 0) glDeleteBuffers(1, &VBO);
         if (VAO != 0) glDeleteVertexArrays(1, &VAO);
+        VAO = VBO = EBO = 0;
         
         vertices.clear();
         indices.clear();
+
+        ResourceRegistry& registry = ResourceRegistry::shared();
+        registry.untrack(vertexResource);
+        registry.untrack(indexResource);
+        registry.untrack(cpuResource);
     }
     
     ~OBJModel() {
@@ -198,7 +378,61 @@ public:
     
 private:
     std::unordered_map<std::string, unsigned int> vertexMap;
+    ResourceId vertexResource = NO_RESOURCE;
+    ResourceId indexResource = NO_RESOURCE;
+    ResourceId cpuResource = NO_RESOURCE;
     
+    static glm::vec3 safeNormalize(const glm::vec3& v) {
+        float length = glm::length(v);
+        return length > 0.0f ? v / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    unsigned int findMaterial(const std::string& materialName) {
+        for (size_t i = 0; i < materials.size(); i++) {
+            if (materials[i].name == materialName) return static_cast<unsigned int>(i);
+        }
+        // usemtl без описания в .mtl - белый материал с текстурой по умолчанию
+        materials.push_back(OBJMaterial());
+        materials.back().name = materialName;
+        return static_cast<unsigned int>(materials.size() - 1);
+    }
+
+    // newmtl, Kd и map_Kd; остальные параметры освещения шейдер не использует
+    void loadMaterialLibrary(const std::string& directory, const std::string& library) {
+        std::ifstream file(directory + library);
+        if (!file.is_open()) {
+            std::cerr << "Не получилось открыть библиотеку материалов: " << directory + library << std::endl;
+            return;
+        }
+
+        OBJMaterial* material = nullptr;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream iss(line);
+            std::string type;
+            iss >> type;
+
+            if (type == "newmtl") {
+                std::string materialName;
+                iss >> materialName;
+                material = &materials[findMaterial(materialName)];
+            }
+            else if (type == "Kd" && material) {
+                iss >> material->diffuse.x >> material->diffuse.y >> material->diffuse.z;
+            }
+            else if (type == "map_Kd" && material) {
+                // Путь - последнее слово строки, перед ним могут быть параметры (-s, -o ...)
+                std::string word;
+                while (iss >> word) material->diffuseTexture = directory + word;
+            }
+        }
+    }
+
+    unsigned int appendVertex(const OBJVertex& v) {
+        vertices.push_back(v);
+        return vertices.size() - 1;
+    }
+
     unsigned int addVertex(const OBJVertex& v) {
         // дедупликация
         for (size_t i = 0; i < vertices.size(); i++) {
@@ -211,6 +445,14 @@ private:
     }
     
     bool createFallbackModel() {
+        fillFallbackModel();
+        setupBuffers();
+        return true;
+    }
+    
+public:
+    // Куб в vertices/indices без обращений к OpenGL
+    void fillFallbackModel() {
         std::cout << "Создан куб вместо модели" << std::endl;
         
         vertices = {
@@ -236,7 +478,7 @@ private:
         };
         
         indexCount = indices.size();
-        setupBuffers();
-        return true;
+        materials.clear();
+        setSingleMaterial(indexCount);
     }
 };
\ No newline at end of file
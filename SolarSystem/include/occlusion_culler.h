@@ -0,0 +1,105 @@
+#pragma once
+
+#include "soft_rasterizer.h"
+#include "solar_system.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+// =====================================================
+// Отсечение перекрытых тел (иерархический Z-буфер на CPU)
+// =====================================================
+//
+// Несколько крупных тел (обычно Солнце) растеризуются в буфер глубины
+// низкого разрешения - SSE2 по 4 пикселя, только глубина. Из него строится
+// пирамида: каждый уровень хранит максимум (самую дальнюю глубину) 2x2
+// texels предыдущего. Ограничивающая сфера тела проецируется в экранный
+// прямоугольник, выбирается уровень, где он занимает не больше 2x2 texels,
+// и тело отсекается, если его ближайшая точка дальше всех этих texels.
+// Проверка консервативна: сфера, пересекающая ближнюю плоскость, видима.
+
+struct OcclusionStats {
+    size_t tested = 0;
+    size_t frustumCulled = 0;       // прямоугольник целиком за экраном
+    size_t occluded = 0;
+    size_t occluders = 0;
+    size_t occluderTriangles = 0;
+    double rasterSeconds = 0.0;
+    double pyramidSeconds = 0.0;
+    double testSeconds = 0.0;
+
+    size_t visible() const { return tested - frustumCulled - occluded; }
+    double totalSeconds() const { return rasterSeconds + pyramidSeconds + testSeconds; }
+};
+
+class OcclusionCuller {
+public:
+    // Ширина округляется вверх до кратной 4
+    OcclusionCuller(int width, int height, ThreadPool& pool);
+
+    // Очистить буфер глубины и запомнить камеру кадра
+    void beginFrame(const glm::mat4& view, const glm::mat4& projection);
+
+    // Растеризовать меш как перекрывающий объект (задние грани отбрасываются, как GL_BACK)
+    void addOccluder(const SoftMesh& mesh, const glm::mat4& model);
+
+    void buildPyramid();
+
+    // Сфера в мировых координатах; false - за экраном или перекрыта
+    bool isSphereVisible(const glm::vec3& center, float radius) const;
+
+    // Индексы до maxCount тел, чья сфера занимает на экране не меньше minScreenFraction по высоте.
+    // Ссылка на внутренний буфер - действительна до следующего вызова.
+    const std::vector<uint32_t>& selectOccluders(const std::vector<CelestialBody>& bodies, float meshRadius,
+                                                 size_t maxCount, float minScreenFraction = 0.1f);
+
+    // Проверить все тела параллельно и записать индексы видимых (порядок сохраняется)
+    void cullBodies(const std::vector<CelestialBody>& bodies, float meshRadius,
+                    std::vector<uint32_t>& visible);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t getLevelCount() const { return levels.size(); }
+    const float* getDepthBuffer() const { return levels[0].depth.data(); }
+
+    const OcclusionStats& getStats() const { return stats; }
+
+private:
+    enum SphereResult { SPHERE_VISIBLE, SPHERE_OFFSCREEN, SPHERE_OCCLUDED };
+
+    struct Level {
+        int width = 0;
+        int height = 0;
+        std::vector<float> depth;
+    };
+
+    SphereResult testSphere(const glm::vec3& center, float radius) const;
+    void rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+    int width = 0;
+    int height = 0;
+
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+
+    std::vector<Level> levels;
+    std::vector<glm::vec4> clipVertices;
+
+    // Раскладка по кускам для параллельного сжатия индексов
+    std::vector<size_t> chunkCounts;
+    std::vector<uint8_t> results;
+
+    std::vector<std::pair<float, uint32_t>> occluderCandidates;
+    std::vector<uint32_t> occluders;
+
+    ThreadPool& pool;
+    OcclusionStats stats;
+};
+
+// Радиус ограничивающей сферы меша относительно начала координат модели
+float meshBoundingRadius(const SoftMesh& mesh);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Окружность орбиты в плоскости XZ: segments + 1 точек (x, y, z) подряд
+std::vector<float> createOrbitCircle(float radius, int segments = 100);
+
+// Цвет орбиты тела с индексом bodyIndex (тело 0 - центральное, без орбиты)
+glm::vec3 orbitColor(size_t bodyIndex);
+
+// =====================================================
+// Уровни тесселяции орбит
+// =====================================================
+//
+// Все орбиты рисуются из одного буфера единичных окружностей: уровень k -
+// ORBIT_MIN_SEGMENTS << k отрезков. Центр и радиус орбиты применяются при
+// рисовании, а уровень выбирается каждый кадр по размеру орбиты на экране:
+// хорда отрезка отходит от дуги не дальше допуска в пикселях. Геометрия
+// строится один раз и между кадрами не меняется.
+
+const int ORBIT_MIN_SEGMENTS = 8;
+const int ORBIT_LEVEL_COUNT = 9;    // 8 ... 2048 отрезков
+
+// Отрезок буфера уровней в вершинах (segments + 1 точек, замкнутая ломаная)
+struct OrbitLevel {
+    int first;
+    int count;
+};
+
+// Единичные окружности всех уровней подряд, по 3 float на вершину
+void buildOrbitLevels(std::vector<float>& vertices, std::vector<OrbitLevel>& levels);
+
+// Радиус орбиты в пикселях для оценки ошибки: по ближайшей к камере точке
+// окружности, поэтому ни один участок орбиты не крупнее оценки.
+// focalPixels = projection[1][1] * высота окна / 2
+float orbitRadiusPixels(const glm::vec3& center, float radius, const glm::vec3& cameraPosition,
+                        float focalPixels);
+
+// Наименьшее число отрезков, при котором хорда отходит от окружности
+// радиуса radiusPixels не больше чем на tolerancePixels
+int orbitSegmentsForError(float radiusPixels, float tolerancePixels);
+
+// Наименьший уровень не грубее segments (последний, если такого нет)
+int orbitLevelForSegments(int segments);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "camera.h"
+#include "mesh_bvh.h"
+#include "solar_system.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// =====================================================
+// Выбор тела лучом из точки экрана
+// =====================================================
+//
+// Широкая фаза - ограничивающие сферы тел (радиус меша * scale), кандидаты
+// сортируются по входу в сферу. Узкая фаза - луч переводится в координаты
+// меша обратной матрицей getModelMatrix() и проверяется по общему BVH меша;
+// перебор кандидатов прекращается, как только вход в сферу дальше уже
+// найденного пересечения. Направление в координатах меша не нормируется,
+// поэтому расстояние по лучу одно и то же в обоих пространствах.
+// Широкая фаза идёт параллельно по кускам тел.
+
+struct PickRay {
+    glm::vec3 origin;
+    glm::vec3 direction;            // единичный
+};
+
+// x, y - пиксели от левого верхнего угла окна
+PickRay screenRay(const Camera& camera, float x, float y, float width, float height);
+
+struct PickResult {
+    bool hit = false;
+    uint32_t body = 0;
+    float distance = 0.0f;
+    glm::vec3 point = glm::vec3(0.0f);
+    uint32_t triangle = 0;
+    size_t candidates = 0;          // тел прошло широкую фазу
+    size_t meshTests = 0;           // из них проверено по BVH
+};
+
+class BodyPicker {
+public:
+    explicit BodyPicker(ThreadPool& pool);
+
+    PickResult pick(const std::vector<CelestialBody>& bodies, const MeshBVH& mesh,
+                    float meshRadius, const PickRay& ray);
+
+private:
+    struct Candidate {
+        float enter;
+        uint32_t body;
+    };
+    ThreadPool& pool;
+    std::vector<std::vector<Candidate>> workerCandidates;
+    std::vector<Candidate> candidates;
+};
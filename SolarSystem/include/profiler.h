@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// =====================================================
+// Профилировщик кадра
+// =====================================================
+//
+// Замеры пишутся в кольцевой буфер без блокировок (несколько писателей,
+// один читатель). Основной поток раз в кадр забирает их в агрегаты и
+// в историю для экспорта в формат Chrome trace (chrome://tracing, Perfetto).
+// Выключенный профилировщик стоит одну relaxed-загрузку флага на замер;
+// при сборке без SOLAR_PROFILER макросы не генерируют кода вовсе.
+
+enum class ProfileTrack : uint8_t {
+    CPU,
+    GPU
+};
+
+struct ProfileEvent {
+    const char* name;       // строковый литерал, не копируется
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint32_t threadId;
+    uint32_t frame;
+    ProfileTrack track;
+};
+
+// Ограниченная MPSC очередь (схема Вьюкова); при переполнении замер теряется
+class ProfileRing {
+public:
+    explicit ProfileRing(size_t capacityPow2);
+
+    bool push(const ProfileEvent& event);
+    bool pop(ProfileEvent& event);
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        ProfileEvent event;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+    alignas(64) std::atomic<uint64_t> writeIndex{0};
+    alignas(64) uint64_t readIndex = 0;
+    std::atomic<uint64_t> dropped{0};
+};
+
+class Profiler {
+public:
+    static Profiler& instance();
+
+    void setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Сохранять историю событий для экспорта трассы
+    void setTraceCapture(bool value) { captureTrace = value; }
+
+    // Интервал печати сводки в секундах (0 - не печатать)
+    void setSummaryInterval(double seconds) { summaryInterval = seconds; }
+
+    void beginFrame();
+    void endFrame();
+
+    void record(const char* name, uint64_t startNs, uint64_t durationNs,
+                ProfileTrack track = ProfileTrack::CPU);
+
+    // Забрать события из кольца (только основной поток)
+    void collect();
+
+    void printSummary();
+    bool exportChromeTrace(const std::string& filename);
+
+    uint32_t currentFrame() const { return frameIndex; }
+
+    static uint64_t nowNs();
+    static uint32_t currentThreadId();
+
+private:
+    Profiler();
+
+    struct ScopeStats {
+        const char* name;
+        ProfileTrack track;
+        uint64_t calls = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+    };
+
+    ScopeStats& statsFor(const char* name, ProfileTrack track);
+
+    std::atomic<bool> enabled{false};
+    bool captureTrace = false;
+    double summaryInterval = 5.0;
+
+    ProfileRing ring;
+    std::vector<ScopeStats> scopes;
+    std::vector<ProfileEvent> trace;
+
+    uint32_t frameIndex = 0;
+    uint64_t frameStartNs = 0;
+    uint64_t intervalStartNs = 0;
+    uint64_t intervalFrames = 0;
+    uint64_t intervalFrameNs = 0;
+    uint64_t intervalMaxFrameNs = 0;
+};
+
+// RAII-замер участка кода на CPU
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(Profiler::instance().isEnabled() ? name : nullptr),
+          startNs(this->name ? Profiler::nowNs() : 0) {}
+
+    ~ProfileScope() {
+        if (name) {
+            Profiler::instance().record(name, startNs, Profiler::nowNs() - startNs);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#ifdef SOLAR_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
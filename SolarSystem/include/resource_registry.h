@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// =====================================================
+// Учёт памяти ресурсов
+// =====================================================
+//
+// Реестр размеров всех буферов и текстур на GPU и копий их данных в памяти
+// процесса. Владелец ресурса хранит ResourceId и сообщает новый размер при
+// каждом изменении; обновление размера не выделяет память, поэтому годится
+// для цикла кадра. Для GPU и CPU задаются бюджеты: превышение проверяет
+// приложение и само решает, что ужать (уровни текстур, LOD модели, копии
+// на CPU). Сам реестр OpenGL не вызывает.
+
+using ResourceId = uint32_t;
+const ResourceId NO_RESOURCE = UINT32_MAX;
+
+enum ResourceKind : uint32_t {
+    RESOURCE_BUFFER = 0,        // буфер OpenGL
+    RESOURCE_TEXTURE = 1,       // текстура или renderbuffer
+    RESOURCE_CPU_MIRROR = 2     // копия данных, уже загруженных на GPU
+};
+
+enum MemoryDomain : uint32_t {
+    MEMORY_GPU = 0,
+    MEMORY_CPU = 1,
+    MEMORY_DOMAIN_COUNT = 2
+};
+
+MemoryDomain resourceDomain(ResourceKind kind);
+
+// Байт текстуры с levels уровнями mip (0 - вся цепочка до 1x1)
+size_t mipChainBytes(uint32_t width, uint32_t height, uint32_t bytesPerTexel, uint32_t levels = 0);
+
+struct ResourceRecord {
+    std::string name;
+    ResourceKind kind = RESOURCE_BUFFER;
+    size_t bytes = 0;
+    bool live = false;
+};
+
+class ResourceRegistry {
+public:
+    // id == NO_RESOURCE - новая запись (id заполняется), иначе новый размер.
+    // name копируется только при создании записи
+    void track(ResourceId& id, const char* name, ResourceKind kind, size_t bytes);
+    // Ресурс освобождён; id сбрасывается в NO_RESOURCE
+    void untrack(ResourceId& id);
+
+    size_t totalBytes(MemoryDomain domain) const;
+    size_t peakBytes(MemoryDomain domain) const;
+
+    // 0 - без ограничения
+    void setBudget(MemoryDomain domain, size_t bytes);
+    size_t getBudget(MemoryDomain domain) const;
+    bool overBudget(MemoryDomain domain) const;
+
+    // Живые записи по убыванию размера
+    std::vector<ResourceRecord> snapshot() const;
+    // Таблица ресурсов, итоги, пики и бюджеты
+    std::string formatReport() const;
+
+    // Общий реестр приложения
+    static ResourceRegistry& shared();
+
+private:
+    mutable std::mutex mutex;
+    std::vector<ResourceRecord> records;
+    size_t totals[MEMORY_DOMAIN_COUNT] = {};
+    size_t peaks[MEMORY_DOMAIN_COUNT] = {};
+    size_t budgets[MEMORY_DOMAIN_COUNT] = {};
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "solar_system.h"
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// =====================================================
+// Процедурная галактика
+// =====================================================
+//
+// Сцена из bodyCount тел (от десятка до десятков миллионов) по seed.
+// Вложенность: галактика - диск со спиральными рукавами из скоплений,
+// скопление - облако звёздных систем, система - звезда в центре и планеты
+// вокруг неё. Радиусы орбит в системе растут геометрически, скорость
+// убывает по Кеплеру (~ r^-1.5) и растёт с массой звезды, мелких планет
+// больше, чем крупных.
+//
+// Каждая система строится своим генератором, засеянным от seed и номера
+// системы, поэтому системы строятся параллельно, а результат побитно
+// одинаков при любом числе потоков. Спутников у планет нет: центр орбиты
+// CelestialBody неподвижен.
+
+struct GalaxyParams {
+    size_t bodyCount = 1000;
+    uint64_t seed = 1;
+    uint32_t clusterCount = 0;      // 0 - около корня из числа систем
+    uint32_t arms = 4;              // спиральных рукавов
+    uint32_t minPlanets = 1;
+    uint32_t maxPlanets = 12;
+    float systemSpacing = 60.0f;    // среднее расстояние между соседними системами
+    float thickness = 0.05f;        // толщина диска в долях радиуса
+};
+
+struct GalaxyStats {
+    size_t clusters = 0;
+    size_t systems = 0;
+    size_t bodies = 0;
+    float radius = 0.0f;            // радиус диска
+    double seconds = 0.0;
+
+    double bodiesPerSecond() const { return seconds > 0.0 ? bodies / seconds : 0.0; }
+};
+
+// Заменяет тела system сгенерированными; системы делятся между потоками пула
+void generateGalaxy(const GalaxyParams& params, SolarSystem& system, ThreadPool& pool,
+                    GalaxyStats* stats = nullptr);
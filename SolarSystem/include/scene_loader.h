@@ -0,0 +1,86 @@
+#pragma once
+
+#include "solar_system.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// =====================================================
+// Форматы сцены
+// =====================================================
+//
+// Текстовый (.scene) - по одному телу на строку:
+//   body <orbitRadius> <orbitSpeed> <rotationSpeed> <scale> [<cx> <cy> <cz>]
+// Строки, начинающиеся с '#', и пустые строки пропускаются.
+//
+// Бинарный колоночный (.sscn) - заголовок, таблица колонок и сами колонки
+// float32 (little-endian), каждая выровнена по 64 байтам. Файл отображается
+// в память и читается кусками, поэтому память не растёт с размером сцены.
+
+const uint32_t SCENE_BINARY_VERSION = 1;
+
+enum SceneColumn : uint32_t {
+    SCENE_COL_ORBIT_RADIUS = 0,
+    SCENE_COL_ORBIT_SPEED,
+    SCENE_COL_ROTATION_SPEED,
+    SCENE_COL_SCALE,
+    SCENE_COL_CENTER_X,
+    SCENE_COL_CENTER_Y,
+    SCENE_COL_CENTER_Z,
+    SCENE_COL_ORBIT_ANGLE,
+    SCENE_COL_ROTATION_ANGLE,
+    SCENE_COLUMN_COUNT
+};
+
+// Доступ к полю тела по номеру колонки
+float sceneColumnValue(const CelestialBody& body, uint32_t column);
+float* sceneColumnField(CelestialBody& body, uint32_t column);
+
+struct SceneFileHeader {
+    char magic[4];          // "SSCN"
+    uint32_t version;
+    uint64_t bodyCount;
+    uint32_t columnCount;
+    uint32_t reserved;
+};
+
+struct SceneColumnDesc {
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t offset;        // от начала файла
+};
+
+// Статистика загрузки для замеров пропускной способности
+struct SceneLoadStats {
+    size_t bodyCount = 0;
+    size_t bytesRead = 0;
+    double seconds = 0.0;
+
+    double bodiesPerSecond() const { return seconds > 0.0 ? bodyCount / seconds : 0.0; }
+    double megabytesPerSecond() const { return seconds > 0.0 ? bytesRead / seconds / (1024.0 * 1024.0) : 0.0; }
+};
+
+// Получает очередной кусок тел; память под кусок переиспользуется
+using SceneChunkCallback = std::function<void(const CelestialBody* bodies, size_t count)>;
+
+const size_t SCENE_DEFAULT_CHUNK = 64 * 1024;
+
+// Потоковое чтение: тела выдаются кусками не больше chunkSize.
+// Формат выбирается по расширению (.sscn - бинарный, иначе текстовый).
+bool streamScene(const std::string& filename, const SceneChunkCallback& callback,
+                 size_t chunkSize = SCENE_DEFAULT_CHUNK, SceneLoadStats* stats = nullptr);
+
+// Загрузить сцену в систему (предыдущие тела удаляются)
+bool loadScene(const std::string& filename, SolarSystem& system, SceneLoadStats* stats = nullptr);
+
+bool saveSceneText(const std::string& filename, const SolarSystem& system);
+bool saveSceneBinary(const std::string& filename, const SolarSystem& system);
+
+// Сохранить в формате, определённом по расширению
+bool saveScene(const std::string& filename, const SolarSystem& system);
+
+bool isBinarySceneFile(const std::string& filename);
+
+// Встроенная сцена: Солнце и шесть планет
+void buildDefaultScene(SolarSystem& system);
@@ -3,15 +3,32 @@
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 #include <string>
 
+class ProgramCache;
+
+// Варианты основного шейдера: каждая возможность - #define при компиляции
+// одного и того же исходника, лишние ветки в GLSL не попадают
+enum ShaderFeature : uint32_t {
+    SHADER_SPECULAR = 1 << 0,           // блик по Фонгу
+    SHADER_TEXTURED = 1 << 1,           // цвет из текстуры, иначе ровный серый
+    SHADER_COMPACT_INSTANCES = 1 << 2,  // инстанс - 3 строки аффинной матрицы (48 байт вместо 64)
+    SHADER_CLUSTERED_LIGHTS = 1 << 3,   // источники из списков кластеров вместо одного lightPos
+};
+
+const uint32_t SHADER_DEFAULT_FEATURES = SHADER_SPECULAR | SHADER_TEXTURED;
+
+// Строки #define для набора возможностей
+std::string shaderFeatureDefines(uint32_t features);
+
 class InstancedShader {
 public:
     GLuint programID;
     
-    // Конструктор для инстанцированного шейдера
-    InstancedShader();
+    // Конструктор для инстанцированного шейдера; вариант берётся из кэша программ
+    InstancedShader(ProgramCache& cache, uint32_t features = SHADER_DEFAULT_FEATURES);
     
     // Деструктор
     ~InstancedShader();
@@ -19,14 +36,17 @@ public:
     // Использовать программу
     void use() const;
     
-    // Установить uniform переменные
-    void setMat4(const std::string& name, const glm::mat4& mat) const;
-    void setVec3(const std::string& name, const glm::vec3& vec) const;
-    void setFloat(const std::string& name, float value) const;
-    void setInt(const std::string& name, int value) const;
+    // Установить uniform переменные (имя - литерал, без временных std::string)
+    void setMat4(const char* name, const glm::mat4& mat) const;
+    void setVec3(const char* name, const glm::vec3& vec) const;
+    void setFloat(const char* name, float value) const;
+    void setInt(const char* name, int value) const;
+
+    bool isValid() const { return programID != 0; }
+    uint32_t getFeatures() const { return features; }
     
 private:
-    void checkCompileErrors(GLuint shader, const std::string& type);
+    uint32_t features;
 };
 
 extern const char* orbitVertexShader;
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// =====================================================
+// Кэш слинкованных программ на диске
+// =====================================================
+//
+// Программа собирается из исходников вершинного и фрагментного шейдеров и
+// строки #define (варианта); defines вставляются сразу после #version.
+// Готовый бинарник из glGetProgramBinary сохраняется в directory под ключом -
+// хэшем от драйвера (GL_VENDOR, GL_RENDERER, GL_VERSION) и итоговых исходников,
+// так что обновление драйвера или правка шейдера дают промах, а не чужой
+// бинарник. При следующем запуске программа загружается glProgramBinary без
+// компиляции; если драйвер её не принял - компилируется заново и файл
+// перезаписывается. Без ARB_get_program_binary кэш выключен.
+
+struct ProgramCacheStats {
+    size_t hits = 0;                // загружено из кэша
+    size_t misses = 0;              // скомпилировано из исходников
+    size_t rejected = 0;            // файл был, но драйвер его не принял
+    double loadSeconds = 0.0;
+    double compileSeconds = 0.0;
+};
+
+// Исходник с defines сразу после строки #version
+std::string injectDefines(const char* source, const std::string& defines);
+
+class ProgramCache {
+public:
+    // directory пустая - без кэша, программы всегда компилируются
+    void init(const std::string& directory);
+
+    // 0 - ошибка компиляции или линковки (текст в std::cerr)
+    GLuint build(const char* name, const char* vertexSource, const char* fragmentSource,
+                 const std::string& defines = std::string());
+
+    bool isEnabled() const { return enabled; }
+    const ProgramCacheStats& getStats() const { return stats; }
+
+private:
+    GLuint load(const std::string& path, uint64_t key);
+    void store(const std::string& path, uint64_t key, GLuint program);
+
+    bool enabled = false;
+    std::string directory;
+    std::string driver;
+    ProgramCacheStats stats;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "solar_system.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+// =====================================================
+// Поток состояний тел на диск (.ssim)
+// =====================================================
+//
+// Заголовок SimStreamHeader, затем кадры: SimFrameHeader и zlib-поток
+// с данными кадра. Данные кадра - положения всех тел (3 float на тело),
+// затем аффинные части матриц модели (3 строки по 4 float; нижняя строка
+// всегда 0 0 0 1 и не хранится). Какие части есть - флаги заголовка.
+//
+// Запись двухбуферная: поток симуляции заполняет один буфер, пока фоновый
+// поток сжимает и пишет другой. Поток симуляции ждёт, только если диск
+// или сжатие не успевают за двумя кадрами подряд.
+
+const uint32_t SIM_STREAM_VERSION = 1;
+
+enum SimStreamFlags : uint32_t {
+    SIM_STREAM_POSITIONS = 1u << 0,
+    SIM_STREAM_MATRICES = 1u << 1
+};
+
+struct SimStreamHeader {
+    char magic[4];                  // "SSIM"
+    uint32_t version;
+    uint64_t bodyCount;
+    uint32_t stride;                // шагов симуляции между кадрами
+    uint32_t flags;                 // SimStreamFlags
+    float deltaTime;                // шаг симуляции
+    uint32_t reserved;
+};
+
+struct SimFrameHeader {
+    uint64_t step;
+    double time;                    // SolarSystem::getTime()
+    uint64_t rawSize;               // байт до сжатия
+    uint64_t compressedSize;        // байт zlib-потока после заголовка
+};
+
+// Байт данных одного кадра до сжатия
+size_t simFrameSize(size_t bodyCount, uint32_t flags);
+
+// Данные кадра в out (simFrameSize байт), тела делятся между потоками пула
+void captureSimFrame(const SolarSystem& system, uint32_t flags, unsigned char* out, ThreadPool& pool);
+
+struct SimStreamStats {
+    size_t frames = 0;
+    size_t rawBytes = 0;
+    size_t compressedBytes = 0;     // с заголовками
+    double compressSeconds = 0.0;   // фоновый поток
+    double writeSeconds = 0.0;      // фоновый поток
+    double stallSeconds = 0.0;      // поток симуляции ждал свободный буфер
+
+    double compressionRatio() const { return compressedBytes > 0 ? double(rawBytes) / compressedBytes : 0.0; }
+};
+
+class SimStreamWriter {
+public:
+    SimStreamWriter() = default;
+    ~SimStreamWriter();
+
+    SimStreamWriter(const SimStreamWriter&) = delete;
+    SimStreamWriter& operator=(const SimStreamWriter&) = delete;
+
+    // level - уровень zlib 0..9 (1 - быстрее всего со сжатием)
+    bool open(const std::string& filename, size_t bodyCount, uint32_t stride, uint32_t flags,
+              float deltaTime, int level);
+    // Дописывает очередь и закрывает файл; false - была ошибка сжатия или записи
+    bool close();
+
+    // Свободный буфер на simFrameSize байт; ждёт, если оба ещё в записи
+    unsigned char* acquireFrame();
+    // Отдать буфер из acquireFrame фоновому потоку
+    void submitFrame(uint64_t step, double time);
+
+    const SimStreamStats& getStats() const { return stats; }
+    size_t getFrameSize() const { return frameSize; }
+
+private:
+    struct Slot {
+        std::vector<unsigned char> data;
+        uint64_t step = 0;
+        double time = 0.0;
+        bool queued = false;        // ждёт записи или пишется
+    };
+
+    void writerLoop();
+    bool writeFrame(const Slot& slot, std::vector<unsigned char>& compressed);
+
+    std::FILE* file = nullptr;
+    size_t frameSize = 0;
+    int level = 1;
+
+    Slot slots[2];
+    size_t current = 0;             // слот, который заполняет поток симуляции
+    size_t next = 0;                // слот, который запишется следующим
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable queuedChanged;
+    bool closing = false;
+    bool failed = false;
+    SimStreamStats stats;
+};
+
+// Последовательное чтение .ssim, кадр за кадром
+class SimStreamReader {
+public:
+    ~SimStreamReader();
+
+    bool open(const std::string& filename);
+    void close();
+
+    const SimStreamHeader& getHeader() const { return header; }
+
+    // Следующий кадр, data - simFrameSize байт; false - конец файла или ошибка
+    bool readFrame(SimFrameHeader& frame, std::vector<unsigned char>& data);
+
+private:
+    std::FILE* file = nullptr;
+    SimStreamHeader header = {};
+    std::vector<unsigned char> compressed;
+};
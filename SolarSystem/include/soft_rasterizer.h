@@ -0,0 +1,131 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+struct OBJVertex;
+
+// =====================================================
+// Программный растеризатор
+// =====================================================
+//
+// Рисует ту же сцену, что и render(), без GPU: инстансы модели с освещением
+// по Фонгу из fragmentShaderSource и линии орбит. Кадр делится на тайлы
+// 64x64; треугольники после отсечения раскладываются по корзинам тайлов
+// (у каждого потока свои корзины), затем тайлы растеризуются параллельно.
+// Функции рёбер считаются сразу для 4 пикселей (SSE2, иначе скалярно).
+
+// Текстура RGBA8, строка 0 соответствует v = 0 (как после flipVertically)
+struct SoftTexture {
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> texels;
+
+    // Билинейная выборка с GL_REPEAT
+    glm::vec4 sample(glm::vec2 uv) const;
+
+    // Заглушка 4x4, как в loadSimpleTexture
+    static SoftTexture solid(glm::vec3 color);
+};
+
+struct SoftMesh {
+    const OBJVertex* vertices = nullptr;
+    size_t vertexCount = 0;
+    const unsigned int* indices = nullptr;
+    size_t indexCount = 0;
+};
+
+struct SoftRasterStats {
+    size_t trianglesSubmitted = 0;
+    size_t trianglesBinned = 0;     // после отсечения и отбраковки задних граней
+    size_t pixelsShaded = 0;
+    size_t linesDrawn = 0;
+    double seconds = 0.0;
+
+    double trianglesPerSecond() const { return seconds > 0.0 ? trianglesSubmitted / seconds : 0.0; }
+    double pixelsPerSecond() const { return seconds > 0.0 ? pixelsShaded / seconds : 0.0; }
+};
+
+class SoftRasterizer {
+public:
+    SoftRasterizer(int width, int height, ThreadPool& pool);
+
+    void resize(int width, int height);
+
+    void clear(glm::vec3 color);
+    void setCamera(const glm::mat4& view, const glm::mat4& projection);
+
+    // Ломаная из count точек (x, y, z подряд) без теста глубины, как renderOrbits
+    void drawLineStrip(const float* points, size_t count, glm::vec3 color);
+
+    void drawMeshInstanced(const SoftMesh& mesh, const glm::mat4* instances, size_t instanceCount,
+                           const SoftTexture& texture, glm::vec3 lightPos);
+
+    // Сохранить кадр в PPM (P6)
+    bool writePPM(const std::string& filename) const;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const uint32_t* getColorBuffer() const { return color.data(); }
+    const float* getDepthBuffer() const { return depth.data(); }
+
+    const SoftRasterStats& getStats() const { return stats; }
+    void resetStats() { stats = SoftRasterStats(); }
+
+    static const int TILE_SIZE = 64;
+
+private:
+    struct ClipVertex {
+        glm::vec4 clip;
+        glm::vec3 world;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+
+    // Треугольник после настройки: экранные координаты и атрибуты, делённые на w
+    struct SetupTriangle {
+        float edgeA[3], edgeB[3], edgeC[3];
+        bool topLeft[3];
+        float invArea;
+        float z[3];
+        float invW[3];
+        glm::vec2 uvOverW[3];
+        glm::vec3 normalOverW[3];
+        glm::vec3 worldOverW[3];
+        int minX, minY, maxX, maxY;
+    };
+
+    void clipAndSetup(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c,
+                      size_t worker);
+    void setupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c,
+                       size_t worker);
+    void rasterizeTile(size_t tile, const SoftTexture& texture, glm::vec3 lightPos,
+                       size_t& pixelsShaded);
+    void rasterizeTriangle(const SetupTriangle& tri, int x0, int y0, int x1, int y1,
+                           const SoftTexture& texture, glm::vec3 lightPos, size_t& pixelsShaded);
+
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+
+    std::vector<uint32_t> color;
+    std::vector<float> depth;
+
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+
+    ThreadPool& pool;
+
+    // Буферы пакета переиспользуются между кадрами
+    std::vector<ClipVertex> clipVertices;
+    std::vector<std::vector<SetupTriangle>> workerTriangles;
+    std::vector<std::vector<std::vector<uint32_t>>> workerBins;
+
+    SoftRasterStats stats;
+};
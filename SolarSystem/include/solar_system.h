@@ -3,6 +3,8 @@
 #include <glm/glm.hpp>
 #include <vector>
 
+class ThreadPool;
+
 // Структура для описания орбитального объекта
 struct CelestialBody {
     float orbitRadius;
@@ -26,16 +28,27 @@ public:
     SolarSystem();
 
     void addBody(const CelestialBody& body);
+    void reserve(size_t count) { bodies.reserve(count); }
+    void clear() { bodies.clear(); time = 0.0; }
 
     void update(float deltaTime = 1.0f);
+    // То же, тела делятся между потоками пула; результат совпадает побитно
+    void update(float deltaTime, ThreadPool& pool);
 
     const std::vector<CelestialBody>& getBodies() const { return bodies; }
     std::vector<CelestialBody>& getBodies() { return bodies; }
 
     size_t getBodyCount() const { return bodies.size(); }
 
+    // Суммарное время симуляции (сумма deltaTime всех update)
+    double getTime() const { return time; }
+    void setTime(double value) { time = value; }
+
     std::vector<glm::mat4> getModelMatrices() const;
+    // То же без выделения памяти: out - не меньше getBodyCount() матриц
+    void writeModelMatrices(glm::mat4* out) const;
 
 private:
     std::vector<CelestialBody> bodies;
+    double time = 0.0;
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// =====================================================
+// Граф стадий запуска
+// =====================================================
+//
+// Стадия запускается, когда завершены все её зависимости. Стадии MAIN
+// обращаются к OpenGL и выполняются только на вызывающем потоке (там
+// контекст), стадии ANY - на любом потоке пула. Пока главный поток
+// компилирует шейдеры и заливает буферы, остальные разбирают файлы и
+// строят сцену. Главный поток берёт стадии ANY, только если в пуле один
+// поток или стадий MAIN больше не осталось, чтобы не задерживать GL.
+//
+// Граф выполняется через ThreadPool::runOnAll, поэтому parallelFor того же
+// пула внутри стадии выполняется последовательно на её потоке. Большую
+// параллельную работу лучше сделать до run().
+
+enum class StageThread {
+    ANY,
+    MAIN,
+};
+
+struct StageTiming {
+    std::string name;
+    StageThread thread;
+    size_t worker = 0;              // на каком потоке пула выполнилась
+    double startSeconds = 0.0;      // от начала run()
+    double seconds = 0.0;
+};
+
+class StartupGraph {
+public:
+    using StageId = size_t;
+
+    StageId add(const char* name, StageThread thread, std::initializer_list<StageId> dependencies,
+                std::function<void()> work);
+
+    // Выполнить все стадии; вызывать с потока, где активен GL-контекст
+    void run(ThreadPool& pool);
+
+    const std::vector<StageTiming>& getTimings() const { return timings; }
+    double getWallSeconds() const { return wallSeconds; }
+
+    // Таблица стадий по времени начала и суммарная параллельность
+    void printReport() const;
+
+private:
+    struct Stage {
+        std::function<void()> work;
+        std::vector<StageId> dependents;
+        size_t remaining = 0;       // незавершённых зависимостей
+        bool started = false;
+    };
+
+    std::vector<Stage> stages;
+    std::vector<StageTiming> timings;
+    double wallSeconds = 0.0;
+};
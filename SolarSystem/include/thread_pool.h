@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Невладеющая ссылка на вызываемый объект. В отличие от std::function
+// никогда не выделяет память (лямбда с несколькими захватами по ссылке
+// в std::function уходит в кучу), поэтому годится для цикла кадра.
+// Объект должен жить, пока идёт вызов - для parallelFor это так.
+template <typename Signature>
+class FunctionRef;
+
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, FunctionRef>::value>>
+    FunctionRef(F&& function)
+        : object(const_cast<void*>(static_cast<const void*>(&function))),
+          invoke([](void* target, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<F>*>(target))(std::forward<Args>(args)...);
+          }) {
+    }
+
+    R operator()(Args... args) const {
+        return invoke(object, std::forward<Args>(args)...);
+    }
+
+private:
+    void* object;
+    R (*invoke)(void*, Args...);
+};
+
+// Пул потоков для параллельных циклов. Вызывающий поток тоже участвует
+// в работе, поэтому threadCount = 1 означает последовательное выполнение.
+// Вызов из задачи того же пула (например, из стадии StartupGraph)
+// выполняется сразу на текущем потоке: остальные потоки заняты этой же
+// задачей, и ожидание их привело бы к взаимной блокировке.
+class ThreadPool {
+public:
+    // 0 - по числу аппаратных потоков
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t threadCount() const { return workers.size() + 1; }
+
+    // Выполнить job(workerIndex) на всех потоках и дождаться завершения
+    void runOnAll(FunctionRef<void(size_t worker)> job);
+
+    // Текущий поток выполняет задачу этого пула
+    bool insideJob() const;
+
+    // Разбить [0, count) на куски по grain и обработать параллельно
+    void parallelFor(size_t count, size_t grain,
+                     FunctionRef<void(size_t begin, size_t end, size_t worker)> body);
+
+    // Общий пул приложения
+    static ThreadPool& shared();
+
+private:
+    void workerLoop(size_t index);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const FunctionRef<void(size_t)>* currentJob = nullptr;
+    uint64_t generation = 0;
+    size_t pending = 0;
+    bool stopping = false;
+};
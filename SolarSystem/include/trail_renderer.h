@@ -0,0 +1,65 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "resource_registry.h"
+#include "solar_system.h"
+#include <cstddef>
+#include <vector>
+
+// =====================================================
+// Следы орбит в кольцевом буфере на GPU
+// =====================================================
+//
+// Последние historyLength положений каждого тела лежат в одном буфере
+// по слотам: слот s - положения всех тел в момент s. За кадр заменяется
+// один слот (самый старый) одним glBufferSubData на bodyCount * 12 байт,
+// остальная история на GPU не трогается. Рисуются все следы одним вызовом:
+// инстанс - тело, вершина - возраст отсчёта; шейдер находит слот по
+// номеру головы кольца и читает положение из texture buffer.
+// Память - bodyCount * historyLength * 12 байт и не растёт.
+class TrailRenderer {
+public:
+    ~TrailRenderer();
+
+    bool init();
+
+    // Выделить историю под bodyCount тел; false - если не укладывается в бюджет
+    bool reset(size_t bodyCount, size_t historyLength, size_t budgetBytes);
+
+    // Записать текущие положения тел как новый отсчёт
+    void push(const std::vector<CelestialBody>& bodies);
+
+    void render(const glm::mat4& view, const glm::mat4& projection);
+
+    void release();
+
+    bool isActive() const { return bodyCount > 0 && historyLength > 0; }
+    size_t getMemoryBytes() const { return bodyCount * historyLength * sizeof(glm::vec3); }
+
+    // Байт отправлено на GPU за последний push() и за всё время
+    size_t getLastUploadBytes() const { return lastUploadBytes; }
+    size_t getTotalUploadBytes() const { return totalUploadBytes; }
+    size_t getPushCount() const { return pushCount; }
+
+private:
+    GLuint program = 0;
+    GLuint vao = 0;             // пустой: вершины строятся из gl_VertexID
+    GLuint historyBuffer = 0;
+    GLuint historyTexture = 0;
+    GLuint colorBuffer = 0;
+    GLuint colorTexture = 0;
+    ResourceId historyResource = NO_RESOURCE;
+    ResourceId colorResource = NO_RESOURCE;
+
+    size_t bodyCount = 0;
+    size_t historyLength = 0;
+    size_t head = 0;            // слот последнего отсчёта
+    size_t filled = 0;          // сколько слотов уже записано
+
+    std::vector<glm::vec3> staging;
+
+    size_t lastUploadBytes = 0;
+    size_t totalUploadBytes = 0;
+    size_t pushCount = 0;
+};
@@ -0,0 +1,177 @@
+#include "allocation_tracker.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef SOLAR_ALLOC_TRACKING
+
+namespace {
+
+// Ячейка счётчиков одного потока; своя строка кэша, чтобы потоки не
+// делили её при каждом выделении
+struct alignas(64) ThreadAllocations {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+// Ячейки не освобождаются: счётчики завершившихся потоков остаются в сумме,
+// и разность до и после кадра не уходит в минус. Потоки сверх
+// MAX_TRACKED_THREADS делят последнюю ячейку
+const size_t MAX_TRACKED_THREADS = 256;
+ThreadAllocations threadSlots[MAX_TRACKED_THREADS];
+std::atomic<size_t> usedSlots{0};
+// Общая ячейка исключённых потоков, в сумму не входит
+ThreadAllocations excludedSlot;
+
+// Тривиальный thread_local: к нему можно обращаться из operator new без
+// выделений на инициализацию
+thread_local ThreadAllocations* threadSlot = nullptr;
+
+ThreadAllocations& currentSlot() {
+    if (!threadSlot) {
+        size_t index = usedSlots.fetch_add(1, std::memory_order_relaxed);
+        threadSlot = &threadSlots[std::min(index, MAX_TRACKED_THREADS - 1)];
+    }
+    return *threadSlot;
+}
+
+void countAllocation(std::size_t size) {
+    ThreadAllocations& slot = currentSlot();
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* trackedAllocate(std::size_t size) {
+    countAllocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* trackedAllocateAligned(std::size_t size, std::size_t alignment) {
+    countAllocation(size);
+    if (size == 0) size = 1;
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* pointer = nullptr;
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+    return posix_memalign(&pointer, alignment, size) == 0 ? pointer : nullptr;
+#endif
+}
+
+void trackedFreeAligned(void* pointer) {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (void* pointer = trackedAllocate(size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* pointer = trackedAllocate(size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return trackedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return trackedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* pointer = trackedAllocateAligned(size, static_cast<std::size_t>(alignment))) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    if (void* pointer = trackedAllocateAligned(size, static_cast<std::size_t>(alignment))) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(pointer); }
+
+bool allocationTrackingAvailable() {
+    return true;
+}
+
+AllocationCounters allocationCounters() {
+    AllocationCounters total;
+    size_t slots = std::min(usedSlots.load(std::memory_order_relaxed), MAX_TRACKED_THREADS);
+    for (size_t i = 0; i < slots; i++) {
+        total.allocations += threadSlots[i].allocations.load(std::memory_order_relaxed);
+        total.bytes += threadSlots[i].bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+AllocationCounters threadAllocationCounters() {
+    ThreadAllocations& slot = currentSlot();
+    return AllocationCounters{slot.allocations.load(std::memory_order_relaxed),
+                              slot.bytes.load(std::memory_order_relaxed)};
+}
+
+void excludeThreadFromAllocationCounts() {
+    threadSlot = &excludedSlot;
+}
+
+#else
+
+bool allocationTrackingAvailable() {
+    return false;
+}
+
+AllocationCounters allocationCounters() {
+    return AllocationCounters();
+}
+
+AllocationCounters threadAllocationCounters() {
+    return AllocationCounters();
+}
+
+void excludeThreadFromAllocationCounts() {}
+
+#endif
+
+void SteadyFrameChecker::beginFrame() {
+    frameStart = allocationCounters();
+}
+
+void SteadyFrameChecker::endFrame(bool eventful) {
+    AllocationCounters frame = allocationCounters() - frameStart;
+    frameAllocations = frame.allocations;
+    frames++;
+    totalAllocations += frame.allocations;
+
+    if (eventful) {
+        quietFrames = 0;
+        return;
+    }
+
+    if (quietFrames >= warmupFrames) {
+        steadyFrames++;
+        if (frame.allocations > 0) {
+            allocatingFrames++;
+            steadyAllocations += frame.allocations;
+            steadyBytes += frame.bytes;
+        }
+    }
+    quietFrames++;
+}
@@ -0,0 +1,180 @@
+#include "app_options.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+bool parseAppOptions(int argc, char** argv, AppOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            options.showHelp = true;
+        }
+        else if (std::strcmp(arg, "--scene") == 0 && hasValue) {
+            options.scenePath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--export-scene") == 0 && hasValue) {
+            options.exportScenePath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--profile") == 0) {
+            options.profile = true;
+        }
+        else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options.tracePath = argv[++i];
+            options.profile = true;
+        }
+        else if (std::strcmp(arg, "--profile-interval") == 0 && hasValue) {
+            options.profileInterval = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--record") == 0 && hasValue) {
+            options.recordPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--replay") == 0 && hasValue) {
+            options.replayPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--fast") == 0) {
+            options.replayFast = true;
+        }
+        else if (std::strcmp(arg, "--frame-times") == 0 && hasValue) {
+            options.frameTimesPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--galaxy") == 0 && hasValue) {
+            options.galaxyBodies = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--galaxy-seed") == 0 && hasValue) {
+            options.galaxySeed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(arg, "--checkpoint") == 0 && hasValue) {
+            options.checkpointPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--checkpoint-interval") == 0 && hasValue) {
+            options.checkpointInterval = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--resume") == 0) {
+            options.resume = true;
+        }
+        else if (std::strcmp(arg, "--no-occlusion") == 0) {
+            options.noOcclusion = true;
+        }
+        else if (std::strcmp(arg, "--no-impostors") == 0) {
+            options.noImpostors = true;
+        }
+        else if (std::strcmp(arg, "--impostor-pixels") == 0 && hasValue) {
+            options.impostorPixels = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(arg, "--orbit-tolerance") == 0 && hasValue) {
+            options.orbitTolerancePixels = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(arg, "--trail-length") == 0 && hasValue) {
+            options.trailLength = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--shader-cache") == 0 && hasValue) {
+            options.shaderCachePath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--no-shader-cache") == 0) {
+            options.shaderCachePath.clear();
+        }
+        else if (std::strcmp(arg, "--no-specular") == 0) {
+            options.noSpecular = true;
+        }
+        else if (std::strcmp(arg, "--no-texture") == 0) {
+            options.noTexture = true;
+        }
+        else if (std::strcmp(arg, "--compact-instances") == 0) {
+            options.compactInstances = true;
+        }
+        else if (std::strcmp(arg, "--check-allocations") == 0) {
+            options.checkAllocations = true;
+        }
+        else if (std::strcmp(arg, "--clustered-lights") == 0) {
+            options.clusteredLights = true;
+        }
+        else if (std::strcmp(arg, "--emissive-every") == 0 && hasValue) {
+            options.emissiveEvery = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            options.clusteredLights = true;
+        }
+        else if (std::strcmp(arg, "--metrics") == 0 && hasValue) {
+            options.metricsEndpoint = argv[++i];
+        }
+        else if (std::strcmp(arg, "--collisions") == 0) {
+            options.collisions = true;
+        }
+        else if (std::strcmp(arg, "--belt") == 0 && hasValue) {
+            options.beltCount = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--belt-seed") == 0 && hasValue) {
+            options.beltSeed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--gpu-budget") == 0 && hasValue) {
+            options.gpuBudgetBytes = static_cast<size_t>(std::atof(argv[++i]) * 1024.0 * 1024.0);
+        }
+        else if (std::strcmp(arg, "--cpu-budget") == 0 && hasValue) {
+            options.cpuBudgetBytes = static_cast<size_t>(std::atof(argv[++i]) * 1024.0 * 1024.0);
+        }
+        else if (std::strcmp(arg, "--release-cpu-copies") == 0) {
+            options.releaseCpuCopies = true;
+        }
+        else if (std::strcmp(arg, "--memory-report") == 0) {
+            options.memoryReport = true;
+        }
+        else if (std::strcmp(arg, "--governor") == 0) {
+            options.governor = true;
+        }
+        else if (std::strcmp(arg, "--target-fps") == 0 && hasValue) {
+            options.targetFps = std::atof(argv[++i]);
+            options.governor = true;
+        }
+        else if (std::strcmp(arg, "--substeps") == 0 && hasValue) {
+            options.substeps = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            std::cerr << "Неизвестный аргумент: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " [параметры]" << std::endl;
+    std::cout << "  --scene <файл>         сцена (.scene - текст, .sscn - бинарный)" << std::endl;
+    std::cout << "  --export-scene <файл>  сохранить сцену в файл и выйти" << std::endl;
+    std::cout << "  --galaxy <n>           процедурная галактика из n тел вместо --scene" << std::endl;
+    std::cout << "  --galaxy-seed <n>      seed галактики (1)" << std::endl;
+    std::cout << "  --profile              включить профилировщик кадра" << std::endl;
+    std::cout << "  --trace <файл>         сохранить трассу Chrome trace при выходе" << std::endl;
+    std::cout << "  --profile-interval <с> период печати сводки профиля (0 - выкл)" << std::endl;
+    std::cout << "  --record <файл>        записать ввод и deltaTime каждого кадра" << std::endl;
+    std::cout << "  --replay <файл>        воспроизвести запись вместо клавиатуры" << std::endl;
+    std::cout << "  --fast                 воспроизводить без vsync, как можно быстрее" << std::endl;
+    std::cout << "  --frame-times <файл>   сохранить время каждого кадра в CSV" << std::endl;
+    std::cout << "  --checkpoint <файл>    файл снимка симуляции (F5 - сохранить, F9 - восстановить)" << std::endl;
+    std::cout << "  --checkpoint-interval <с> период дельта-снимков (0 - выкл)" << std::endl;
+    std::cout << "  --resume               продолжить с сохранённого снимка" << std::endl;
+    std::cout << "  --no-occlusion         не отсекать перекрытые тела (C - переключить)" << std::endl;
+    std::cout << "  --no-impostors         рисовать мешем и дальние тела" << std::endl;
+    std::cout << "  --impostor-pixels <r>  радиус на экране (пикс.), ниже - импостор" << std::endl;
+    std::cout << "  --orbit-tolerance <p>  допуск орбиты на экране (пикс.), меньше - больше отрезков" << std::endl;
+    std::cout << "  --trail-length <n>     длина следа орбиты в кадрах (0 - без следов)" << std::endl;
+    std::cout << "  --shader-cache <папка> кэш слинкованных шейдеров (по умолчанию shader_cache)" << std::endl;
+    std::cout << "  --no-shader-cache      компилировать шейдеры при каждом запуске" << std::endl;
+    std::cout << "  --no-specular          вариант шейдера без блика" << std::endl;
+    std::cout << "  --no-texture           вариант шейдера без текстуры" << std::endl;
+    std::cout << "  --compact-instances    инстанс - 3 строки матрицы (48 байт вместо 64)" << std::endl;
+    std::cout << "  --check-allocations    ошибка, если кадр без событий обращался к куче" << std::endl;
+    std::cout << "  --clustered-lights     освещение от всех звёзд сцены по кластерам" << std::endl;
+    std::cout << "  --emissive-every <n>   каждое n-е тело светится (включает --clustered-lights)" << std::endl;
+    std::cout << "  --metrics <адрес>      метрики Prometheus: порт, 127.0.0.1:порт или unix:путь" << std::endl;
+    std::cout << "  --collisions           искать пересечения тел (сводка при выходе)" << std::endl;
+    std::cout << "  --belt <n>             пояс астероидов из n камней" << std::endl;
+    std::cout << "  --belt-seed <n>        seed пояса астероидов" << std::endl;
+    std::cout << "  --gpu-budget <МБ>      бюджет буферов и текстур; сверх него - меньше текстуры и LOD" << std::endl;
+    std::cout << "  --cpu-budget <МБ>      бюджет копий данных на CPU; сверх него - копии освобождаются" << std::endl;
+    std::cout << "  --release-cpu-copies   освобождать копии на CPU после загрузки на GPU" << std::endl;
+    std::cout << "  --memory-report        отчёт о памяти ресурсов при выходе (M - в любой момент)" << std::endl;
+    std::cout << "  --governor             понижать качество, если кадр не укладывается в цель" << std::endl;
+    std::cout << "  --target-fps <f>       цель регулятора качества, кадров/с (60; включает --governor)" << std::endl;
+    std::cout << "  --substeps <n>         шагов симуляции за кадр (1); регулятор может уменьшить" << std::endl;
+    std::cout << "  --help                 эта справка" << std::endl;
+}
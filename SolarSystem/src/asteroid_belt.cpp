@@ -0,0 +1,152 @@
+#include "asteroid_belt.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+namespace {
+
+enum AsteroidChannel : uint32_t {
+    CHANNEL_RADIUS = 0,
+    CHANNEL_HEIGHT,
+    CHANNEL_PHASE,
+    CHANNEL_SCALE,
+    CHANNEL_SPIN_PHASE,
+    CHANNEL_SPIN_SPEED,
+    CHANNEL_AXIS_ANGLE,
+    CHANNEL_AXIS_Z,
+    CHANNEL_SHADE,                  // только в шейдере: оттенок камня
+    CHANNEL_COUNT
+};
+
+const float MAX_SPIN_SPEED = 30.0f;
+
+float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+} // namespace
+
+uint32_t beltHash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float beltRandom(uint32_t seed, uint32_t index, uint32_t channel) {
+    uint32_t h = beltHash(seed ^ beltHash(index * CHANNEL_COUNT + channel));
+    return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+}
+
+AsteroidOrbit asteroidOrbit(const AsteroidBeltParams& belt, uint32_t index) {
+    AsteroidOrbit orbit;
+
+    // sqrt - равномерная плотность по площади кольца
+    orbit.radius = lerp(belt.innerRadius, belt.outerRadius,
+                        std::sqrt(beltRandom(belt.seed, index, CHANNEL_RADIUS)));
+    orbit.height = (beltRandom(belt.seed, index, CHANNEL_HEIGHT) * 2.0f - 1.0f) * belt.thickness;
+    orbit.phase = beltRandom(belt.seed, index, CHANNEL_PHASE) * 360.0f;
+
+    float ratio = belt.innerRadius / orbit.radius;
+    orbit.speed = belt.innerSpeed * ratio * std::sqrt(ratio);
+
+    // Мелких камней больше, чем крупных
+    float size = beltRandom(belt.seed, index, CHANNEL_SCALE);
+    orbit.scale = lerp(belt.minScale, belt.maxScale, size * size);
+
+    orbit.spinPhase = beltRandom(belt.seed, index, CHANNEL_SPIN_PHASE) * 360.0f;
+    orbit.spinSpeed = (beltRandom(belt.seed, index, CHANNEL_SPIN_SPEED) * 2.0f - 1.0f) * MAX_SPIN_SPEED;
+
+    float axisAngle = beltRandom(belt.seed, index, CHANNEL_AXIS_ANGLE) * 6.2831853f;
+    float axisZ = beltRandom(belt.seed, index, CHANNEL_AXIS_Z) * 2.0f - 1.0f;
+    float axisR = std::sqrt(std::max(0.0f, 1.0f - axisZ * axisZ));
+    orbit.spinAxis = glm::vec3(axisR * std::cos(axisAngle), axisR * std::sin(axisAngle), axisZ);
+
+    return orbit;
+}
+
+float wrapDegrees(float degrees) {
+    return degrees - 360.0f * std::floor(degrees / 360.0f);
+}
+
+glm::vec3 asteroidPosition(const AsteroidBeltParams& belt, uint32_t index, float time) {
+    AsteroidOrbit orbit = asteroidOrbit(belt, index);
+    float radians = glm::radians(wrapDegrees(orbit.phase + orbit.speed * time));
+    return belt.center + glm::vec3(orbit.radius * std::cos(radians),
+                                   orbit.height,
+                                   orbit.radius * std::sin(radians));
+}
+
+glm::mat4 asteroidModelMatrix(const AsteroidBeltParams& belt, uint32_t index, float time) {
+    AsteroidOrbit orbit = asteroidOrbit(belt, index);
+    float radians = glm::radians(wrapDegrees(orbit.phase + orbit.speed * time));
+    glm::vec3 position = belt.center + glm::vec3(orbit.radius * std::cos(radians),
+                                                 orbit.height,
+                                                 orbit.radius * std::sin(radians));
+
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+    model = glm::rotate(model, glm::radians(wrapDegrees(orbit.spinPhase + orbit.spinSpeed * time)),
+                        orbit.spinAxis);
+    model = glm::scale(model, glm::vec3(orbit.scale));
+    return model;
+}
+
+std::vector<AsteroidVertex> createAsteroidMesh(uint32_t seed) {
+    const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+    std::vector<glm::vec3> points = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+    };
+    std::vector<uint32_t> faces = {
+        0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+        1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+        3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+        4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1,
+    };
+
+    // Одно разбиение: середины рёбер общие для соседних граней
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+    auto midpoint = [&](uint32_t a, uint32_t b) {
+        auto key = std::make_pair(std::min(a, b), std::max(a, b));
+        auto it = midpoints.find(key);
+        if (it != midpoints.end()) return it->second;
+
+        uint32_t index = static_cast<uint32_t>(points.size());
+        points.push_back((points[a] + points[b]) * 0.5f);
+        midpoints[key] = index;
+        return index;
+    };
+
+    std::vector<uint32_t> subdivided;
+    for (size_t i = 0; i < faces.size(); i += 3) {
+        uint32_t a = faces[i], b = faces[i + 1], c = faces[i + 2];
+        uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+        subdivided.insert(subdivided.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+    }
+
+    // Неровная поверхность: каждая вершина сдвигается по радиусу
+    float maxLength = 0.0f;
+    for (uint32_t i = 0; i < points.size(); i++) {
+        points[i] = glm::normalize(points[i]) * (0.7f + 0.3f * beltRandom(seed, i, 0));
+        maxLength = std::max(maxLength, glm::length(points[i]));
+    }
+
+    std::vector<AsteroidVertex> vertices;
+    vertices.reserve(subdivided.size());
+    for (size_t i = 0; i < subdivided.size(); i += 3) {
+        glm::vec3 a = points[subdivided[i]] / maxLength;
+        glm::vec3 b = points[subdivided[i + 1]] / maxLength;
+        glm::vec3 c = points[subdivided[i + 2]] / maxLength;
+        glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+
+        vertices.push_back({a, normal});
+        vertices.push_back({b, normal});
+        vertices.push_back({c, normal});
+    }
+    return vertices;
+}
@@ -0,0 +1,268 @@
+#include "belt_renderer.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Функции повторяют asteroid_belt.cpp: хеш, beltRandom, asteroidOrbit,
+// wrapDegrees и glm::rotate - при изменении менять в обоих местах
+const char* beltVertexShader = R"(
+#version 330 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float time;
+
+uniform uint seed;
+uniform vec3 center;
+uniform vec2 radiusRange;
+uniform float thickness;
+uniform vec2 scaleRange;
+uniform float innerSpeed;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec3 Color;
+
+const uint CHANNEL_SHADE = 8u;
+const uint CHANNEL_COUNT = 9u;
+const float MAX_SPIN_SPEED = 30.0;
+
+uint beltHash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float beltRandom(uint index, uint channel) {
+    uint h = beltHash(seed ^ beltHash(index * CHANNEL_COUNT + channel));
+    return float(h >> 8) * (1.0 / 16777216.0);
+}
+
+float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+float wrapDegrees(float degrees) {
+    return degrees - 360.0 * floor(degrees / 360.0);
+}
+
+// glm::rotate
+mat3 rotation(float angle, vec3 axis) {
+    float c = cos(angle);
+    float s = sin(angle);
+    vec3 temp = (1.0 - c) * axis;
+    return mat3(
+        c + temp.x * axis.x,          temp.x * axis.y + s * axis.z, temp.x * axis.z - s * axis.y,
+        temp.y * axis.x - s * axis.z, c + temp.y * axis.y,          temp.y * axis.z + s * axis.x,
+        temp.z * axis.x + s * axis.y, temp.z * axis.y - s * axis.x, c + temp.z * axis.z);
+}
+
+void main() {
+    uint index = uint(gl_InstanceID);
+
+    float radius = lerp(radiusRange.x, radiusRange.y, sqrt(beltRandom(index, 0u)));
+    float height = (beltRandom(index, 1u) * 2.0 - 1.0) * thickness;
+    float phase = beltRandom(index, 2u) * 360.0;
+    float ratio = radiusRange.x / radius;
+    float speed = innerSpeed * ratio * sqrt(ratio);
+    float size = beltRandom(index, 3u);
+    float scale = lerp(scaleRange.x, scaleRange.y, size * size);
+    float spinPhase = beltRandom(index, 4u) * 360.0;
+    float spinSpeed = (beltRandom(index, 5u) * 2.0 - 1.0) * MAX_SPIN_SPEED;
+    float axisAngle = beltRandom(index, 6u) * 6.2831853;
+    float axisZ = beltRandom(index, 7u) * 2.0 - 1.0;
+    float axisR = sqrt(max(0.0, 1.0 - axisZ * axisZ));
+    vec3 axis = vec3(axisR * cos(axisAngle), axisR * sin(axisAngle), axisZ);
+
+    float orbitAngle = radians(wrapDegrees(phase + speed * time));
+    vec3 orbitPos = center + vec3(radius * cos(orbitAngle), height, radius * sin(orbitAngle));
+    mat3 spin = rotation(radians(wrapDegrees(spinPhase + spinSpeed * time)), axis);
+
+    FragPos = orbitPos + spin * (position * scale);
+    Normal = spin * normal;
+
+    // Серо-коричневые оттенки по номеру камня
+    float shade = 0.35 + 0.3 * beltRandom(index, CHANNEL_SHADE);
+    Color = vec3(shade * 1.1, shade, shade * 0.85);
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+const char* beltFragmentShader = R"(
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+in vec3 Color;
+
+uniform vec3 lightPos;
+
+out vec4 FragColor;
+
+void main() {
+    // Освещение из fragmentShaderSource
+    vec3 norm = normalize(Normal);
+    vec3 lightDir = normalize(lightPos - FragPos);
+
+    vec3 ambient = 0.4 * Color;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * Color;
+    vec3 viewDir = normalize(-FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+    vec3 specular = 0.5 * spec * vec3(1.0);
+
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
+)";
+
+} // namespace
+
+BeltRenderer::~BeltRenderer() {
+    release();
+}
+
+bool BeltRenderer::init(uint32_t meshSeed) {
+    release();
+
+    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &beltVertexShader, NULL);
+    glCompileShader(vertex);
+
+    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment, 1, &beltFragmentShader, NULL);
+    glCompileShader(fragment);
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+
+    // Для verify(): мировая позиция вершины захватывается до растеризации
+    const char* varyings[] = {"FragPos"};
+    glTransformFeedbackVaryings(program, 1, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cerr << "Ошибка линковки шейдера пояса астероидов:\n" << infoLog << std::endl;
+        release();
+        return false;
+    }
+
+    std::vector<AsteroidVertex> mesh = createAsteroidMesh(meshSeed);
+    vertexCount = static_cast<GLsizei>(mesh.size());
+    firstVertex = mesh[0].position;
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(AsteroidVertex), mesh.data(), GL_STATIC_DRAW);
+    ResourceRegistry::shared().track(vertexResource, "пояс астероидов: меш", RESOURCE_BUFFER,
+                                     mesh.size() * sizeof(AsteroidVertex));
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(AsteroidVertex),
+                          (void*)offsetof(AsteroidVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(AsteroidVertex),
+                          (void*)offsetof(AsteroidVertex, normal));
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return true;
+}
+
+void BeltRenderer::setBeltUniforms(const AsteroidBeltParams& belt, float time) {
+    glUniform1f(glGetUniformLocation(program, "time"), time);
+    glUniform1ui(glGetUniformLocation(program, "seed"), belt.seed);
+    glUniform3fv(glGetUniformLocation(program, "center"), 1, glm::value_ptr(belt.center));
+    glUniform2f(glGetUniformLocation(program, "radiusRange"), belt.innerRadius, belt.outerRadius);
+    glUniform1f(glGetUniformLocation(program, "thickness"), belt.thickness);
+    glUniform2f(glGetUniformLocation(program, "scaleRange"), belt.minScale, belt.maxScale);
+    glUniform1f(glGetUniformLocation(program, "innerSpeed"), belt.innerSpeed);
+}
+
+void BeltRenderer::render(const AsteroidBeltParams& belt, float time,
+                          const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightPos) {
+    if (program == 0 || belt.count == 0) return;
+
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(glGetUniformLocation(program, "lightPos"), 1, glm::value_ptr(lightPos));
+    setBeltUniforms(belt, time);
+
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, static_cast<GLsizei>(belt.count));
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+float BeltRenderer::verify(const AsteroidBeltParams& belt, float time, size_t sampleCount) {
+    sampleCount = std::min<size_t>(sampleCount, belt.count);
+    if (program == 0 || sampleCount == 0) return 0.0f;
+
+    GLuint feedback;
+    glGenBuffers(1, &feedback);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, feedback);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, sampleCount * sizeof(glm::vec3), NULL, GL_STATIC_READ);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, feedback);
+
+    glUseProgram(program);
+    setBeltUniforms(belt, time);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+
+    // Одна вершина (первая вершина меша) на астероид
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(vao);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArraysInstanced(GL_POINTS, 0, 1, static_cast<GLsizei>(sampleCount));
+    glEndTransformFeedback();
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram(0);
+
+    float maxError = 0.0f;
+    const glm::vec3* gpu = static_cast<const glm::vec3*>(
+        glMapBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, sampleCount * sizeof(glm::vec3), GL_MAP_READ_BIT));
+    if (gpu) {
+        for (size_t i = 0; i < sampleCount; i++) {
+            glm::vec4 expected = asteroidModelMatrix(belt, static_cast<uint32_t>(i), time) *
+                                 glm::vec4(firstVertex, 1.0f);
+            maxError = std::max(maxError, glm::length(glm::vec3(expected) - gpu[i]));
+        }
+        glUnmapBuffer(GL_TRANSFORM_FEEDBACK_BUFFER);
+    } else {
+        maxError = -1.0f;
+    }
+
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    glDeleteBuffers(1, &feedback);
+    return maxError;
+}
+
+void BeltRenderer::release() {
+    if (program != 0) glDeleteProgram(program);
+    if (vbo != 0) glDeleteBuffers(1, &vbo);
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    ResourceRegistry::shared().untrack(vertexResource);
+    program = vao = vbo = 0;
+    vertexCount = 0;
+}
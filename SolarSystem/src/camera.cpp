@@ -14,7 +14,7 @@ glm::mat4 Camera::getViewMatrix() const {
 }
 
 glm::mat4 Camera::getProjectionMatrix(float aspect) const {
-    return glm::perspective(glm::radians(fov), aspect, 0.1f, 500.0f);
+    return glm::perspective(glm::radians(fov), aspect, nearPlane, farPlane);
 }
 
 void Camera::moveForward(float distance) {
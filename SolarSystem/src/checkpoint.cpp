@@ -0,0 +1,511 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const char CHECKPOINT_MAGIC[4] = {'S', 'C', 'K', 'P'};
+const size_t CHECKPOINT_ALIGN = 64;
+const size_t CHECKPOINT_CHUNK = 64 * 1024;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool sameBits(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+// Буферизованная запись с отслеживанием позиции для выравнивания колонок
+class ColumnWriter {
+public:
+    explicit ColumnWriter(const std::string& filename) {
+        file = std::fopen(filename.c_str(), "wb");
+        if (file) std::setvbuf(file, nullptr, _IOFBF, 4 << 20);
+    }
+
+    ~ColumnWriter() {
+        if (file) std::fclose(file);
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    void write(const void* data, size_t size) {
+        if (std::fwrite(data, 1, size, file) != size) failed = true;
+        position += size;
+    }
+
+    void padTo(size_t offset) {
+        static const char zeros[CHECKPOINT_ALIGN] = {};
+        while (position < offset) {
+            write(zeros, std::min(CHECKPOINT_ALIGN, offset - position));
+        }
+    }
+
+    bool finish() {
+        bool ok = !failed && std::fclose(file) == 0;
+        file = nullptr;
+        return ok;
+    }
+
+    size_t getPosition() const { return position; }
+
+private:
+    FILE* file = nullptr;
+    size_t position = 0;
+    bool failed = false;
+};
+
+// Записать во временный файл и переименовать - снимок не бывает полузаписанным
+bool commitFile(const std::string& tempName, const std::string& filename) {
+    std::remove(filename.c_str());
+    if (std::rename(tempName.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Не получилось переименовать " << tempName << " в " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+CheckpointHeader makeHeader(CheckpointKind kind, const SolarSystem& system, uint64_t sequence) {
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+    header.version = CHECKPOINT_VERSION;
+    header.kind = kind;
+    header.bodyCount = system.getBodyCount();
+    header.sequence = sequence;
+    header.simulationTime = system.getTime();
+    return header;
+}
+
+} // namespace
+
+// ==============================
+// CheckpointReader
+// ==============================
+bool CheckpointReader::open(const std::string& filename) {
+    std::fill(std::begin(present), std::end(present), false);
+    if (!file.open(filename)) return false;
+
+    if (file.size() < sizeof(CheckpointHeader)) {
+        std::cerr << "Снимок повреждён: " << filename << std::endl;
+        file.close();
+        return false;
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, 4) != 0 || header.version > CHECKPOINT_VERSION) {
+        std::cerr << "Неподдерживаемый формат снимка: " << filename << std::endl;
+        file.close();
+        return false;
+    }
+
+    // Границы - через деление: произведения из заголовка могут переполниться
+    if (header.columnCount > (file.size() - sizeof(CheckpointHeader)) / sizeof(CheckpointColumnDesc)) {
+        std::cerr << "Таблица колонок выходит за пределы снимка: " << filename << std::endl;
+        file.close();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.columnCount; i++) {
+        CheckpointColumnDesc desc;
+        std::memcpy(&desc, file.data() + sizeof(CheckpointHeader) + i * sizeof(desc), sizeof(desc));
+        if (desc.id >= SCENE_COLUMN_COUNT) continue;
+
+        const bool sparse = desc.encoding == CHECKPOINT_SPARSE;
+        size_t available = desc.offset <= file.size() ? file.size() - desc.offset : 0;
+        bool fits = desc.offset <= file.size() &&
+                    desc.count <= available / (sparse ? sizeof(uint32_t) + sizeof(float) : sizeof(float));
+        size_t bytes = !fits ? 0
+            : sparse ? alignUp(desc.count * sizeof(uint32_t), CHECKPOINT_ALIGN) + desc.count * sizeof(float)
+                     : desc.count * sizeof(float);
+        if (desc.offset % CHECKPOINT_ALIGN != 0 || !fits || bytes > available ||
+            (desc.encoding != CHECKPOINT_DENSE && !sparse) ||
+            (desc.encoding == CHECKPOINT_DENSE && desc.count != header.bodyCount)) {
+            std::cerr << "Колонка " << desc.id << " снимка повреждена: " << filename << std::endl;
+            file.close();
+            return false;
+        }
+
+        columns[desc.id] = desc;
+        present[desc.id] = true;
+    }
+
+    // Полный снимок - все колонки плотные: тогда и число тел ограничено
+    // размером файла, и восстановление не оставит поля по умолчанию
+    if (header.kind == CHECKPOINT_FULL) {
+        for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+            if (!present[column] || columns[column].encoding != CHECKPOINT_DENSE) {
+                std::cerr << "В полном снимке нет колонки " << column << ": " << filename << std::endl;
+                file.close();
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+const float* CheckpointReader::denseColumn(uint32_t column) const {
+    if (column >= SCENE_COLUMN_COUNT || !present[column] ||
+        columns[column].encoding != CHECKPOINT_DENSE) {
+        return nullptr;
+    }
+    return reinterpret_cast<const float*>(file.data() + columns[column].offset);
+}
+
+size_t CheckpointReader::readBodies(size_t first, size_t count, CelestialBody* out) const {
+    if (header.kind != CHECKPOINT_FULL || first >= header.bodyCount) return 0;
+    count = std::min<size_t>(count, header.bodyCount - first);
+
+    for (size_t i = 0; i < count; i++) {
+        CelestialBody& body = out[i];
+        body = CelestialBody();
+        body.scale = 1.0f;
+        body.orbitRadius = body.orbitSpeed = body.rotationSpeed = 0.0f;
+        body.orbitAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+        body.orbitCenter = glm::vec3(0.0f);
+    }
+
+    for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+        const float* src = denseColumn(column);
+        if (!src) continue;
+
+        src += first;
+        for (size_t i = 0; i < count; i++) {
+            *sceneColumnField(out[i], column) = src[i];
+        }
+    }
+    return count;
+}
+
+bool CheckpointReader::applyDelta(SolarSystem& system) const {
+    if (header.kind != CHECKPOINT_DELTA || system.getBodyCount() != header.bodyCount) return false;
+
+    auto& bodies = system.getBodies();
+    for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+        if (!present[column]) continue;
+
+        const CheckpointColumnDesc& desc = columns[column];
+        const unsigned char* base = file.data() + desc.offset;
+
+        if (desc.encoding == CHECKPOINT_DENSE) {
+            const float* values = reinterpret_cast<const float*>(base);
+            for (size_t i = 0; i < bodies.size(); i++) {
+                *sceneColumnField(bodies[i], column) = values[i];
+            }
+        } else {
+            const uint32_t* indices = reinterpret_cast<const uint32_t*>(base);
+            const float* values = reinterpret_cast<const float*>(
+                base + alignUp(desc.count * sizeof(uint32_t), CHECKPOINT_ALIGN));
+            for (size_t i = 0; i < desc.count; i++) {
+                if (indices[i] < bodies.size()) {
+                    *sceneColumnField(bodies[indices[i]], column) = values[i];
+                }
+            }
+        }
+    }
+
+    system.setTime(header.simulationTime);
+    return true;
+}
+
+// ==============================
+// Запись снимков
+// ==============================
+bool saveCheckpoint(const std::string& filename, const SolarSystem& system,
+                    uint64_t sequence, CheckpointStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    const std::string tempName = filename + ".tmp";
+    const auto& bodies = system.getBodies();
+
+    {
+        ColumnWriter writer(tempName);
+        if (!writer.isOpen()) {
+            std::cerr << "Не получилось создать снимок: " << filename << std::endl;
+            return false;
+        }
+
+        CheckpointHeader header = makeHeader(CHECKPOINT_FULL, system, sequence);
+        header.columnCount = SCENE_COLUMN_COUNT;
+
+        CheckpointColumnDesc table[SCENE_COLUMN_COUNT];
+        size_t offset = alignUp(sizeof(header) + sizeof(table), CHECKPOINT_ALIGN);
+        for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+            table[column] = {column, CHECKPOINT_DENSE, offset, bodies.size()};
+            offset = alignUp(offset + bodies.size() * sizeof(float), CHECKPOINT_ALIGN);
+        }
+
+        writer.write(&header, sizeof(header));
+        writer.write(table, sizeof(table));
+
+        std::vector<float> buffer(std::min(bodies.size(), CHECKPOINT_CHUNK));
+        for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+            writer.padTo(table[column].offset);
+            for (size_t first = 0; first < bodies.size(); first += buffer.size()) {
+                size_t count = std::min(buffer.size(), bodies.size() - first);
+                for (size_t i = 0; i < count; i++) {
+                    buffer[i] = sceneColumnValue(bodies[first + i], column);
+                }
+                writer.write(buffer.data(), count * sizeof(float));
+            }
+        }
+
+        if (stats) {
+            stats->bytes = writer.getPosition();
+            stats->bodies = bodies.size();
+            stats->columns = SCENE_COLUMN_COUNT;
+        }
+
+        if (!writer.finish()) {
+            std::cerr << "Ошибка записи снимка: " << filename << std::endl;
+            return false;
+        }
+    }
+
+    if (!commitFile(tempName, filename)) return false;
+    if (stats) stats->seconds = secondsSince(start);
+    return true;
+}
+
+bool saveDeltaCheckpoint(const std::string& filename, const SolarSystem& system,
+                         const CheckpointReader& base, uint64_t sequence,
+                         CheckpointStats* stats) {
+    const CheckpointHeader& baseHeader = base.getHeader();
+    if (!base.isOpen() || baseHeader.kind != CHECKPOINT_FULL ||
+        baseHeader.bodyCount != system.getBodyCount()) {
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const auto& bodies = system.getBodies();
+
+    // Проход 1: сколько значений изменилось в каждой колонке
+    std::vector<CheckpointColumnDesc> table;
+    for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+        const float* previous = base.denseColumn(column);
+        size_t changed = 0;
+        for (size_t i = 0; i < bodies.size(); i++) {
+            if (!previous || !sameBits(previous[i], sceneColumnValue(bodies[i], column))) changed++;
+        }
+        if (changed == 0) continue;
+
+        // Разреженная запись стоит 8 байт на значение против 4 у плотной
+        bool sparse = changed * 2 < bodies.size();
+        table.push_back({column, sparse ? CHECKPOINT_SPARSE : CHECKPOINT_DENSE, 0,
+                         sparse ? changed : bodies.size()});
+    }
+
+    CheckpointHeader header = makeHeader(CHECKPOINT_DELTA, system, sequence);
+    header.columnCount = static_cast<uint32_t>(table.size());
+    header.baseSequence = baseHeader.sequence;
+
+    size_t offset = alignUp(sizeof(header) + table.size() * sizeof(CheckpointColumnDesc),
+                            CHECKPOINT_ALIGN);
+    for (auto& desc : table) {
+        desc.offset = offset;
+        size_t bytes = desc.encoding == CHECKPOINT_SPARSE
+            ? alignUp(desc.count * sizeof(uint32_t), CHECKPOINT_ALIGN) + desc.count * sizeof(float)
+            : desc.count * sizeof(float);
+        offset = alignUp(offset + bytes, CHECKPOINT_ALIGN);
+    }
+
+    const std::string tempName = filename + ".tmp";
+    {
+        ColumnWriter writer(tempName);
+        if (!writer.isOpen()) {
+            std::cerr << "Не получилось создать снимок: " << filename << std::endl;
+            return false;
+        }
+
+        writer.write(&header, sizeof(header));
+        writer.write(table.data(), table.size() * sizeof(CheckpointColumnDesc));
+
+        // Проход 2: сами значения
+        std::vector<uint32_t> indices;
+        std::vector<float> values;
+        indices.reserve(CHECKPOINT_CHUNK);
+        values.reserve(CHECKPOINT_CHUNK);
+
+        for (const auto& desc : table) {
+            writer.padTo(desc.offset);
+            const float* previous = base.denseColumn(desc.id);
+
+            if (desc.encoding == CHECKPOINT_DENSE) {
+                for (size_t i = 0; i < bodies.size(); i++) {
+                    values.push_back(sceneColumnValue(bodies[i], desc.id));
+                    if (values.size() == CHECKPOINT_CHUNK || i + 1 == bodies.size()) {
+                        writer.write(values.data(), values.size() * sizeof(float));
+                        values.clear();
+                    }
+                }
+                continue;
+            }
+
+            // Индексы, выравнивание, затем значения в том же порядке
+            for (int pass = 0; pass < 2; pass++) {
+                if (pass == 1) {
+                    writer.padTo(desc.offset + alignUp(desc.count * sizeof(uint32_t), CHECKPOINT_ALIGN));
+                }
+                for (size_t i = 0; i < bodies.size(); i++) {
+                    float value = sceneColumnValue(bodies[i], desc.id);
+                    if (previous && sameBits(previous[i], value)) continue;
+
+                    if (pass == 0) indices.push_back(static_cast<uint32_t>(i));
+                    else values.push_back(value);
+
+                    if (indices.size() == CHECKPOINT_CHUNK) {
+                        writer.write(indices.data(), indices.size() * sizeof(uint32_t));
+                        indices.clear();
+                    }
+                    if (values.size() == CHECKPOINT_CHUNK) {
+                        writer.write(values.data(), values.size() * sizeof(float));
+                        values.clear();
+                    }
+                }
+                writer.write(indices.data(), indices.size() * sizeof(uint32_t));
+                writer.write(values.data(), values.size() * sizeof(float));
+                indices.clear();
+                values.clear();
+            }
+        }
+
+        if (stats) {
+            stats->bytes = writer.getPosition();
+            stats->bodies = bodies.size();
+            stats->columns = table.size();
+        }
+
+        if (!writer.finish()) {
+            std::cerr << "Ошибка записи снимка: " << filename << std::endl;
+            return false;
+        }
+    }
+
+    if (!commitFile(tempName, filename)) return false;
+    if (stats) stats->seconds = secondsSince(start);
+    return true;
+}
+
+bool restoreCheckpoint(const std::string& fullPath, const std::string& deltaPath,
+                       SolarSystem& system, CheckpointStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+
+    CheckpointReader full;
+    if (!full.open(fullPath)) return false;
+    if (full.getHeader().kind != CHECKPOINT_FULL) {
+        std::cerr << "Ожидался полный снимок: " << fullPath << std::endl;
+        return false;
+    }
+
+    // Снимок проверен в open() - только теперь можно трогать текущую сцену
+    const CheckpointHeader& header = full.getHeader();
+    system.clear();
+    system.reserve(static_cast<size_t>(header.bodyCount));
+
+    std::vector<CelestialBody> chunk(std::min<size_t>(header.bodyCount, CHECKPOINT_CHUNK));
+    for (size_t first = 0; first < header.bodyCount; first += chunk.size()) {
+        size_t count = full.readBodies(first, chunk.size(), chunk.data());
+        for (size_t i = 0; i < count; i++) {
+            system.addBody(chunk[i]);
+        }
+    }
+    system.setTime(header.simulationTime);
+
+    size_t bytes = full.getFileSize();
+    size_t columns = header.columnCount;
+
+    // Дельта применяется, только если сделана от этого же полного снимка
+    if (!deltaPath.empty()) {
+        FILE* probe = std::fopen(deltaPath.c_str(), "rb");
+        if (probe) {
+            std::fclose(probe);
+            CheckpointReader delta;
+            if (delta.open(deltaPath) && delta.getHeader().baseSequence == header.sequence &&
+                delta.applyDelta(system)) {
+                bytes += delta.getFileSize();
+                columns += delta.getHeader().columnCount;
+            }
+        }
+    }
+
+    if (stats) {
+        stats->bytes = bytes;
+        stats->bodies = system.getBodyCount();
+        stats->columns = columns;
+        stats->seconds = secondsSince(start);
+    }
+    return true;
+}
+
+// ==============================
+// CheckpointManager
+// ==============================
+void CheckpointManager::configure(const std::string& path, double intervalSeconds) {
+    fullPath = path;
+    interval = intervalSeconds;
+    sinceLastSave = 0.0;
+}
+
+bool CheckpointManager::update(const SolarSystem& system, float deltaTime) {
+    if (interval <= 0.0) return false;
+
+    // Таймер сбрасывает только успешная запись - после ошибки повтор в следующем кадре
+    sinceLastSave += deltaTime;
+    return sinceLastSave >= interval && saveDelta(system);
+}
+
+bool CheckpointManager::saveFull(const SolarSystem& system) {
+    CheckpointStats stats;
+    base.close();
+
+    if (!saveCheckpoint(fullPath, system, ++sequence, &stats)) return false;
+
+    // Старая дельта относится к предыдущей базе
+    std::remove(getDeltaPath().c_str());
+    base.open(fullPath);
+    sinceLastSave = 0.0;
+
+    std::printf("Снимок сохранён: %s, %zu тел, %.1f МБ за %.2f мс (%.2f ГБ/с)\n",
+                fullPath.c_str(), stats.bodies, stats.bytes / 1e6, stats.seconds * 1000.0,
+                stats.gigabytesPerSecond());
+    return true;
+}
+
+bool CheckpointManager::saveDelta(const SolarSystem& system) {
+    if (!base.isOpen()) return saveFull(system);
+
+    CheckpointStats stats;
+    if (!saveDeltaCheckpoint(getDeltaPath(), system, base, ++sequence, &stats)) {
+        return saveFull(system);
+    }
+    sinceLastSave = 0.0;
+
+    std::printf("Дельта-снимок: %zu колонок, %.1f МБ за %.2f мс (%.2f ГБ/с)\n",
+                stats.columns, stats.bytes / 1e6, stats.seconds * 1000.0,
+                stats.gigabytesPerSecond());
+    return true;
+}
+
+bool CheckpointManager::restore(SolarSystem& system) {
+    CheckpointStats stats;
+    if (!restoreCheckpoint(fullPath, getDeltaPath(), system, &stats)) return false;
+
+    // Новые дельты продолжают цепочку от восстановленной базы
+    base.close();
+    base.open(fullPath);
+    sequence = std::max(sequence, base.getHeader().sequence) + 1;
+    sinceLastSave = 0.0;
+
+    std::printf("Снимок восстановлен: %zu тел, t = %.2f, %.1f МБ за %.2f мс (%.2f ГБ/с)\n",
+                stats.bodies, system.getTime(), stats.bytes / 1e6, stats.seconds * 1000.0,
+                stats.gigabytesPerSecond());
+    return true;
+}
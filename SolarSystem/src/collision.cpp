@@ -0,0 +1,194 @@
+#include "collision.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const size_t REFRESH_GRAIN = 16384;
+const size_t SWEEP_GRAIN = 4096;
+const size_t NARROW_GRAIN = 16384;
+
+// Перестановок на тело, после которых досортировка уступает полной сортировке
+const size_t SWEEP_SWAP_BUDGET = 8;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+CollisionDetector::CollisionDetector(ThreadPool& pool)
+    : pool(pool), workerCandidates(pool.threadCount()), workerContacts(pool.threadCount()) {
+}
+
+const std::vector<BodyContact>& CollisionDetector::detect(const std::vector<CelestialBody>& bodies,
+                                                          float meshRadius) {
+    broadphase(bodies, meshRadius);
+    return narrowphase();
+}
+
+void CollisionDetector::rebuild(const std::vector<CelestialBody>& bodies, float meshRadius) {
+    entries.resize(bodies.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i].body = static_cast<uint32_t>(i);
+    }
+
+    // Ось с наибольшим разбросом центров - меньше ложных пересечений отрезков
+    axis = 0;
+    refreshEntries(bodies, meshRadius);
+    double sum[3] = {0.0, 0.0, 0.0};
+    double sum2[3] = {0.0, 0.0, 0.0};
+    for (const SweepEntry& entry : entries) {
+        for (int k = 0; k < 3; k++) {
+            sum[k] += entry.center[k];
+            sum2[k] += double(entry.center[k]) * entry.center[k];
+        }
+    }
+    double count = static_cast<double>(std::max<size_t>(1, entries.size()));
+    double bestVariance = -1.0;
+    for (int k = 0; k < 3; k++) {
+        double mean = sum[k] / count;
+        double variance = sum2[k] / count - mean * mean;
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            axis = k;
+        }
+    }
+    refreshEntries(bodies, meshRadius);
+
+    std::sort(entries.begin(), entries.end(), [](const SweepEntry& a, const SweepEntry& b) {
+        return a.lower < b.lower || (a.lower == b.lower && a.body < b.body);
+    });
+}
+
+void CollisionDetector::refreshEntries(const std::vector<CelestialBody>& bodies, float meshRadius) {
+    const CelestialBody* source = bodies.data();
+    SweepEntry* target = entries.data();
+    const int sweepAxis = axis;
+    pool.parallelFor(entries.size(), REFRESH_GRAIN, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            SweepEntry& entry = target[i];
+            const CelestialBody& body = source[entry.body];
+            entry.center = body.getOrbitPosition();
+            entry.radius = meshRadius * body.scale;
+            entry.lower = entry.center[sweepAxis] - entry.radius;
+            entry.upper = entry.center[sweepAxis] + entry.radius;
+        }
+    });
+}
+
+bool CollisionDetector::insertionSort(size_t swapBudget) {
+    for (size_t i = 1; i < entries.size(); i++) {
+        if (entries[i - 1].lower <= entries[i].lower) continue;
+
+        SweepEntry entry = entries[i];
+        size_t j = i;
+        while (j > 0 && entries[j - 1].lower > entry.lower) {
+            entries[j] = entries[j - 1];
+            j--;
+            if (++stats.swaps > swapBudget) {
+                entries[j] = entry;
+                return false;
+            }
+        }
+        entries[j] = entry;
+    }
+    return true;
+}
+
+void CollisionDetector::broadphase(const std::vector<CelestialBody>& bodies, float meshRadius) {
+    stats = CollisionStats();
+    stats.bodies = bodies.size();
+    candidates.clear();
+
+    // Обновление отрезков и досортировка
+    auto start = std::chrono::steady_clock::now();
+    if (entries.size() != bodies.size()) {
+        rebuild(bodies, meshRadius);
+        stats.rebuilt = true;
+    } else {
+        refreshEntries(bodies, meshRadius);
+        if (!insertionSort(entries.size() * SWEEP_SWAP_BUDGET)) {
+            std::sort(entries.begin(), entries.end(), [](const SweepEntry& a, const SweepEntry& b) {
+                return a.lower < b.lower || (a.lower == b.lower && a.body < b.body);
+            });
+            stats.rebuilt = true;
+        }
+    }
+    stats.axis = axis;
+    stats.sortSeconds = secondsSince(start);
+
+    // Развёртка: у каждого отрезка - следующие, начавшиеся до его конца;
+    // по двум другим осям сразу отбрасываются непересекающиеся AABB
+    start = std::chrono::steady_clock::now();
+    for (auto& list : workerCandidates) {
+        list.clear();
+    }
+    const SweepEntry* sorted = entries.data();
+    const size_t count = entries.size();
+    const int axisU = (axis + 1) % 3;
+    const int axisV = (axis + 2) % 3;
+    pool.parallelFor(count, SWEEP_GRAIN, [&](size_t begin, size_t end, size_t worker) {
+        std::vector<CandidatePair>& list = workerCandidates[worker];
+        for (size_t i = begin; i < end; i++) {
+            const SweepEntry& first = sorted[i];
+            for (size_t j = i + 1; j < count && sorted[j].lower <= first.upper; j++) {
+                const SweepEntry& second = sorted[j];
+                float reach = first.radius + second.radius;
+                if (std::abs(first.center[axisU] - second.center[axisU]) > reach) continue;
+                if (std::abs(first.center[axisV] - second.center[axisV]) > reach) continue;
+                list.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(j)});
+            }
+        }
+    });
+    for (const auto& list : workerCandidates) {
+        candidates.insert(candidates.end(), list.begin(), list.end());
+    }
+    stats.candidates = candidates.size();
+    stats.sweepSeconds = secondsSince(start);
+}
+
+const std::vector<BodyContact>& CollisionDetector::narrowphase() {
+    auto start = std::chrono::steady_clock::now();
+    contacts.clear();
+    for (auto& list : workerContacts) {
+        list.clear();
+    }
+
+    const SweepEntry* sorted = entries.data();
+    const CandidatePair* pairs = candidates.data();
+    pool.parallelFor(candidates.size(), NARROW_GRAIN, [&](size_t begin, size_t end, size_t worker) {
+        std::vector<BodyContact>& list = workerContacts[worker];
+        for (size_t i = begin; i < end; i++) {
+            const SweepEntry* first = &sorted[pairs[i].first];
+            const SweepEntry* second = &sorted[pairs[i].second];
+            if (first->body > second->body) std::swap(first, second);
+
+            glm::vec3 offset = second->center - first->center;
+            float reach = first->radius + second->radius;
+            float distance2 = glm::dot(offset, offset);
+            if (distance2 >= reach * reach) continue;
+
+            // Совпавшие центры - нормаль любая, берём вверх
+            float distance = std::sqrt(distance2);
+            BodyContact contact;
+            contact.a = first->body;
+            contact.b = second->body;
+            contact.normal = distance > 0.0f ? offset / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+            contact.depth = reach - distance;
+            list.push_back(contact);
+        }
+    });
+    for (const auto& list : workerContacts) {
+        contacts.insert(contacts.end(), list.begin(), list.end());
+    }
+    std::sort(contacts.begin(), contacts.end(), [](const BodyContact& x, const BodyContact& y) {
+        return x.a < y.a || (x.a == y.a && x.b < y.b);
+    });
+
+    stats.contacts = contacts.size();
+    stats.narrowSeconds = secondsSince(start);
+    return contacts;
+}
@@ -0,0 +1,416 @@
+#include "compiled_asset.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char MESH_MAGIC[4] = {'S', 'M', 'S', 'H'};
+const char TEXTURE_MAGIC[4] = {'S', 'T', 'E', 'X'};
+const size_t DATA_ALIGN = 16;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+int16_t toSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::min(1.0f, std::max(-1.0f, value)) * 32767.0f));
+}
+
+uint16_t toUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::min(1.0f, std::max(0.0f, value)) * 65535.0f));
+}
+
+int8_t toSnorm8(float value) {
+    return static_cast<int8_t>(std::lround(std::min(1.0f, std::max(-1.0f, value)) * 127.0f));
+}
+
+float srgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// Запись с выравниванием отрезков; ошибка любой записи - ошибка файла
+class AssetWriter {
+public:
+    explicit AssetWriter(const std::string& filename) : tempName(filename + ".tmp"), filename(filename) {
+        file = std::fopen(tempName.c_str(), "wb");
+    }
+
+    ~AssetWriter() {
+        if (file) {
+            std::fclose(file);
+            std::remove(tempName.c_str());
+        }
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    void write(const void* data, size_t size) {
+        if (size > 0 && std::fwrite(data, 1, size, file) != size) failed = true;
+        position += size;
+    }
+
+    void padTo(size_t offset) {
+        static const char zeros[DATA_ALIGN] = {};
+        while (position < offset) {
+            write(zeros, std::min(DATA_ALIGN, offset - position));
+        }
+    }
+
+    size_t getPosition() const { return position; }
+
+    // Через временный файл: прерванная сборка не оставляет полузаписанный ассет
+    bool finish() {
+        bool ok = !failed && std::fclose(file) == 0;
+        file = nullptr;
+        if (ok) {
+            std::remove(filename.c_str());
+            ok = std::rename(tempName.c_str(), filename.c_str()) == 0;
+        }
+        if (!ok) {
+            std::remove(tempName.c_str());
+            std::cerr << "Не получилось записать " << filename << std::endl;
+        }
+        return ok;
+    }
+
+private:
+    std::string tempName;
+    std::string filename;
+    FILE* file = nullptr;
+    size_t position = 0;
+    bool failed = false;
+};
+
+bool readAt(const std::vector<char>& data, size_t offset, void* out, size_t size) {
+    if (offset > data.size() || size > data.size() - offset) return false;
+    std::memcpy(out, data.data() + offset, size);
+    return true;
+}
+
+} // namespace
+
+uint64_t hashAssetBytes(const void* data, size_t size, uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool readWholeFile(const std::string& filename, std::vector<char>& data) {
+    FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) return false;
+
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    bool ok = size >= 0;
+    if (ok) {
+        data.resize(static_cast<size_t>(size));
+        ok = std::fread(data.data(), 1, data.size(), file) == data.size();
+    }
+    std::fclose(file);
+    return ok;
+}
+
+MeshQuantization computeQuantization(const std::vector<OBJVertex>& vertices) {
+    glm::vec3 lower(0.0f), upper(0.0f);
+    glm::vec2 uvLower(0.0f), uvUpper(0.0f);
+    if (!vertices.empty()) {
+        lower = upper = vertices[0].position;
+        uvLower = uvUpper = vertices[0].texCoord;
+    }
+    for (const OBJVertex& vertex : vertices) {
+        lower = glm::min(lower, vertex.position);
+        upper = glm::max(upper, vertex.position);
+        uvLower = glm::min(uvLower, vertex.texCoord);
+        uvUpper = glm::max(uvUpper, vertex.texCoord);
+    }
+
+    MeshQuantization quantization;
+    for (int axis = 0; axis < 3; axis++) {
+        quantization.positionOffset[axis] = (lower[axis] + upper[axis]) * 0.5f;
+        quantization.positionScale[axis] = std::max((upper[axis] - lower[axis]) * 0.5f, 1e-20f);
+    }
+    for (int axis = 0; axis < 2; axis++) {
+        quantization.texCoordOffset[axis] = uvLower[axis];
+        quantization.texCoordScale[axis] = std::max(uvUpper[axis] - uvLower[axis], 1e-20f);
+    }
+    return quantization;
+}
+
+QuantizedVertex quantizeVertex(const OBJVertex& vertex, const MeshQuantization& quantization) {
+    QuantizedVertex result = {};
+    for (int axis = 0; axis < 3; axis++) {
+        result.position[axis] = toSnorm16((vertex.position[axis] - quantization.positionOffset[axis]) /
+                                          quantization.positionScale[axis]);
+        result.normal[axis] = toSnorm8(vertex.normal[axis]);
+    }
+    for (int axis = 0; axis < 2; axis++) {
+        result.texCoord[axis] = toUnorm16((vertex.texCoord[axis] - quantization.texCoordOffset[axis]) /
+                                          quantization.texCoordScale[axis]);
+    }
+    return result;
+}
+
+OBJVertex dequantizeVertex(const QuantizedVertex& vertex, const MeshQuantization& quantization) {
+    OBJVertex result;
+    for (int axis = 0; axis < 3; axis++) {
+        result.position[axis] = quantization.positionOffset[axis] +
+                                quantization.positionScale[axis] * (vertex.position[axis] / 32767.0f);
+        result.normal[axis] = vertex.normal[axis] / 127.0f;
+    }
+    for (int axis = 0; axis < 2; axis++) {
+        result.texCoord[axis] = quantization.texCoordOffset[axis] +
+                                quantization.texCoordScale[axis] * (vertex.texCoord[axis] / 65535.0f);
+    }
+    float length = glm::length(result.normal);
+    result.normal = length > 0.0f ? result.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    return result;
+}
+
+void buildMipChain(const unsigned char* rgba, uint32_t width, uint32_t height,
+                   std::vector<std::vector<unsigned char>>& levels) {
+    levels.clear();
+    levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+    float toLinear[256];
+    for (int i = 0; i < 256; i++) {
+        toLinear[i] = srgbToLinear(i / 255.0f);
+    }
+
+    while (width > 1 || height > 1) {
+        uint32_t nextWidth = std::max(1u, width / 2);
+        uint32_t nextHeight = std::max(1u, height / 2);
+        const std::vector<unsigned char>& source = levels.back();
+        std::vector<unsigned char> level(static_cast<size_t>(nextWidth) * nextHeight * 4);
+
+        for (uint32_t y = 0; y < nextHeight; y++) {
+            // Нечётный размер: последний столбец/строка берётся с краю
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+            for (uint32_t x = 0; x < nextWidth; x++) {
+                uint32_t x0 = std::min(x * 2, width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                const unsigned char* texels[4] = {
+                    &source[(static_cast<size_t>(y0) * width + x0) * 4],
+                    &source[(static_cast<size_t>(y0) * width + x1) * 4],
+                    &source[(static_cast<size_t>(y1) * width + x0) * 4],
+                    &source[(static_cast<size_t>(y1) * width + x1) * 4],
+                };
+                unsigned char* out = &level[(static_cast<size_t>(y) * nextWidth + x) * 4];
+                for (int channel = 0; channel < 3; channel++) {
+                    float sum = 0.0f;
+                    for (const unsigned char* texel : texels) sum += toLinear[texel[channel]];
+                    out[channel] = static_cast<unsigned char>(std::lround(linearToSrgb(sum * 0.25f) * 255.0f));
+                }
+                unsigned alpha = texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3];
+                out[3] = static_cast<unsigned char>((alpha + 2) / 4);
+            }
+        }
+
+        levels.push_back(std::move(level));
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+bool writeCompiledMesh(const std::string& filename, const CompiledMesh& mesh) {
+    AssetWriter writer(filename);
+    if (!writer.isOpen()) {
+        std::cerr << "Не получилось открыть " << filename << " для записи" << std::endl;
+        return false;
+    }
+
+    CompiledMeshHeader header = mesh.header;
+    std::memcpy(header.magic, MESH_MAGIC, 4);
+    header.version = COMPILED_ASSET_VERSION;
+    header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+
+    // 16-битные индексы, если каждый LOD умещается
+    header.indexSize = 2;
+    for (const CompiledMeshLod& lod : mesh.lods) {
+        if (lod.vertexCount > 65536) header.indexSize = 4;
+    }
+
+    writer.write(&header, sizeof(header));
+    writer.write(mesh.lods.data(), mesh.lods.size() * sizeof(CompiledMeshLod));
+    writer.padTo(alignUp(writer.getPosition(), DATA_ALIGN));
+    writer.write(mesh.vertices.data(), mesh.vertices.size() * sizeof(QuantizedVertex));
+    writer.padTo(alignUp(writer.getPosition(), DATA_ALIGN));
+    if (header.indexSize == 4) {
+        writer.write(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    } else {
+        std::vector<uint16_t> narrow(mesh.indices.begin(), mesh.indices.end());
+        writer.write(narrow.data(), narrow.size() * sizeof(uint16_t));
+    }
+    return writer.finish();
+}
+
+bool readCompiledMesh(const std::string& filename, CompiledMesh& mesh) {
+    std::vector<char> data;
+    if (!readWholeFile(filename, data)) return false;
+
+    CompiledMeshHeader& header = mesh.header;
+    if (!readAt(data, 0, &header, sizeof(header)) || std::memcmp(header.magic, MESH_MAGIC, 4) != 0 ||
+        header.version != COMPILED_ASSET_VERSION || (header.indexSize != 2 && header.indexSize != 4)) {
+        std::cerr << "Неподдерживаемый формат меша: " << filename << std::endl;
+        return false;
+    }
+
+    // Размеры частей - до выделения памяти: счётчики повреждённого заголовка
+    // не должны приводить к огромным resize. Произведения 32-битных счётчиков
+    // на размер записи в 64 битах не переполняются
+    size_t offset = sizeof(header);
+    uint64_t vertexStart = alignUp(offset + uint64_t(header.lodCount) * sizeof(CompiledMeshLod), DATA_ALIGN);
+    uint64_t indexStart = alignUp(vertexStart + uint64_t(header.vertexCount) * sizeof(QuantizedVertex), DATA_ALIGN);
+    if (header.lodCount == 0 || indexStart + uint64_t(header.indexCount) * header.indexSize > data.size()) {
+        std::cerr << "Меш повреждён: " << filename << std::endl;
+        return false;
+    }
+
+    mesh.lods.resize(header.lodCount);
+    mesh.vertices.resize(header.vertexCount);
+    mesh.indices.resize(header.indexCount);
+    bool ok = readAt(data, offset, mesh.lods.data(), mesh.lods.size() * sizeof(CompiledMeshLod));
+    offset = alignUp(offset + mesh.lods.size() * sizeof(CompiledMeshLod), DATA_ALIGN);
+    ok = ok && readAt(data, offset, mesh.vertices.data(), mesh.vertices.size() * sizeof(QuantizedVertex));
+    offset = alignUp(offset + mesh.vertices.size() * sizeof(QuantizedVertex), DATA_ALIGN);
+    if (header.indexSize == 4) {
+        ok = ok && readAt(data, offset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    } else {
+        std::vector<uint16_t> narrow(header.indexCount);
+        ok = ok && readAt(data, offset, narrow.data(), narrow.size() * sizeof(uint16_t));
+        std::copy(narrow.begin(), narrow.end(), mesh.indices.begin());
+    }
+
+    // Индексы LOD - относительно его отрезка вершин и не должны выходить за него
+    for (const CompiledMeshLod& lod : mesh.lods) {
+        ok = ok && lod.vertexOffset + static_cast<uint64_t>(lod.vertexCount) <= header.vertexCount &&
+             lod.indexOffset + static_cast<uint64_t>(lod.indexCount) <= header.indexCount;
+        for (uint32_t i = 0; ok && i < lod.indexCount; i++) {
+            ok = mesh.indices[lod.indexOffset + i] < lod.vertexCount;
+        }
+    }
+    if (!ok) {
+        std::cerr << "Меш повреждён: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void unpackCompiledLod(const CompiledMesh& mesh, size_t lodIndex,
+                       std::vector<OBJVertex>& vertices, std::vector<unsigned int>& indices) {
+    const CompiledMeshLod& lod = mesh.lods[lodIndex];
+    vertices.resize(lod.vertexCount);
+    for (uint32_t i = 0; i < lod.vertexCount; i++) {
+        vertices[i] = dequantizeVertex(mesh.vertices[lod.vertexOffset + i], mesh.header.quantization);
+    }
+    indices.assign(mesh.indices.begin() + lod.indexOffset,
+                   mesh.indices.begin() + lod.indexOffset + lod.indexCount);
+}
+
+bool writeCompiledTexture(const std::string& filename, const CompiledTexture& texture) {
+    AssetWriter writer(filename);
+    if (!writer.isOpen()) {
+        std::cerr << "Не получилось открыть " << filename << " для записи" << std::endl;
+        return false;
+    }
+
+    CompiledTextureHeader header = texture.header;
+    std::memcpy(header.magic, TEXTURE_MAGIC, 4);
+    header.version = COMPILED_ASSET_VERSION;
+    header.mipCount = static_cast<uint32_t>(texture.mips.size());
+
+    writer.write(&header, sizeof(header));
+    writer.write(texture.mips.data(), texture.mips.size() * sizeof(CompiledTextureMip));
+    writer.padTo(alignUp(writer.getPosition(), DATA_ALIGN));
+    writer.write(texture.texels.data(), texture.texels.size());
+    return writer.finish();
+}
+
+bool readCompiledTexture(const std::string& filename, CompiledTexture& texture) {
+    std::vector<char> data;
+    if (!readWholeFile(filename, data)) return false;
+
+    CompiledTextureHeader& header = texture.header;
+    if (!readAt(data, 0, &header, sizeof(header)) || std::memcmp(header.magic, TEXTURE_MAGIC, 4) != 0 ||
+        header.version != COMPILED_ASSET_VERSION || header.format != 0) {
+        std::cerr << "Неподдерживаемый формат текстуры: " << filename << std::endl;
+        return false;
+    }
+
+    // Уровней не больше, чем в полной цепочке до 1x1, и хотя бы один
+    uint32_t chainLength = 1;
+    for (uint32_t size = std::max(header.width, header.height); size > 1; size /= 2) chainLength++;
+    size_t offset = sizeof(header);
+    if (header.width == 0 || header.height == 0 || header.mipCount == 0 || header.mipCount > chainLength ||
+        offset + uint64_t(header.mipCount) * sizeof(CompiledTextureMip) > data.size()) {
+        std::cerr << "Текстура повреждена: " << filename << std::endl;
+        return false;
+    }
+
+    texture.mips.resize(header.mipCount);
+    bool ok = readAt(data, offset, texture.mips.data(), texture.mips.size() * sizeof(CompiledTextureMip));
+    offset = alignUp(offset + texture.mips.size() * sizeof(CompiledTextureMip), DATA_ALIGN);
+    ok = ok && offset <= data.size();
+    if (ok) {
+        texture.texels.assign(data.begin() + offset, data.end());
+    }
+    // Уровень i - базовый размер, уменьшенный вдвое i раз (не меньше 1)
+    for (uint32_t level = 0; ok && level < header.mipCount; level++) {
+        const CompiledTextureMip& mip = texture.mips[level];
+        ok = mip.width == std::max(1u, header.width >> level) &&
+             mip.height == std::max(1u, header.height >> level) &&
+             mip.size == static_cast<uint64_t>(mip.width) * mip.height * 4 &&
+             mip.offset <= texture.texels.size() && mip.size <= texture.texels.size() - mip.offset;
+    }
+    if (!ok) {
+        std::cerr << "Текстура повреждена: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool readCompiledHashes(const std::string& filename, uint64_t& sourceHash, uint64_t& settingsHash) {
+    FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) return false;
+
+    // Общее начало заголовков меша и текстуры
+    struct {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t settingsHash;
+    } prefix;
+    bool ok = std::fread(&prefix, sizeof(prefix), 1, file) == 1;
+    std::fclose(file);
+
+    ok = ok && prefix.version == COMPILED_ASSET_VERSION &&
+         (std::memcmp(prefix.magic, MESH_MAGIC, 4) == 0 || std::memcmp(prefix.magic, TEXTURE_MAGIC, 4) == 0);
+    if (!ok) return false;
+
+    sourceHash = prefix.sourceHash;
+    settingsHash = prefix.settingsHash;
+    return true;
+}
+
+bool compiledAssetIsCurrent(const std::string& compiledPath, const std::string& sourcePath) {
+    uint64_t sourceHash = 0, settingsHash = 0;
+    if (!readCompiledHashes(compiledPath, sourceHash, settingsHash)) return false;
+
+    // Исходника нет (поставляются только скомпилированные файлы) - берём как есть
+    std::vector<char> source;
+    if (!readWholeFile(sourcePath, source)) return true;
+    return hashAssetBytes(source.data(), source.size()) == sourceHash;
+}
@@ -0,0 +1,106 @@
+#include "far_field.h"
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace {
+
+// Тел на один кусок при параллельном разделении
+const size_t SPLIT_CHUNK = 4096;
+
+} // namespace
+
+float projectedRadiusPixels(const glm::vec3& center, float radius, const glm::mat4& view,
+                            const glm::mat4& projection, float viewportHeight) {
+    glm::vec4 viewCenter = view * glm::vec4(center, 1.0f);
+    float distance = -viewCenter.z;
+
+    // Камера внутри сферы или тело позади - считаем его большим
+    if (distance <= radius) return 1e30f;
+    return radius / distance * projection[1][1] * viewportHeight * 0.5f;
+}
+
+void splitFarField(const std::vector<CelestialBody>& bodies, const std::vector<uint32_t>* indices,
+                   float meshRadius, const glm::mat4& view, const glm::mat4& projection,
+                   float viewportHeight, const FarFieldSettings& settings,
+                   FarFieldSplit& split, ThreadPool& pool) {
+    const size_t count = indices ? indices->size() : bodies.size();
+    const float fadeStart = settings.thresholdPixels * (1.0f - settings.fadeBand);
+    const float fadeEnd = settings.thresholdPixels * (1.0f + settings.fadeBand);
+
+    // Проход 1: растворение меша для каждого тела и число мешей/импосторов в кусках
+    std::vector<float>& dissolve = split.bodyDissolve;
+    dissolve.resize(count);
+
+    size_t chunkCount = (count + SPLIT_CHUNK - 1) / SPLIT_CHUNK;
+    std::vector<size_t>& meshOffsets = split.meshOffsets;
+    std::vector<size_t>& impostorOffsets = split.impostorOffsets;
+    meshOffsets.assign(chunkCount + 1, 0);
+    impostorOffsets.assign(chunkCount + 1, 0);
+
+    pool.parallelFor(chunkCount, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t chunk = begin; chunk < end; chunk++) {
+            size_t first = chunk * SPLIT_CHUNK;
+            size_t last = std::min(first + SPLIT_CHUNK, count);
+            size_t meshes = 0, impostors = 0;
+
+            for (size_t i = first; i < last; i++) {
+                const CelestialBody& body = bodies[indices ? (*indices)[i] : i];
+                float pixels = projectedRadiusPixels(body.getOrbitPosition(), meshRadius * body.scale,
+                                                     view, projection, viewportHeight);
+
+                float value = 0.0f;
+                if (!settings.enabled || pixels >= fadeEnd) {
+                    value = 0.0f;
+                } else if (pixels <= fadeStart) {
+                    value = 1.0f;
+                } else {
+                    value = (fadeEnd - pixels) / (fadeEnd - fadeStart);
+                }
+
+                dissolve[i] = value;
+                meshes += value < 1.0f;
+                impostors += value > 0.0f;
+            }
+
+            meshOffsets[chunk + 1] = meshes;
+            impostorOffsets[chunk + 1] = impostors;
+        }
+    });
+
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        meshOffsets[chunk + 1] += meshOffsets[chunk];
+        impostorOffsets[chunk + 1] += impostorOffsets[chunk];
+    }
+
+    split.meshMatrices.resize(meshOffsets[chunkCount]);
+    split.meshDissolve.resize(meshOffsets[chunkCount]);
+    split.impostors.resize(impostorOffsets[chunkCount]);
+
+    // Проход 2: каждый кусок пишет свои инстансы со своих смещений
+    pool.parallelFor(chunkCount, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t chunk = begin; chunk < end; chunk++) {
+            size_t first = chunk * SPLIT_CHUNK;
+            size_t last = std::min(first + SPLIT_CHUNK, count);
+            size_t mesh = meshOffsets[chunk];
+            size_t impostor = impostorOffsets[chunk];
+
+            for (size_t i = first; i < last; i++) {
+                const CelestialBody& body = bodies[indices ? (*indices)[i] : i];
+                float value = dissolve[i];
+
+                if (value < 1.0f) {
+                    split.meshMatrices[mesh] = body.getModelMatrix();
+                    split.meshDissolve[mesh] = value;
+                    mesh++;
+                }
+                if (value > 0.0f) {
+                    ImpostorInstance& instance = split.impostors[impostor++];
+                    instance.positionRadius = glm::vec4(body.getOrbitPosition(), meshRadius * body.scale);
+                    instance.params = glm::vec4(glm::radians(body.currentRotationAngle), value, 0.0f, 0.0f);
+                }
+            }
+        }
+    });
+
+    split.crossfading = split.meshMatrices.size() + split.impostors.size() - count;
+}
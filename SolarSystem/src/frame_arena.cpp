@@ -0,0 +1,66 @@
+#include "frame_arena.h"
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t initialBytes) {
+    blocks.reserve(8);
+    addBlock(std::max<size_t>(initialBytes, 64));
+}
+
+FrameArena::~FrameArena() {
+    for (const Block& block : blocks) {
+        delete[] block.data;
+    }
+}
+
+void FrameArena::addBlock(size_t minBytes) {
+    size_t size = blocks.empty() ? minBytes : std::max(minBytes, blocks.back().size * 2);
+    blocks.push_back(Block{new char[size], size});
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    for (;;) {
+        Block& block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+        uintptr_t aligned = (base + offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        size_t end = static_cast<size_t>(aligned - base) + bytes;
+
+        if (end <= block.size) {
+            usedBytes += end - offset;
+            offset = end;
+            peakBytes = std::max(peakBytes, usedBytes);
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Не поместилось - следующий блок, при необходимости новый
+        if (current + 1 == blocks.size()) {
+            addBlock(bytes + alignment);
+        }
+        usedBytes += block.size - offset;
+        current++;
+        offset = 0;
+    }
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        // Кадр не уместился в один блок: заменяем всё одним блоком на пик
+        size_t total = getCapacity();
+        for (const Block& block : blocks) {
+            delete[] block.data;
+        }
+        blocks.clear();
+        addBlock(std::max(total, peakBytes));
+    }
+    current = 0;
+    offset = 0;
+    usedBytes = 0;
+}
+
+size_t FrameArena::getCapacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
@@ -0,0 +1,116 @@
+#include "frame_governor.h"
+#include <algorithm>
+
+namespace {
+
+const char* LEVER_NAMES[QUALITY_LEVER_COUNT] = {"msaa", "impostors", "lod", "orbits", "substeps"};
+
+// Порядок понижения по узкому месту: сначала то, что дешевле всего для картинки
+const QualityLever GPU_ORDER[] = {QUALITY_MSAA, QUALITY_IMPOSTORS, QUALITY_LOD, QUALITY_ORBITS};
+const QualityLever CPU_ORDER[] = {QUALITY_SUBSTEPS, QUALITY_IMPOSTORS, QUALITY_ORBITS};
+// Без замера GPU узкое место неизвестно
+const QualityLever ANY_ORDER[] = {QUALITY_SUBSTEPS, QUALITY_MSAA, QUALITY_IMPOSTORS, QUALITY_LOD, QUALITY_ORBITS};
+
+} // namespace
+
+const char* qualityLeverName(QualityLever lever) {
+    return lever < QUALITY_LEVER_COUNT ? LEVER_NAMES[lever] : "?";
+}
+
+void FrameGovernor::configure(const GovernorSettings& newSettings, const int newMaxLevels[QUALITY_LEVER_COUNT]) {
+    settings = newSettings;
+    size_t totalLevels = 0;
+    for (uint32_t lever = 0; lever < QUALITY_LEVER_COUNT; lever++) {
+        maxLevels[lever] = std::max(0, newMaxLevels[lever]);
+        levels[lever] = 0;
+        totalLevels += maxLevels[lever];
+    }
+    history.clear();
+    history.reserve(totalLevels);
+
+    primed = false;
+    overSeconds = 0.0;
+    underSeconds = 0.0;
+    sinceDecision = 0.0;
+    sinceUpgrade = 1e9;
+    upgradeHold = settings.upgradeHold;
+    downgrades = 0;
+    upgrades = 0;
+}
+
+bool FrameGovernor::update(double frameSeconds, double cpuSeconds, double gpuSeconds, GovernorDecision& decision) {
+    if (!primed) {
+        smoothedCpu = cpuSeconds;
+        smoothedGpu = gpuSeconds;
+        primed = true;
+    } else {
+        smoothedCpu += settings.smoothing * (cpuSeconds - smoothedCpu);
+        if (gpuSeconds > 0.0) smoothedGpu += settings.smoothing * (gpuSeconds - smoothedGpu);
+    }
+    sinceDecision += frameSeconds;
+    sinceUpgrade += frameSeconds;
+
+    double load = std::max(smoothedCpu, smoothedGpu);
+    overSeconds = load > settings.targetSeconds * settings.downgradeRatio ? overSeconds + frameSeconds : 0.0;
+    underSeconds = load < settings.targetSeconds * settings.upgradeRatio ? underSeconds + frameSeconds : 0.0;
+    if (sinceDecision < settings.cooldown) return false;
+
+    bool decided = false;
+    if (overSeconds >= settings.downgradeHold) {
+        decided = downgrade(smoothedGpu > 0.0 && smoothedGpu >= smoothedCpu, decision);
+        // Повышение не удержалось - в следующий раз ждать дольше
+        if (decided && sinceUpgrade < upgradeHold + settings.downgradeHold + settings.cooldown) {
+            upgradeHold = std::min(upgradeHold * 2.0, settings.maxUpgradeHold);
+        }
+    } else if (underSeconds >= upgradeHold) {
+        decided = upgrade(decision);
+        if (decided) sinceUpgrade = 0.0;
+    }
+
+    if (decided) {
+        decision.cpuSeconds = smoothedCpu;
+        decision.gpuSeconds = smoothedGpu;
+        sinceDecision = 0.0;
+        overSeconds = 0.0;
+        underSeconds = 0.0;
+    }
+    return decided;
+}
+
+bool FrameGovernor::downgrade(bool gpuBound, GovernorDecision& decision) {
+    const QualityLever* order = ANY_ORDER;
+    size_t count = sizeof(ANY_ORDER) / sizeof(ANY_ORDER[0]);
+    if (smoothedGpu > 0.0) {
+        order = gpuBound ? GPU_ORDER : CPU_ORDER;
+        count = gpuBound ? sizeof(GPU_ORDER) / sizeof(GPU_ORDER[0]) : sizeof(CPU_ORDER) / sizeof(CPU_ORDER[0]);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        QualityLever lever = order[i];
+        if (levels[lever] >= maxLevels[lever]) continue;
+
+        levels[lever]++;
+        history.push_back(lever);
+        downgrades++;
+        decision.lever = lever;
+        decision.level = levels[lever];
+        decision.downgrade = true;
+        decision.gpuBound = gpuBound;
+        return true;
+    }
+    return false;
+}
+
+bool FrameGovernor::upgrade(GovernorDecision& decision) {
+    if (history.empty()) return false;
+
+    QualityLever lever = history.back();
+    history.pop_back();
+    levels[lever]--;
+    upgrades++;
+    decision.lever = lever;
+    decision.level = levels[lever];
+    decision.downgrade = false;
+    decision.gpuBound = smoothedGpu > 0.0 && smoothedGpu >= smoothedCpu;
+    return true;
+}
@@ -0,0 +1,126 @@
+#include "gpu_timer.h"
+#include "profiler.h"
+
+GpuTimer::~GpuTimer() {
+    release();
+}
+
+void GpuTimer::begin(const char* name) {
+    if (!Profiler::instance().isEnabled() || active >= 0) return;
+
+    int slot = -1;
+    for (size_t i = 0; i < queries.size(); i++) {
+        if (!queries[i].pending) {
+            slot = static_cast<int>(i);
+            break;
+        }
+    }
+
+    if (slot < 0) {
+        // Все запросы ещё в полёте: заводим новый или пропускаем замер
+        if (queries.size() >= MAX_QUERIES) return;
+        queries.emplace_back();
+        glGenQueries(1, &queries.back().id);
+        slot = static_cast<int>(queries.size() - 1);
+    }
+
+    Query& query = queries[slot];
+    query.name = name;
+    query.cpuStartNs = Profiler::nowNs();
+    query.pending = true;
+
+    glBeginQuery(GL_TIME_ELAPSED, query.id);
+    active = slot;
+}
+
+void GpuTimer::end() {
+    if (active < 0) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    active = -1;
+}
+
+void GpuTimer::poll() {
+    for (auto& query : queries) {
+        if (!query.pending || &query - queries.data() == active) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed);
+        query.pending = false;
+
+        // Начало на GPU неизвестно - привязываем к моменту отправки команды
+        Profiler::instance().record(query.name, query.cpuStartNs, elapsed, ProfileTrack::GPU);
+    }
+}
+
+void GpuTimer::release() {
+    for (auto& query : queries) {
+        if (query.id != 0) glDeleteQueries(1, &query.id);
+    }
+    queries.clear();
+    active = -1;
+}
+
+// ==============================
+// FrameGpuClock
+// ==============================
+FrameGpuClock::~FrameGpuClock() {
+    release();
+}
+
+void FrameGpuClock::begin() {
+    Frame& frame = frames[current];
+    // Результат этого слота ещё не забран - кадр не замеряем
+    if (frame.pending) return;
+
+    if (frame.start == 0) {
+        glGenQueries(1, &frame.start);
+        glGenQueries(1, &frame.end);
+    }
+    glQueryCounter(frame.start, GL_TIMESTAMP);
+    recording = true;
+}
+
+void FrameGpuClock::end() {
+    if (!recording) return;
+
+    Frame& frame = frames[current];
+    glQueryCounter(frame.end, GL_TIMESTAMP);
+    frame.pending = true;
+    recording = false;
+    current = (current + 1) % FRAMES_IN_FLIGHT;
+}
+
+double FrameGpuClock::poll() {
+    // От старых кадров к новым: последним запишется самый свежий результат
+    for (size_t i = 0; i < FRAMES_IN_FLIGHT; i++) {
+        Frame& frame = frames[(current + i) % FRAMES_IN_FLIGHT];
+        if (!frame.pending) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(frame.end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(frame.start, GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(frame.end, GL_QUERY_RESULT, &end);
+        frame.pending = false;
+        lastSeconds = end > start ? (end - start) * 1e-9 : 0.0;
+    }
+    return lastSeconds;
+}
+
+void FrameGpuClock::release() {
+    for (Frame& frame : frames) {
+        if (frame.start != 0) glDeleteQueries(1, &frame.start);
+        if (frame.end != 0) glDeleteQueries(1, &frame.end);
+        frame = Frame();
+    }
+    recording = false;
+    lastSeconds = 0.0;
+}
@@ -0,0 +1,382 @@
+#include "impostor.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// Диапазон углов возвышения, с которых запекается атлас
+const float MIN_ELEVATION = -1.2f;
+const float MAX_ELEVATION = 1.2f;
+// Уровней mip в атласах
+const int ATLAS_LEVELS = 5;
+
+const char* bakeVertexShader = R"(
+#version 330 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec3 normal;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec2 TexCoord;
+out vec3 ViewNormal;
+
+void main() {
+    gl_Position = projection * view * vec4(position, 1.0);
+    TexCoord = texCoord;
+    ViewNormal = mat3(view) * normal;
+}
+)";
+
+const char* bakeFragmentShader = R"(
+#version 330 core
+in vec2 TexCoord;
+in vec3 ViewNormal;
+
+uniform sampler2D textureSampler;
+
+layout(location = 0) out vec4 Albedo;
+layout(location = 1) out vec4 Normal;
+
+void main() {
+    vec4 texColor = texture(textureSampler, TexCoord);
+    if (texColor.a < 0.1) discard;
+
+    Albedo = vec4(texColor.rgb, 1.0);
+    Normal = vec4(normalize(ViewNormal) * 0.5 + 0.5, 1.0);
+}
+)";
+
+const char* impostorVertexShader = R"(
+#version 330 core
+layout(location = 0) in vec4 positionRadius;
+layout(location = 1) in vec4 params;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform vec2 atlasCells;
+uniform vec2 elevationRange;
+
+out vec2 TexCoord;
+out vec3 FragPos;
+out vec3 Right;
+out vec3 Up;
+out vec3 Back;
+flat out float Dissolve;
+
+void main() {
+    // Вершины полосы: (-1,-1), (1,-1), (-1,1), (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    vec3 center = positionRadius.xyz;
+
+    // Базис как у lookAt при запекании
+    vec3 back = normalize(cameraPos - center);
+    vec3 right = cross(-back, vec3(0.0, 1.0, 0.0));
+    right = dot(right, right) < 1e-8 ? vec3(1.0, 0.0, 0.0) : normalize(right);
+    vec3 up = cross(right, -back);
+
+    // Направление на камеру в системе тела (поворот вокруг Y на -угол)
+    float c = cos(params.x);
+    float s = sin(params.x);
+    vec3 local = vec3(c * back.x - s * back.z, back.y, s * back.x + c * back.z);
+
+    float azimuth = atan(local.z, local.x);
+    float elevation = asin(clamp(local.y, -1.0, 1.0));
+    float column = mod(floor(azimuth / 6.2831853 * atlasCells.x + 0.5), atlasCells.x);
+    float row = clamp(floor((elevation - elevationRange.x) / (elevationRange.y - elevationRange.x)
+                            * (atlasCells.y - 1.0) + 0.5), 0.0, atlasCells.y - 1.0);
+
+    TexCoord = (vec2(column, row) + corner * 0.5 + 0.5) / atlasCells;
+    FragPos = center + (right * corner.x + up * corner.y) * positionRadius.w;
+    Right = right;
+    Up = up;
+    Back = back;
+    Dissolve = params.y;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+)";
+
+const char* impostorFragmentShader = R"(
+#version 330 core
+in vec2 TexCoord;
+in vec3 FragPos;
+in vec3 Right;
+in vec3 Up;
+in vec3 Back;
+flat in float Dissolve;
+
+uniform sampler2D albedoAtlas;
+uniform sampler2D normalAtlas;
+uniform vec3 lightPos;
+
+out vec4 FragColor;
+
+// Порог Байера 4x4 - тот же, что в fragmentShaderSource
+float ditherThreshold(vec2 fragCoord) {
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                      3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    ivec2 p = ivec2(fragCoord) & 3;
+    return (bayer[p.y * 4 + p.x] + 0.5) / 16.0;
+}
+
+void main() {
+    // Пиксели, которые оставил меш, импостор пропускает
+    if (Dissolve + ditherThreshold(gl_FragCoord.xy) < 1.0) discard;
+
+    vec4 albedo = texture(albedoAtlas, TexCoord);
+    if (albedo.a < 0.5) discard;
+
+    vec3 n = texture(normalAtlas, TexCoord).xyz * 2.0 - 1.0;
+    vec3 norm = normalize(Right * n.x + Up * n.y + Back * n.z);
+    vec3 lightDir = normalize(lightPos - FragPos);
+
+    // Освещение из fragmentShaderSource
+    vec3 ambient = 0.4 * albedo.rgb;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * albedo.rgb;
+    vec3 viewDir = normalize(-FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+    vec3 specular = 0.5 * spec * vec3(1.0);
+
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
+)";
+
+GLuint compileProgram(const char* vertexSource, const char* fragmentSource, const char* name) {
+    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &vertexSource, NULL);
+    glCompileShader(vertex);
+
+    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment, 1, &fragmentSource, NULL);
+    glCompileShader(fragment);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cerr << "Ошибка линковки шейдера " << name << ":\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+GLuint createAtlasTexture(int width, int height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Мелкие уровни смешивали бы соседние ячейки
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ATLAS_LEVELS - 1);
+    return texture;
+}
+
+} // namespace
+
+ImpostorRenderer::~ImpostorRenderer() {
+    release();
+}
+
+bool ImpostorRenderer::init(const OBJModel& model, GLuint texture, float meshRadius) {
+    release();
+
+    program = compileProgram(impostorVertexShader, impostorFragmentShader, "импосторов");
+    if (program == 0 || !bakeAtlas(model, texture, meshRadius)) {
+        release();
+        return false;
+    }
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &instanceVBO);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance),
+                          (void*)offsetof(ImpostorInstance, positionRadius));
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance),
+                          (void*)offsetof(ImpostorInstance, params));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    std::cout << "Атлас импосторов: " << AZIMUTH_CELLS << "x" << ELEVATION_CELLS
+              << " видов по " << CELL_SIZE << " пикс." << std::endl;
+    return true;
+}
+
+bool ImpostorRenderer::bakeAtlas(const OBJModel& model, GLuint texture, float meshRadius) {
+    if (model.VAO == 0 || meshRadius <= 0.0f) return false;
+
+    GLuint bakeProgram = compileProgram(bakeVertexShader, bakeFragmentShader, "запекания импосторов");
+    if (bakeProgram == 0) return false;
+
+    const int atlasWidth = CELL_SIZE * AZIMUTH_CELLS;
+    const int atlasHeight = CELL_SIZE * ELEVATION_CELLS;
+    albedoAtlas = createAtlasTexture(atlasWidth, atlasHeight);
+    normalAtlas = createAtlasTexture(atlasWidth, atlasHeight);
+    ResourceRegistry& registry = ResourceRegistry::shared();
+    size_t atlasBytes = mipChainBytes(atlasWidth, atlasHeight, 4, ATLAS_LEVELS);
+    registry.track(albedoResource, "импосторы: атлас цвета", RESOURCE_TEXTURE, atlasBytes);
+    registry.track(normalResource, "импосторы: атлас нормалей", RESOURCE_TEXTURE, atlasBytes);
+
+    GLuint depth;
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasWidth, atlasHeight);
+
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoAtlas, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalAtlas, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+    const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        GLint viewport[4];
+        GLfloat clearColor[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glUseProgram(bakeProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glUniform1i(glGetUniformLocation(bakeProgram, "textureSampler"), 0);
+
+        // Ортографическая проекция вокруг ограничивающей сферы
+        glm::mat4 projection = glm::ortho(-meshRadius, meshRadius, -meshRadius, meshRadius,
+                                          meshRadius, 3.0f * meshRadius);
+        glUniformMatrix4fv(glGetUniformLocation(bakeProgram, "projection"), 1, GL_FALSE,
+                           glm::value_ptr(projection));
+
+        glBindVertexArray(model.VAO);
+        for (int row = 0; row < ELEVATION_CELLS; row++) {
+            float elevation = MIN_ELEVATION + (MAX_ELEVATION - MIN_ELEVATION) * row / (ELEVATION_CELLS - 1);
+            for (int column = 0; column < AZIMUTH_CELLS; column++) {
+                float azimuth = 6.2831853f * column / AZIMUTH_CELLS;
+                glm::vec3 direction(std::cos(elevation) * std::cos(azimuth), std::sin(elevation),
+                                    std::cos(elevation) * std::sin(azimuth));
+
+                glm::mat4 view = glm::lookAt(direction * (2.0f * meshRadius), glm::vec3(0.0f),
+                                             glm::vec3(0.0f, 1.0f, 0.0f));
+                glUniformMatrix4fv(glGetUniformLocation(bakeProgram, "view"), 1, GL_FALSE,
+                                   glm::value_ptr(view));
+
+                glViewport(column * CELL_SIZE, row * CELL_SIZE, CELL_SIZE, CELL_SIZE);
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(model.indexCount), GL_UNSIGNED_INT, 0);
+            }
+        }
+        glBindVertexArray(0);
+        glUseProgram(0);
+
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    } else {
+        std::cerr << "Кадровый буфер атласа импосторов неполон" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteProgram(bakeProgram);
+
+    if (complete) {
+        glBindTexture(GL_TEXTURE_2D, albedoAtlas);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, normalAtlas);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return complete;
+}
+
+void ImpostorRenderer::render(const ImpostorInstance* instances, size_t count,
+                              const glm::mat4& view, const glm::mat4& projection,
+                              const glm::vec3& cameraPos, const glm::vec3& lightPos) {
+    if (program == 0 || count == 0) return;
+
+    // Буфер растёт с запасом; старое содержимое отбрасывается, чтобы не ждать GPU
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (count > capacity) {
+        capacity = count + count / 2;
+        ResourceRegistry::shared().track(instanceResource, "импосторы: инстансы", RESOURCE_BUFFER,
+                                         capacity * sizeof(ImpostorInstance));
+    }
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(ImpostorInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(ImpostorInstance), instances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(glGetUniformLocation(program, "cameraPos"), 1, glm::value_ptr(cameraPos));
+    glUniform3fv(glGetUniformLocation(program, "lightPos"), 1, glm::value_ptr(lightPos));
+    glUniform2f(glGetUniformLocation(program, "atlasCells"),
+                static_cast<float>(AZIMUTH_CELLS), static_cast<float>(ELEVATION_CELLS));
+    glUniform2f(glGetUniformLocation(program, "elevationRange"), MIN_ELEVATION, MAX_ELEVATION);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, albedoAtlas);
+    glUniform1i(glGetUniformLocation(program, "albedoAtlas"), 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, normalAtlas);
+    glUniform1i(glGetUniformLocation(program, "normalAtlas"), 1);
+
+    // Квадрат всегда смотрит на камеру - отбрасывать нечего
+    glDisable(GL_CULL_FACE);
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+    glBindVertexArray(0);
+    glEnable(GL_CULL_FACE);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
+
+void ImpostorRenderer::release() {
+    if (program != 0) glDeleteProgram(program);
+    if (albedoAtlas != 0) glDeleteTextures(1, &albedoAtlas);
+    if (normalAtlas != 0) glDeleteTextures(1, &normalAtlas);
+    if (instanceVBO != 0) glDeleteBuffers(1, &instanceVBO);
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    ResourceRegistry& registry = ResourceRegistry::shared();
+    registry.untrack(albedoResource);
+    registry.untrack(normalResource);
+    registry.untrack(instanceResource);
+    program = albedoAtlas = normalAtlas = instanceVBO = vao = 0;
+    capacity = 0;
+}
@@ -0,0 +1,164 @@
+#include "input_recorder.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char INPUT_MAGIC[4] = {'S', 'I', 'N', 'P'};
+
+// magic, version, bodyCount, frameCount
+const size_t INPUT_HEADER_SIZE = 4 + 4 + 8 + 8;
+const size_t INPUT_FRAME_SIZE = 4 + 2;
+
+} // namespace
+
+// ==============================
+// InputRecorder
+// ==============================
+InputRecorder::~InputRecorder() {
+    close();
+}
+
+bool InputRecorder::open(const std::string& filename, uint64_t bodyCount) {
+    close();
+
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Не получилось создать файл записи: " << filename << std::endl;
+        return false;
+    }
+
+    frameCount = 0;
+    file.write(INPUT_MAGIC, 4);
+    file.write(reinterpret_cast<const char*>(&INPUT_LOG_VERSION), 4);
+    file.write(reinterpret_cast<const char*>(&bodyCount), 8);
+    file.write(reinterpret_cast<const char*>(&frameCount), 8);   // допишется в close()
+    return file.good();
+}
+
+void InputRecorder::record(const InputFrame& frame) {
+    if (!file.is_open()) return;
+
+    char buffer[INPUT_FRAME_SIZE];
+    std::memcpy(buffer, &frame.deltaTime, 4);
+    std::memcpy(buffer + 4, &frame.keys, 2);
+    file.write(buffer, INPUT_FRAME_SIZE);
+    frameCount++;
+}
+
+void InputRecorder::close() {
+    if (!file.is_open()) return;
+
+    file.seekp(INPUT_HEADER_SIZE - 8);
+    file.write(reinterpret_cast<const char*>(&frameCount), 8);
+    file.close();
+
+    std::cout << "Записано кадров ввода: " << frameCount << std::endl;
+}
+
+// ==============================
+// InputPlayer
+// ==============================
+bool InputPlayer::open(const std::string& filename) {
+    opened = false;
+    frames.clear();
+    position = 0;
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "Не получилось открыть запись: " << filename << std::endl;
+        return false;
+    }
+    uint64_t fileSize = static_cast<uint64_t>(std::max<std::streamoff>(0, file.tellg()));
+    file.seekg(0);
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t frameCount = 0;
+    file.read(magic, 4);
+    file.read(reinterpret_cast<char*>(&version), 4);
+    file.read(reinterpret_cast<char*>(&bodyCount), 8);
+    file.read(reinterpret_cast<char*>(&frameCount), 8);
+
+    if (!file || std::memcmp(magic, INPUT_MAGIC, 4) != 0 || version > INPUT_LOG_VERSION) {
+        std::cerr << "Файл не является записью ввода: " << filename << std::endl;
+        return false;
+    }
+
+    // Запись целиком в памяти: чтение с диска не должно влиять на время кадров.
+    // Кадры читаются до конца файла: frameCount дописывается только в close(),
+    // и у записи упавшей сессии он равен 0. Резерв - по размеру файла
+    frames.reserve(static_cast<size_t>((fileSize - INPUT_HEADER_SIZE) / INPUT_FRAME_SIZE));
+    char buffer[INPUT_FRAME_SIZE];
+    while (file.read(buffer, INPUT_FRAME_SIZE)) {
+        InputFrame frame;
+        std::memcpy(&frame.deltaTime, buffer, 4);
+        std::memcpy(&frame.keys, buffer + 4, 2);
+        frames.push_back(frame);
+    }
+
+    if (frameCount == 0 && !frames.empty()) {
+        std::cerr << "Запись не была закрыта, кадров в ней: " << frames.size() << std::endl;
+    } else if (frames.size() != frameCount) {
+        std::cerr << "Запись обрезана: " << frames.size() << " из " << frameCount
+                  << " кадров" << std::endl;
+    }
+
+    opened = true;
+    return true;
+}
+
+bool InputPlayer::next(InputFrame& frame) {
+    if (position >= frames.size()) return false;
+
+    frame = frames[position++];
+    return true;
+}
+
+// ==============================
+// Сводка времени кадров
+// ==============================
+FrameTimeSummary summarizeFrameTimes(std::vector<float> frameSeconds) {
+    FrameTimeSummary summary;
+    if (frameSeconds.empty()) return summary;
+
+    std::sort(frameSeconds.begin(), frameSeconds.end());
+
+    auto percentile = [&](double p) {
+        size_t index = static_cast<size_t>(p * (frameSeconds.size() - 1) + 0.5);
+        return frameSeconds[index] * 1000.0;
+    };
+
+    summary.frames = frameSeconds.size();
+    for (float seconds : frameSeconds) summary.totalSeconds += seconds;
+    summary.meanMs = summary.totalSeconds * 1000.0 / summary.frames;
+    summary.p50Ms = percentile(0.50);
+    summary.p95Ms = percentile(0.95);
+    summary.p99Ms = percentile(0.99);
+    summary.maxMs = frameSeconds.back() * 1000.0;
+    return summary;
+}
+
+void printFrameTimeSummary(const FrameTimeSummary& summary) {
+    std::printf("Кадров: %zu за %.2f с; время кадра, мс: среднее %.3f, p50 %.3f, "
+                "p95 %.3f, p99 %.3f, макс %.3f\n",
+                summary.frames, summary.totalSeconds, summary.meanMs, summary.p50Ms,
+                summary.p95Ms, summary.p99Ms, summary.maxMs);
+}
+
+bool writeFrameTimes(const std::string& filename, const std::vector<float>& frameSeconds) {
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file) {
+        std::cerr << "Не получилось создать файл: " << filename << std::endl;
+        return false;
+    }
+
+    std::fprintf(file, "frame,ms\n");
+    for (size_t i = 0; i < frameSeconds.size(); i++) {
+        std::fprintf(file, "%zu,%.4f\n", i, frameSeconds[i] * 1000.0);
+    }
+    std::fclose(file);
+    return true;
+}
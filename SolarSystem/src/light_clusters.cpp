@@ -0,0 +1,203 @@
+#include "light_clusters.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+const size_t BOUNDS_GRAIN = 1024;
+
+// Цвета светящихся тел - несколько тёплых и холодных оттенков по номеру тела
+const glm::vec3 EMISSIVE_PALETTE[] = {
+    glm::vec3(1.0f, 0.55f, 0.25f),
+    glm::vec3(0.35f, 0.6f, 1.0f),
+    glm::vec3(1.0f, 0.9f, 0.4f),
+    glm::vec3(0.9f, 0.35f, 0.8f),
+    glm::vec3(0.4f, 1.0f, 0.6f),
+};
+const float EMISSIVE_INTENSITY = 1.5f;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint8_t tileIndex(float ndc, uint32_t tiles) {
+    int tile = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * tiles));
+    return static_cast<uint8_t>(std::min(std::max(tile, 0), static_cast<int>(tiles) - 1));
+}
+
+// Диапазон ndc, в который проецируется отрезок [lower, upper] координаты при
+// глубине от nearDepth до farDepth (обе > 0): крайние значения - в углах
+void projectRange(float lower, float upper, float nearDepth, float farDepth, float scale,
+                  float& ndcLower, float& ndcUpper) {
+    ndcLower = scale * std::min(lower / nearDepth, lower / farDepth);
+    ndcUpper = scale * std::max(upper / nearDepth, upper / farDepth);
+}
+
+ClusterBounds lightBounds(const PointLight& light, const glm::mat4& view, const glm::mat4& projection,
+                          float nearPlane, float farPlane) {
+    ClusterBounds empty = {1, 0, 1, 0, 1, 0};
+    glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+    float depth = -center.z;
+    float radius = light.range;
+    if (depth + radius < nearPlane || depth - radius > farPlane) return empty;
+
+    ClusterBounds bounds;
+    bounds.zBegin = static_cast<uint8_t>(clusterSlice(std::max(depth - radius, nearPlane), nearPlane, farPlane));
+    bounds.zEnd = static_cast<uint8_t>(clusterSlice(std::min(depth + radius, farPlane), nearPlane, farPlane));
+
+    // Сфера задевает ближнюю плоскость - проекция не ограничена, берём весь экран
+    if (depth - radius <= nearPlane) {
+        bounds.xBegin = 0;
+        bounds.xEnd = CLUSTER_X - 1;
+        bounds.yBegin = 0;
+        bounds.yEnd = CLUSTER_Y - 1;
+        return bounds;
+    }
+
+    float xLower, xUpper, yLower, yUpper;
+    projectRange(center.x - radius, center.x + radius, depth - radius, depth + radius,
+                 projection[0][0], xLower, xUpper);
+    projectRange(center.y - radius, center.y + radius, depth - radius, depth + radius,
+                 projection[1][1], yLower, yUpper);
+    if (xUpper < -1.0f || xLower > 1.0f || yUpper < -1.0f || yLower > 1.0f) return empty;
+
+    bounds.xBegin = tileIndex(xLower, CLUSTER_X);
+    bounds.xEnd = tileIndex(xUpper, CLUSTER_X);
+    bounds.yBegin = tileIndex(yLower, CLUSTER_Y);
+    bounds.yEnd = tileIndex(yUpper, CLUSTER_Y);
+    return bounds;
+}
+
+} // namespace
+
+void selectLightBodies(const std::vector<CelestialBody>& bodies, unsigned emissiveEvery,
+                       std::vector<uint32_t>& lightBodies) {
+    lightBodies.clear();
+    size_t planets = 0;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        bool star = bodies[i].orbitRadius == 0.0f;
+        bool emissive = !star && emissiveEvery > 0 && planets++ % emissiveEvery == 0;
+        if (star || emissive) {
+            lightBodies.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void gatherBodyLights(const std::vector<CelestialBody>& bodies, const std::vector<uint32_t>& lightBodies,
+                      std::vector<PointLight>& lights) {
+    lights.resize(lightBodies.size());
+    for (size_t i = 0; i < lightBodies.size(); i++) {
+        uint32_t index = lightBodies[i];
+        const CelestialBody& body = bodies[index];
+        PointLight& light = lights[i];
+        light.position = body.getOrbitPosition();
+        light.padding = 0.0f;
+        if (body.orbitRadius == 0.0f) {
+            light.range = STAR_LIGHT_RANGE;
+            light.color = glm::vec3(1.0f);
+        } else {
+            light.range = EMISSIVE_RANGE_SCALE * body.scale;
+            light.color = EMISSIVE_PALETTE[index % (sizeof(EMISSIVE_PALETTE) / sizeof(EMISSIVE_PALETTE[0]))] *
+                          EMISSIVE_INTENSITY;
+        }
+    }
+}
+
+uint32_t clusterSlice(float depth, float nearPlane, float farPlane) {
+    if (depth <= nearPlane) return 0;
+    float slice = std::floor(std::log(depth / nearPlane) * CLUSTER_Z / std::log(farPlane / nearPlane));
+    return static_cast<uint32_t>(std::min(slice, static_cast<float>(CLUSTER_Z - 1)));
+}
+
+void buildLightClusters(const std::vector<PointLight>& lights, const glm::mat4& view,
+                        const glm::mat4& projection, float nearPlane, float farPlane,
+                        LightClusters& clusters, ThreadPool& pool) {
+    auto start = std::chrono::steady_clock::now();
+    ClusterStats& stats = clusters.stats;
+    stats = ClusterStats();
+    stats.lights = lights.size();
+
+    // Ближние к камере - первыми: при обрезке списка кластера остаются они
+    const size_t count = lights.size();
+    clusters.order.resize(count);
+    clusters.distances.resize(count);
+    std::iota(clusters.order.begin(), clusters.order.end(), 0u);
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        clusters.distances[i] = glm::dot(center, center);
+    }
+    const float* distances = clusters.distances.data();
+    std::sort(clusters.order.begin(), clusters.order.end(), [distances](uint32_t a, uint32_t b) {
+        return distances[a] < distances[b] || (distances[a] == distances[b] && a < b);
+    });
+    clusters.lights.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        clusters.lights[i] = lights[clusters.order[i]];
+    }
+
+    clusters.bounds.resize(count);
+    const PointLight* sorted = clusters.lights.data();
+    ClusterBounds* bounds = clusters.bounds.data();
+    pool.parallelFor(count, BOUNDS_GRAIN, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            bounds[i] = lightBounds(sorted[i], view, projection, nearPlane, farPlane);
+        }
+    });
+    for (size_t i = 0; i < count; i++) {
+        stats.visibleLights += bounds[i].xBegin <= bounds[i].xEnd ? 1 : 0;
+    }
+
+    // Каждый срез глубины - у одного потока: счётчики и списки его кластеров
+    // больше никто не трогает. Два прохода: подсчёт, затем заполнение
+    clusters.counts.assign(CLUSTER_COUNT, 0);
+    uint32_t* counts = clusters.counts.data();
+    auto forEachCluster = [&](size_t slice, auto&& visit) {
+        for (size_t i = 0; i < count; i++) {
+            const ClusterBounds& b = bounds[i];
+            if (b.xBegin > b.xEnd || slice < b.zBegin || slice > b.zEnd) continue;
+            for (uint32_t y = b.yBegin; y <= b.yEnd; y++) {
+                uint32_t row = (static_cast<uint32_t>(slice) * CLUSTER_Y + y) * CLUSTER_X;
+                for (uint32_t x = b.xBegin; x <= b.xEnd; x++) {
+                    visit(row + x, static_cast<uint32_t>(i));
+                }
+            }
+        }
+    };
+    pool.parallelFor(CLUSTER_Z, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t slice = begin; slice < end; slice++) {
+            forEachCluster(slice, [counts](uint32_t cluster, uint32_t) { counts[cluster]++; });
+        }
+    });
+
+    clusters.ranges.resize(CLUSTER_COUNT * 2);
+    uint32_t* ranges = clusters.ranges.data();
+    uint32_t offset = 0;
+    for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        uint32_t total = counts[cluster];
+        uint32_t kept = std::min(total, MAX_LIGHTS_PER_CLUSTER);
+        stats.maxPerCluster = std::max<size_t>(stats.maxPerCluster, total);
+        stats.overflowClusters += total > kept ? 1 : 0;
+        ranges[cluster * 2] = offset;
+        ranges[cluster * 2 + 1] = kept;
+        offset += kept;
+        counts[cluster] = 0;
+    }
+    stats.references = offset;
+
+    clusters.lightIndices.resize(offset);
+    uint32_t* indices = clusters.lightIndices.data();
+    pool.parallelFor(CLUSTER_Z, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t slice = begin; slice < end; slice++) {
+            forEachCluster(slice, [counts, ranges, indices](uint32_t cluster, uint32_t light) {
+                if (counts[cluster] < ranges[cluster * 2 + 1]) {
+                    indices[ranges[cluster * 2] + counts[cluster]++] = light;
+                }
+            });
+        }
+    });
+
+    stats.seconds = secondsSince(start);
+}
@@ -4,12 +4,40 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 
 #include "shader.h"
+#include "shader_cache.h"
 #include "obj_loader.h"
 #include "camera.h"
 #include "solar_system.h"
+#include "orbit_geometry.h"
+#include "scene_loader.h"
+#include "app_options.h"
+#include "profiler.h"
+#include "gpu_timer.h"
+#include "input_recorder.h"
+#include "checkpoint.h"
+#include "occlusion_culler.h"
+#include "far_field.h"
+#include "impostor.h"
+#include "belt_renderer.h"
+#include "trail_renderer.h"
+#include "picking.h"
+#include "collision.h"
+#include "light_clusters.h"
+#include "metrics_server.h"
+#include "frame_arena.h"
+#include "resource_registry.h"
+#include "scene_generator.h"
+#include "frame_governor.h"
+#include "allocation_tracker.h"
+#include "startup_graph.h"
+#include "thread_pool.h"
+#include "compiled_asset.h"
 
 // =====================================================
 // ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ ДЛЯ ОРБИТ
@@ -17,11 +45,25 @@
 
 GLuint orbitShaderProgram = 0;
 GLuint orbitVAO = 0, orbitVBO = 0;
-std::vector<float> orbitVertices;
+std::vector<float> orbitVertices;        // единичные окружности всех уровней
+std::vector<OrbitLevel> orbitLevels;
+std::vector<glm::vec4> orbitShapes;       // центр и радиус каждой орбиты
 std::vector<glm::vec3> orbitColors;
-std::vector<int> orbitSegmentStarts;
-std::vector<int> orbitSegmentCounts;
 bool showOrbits = true;
+// Допустимое отклонение ломаной орбиты от окружности на экране, пикс.
+float orbitTolerancePixels = 0.5f;
+
+struct OrbitTotals {
+    size_t frames = 0;
+    size_t orbits = 0;
+    size_t segments = 0;
+    size_t lastSegments = 0;    // в последнем кадре - для метрик
+} orbitTotals;
+
+// Следы: последние trailLength положений каждого тела в кольцевом буфере на GPU
+TrailRenderer trailRenderer;
+size_t trailLength = 64;
+const size_t TRAIL_BUDGET_BYTES = 256 * 1024 * 1024;
 
 // =====================================================
 // ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ ДЛЯ ИНСТАНЦИРОВАНИЯ
@@ -29,102 +71,231 @@ bool showOrbits = true;
 
 OBJModel planetModel;              
 InstancedShader* instancedShader = nullptr;
+ProgramCache programCache;
+uint32_t shaderFeatures = SHADER_DEFAULT_FEATURES;
 Camera* camera = nullptr;
 SolarSystem* solarSystem = nullptr;
 
 GLuint sunTexture = 0;
 GLuint planetTexture = 0;
+// Текстуры материалов модели по номеру материала; 0 - planetTexture
+std::vector<GLuint> materialTextures;
+
+AppOptions appOptions;
+GpuTimer gpuTimer;
+CheckpointManager checkpoints;
+
+// Временные данные кадра; сбрасывается в начале каждого кадра
+FrameArena frameArena;
+
+// Вызовы отрисовки и загрузки на GPU текущего кадра - для метрик
+struct FrameCounters {
+    size_t drawCalls = 0;
+    size_t uploadBytes = 0;
+} frameCounters;
+
+MetricsServer metricsServer;
+MetricsSnapshot frameMetrics;
+
+// Столько времён кадров резервируется в живой сессии (~70 минут при 60 FPS)
+const size_t FRAME_HISTORY_RESERVE = 1 << 18;
 
 GLuint instanceVBO = 0;
+GLuint instanceDissolveVBO = 0;
 GLuint instanceVAO = 0;
 size_t instanceCount = 0;
 
 // =====================================================
-// ФУНКЦИИ ДЛЯ ОРБИТ
+// УЧЁТ ПАМЯТИ
 // =====================================================
 
-std::vector<float> createOrbitCircle(float radius, int segments = 100) {
-    std::vector<float> vertices;
-    for (int i = 0; i <= segments; i++) {
-        float angle = (i / (float)segments) * 2.0f * 3.14159265f;
-        vertices.push_back(radius * std::cos(angle));  
-        vertices.push_back(0.0f);                      
-        vertices.push_back(radius * std::sin(angle));  
-    }
-    return vertices;
-}
+ResourceId instanceResource = NO_RESOURCE;
+ResourceId instanceDissolveResource = NO_RESOURCE;
+ResourceId orbitBufferResource = NO_RESOURCE;
+ResourceId orbitCpuResource = NO_RESOURCE;
+
+// Текстура, которую можно ужать при превышении бюджета GPU
+struct ManagedTexture {
+    GLuint texture = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 1;            // уровней mip; ужимается только RGBA8 с levels > 1
+    ResourceId resource = NO_RESOURCE;
+};
+std::vector<ManagedTexture> managedTextures;
+// Меньше этой стороны текстуры не ужимаются
+const uint32_t MIN_DEMOTED_TEXTURE_SIZE = 64;
+
+// LOD модели планеты на GPU: 0 - полный. Уровни есть только у .smesh
+int planetGpuLod = 0;
+int planetLodCount = 1;
+int planetMemoryLod = 0;            // не точнее этого - по бюджету GPU
+int planetQualityLod = 0;           // не точнее этого - по регулятору качества
+// Разобранный .smesh со всеми LOD: смена LOD распаковывает его, не читая файл
+CompiledMesh planetCompiled;
+ResourceId planetCompiledResource = NO_RESOURCE;
+
+bool releaseCpuCopies = false;      // освобождать копии на CPU после загрузки
+size_t memoryDemotions = 0;
 
-void initOrbitShader() {  
-    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &orbitVertexShader, NULL);
-    glCompileShader(vertex);
-    
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cerr << "Ошибка компиляции вертексного шейдера орбит:\n" << infoLog << std::endl;
-    }
-    
-    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &orbitFragmentShader, NULL);
-    glCompileShader(fragment);
-    
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cerr << "Ошибка компиляции фрагментного шейдера орбит:\n" << infoLog << std::endl;
-    }
-    
-    orbitShaderProgram = glCreateProgram();
-    glAttachShader(orbitShaderProgram, vertex);
-    glAttachShader(orbitShaderProgram, fragment);
-    glLinkProgram(orbitShaderProgram);
-    
-    glGetProgramiv(orbitShaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(orbitShaderProgram, 512, NULL, infoLog);
-        std::cerr << "Ошибка линковки шейдера орбит:\n" << infoLog << std::endl;
+// =====================================================
+// РЕГУЛЯТОР КАЧЕСТВА
+// =====================================================
+
+FrameGovernor frameGovernor;
+FrameGpuClock frameGpuClock;
+bool governorEnabled = false;
+int simulationSubsteps = 1;         // шагов симуляции за кадр при полном качестве
+float baseImpostorPixels = 6.0f;    // порог импосторов и допуск орбит при полном качестве
+float baseOrbitTolerance = 0.5f;
+bool msaaAvailable = false;
+// Ступени рычагов импосторов и орбит: множитель 2 за ступень
+const int GOVERNOR_SCALE_LEVELS = 3;
+
+// =====================================================
+// ОТСЕЧЕНИЕ ПЕРЕКРЫТЫХ ТЕЛ
+// =====================================================
+
+const int OCCLUSION_WIDTH = 256;
+const int OCCLUSION_HEIGHT = 160;
+const size_t MAX_OCCLUDERS = 4;
+
+OcclusionCuller* occlusionCuller = nullptr;
+bool occlusionCulling = true;
+float planetRadius = 1.0f;
+std::vector<uint32_t> visibleBodies;
+
+// =====================================================
+// ВЫБОР ТЕЛА МЫШЬЮ
+// =====================================================
+
+MeshBVH planetBVH;
+BodyPicker* bodyPicker = nullptr;
+
+// Накопленные за сессию результаты для сводки при выходе
+struct OcclusionTotals {
+    size_t frames = 0;
+    size_t tested = 0;
+    size_t occluded = 0;
+    size_t frustumCulled = 0;
+    double seconds = 0.0;
+} occlusionTotals;
+
+// =====================================================
+// ПЕРЕСЕЧЕНИЯ ТЕЛ
+// =====================================================
+
+CollisionDetector* collisionDetector = nullptr;
+
+struct CollisionTotals {
+    size_t frames = 0;
+    size_t candidates = 0;
+    size_t contacts = 0;
+    size_t maxContacts = 0;
+    size_t rebuilds = 0;
+    double broadphaseSeconds = 0.0;
+    double narrowSeconds = 0.0;
+} collisionTotals;
+
+// =====================================================
+// ДАЛЬНИЕ ТЕЛА (ИМПОСТОРЫ)
+// =====================================================
+
+FarFieldSettings farField;
+FarFieldSplit farFieldSplit;
+ImpostorRenderer impostorRenderer;
+bool impostorsReady = false;
+
+struct FarFieldTotals {
+    size_t frames = 0;
+    size_t meshes = 0;
+    size_t impostors = 0;
+    size_t crossfading = 0;
+} farFieldTotals;
+
+// =====================================================
+// КЛАСТЕРНОЕ ОСВЕЩЕНИЕ
+// =====================================================
+
+bool clusteredLighting = false;
+std::vector<uint32_t> lightBodies;
+// Выбор светящихся тел сделан для текущей сцены; пустой выбор - тоже выбор
+bool lightBodiesSelected = false;
+std::vector<PointLight> frameLights;
+LightClusters lightClusters;
+
+// Списки уходят в шейдер через texture buffer: буфер и текстура-вид на него
+struct TextureBuffer {
+    GLuint buffer = 0;
+    GLuint texture = 0;
+    ResourceId resource = NO_RESOURCE;
+};
+TextureBuffer lightDataBuffer;      // RGBA32F, два texel на источник
+TextureBuffer clusterRangeBuffer;   // RG32UI, смещение и число на кластер
+TextureBuffer clusterLightBuffer;   // R32UI, номера источников
+
+struct LightingTotals {
+    size_t frames = 0;
+    size_t lights = 0;
+    size_t visibleLights = 0;
+    size_t references = 0;
+    size_t maxPerCluster = 0;
+    size_t overflowClusters = 0;
+    double seconds = 0.0;
+} lightingTotals;
+
+// =====================================================
+// ПОЯС АСТЕРОИДОВ
+// =====================================================
+
+AsteroidBeltParams asteroidBelt;
+BeltRenderer beltRenderer;
+bool beltReady = false;
+
+// Сколько астероидов сверять с эталоном на CPU при запуске
+const size_t BELT_VERIFY_SAMPLES = 65536;
+// Допустимое отклонение относительно радиуса пояса: sin/cos на GPU менее точны
+const float BELT_VERIFY_TOLERANCE = 1e-3f;
+
+// =====================================================
+// ФУНКЦИИ ДЛЯ ОРБИТ
+// =====================================================
+
+void initOrbitShader() {
+    orbitShaderProgram = programCache.build("orbits", orbitVertexShader, orbitFragmentShader);
+    if (orbitShaderProgram != 0) {
+        std::cout << "Шейдер для орбит готов" << std::endl;
     }
-    
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    
-    std::cout << "Шейдер для орбит скомпилирован" << std::endl;
 }
 
-void initOrbits() {
+// Геометрия орбит на CPU, без обращений к OpenGL
+void buildOrbitGeometry() {
+    // Повторный вызов (после восстановления снимка) строит орбиты заново
+    buildOrbitLevels(orbitVertices, orbitLevels);
+    orbitShapes.clear();
+    orbitColors.clear();
     if (!solarSystem) return;
     
     const auto& bodies = solarSystem->getBodies();
     
-    std::vector<glm::vec3> colors = {
-        glm::vec3(1.0f, 0.5f, 0.0f),  
-        glm::vec3(0.0f, 0.8f, 1.0f),  
-        glm::vec3(0.0f, 1.0f, 0.5f),  
-        glm::vec3(1.0f, 0.0f, 0.5f),  
-        glm::vec3(0.5f, 0.0f, 1.0f),  
-        glm::vec3(1.0f, 1.0f, 0.0f),  
-        glm::vec3(1.0f, 0.8f, 0.0f),  
-    };
-    
     for (size_t i = 1; i < bodies.size(); i++) {  
         const auto& body = bodies[i];
         if (body.orbitRadius > 0.0f) {
-            auto circleVertices = createOrbitCircle(body.orbitRadius);
-            
-            orbitSegmentStarts.push_back(orbitVertices.size() / 3);  
-            orbitSegmentCounts.push_back(circleVertices.size() / 3); 
-            
-            orbitVertices.insert(orbitVertices.end(), 
-                                circleVertices.begin(), 
-                                circleVertices.end());
-            
-            int colorIndex = (i - 1) % colors.size();
-            orbitColors.push_back(colors[colorIndex]);
+            orbitShapes.push_back(glm::vec4(body.orbitCenter, body.orbitRadius));
+            orbitColors.push_back(orbitColor(i));
         }
     }
+}
+
+// Загрузить орбиты из buildOrbitGeometry в буфер и начать следы заново
+void uploadOrbits() {
+    if (!solarSystem) return;
+
+    if (orbitVAO != 0) {
+        glDeleteVertexArrays(1, &orbitVAO);
+        glDeleteBuffers(1, &orbitVBO);
+        orbitVAO = orbitVBO = 0;
+    }
     
     if (!orbitVertices.empty()) {
         glGenVertexArrays(1, &orbitVAO);
@@ -144,10 +315,25 @@ void initOrbits() {
         
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+
+        ResourceRegistry& registry = ResourceRegistry::shared();
+        registry.track(orbitBufferResource, "орбиты: окружности", RESOURCE_BUFFER, orbitVertices.size() * sizeof(float));
+        registry.track(orbitCpuResource, "орбиты: окружности", RESOURCE_CPU_MIRROR,
+                       orbitVertices.capacity() * sizeof(float));
+    }
+
+    // История следов начинается заново с текущих положений
+    if (trailLength > 0) {
+        trailRenderer.reset(solarSystem->getBodyCount(), trailLength, TRAIL_BUDGET_BYTES);
     }
 }
 
-void renderOrbits(const glm::mat4& view, const glm::mat4& projection) {
+void initOrbits() {
+    buildOrbitGeometry();
+    uploadOrbits();
+}
+
+void renderOrbits(const glm::mat4& view, const glm::mat4& projection, float viewportHeight) {
     if (!showOrbits || orbitVAO == 0 || orbitShaderProgram == 0) return;
     
     glUseProgram(orbitShaderProgram);
@@ -155,6 +341,7 @@ void renderOrbits(const glm::mat4& view, const glm::mat4& projection) {
     GLint viewLoc = glGetUniformLocation(orbitShaderProgram, "view");
     GLint projLoc = glGetUniformLocation(orbitShaderProgram, "projection");
     GLint colorLoc = glGetUniformLocation(orbitShaderProgram, "color");
+    GLint orbitLoc = glGetUniformLocation(orbitShaderProgram, "orbit");
     
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
@@ -165,12 +352,25 @@ void renderOrbits(const glm::mat4& view, const glm::mat4& projection) {
     
     glBindVertexArray(orbitVAO);
     
-    for (size_t i = 0; i < orbitSegmentStarts.size(); i++) {
+    // Уровень окружности - по размеру орбиты на экране в этом кадре
+    const float focalPixels = projection[1][1] * viewportHeight * 0.5f;
+    size_t segments = 0;
+    for (size_t i = 0; i < orbitShapes.size(); i++) {
+        const glm::vec4& shape = orbitShapes[i];
+        float radiusPixels = orbitRadiusPixels(glm::vec3(shape), shape.w, camera->position, focalPixels);
+        const OrbitLevel& level =
+            orbitLevels[orbitLevelForSegments(orbitSegmentsForError(radiusPixels, orbitTolerancePixels))];
+        segments += level.count - 1;
+
+        glUniform4fv(orbitLoc, 1, glm::value_ptr(shape));
         glUniform3fv(colorLoc, 1, glm::value_ptr(orbitColors[i]));
-        glDrawArrays(GL_LINE_STRIP, 
-                    orbitSegmentStarts[i], 
-                    orbitSegmentCounts[i]);
+        glDrawArrays(GL_LINE_STRIP, level.first, level.count);
     }
+    frameCounters.drawCalls += orbitShapes.size();
+    orbitTotals.frames++;
+    orbitTotals.orbits += orbitShapes.size();
+    orbitTotals.segments += segments;
+    orbitTotals.lastSegments = segments;
     
     glBindVertexArray(0);
     
@@ -183,6 +383,11 @@ void renderOrbits(const glm::mat4& view, const glm::mat4& projection) {
 // ФУНКЦИИ ДЛЯ ИНСТАНЦИРОВАННОГО РЕНДЕРИНГА
 // =====================================================
 
+// Сколько vec4 занимает один инстанс в буфере
+GLuint instanceVectors() {
+    return (shaderFeatures & SHADER_COMPACT_INSTANCES) ? 3 : 4;
+}
+
 void setupInstancedRendering() {
     glGenVertexArrays(1, &instanceVAO);
     glGenBuffers(1, &instanceVBO);
@@ -211,52 +416,219 @@ void setupInstancedRendering() {
 
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
 
-    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::mat4),
-                        (void*)0);
-    glEnableVertexAttribArray(3);
+    // Матрица инстанса - 4 столбца, в компактном варианте 3 строки
+    const GLuint instanceColumns = instanceVectors();
+    const GLsizei instanceStride = static_cast<GLsizei>(instanceColumns * sizeof(glm::vec4));
+    for (GLuint i = 0; i < instanceColumns; i++) {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE,
+                            instanceStride,
+                            (void*)(i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
 
-    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::mat4),
-                        (void*)(sizeof(glm::vec4)));
-    glEnableVertexAttribArray(4);
+    // Переход к импостору: массив включается, только когда есть дальние тела
+    glGenBuffers(1, &instanceDissolveVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceDissolveVBO);
+    glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+    glVertexAttribDivisor(7, 1);
 
-    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::mat4),
-                        (void*)(2 * sizeof(glm::vec4)));
-    glEnableVertexAttribArray(5);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planetModel.EBO);
 
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::mat4),
-                        (void*)(3 * sizeof(glm::vec4)));
-    glEnableVertexAttribArray(6);
+    glBindVertexArray(0);
+}
 
-    glVertexAttribDivisor(3, 1);
-    glVertexAttribDivisor(4, 1);
-    glVertexAttribDivisor(5, 1);
-    glVertexAttribDivisor(6, 1);
+SoftMesh planetMesh() {
+    SoftMesh mesh;
+    mesh.vertices = planetModel.vertices.data();
+    mesh.vertexCount = planetModel.vertices.size();
+    mesh.indices = planetModel.indices.data();
+    mesh.indexCount = planetModel.indices.size();
+    return mesh;
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planetModel.EBO);
+// Луч из точки окна - в ближайшее тело, результат в консоль
+void pickBodyAt(int x, int y, float width, float height) {
+    if (!bodyPicker || planetBVH.empty()) return;
 
-    glBindVertexArray(0);
+    auto start = std::chrono::steady_clock::now();
+    PickRay ray = screenRay(*camera, static_cast<float>(x), static_cast<float>(y), width, height);
+    PickResult result = bodyPicker->pick(solarSystem->getBodies(), planetBVH, planetRadius, ray);
+    double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    if (result.hit) {
+        std::printf("Выбрано тело %u: расстояние %.2f, точка (%.2f, %.2f, %.2f), треугольник %u\n",
+                    result.body, result.distance, result.point.x, result.point.y, result.point.z,
+                    result.triangle);
+    } else {
+        std::printf("Луч ни во что не попал\n");
+    }
+    std::printf("  %zu тел по сферам, %zu проверено по BVH, %.1f мкс\n",
+                result.candidates, result.meshTests, micros);
 }
 
-void updateInstanceBuffer() {
-    if (solarSystem == nullptr) return;
+// Пары пересекающихся тел после шага симуляции; пока только учёт для сводки
+void detectCollisions() {
+    if (!collisionDetector) return;
+
+    collisionDetector->detect(solarSystem->getBodies(), planetRadius);
+    const CollisionStats& stats = collisionDetector->getStats();
+    collisionTotals.frames++;
+    collisionTotals.candidates += stats.candidates;
+    collisionTotals.contacts += stats.contacts;
+    collisionTotals.maxContacts = std::max(collisionTotals.maxContacts, stats.contacts);
+    collisionTotals.rebuilds += stats.rebuilt ? 1 : 0;
+    collisionTotals.broadphaseSeconds += stats.broadphaseSeconds();
+    collisionTotals.narrowSeconds += stats.narrowSeconds;
+}
 
-    std::vector<glm::mat4> modelMatrices = solarSystem->getModelMatrices();
-    instanceCount = modelMatrices.size();
+// Снимок кадра для сервера метрик; публикация не ждёт читателя
+void publishFrameMetrics(double frameSeconds, double tickSeconds) {
+    if (!metricsServer.isRunning()) return;
+
+    MetricsSnapshot& metrics = frameMetrics;
+    recordFrameTime(metrics, frameSeconds);
+    metrics.drawCalls = frameCounters.drawCalls;
+    metrics.drawCallsTotal += frameCounters.drawCalls;
+    metrics.uploadBytes = frameCounters.uploadBytes;
+    metrics.uploadBytesTotal += frameCounters.uploadBytes;
+    metrics.simulationTicks++;
+    metrics.simulationTickSeconds += tickSeconds;
+    metrics.simulationTime = solarSystem->getTime();
+
+    metrics.bodies = solarSystem->getBodyCount();
+    metrics.visibleBodies = metrics.bodies;
+    metrics.occludedBodies = 0;
+    metrics.frustumCulledBodies = 0;
+    if (occlusionCulling && occlusionCuller) {
+        const OcclusionStats& stats = occlusionCuller->getStats();
+        metrics.visibleBodies = stats.visible();
+        metrics.occludedBodies = stats.occluded;
+        metrics.frustumCulledBodies = stats.frustumCulled;
+    }
+    metrics.meshInstances = instanceCount;
+    metrics.impostors = farField.enabled && impostorsReady ? farFieldSplit.impostors.size() : 0;
+    metrics.lights = clusteredLighting ? lightClusters.stats.lights : 1;
+    metrics.collisionContacts = collisionDetector ? collisionDetector->getStats().contacts : 0;
+    metrics.orbitsVisible = showOrbits;
+    metrics.orbitSegments = showOrbits ? orbitTotals.lastSegments : 0;
+    metrics.occlusionEnabled = occlusionCulling;
+    metrics.gpuMemoryBytes = ResourceRegistry::shared().totalBytes(MEMORY_GPU);
+    metrics.cpuMemoryBytes = ResourceRegistry::shared().totalBytes(MEMORY_CPU);
+    metrics.memoryDemotions = memoryDemotions;
+    metrics.governorEnabled = governorEnabled;
+    if (governorEnabled) {
+        metrics.governorCpuSeconds = frameGovernor.getSmoothedCpu();
+        metrics.governorGpuSeconds = frameGovernor.getSmoothedGpu();
+        metrics.qualityDowngrades = frameGovernor.getDowngrades();
+        metrics.qualityUpgrades = frameGovernor.getUpgrades();
+        for (uint32_t lever = 0; lever < QUALITY_LEVER_COUNT; lever++) {
+            metrics.qualityLevels[lever] = frameGovernor.getLevel(static_cast<QualityLever>(lever));
+        }
+    }
+    metricsServer.publish(metrics);
+}
 
+// Крупнейшие на экране тела - в буфер глубины, остальные проверяются по пирамиде
+void cullOccludedBodies(const glm::mat4& view, const glm::mat4& projection) {
+    PROFILE_SCOPE("occlusionCulling");
+
+    const auto& bodies = solarSystem->getBodies();
+    SoftMesh mesh = planetMesh();
+
+    occlusionCuller->beginFrame(view, projection);
+    for (uint32_t index : occlusionCuller->selectOccluders(bodies, planetRadius, MAX_OCCLUDERS)) {
+        occlusionCuller->addOccluder(mesh, bodies[index].getModelMatrix());
+    }
+    occlusionCuller->buildPyramid();
+    occlusionCuller->cullBodies(bodies, planetRadius, visibleBodies);
+
+    const OcclusionStats& stats = occlusionCuller->getStats();
+    occlusionTotals.frames++;
+    occlusionTotals.tested += stats.tested;
+    occlusionTotals.occluded += stats.occluded;
+    occlusionTotals.frustumCulled += stats.frustumCulled;
+    occlusionTotals.seconds += stats.totalSeconds();
+}
+
+// dissolve == nullptr - все инстансы рисуются мешем целиком
+void uploadInstances(const glm::mat4* matrices, const float* dissolve, size_t count) {
+    instanceCount = count;
     if (instanceCount == 0) return;
 
+    const void* instanceData = matrices;
+    if (shaderFeatures & SHADER_COMPACT_INSTANCES) {
+        // Четвёртая строка аффинной матрицы всегда (0, 0, 0, 1) - не передаём
+        glm::vec4* rows = frameArena.allocateArray<glm::vec4>(instanceCount * 3);
+        for (size_t i = 0; i < instanceCount; i++) {
+            const glm::mat4& m = matrices[i];
+            for (int r = 0; r < 3; r++) {
+                rows[i * 3 + r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+            }
+        }
+        instanceData = rows;
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
     glBufferData(GL_ARRAY_BUFFER,
-                instanceCount * sizeof(glm::mat4),
-                modelMatrices.data(),
+                instanceCount * instanceVectors() * sizeof(glm::vec4),
+                instanceData,
                 GL_DYNAMIC_DRAW);
+    frameCounters.uploadBytes += instanceCount * instanceVectors() * sizeof(glm::vec4);
+    ResourceRegistry::shared().track(instanceResource, "инстансы: матрицы", RESOURCE_BUFFER,
+                                     instanceCount * instanceVectors() * sizeof(glm::vec4));
+
+    glBindVertexArray(instanceVAO);
+    if (dissolve) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceDissolveVBO);
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(float), dissolve, GL_DYNAMIC_DRAW);
+        frameCounters.uploadBytes += instanceCount * sizeof(float);
+        ResourceRegistry::shared().track(instanceDissolveResource, "инстансы: растворение", RESOURCE_BUFFER,
+                                         instanceCount * sizeof(float));
+        glEnableVertexAttribArray(7);
+    } else {
+        // Значение атрибута по умолчанию - 0
+        glDisableVertexAttribArray(7);
+    }
+    glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+// Разделить тела на меши и импосторы и загрузить инстансы мешей
+void updateFarFieldInstances(const glm::mat4& view, const glm::mat4& projection, float viewportHeight,
+                             const std::vector<uint32_t>* visible) {
+    PROFILE_SCOPE("splitFarField");
+
+    splitFarField(solarSystem->getBodies(), visible, planetRadius, view, projection, viewportHeight,
+                  farField, farFieldSplit, ThreadPool::shared());
+    uploadInstances(farFieldSplit.meshMatrices.data(), farFieldSplit.meshDissolve.data(),
+                    farFieldSplit.meshMatrices.size());
+
+    farFieldTotals.frames++;
+    farFieldTotals.meshes += farFieldSplit.meshMatrices.size();
+    farFieldTotals.impostors += farFieldSplit.impostors.size();
+    farFieldTotals.crossfading += farFieldSplit.crossfading;
+}
+
+// visible - индексы тел после отсечения, nullptr - все тела
+void updateInstanceBuffer(const std::vector<uint32_t>* visible = nullptr) {
+    if (solarSystem == nullptr) return;
+
+    PROFILE_SCOPE("updateInstanceBuffer");
+
+    size_t count = visible ? visible->size() : solarSystem->getBodyCount();
+    glm::mat4* modelMatrices = frameArena.allocateArray<glm::mat4>(count);
+    if (visible) {
+        const auto& bodies = solarSystem->getBodies();
+        for (size_t i = 0; i < count; i++) {
+            modelMatrices[i] = bodies[(*visible)[i]].getModelMatrix();
+        }
+    } else {
+        solarSystem->writeModelMatrices(modelMatrices);
+    }
+    uploadInstances(modelMatrices, nullptr, count);
+}
+
 // =====================================================
 // ИНИЦИАЛИЗАЦИЯ
 // =====================================================
@@ -273,15 +645,98 @@ void initGL() {
 }
 
 void initShaders() {
-    instancedShader = new InstancedShader();
-    std::cout << "Инстанцированные шейдеры скомпилированы" << std::endl;    
+    auto start = std::chrono::steady_clock::now();
+    programCache.init(appOptions.shaderCachePath);
+
+    instancedShader = new InstancedShader(programCache, shaderFeatures);
+    if (instancedShader->isValid()) {
+        std::cout << "Инстанцированные шейдеры готовы (вариант "
+                  << shaderFeatures << ")" << std::endl;
+    }
     initOrbitShader();
+
+    // Холодный кэш - всё компилируется, тёплый - только загрузка бинарников
+    const ProgramCacheStats& stats = programCache.getStats();
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Шейдеры: %.1f мс; из кэша %zu (%.1f мс), скомпилировано %zu (%.1f мс)%s\n",
+                millis, stats.hits, stats.loadSeconds * 1000.0, stats.misses, stats.compileSeconds * 1000.0,
+                programCache.isEnabled() ? "" : ", кэш выключен");
+    if (stats.rejected > 0) {
+        std::printf("  %zu файлов кэша отброшено (другой драйвер или повреждены)\n", stats.rejected);
+    }
 }
 
-GLuint loadSimpleTexture(const std::string& filename) {
+// Картинка, декодированная на любом потоке; в GL загружается uploadTexture
+struct DecodedTexture {
+    explicit DecodedTexture(const std::string& filename) : filename(filename) {}
+
+    std::string filename;
     sf::Image image;
-    if (image.loadFromFile(filename)) {
-        image.flipVertically();
+    CompiledTexture compiled;       // .stex от solar_assetc: все уровни mip готовы
+    bool fromCompiled = false;
+    bool loaded = false;
+};
+
+std::string compiledAssetPath(const std::string& source, const char* extension);
+
+void trackTexture(GLuint texture, const std::string& name, uint32_t width, uint32_t height,
+                  uint32_t bytesPerTexel, uint32_t levels) {
+    ManagedTexture managed;
+    managed.texture = texture;
+    managed.width = width;
+    managed.height = height;
+    managed.levels = levels;
+    ResourceRegistry::shared().track(managed.resource, name.c_str(), RESOURCE_TEXTURE,
+                                     mipChainBytes(width, height, bytesPerTexel, levels));
+    managedTextures.push_back(managed);
+}
+
+void decodeTexture(DecodedTexture& texture) {
+    const std::string compiledPath = compiledAssetPath(texture.filename, ".stex");
+    if (compiledAssetIsCurrent(compiledPath, texture.filename) &&
+        readCompiledTexture(compiledPath, texture.compiled)) {
+        texture.fromCompiled = true;
+        texture.loaded = true;
+        return;
+    }
+
+    texture.loaded = texture.image.loadFromFile(texture.filename);
+    if (texture.loaded) {
+        texture.image.flipVertically();
+    }
+}
+
+GLuint uploadTexture(const DecodedTexture& decoded) {
+    const std::string& filename = decoded.filename;
+    if (decoded.loaded && decoded.fromCompiled) {
+        const CompiledTexture& compiled = decoded.compiled;
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(compiled.mips.size()) - 1);
+
+        // Уровни уже посчитаны компилятором - без glGenerateMipmap
+        for (size_t level = 0; level < compiled.mips.size(); level++) {
+            const CompiledTextureMip& mip = compiled.mips[level];
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA,
+                        mip.width, mip.height,
+                        0, GL_RGBA, GL_UNSIGNED_BYTE, compiled.texels.data() + mip.offset);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        trackTexture(texture, filename, compiled.mips[0].width, compiled.mips[0].height, 4,
+                     static_cast<uint32_t>(compiled.mips.size()));
+
+        std::cout << "Текстура загружена: " << filename << " (" << compiled.mips.size()
+                  << " уровней из .stex)" << std::endl;
+        return texture;
+    }
+
+    if (decoded.loaded) {
+        const sf::Image& image = decoded.image;
         GLuint texture;
         glGenTextures(1, &texture);
         glBindTexture(GL_TEXTURE_2D, texture);
@@ -297,6 +752,10 @@ GLuint loadSimpleTexture(const std::string& filename) {
         glGenerateMipmap(GL_TEXTURE_2D);
         glBindTexture(GL_TEXTURE_2D, 0);
 
+        uint32_t levels = 1;
+        for (uint32_t side = std::max(size.x, size.y); side > 1; side /= 2) levels++;
+        trackTexture(texture, filename, size.x, size.y, 4, levels);
+
         std::cout << "Текстура загружена: " << filename << std::endl;
         return texture;
     }
@@ -325,54 +784,476 @@ GLuint loadSimpleTexture(const std::string& filename) {
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 4, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
     glBindTexture(GL_TEXTURE_2D, 0);
+    trackTexture(texture, filename, 4, 4, 3, 1);
 
     return texture;
 }
 
-void initModelsAndSystem() {
-    if (!planetModel.load("models/fish.obj")) {
+// Модель на CPU; без файла - куб
+// Путь к результату solar_assetc рядом с исходником: fish.obj -> fish.smesh
+std::string compiledAssetPath(const std::string& source, const char* extension) {
+    return source.substr(0, source.find_last_of('.')) + extension;
+}
+
+void parsePlanetModel() {
+    const std::string modelPath = "models/fish.obj";
+    const std::string compiledPath = compiledAssetPath(modelPath, ".smesh");
+    CompiledMesh& compiled = planetCompiled;
+    bool compiledUsable = compiledAssetIsCurrent(compiledPath, modelPath) && readCompiledMesh(compiledPath, compiled);
+    // Материалов в .smesh нет: без флага модель берётся из OBJ с её MTL
+    if (compiledUsable && !(compiled.header.flags & COMPILED_MESH_SINGLE_MATERIAL)) {
+        std::cerr << compiledPath << " собран без проверки материалов - модель читается из OBJ" << std::endl;
+        compiledUsable = false;
+    }
+    if (compiledUsable) {
+        // CPU-структурам (BVH, отсечение, импосторы) нужны float-вершины -
+        // берём LOD 0 с распаковкой, зато без разбора текста OBJ
+        unpackCompiledLod(compiled, 0, planetModel.vertices, planetModel.indices);
+        planetModel.indexCount = planetModel.indices.size();
+        planetModel.setSingleMaterial(planetModel.indexCount);
+        planetModel.name = modelPath;
+        planetLodCount = static_cast<int>(compiled.lods.size());
+        ResourceRegistry::shared().track(planetCompiledResource, "модель планеты: .smesh", RESOURCE_CPU_MIRROR,
+                                         compiled.vertices.size() * sizeof(QuantizedVertex) +
+                                         compiled.indices.size() * sizeof(uint32_t));
+        std::cout << "Модель планеты загружена из " << compiledPath << ": "
+                  << planetModel.vertices.size() << " вершин, "
+                  << planetModel.indices.size() << " индексов" << std::endl;
+        return;
+    }
+
+    planetCompiled = CompiledMesh();
+    if (!planetModel.parse(modelPath)) {
         std::cerr << "Ошибка загрузки модели планеты" << std::endl;
+        planetModel.fillFallbackModel();
     } else {
         std::cout << "Модель планеты загружена: "
                   << planetModel.vertices.size() << " вершин, "
-                  << planetModel.indices.size() << " индексов" << std::endl;
+                  << planetModel.indices.size() << " индексов, "
+                  << planetModel.submeshes.size() << " материалов, "
+                  << planetModel.groupCount << " групп" << std::endl;
     }
+}
+
+// Всё, что строится по модели на CPU: радиус, BVH, отсечение
+void buildPlanetStructures() {
+    planetRadius = meshBoundingRadius(planetMesh());
+    occlusionCuller = new OcclusionCuller(OCCLUSION_WIDTH, OCCLUSION_HEIGHT, ThreadPool::shared());
 
-    sunTexture = loadSimpleTexture("textures/fish.png");
-    planetTexture = loadSimpleTexture("textures/fish.png");
+    planetBVH.build(planetMesh());
+    bodyPicker = new BodyPicker(ThreadPool::shared());
+    if (appOptions.collisions) {
+        collisionDetector = new CollisionDetector(ThreadPool::shared());
+    }
+    std::cout << "BVH модели: " << planetBVH.getStats().nodes << " узлов, глубина "
+              << planetBVH.getStats().maxDepth << ", построен за "
+              << planetBVH.getStats().buildSeconds * 1000.0 << " мс" << std::endl;
+}
 
-    setupInstancedRendering();
+void initImpostors() {
+    if (!farField.enabled) return;
 
-    solarSystem = new SolarSystem();
+    impostorsReady = impostorRenderer.init(planetModel, planetTexture, planetRadius);
+    if (!impostorsReady) {
+        std::cerr << "Импосторы недоступны, все тела рисуются мешем" << std::endl;
+    }
+}
+
+void createTextureBuffer(TextureBuffer& target, GLenum format, const char* name) {
+    glGenBuffers(1, &target.buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+    glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_BUFFER, target.texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, target.buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    ResourceRegistry::shared().track(target.resource, name, RESOURCE_BUFFER, 16);
+}
+
+void releaseTextureBuffer(TextureBuffer& target) {
+    glDeleteTextures(1, &target.texture);
+    glDeleteBuffers(1, &target.buffer);
+    ResourceRegistry::shared().untrack(target.resource);
+    target = TextureBuffer();
+}
+
+// Новое содержимое каждый кадр; пустой список - один нулевой элемент,
+// чтобы у текстуры всегда было хранилище
+void uploadTextureBuffer(TextureBuffer& target, const void* data, size_t bytes) {
+    static const uint32_t zeros[4] = {0, 0, 0, 0};
+    glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+    glBufferData(GL_TEXTURE_BUFFER, bytes > 0 ? bytes : sizeof(zeros), bytes > 0 ? data : zeros,
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    frameCounters.uploadBytes += bytes;
+    ResourceRegistry::shared().track(target.resource, "", RESOURCE_BUFFER, bytes > 0 ? bytes : sizeof(zeros));
+}
 
+void initClusteredLighting() {
+    if (!clusteredLighting) return;
 
-    CelestialBody sun;
-    sun.orbitRadius = 0.0f;
-    sun.orbitSpeed = 0.0f;
-    sun.rotationSpeed = 0.5f;
-    sun.scale = 15.0f;
-    sun.orbitCenter = glm::vec3(0.0f, 0.0f, 0.0f);
-    solarSystem->addBody(sun);
+    createTextureBuffer(lightDataBuffer, GL_RGBA32F, "освещение: источники");
+    createTextureBuffer(clusterRangeBuffer, GL_RG32UI, "освещение: диапазоны кластеров");
+    createTextureBuffer(clusterLightBuffer, GL_R32UI, "освещение: списки кластеров");
+    std::cout << "Кластерное освещение: сетка " << CLUSTER_X << "x" << CLUSTER_Y << "x" << CLUSTER_Z
+              << ", до " << MAX_LIGHTS_PER_CLUSTER << " источников на кластер" << std::endl;
+}
+
+// Источники в текущих положениях тел -> списки кластеров -> texture buffers
+void updateClusteredLights(const glm::mat4& view, const glm::mat4& projection) {
+    const auto& bodies = solarSystem->getBodies();
+    if (!lightBodiesSelected) {
+        selectLightBodies(bodies, appOptions.emissiveEvery, lightBodies);
+        lightBodiesSelected = true;
+    }
+    gatherBodyLights(bodies, lightBodies, frameLights);
+    buildLightClusters(frameLights, view, projection, camera->nearPlane, camera->farPlane,
+                       lightClusters, ThreadPool::shared());
+
+    uploadTextureBuffer(lightDataBuffer, lightClusters.lights.data(),
+                        lightClusters.lights.size() * sizeof(PointLight));
+    uploadTextureBuffer(clusterRangeBuffer, lightClusters.ranges.data(),
+                        lightClusters.ranges.size() * sizeof(uint32_t));
+    uploadTextureBuffer(clusterLightBuffer, lightClusters.lightIndices.data(),
+                        lightClusters.lightIndices.size() * sizeof(uint32_t));
+
+    const ClusterStats& stats = lightClusters.stats;
+    lightingTotals.frames++;
+    lightingTotals.lights += stats.lights;
+    lightingTotals.visibleLights += stats.visibleLights;
+    lightingTotals.references += stats.references;
+    lightingTotals.maxPerCluster = std::max(lightingTotals.maxPerCluster, stats.maxPerCluster);
+    lightingTotals.overflowClusters += stats.overflowClusters;
+    lightingTotals.seconds += stats.seconds;
+}
 
-    float radii[] = {4.0f, 6.0f, 8.0f, 10.0f, 13.0f, 16.0f};
-    float speeds[] = {3.0f, 2.0f, 1.5f, 1.2f, 0.8f, 0.5f};
-    float rotations[] = {4.0f, 3.0f, 2.5f, 2.0f, 1.5f, 1.0f};
-    float scales[] = {5.3f, 5.1f, 5.6f, 6.4f, 4.2f, 4.8f};
+// Тела сцены сменились - индексы светящихся тел больше не годятся
+void resetLightBodies() {
+    lightBodies.clear();
+    lightBodiesSelected = false;
+}
 
-    for (int i = 0; i < 6; i++) {
-        CelestialBody planet;
-        planet.orbitRadius = radii[i];
-        planet.orbitSpeed = speeds[i];
-        planet.rotationSpeed = rotations[i];
-        planet.scale = scales[i];
-        planet.orbitCenter = glm::vec3(0.0f, 0.0f, 0.0f);
-        solarSystem->addBody(planet);
+void bindClusteredLights(float width, float height) {
+    const TextureBuffer* buffers[3] = {&lightDataBuffer, &clusterRangeBuffer, &clusterLightBuffer};
+    const char* names[3] = {"lightData", "clusterRanges", "clusterLights"};
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE1 + i);
+        glBindTexture(GL_TEXTURE_BUFFER, buffers[i]->texture);
+        instancedShader->setInt(names[i], 1 + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform3i(glGetUniformLocation(instancedShader->programID, "clusterGrid"),
+                CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    glUniform2f(glGetUniformLocation(instancedShader->programID, "viewportSize"), width, height);
+    glUniform2f(glGetUniformLocation(instancedShader->programID, "clusterDepth"), camera->nearPlane,
+                CLUSTER_Z / std::log(camera->farPlane / camera->nearPlane));
+}
+
+void unbindClusteredLights() {
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE1 + i);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void initBelt() {
+    if (asteroidBelt.count == 0) return;
+
+    beltReady = beltRenderer.init();
+    if (beltReady) {
+        float error = beltRenderer.verify(asteroidBelt, 0.0f, BELT_VERIFY_SAMPLES);
+        size_t checked = std::min<size_t>(BELT_VERIFY_SAMPLES, asteroidBelt.count);
+        if (error < 0.0f || error > BELT_VERIFY_TOLERANCE * asteroidBelt.outerRadius) {
+            std::cerr << "Пояс астероидов: шейдер расходится с эталоном на CPU (отклонение "
+                      << error << " на " << checked << " астероидах)" << std::endl;
+        } else {
+            std::cout << "Пояс астероидов: " << asteroidBelt.count << " камней, проверено "
+                      << checked << ", наибольшее отклонение " << error << std::endl;
+        }
+    }
+}
+
+// Галактика по --galaxy и --galaxy-seed
+void generateSolarSystem(SolarSystem& system) {
+    GalaxyParams params;
+    params.bodyCount = appOptions.galaxyBodies;
+    params.seed = appOptions.galaxySeed;
+    GalaxyStats stats;
+    generateGalaxy(params, system, ThreadPool::shared(), &stats);
+    std::cout << "Галактика (seed " << params.seed << "): " << stats.bodies << " тел, " << stats.systems
+              << " систем в " << stats.clusters << " скоплениях, радиус " << stats.radius << ", за "
+              << stats.seconds * 1000.0 << " мс (" << stats.bodiesPerSecond() / 1e6 << " Mтел/с)" << std::endl;
+}
+
+void loadSolarSystem() {
+    solarSystem = new SolarSystem();
+
+    SceneLoadStats sceneStats;
+    if (appOptions.resume && checkpoints.restore(*solarSystem)) {
+        // Сцена из снимка, файл сцены не нужен
+    } else if (appOptions.galaxyBodies > 0) {
+        generateSolarSystem(*solarSystem);
+    } else if (loadScene(appOptions.scenePath, *solarSystem, &sceneStats) && solarSystem->getBodyCount() > 0) {
+        std::cout << "Сцена загружена из " << appOptions.scenePath << ": "
+                  << sceneStats.bodyCount << " тел за " << sceneStats.seconds * 1000.0 << " мс ("
+                  << sceneStats.bodiesPerSecond() / 1e6 << " Mтел/с, "
+                  << sceneStats.megabytesPerSecond() << " МБ/с)" << std::endl;
+    } else {
+        std::cerr << "Использую встроенную сцену" << std::endl;
+        buildDefaultScene(*solarSystem);
     }
 
     std::cout << "Солнечная система инициализирована (" << solarSystem->getBodyCount() << " объектов)" << std::endl;
+}
+
+// Запуск графом стадий: разбор модели, декодирование текстур, сцена и орбиты
+// идут на потоках пула, пока главный поток создаёт GL-ресурсы
+void initStartup() {
+    DecodedTexture sunImage("textures/fish.png");
+    DecodedTexture planetImage("textures/fish.png");
+
+    using Stage = StartupGraph::StageId;
+    StartupGraph graph;
+
+    Stage gl = graph.add("initGL", StageThread::MAIN, {}, initGL);
+    Stage shaders = graph.add("initShaders", StageThread::MAIN, {gl}, initShaders);
+
+    Stage model = graph.add("parseModel", StageThread::ANY, {}, parsePlanetModel);
+    Stage sunDecode = graph.add("decodeSunTexture", StageThread::ANY, {}, [&] { decodeTexture(sunImage); });
+    Stage planetDecode = graph.add("decodePlanetTexture", StageThread::ANY, {}, [&] { decodeTexture(planetImage); });
+    // Галактика строится parallelFor на всём пуле, а внутри стадии он бы
+    // выполнялся на одном потоке - поэтому до графа, пока пул свободен
+    const bool sceneBeforeGraph = appOptions.galaxyBodies > 0;
+    if (sceneBeforeGraph) loadSolarSystem();
+    Stage scene = graph.add("loadScene", StageThread::ANY, {}, [sceneBeforeGraph] {
+        if (!sceneBeforeGraph) loadSolarSystem();
+    });
+    Stage orbits = graph.add("buildOrbits", StageThread::ANY, {scene}, buildOrbitGeometry);
+    Stage structures = graph.add("buildBVH", StageThread::ANY, {model}, buildPlanetStructures);
+    std::vector<DecodedTexture> materialImages;
+    Stage materialDecode = graph.add("decodeMaterialTextures", StageThread::ANY, {model}, [&] {
+        for (const OBJMaterial& material : planetModel.materials) {
+            materialImages.emplace_back(material.diffuseTexture);
+            if (!material.diffuseTexture.empty()) decodeTexture(materialImages.back());
+        }
+    });
+
+    Stage modelBuffers = graph.add("uploadModel", StageThread::MAIN, {gl, model}, [] {
+        planetModel.setupBuffers();
+        setupInstancedRendering();
+    });
+    graph.add("uploadSunTexture", StageThread::MAIN, {gl, sunDecode}, [&] { sunTexture = uploadTexture(sunImage); });
+    Stage planetUpload = graph.add("uploadPlanetTexture", StageThread::MAIN, {gl, planetDecode},
+                                   [&] { planetTexture = uploadTexture(planetImage); });
+    graph.add("initImpostors", StageThread::MAIN, {modelBuffers, planetUpload, structures}, initImpostors);
+    graph.add("uploadMaterialTextures", StageThread::MAIN, {gl, materialDecode}, [&] {
+        materialTextures.assign(materialImages.size(), 0);
+        for (size_t i = 0; i < materialImages.size(); i++) {
+            if (!materialImages[i].filename.empty()) materialTextures[i] = uploadTexture(materialImages[i]);
+        }
+    });
+    graph.add("initBelt", StageThread::MAIN, {gl}, initBelt);
+    graph.add("initClusteredLighting", StageThread::MAIN, {gl}, initClusteredLighting);
+    graph.add("uploadInstances", StageThread::MAIN, {shaders, modelBuffers, scene}, [] { updateInstanceBuffer(); });
+    Stage trails = graph.add("initTrails", StageThread::MAIN, {gl}, [] {
+        if (trailLength > 0) trailRenderer.init();
+    });
+    graph.add("uploadOrbits", StageThread::MAIN, {orbits, trails}, uploadOrbits);
+
+    graph.run(ThreadPool::shared());
+    graph.printReport();
+}
+
+// =====================================================
+// БЮДЖЕТЫ ПАМЯТИ
+// =====================================================
+
+// Сдвиг цепочки mip на уровень вниз: уровень 1 становится основным.
+// GL 3.3 не умеет менять размер текстуры на месте, поэтому уровни
+// читаются обратно и задаются заново
+bool demoteTexture(ManagedTexture& managed) {
+    if (managed.levels < 2 || std::max(managed.width, managed.height) <= MIN_DEMOTED_TEXTURE_SIZE) return false;
+
+    std::vector<unsigned char> texels;
+    glBindTexture(GL_TEXTURE_2D, managed.texture);
+    uint32_t width = managed.width;
+    uint32_t height = managed.height;
+    for (uint32_t level = 1; level < managed.levels; level++) {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        texels.resize(size_t(width) * height * 4);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTexImage(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level - 1), GL_RGBA, width, height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(managed.levels) - 2);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    managed.width = std::max(1u, managed.width / 2);
+    managed.height = std::max(1u, managed.height / 2);
+    managed.levels--;
+    ResourceRegistry::shared().track(managed.resource, "", RESOURCE_TEXTURE,
+                                     mipChainBytes(managed.width, managed.height, 4, managed.levels));
+    std::cout << "Бюджет GPU: текстура " << managed.texture << " уменьшена до "
+              << managed.width << "x" << managed.height << std::endl;
+    return true;
+}
+
+// Модель планеты на GPU - другой LOD из .smesh; копия на CPU не меняется
+bool setPlanetGpuLod(int lod) {
+    if (lod >= static_cast<int>(planetCompiled.lods.size())) return false;
+
+    std::vector<OBJVertex> vertices;
+    std::vector<GLuint> indices;
+    unpackCompiledLod(planetCompiled, static_cast<size_t>(lod), vertices, indices);
+    planetModel.uploadBuffers(vertices, indices);
+    // Материал у .smesh один, а число индексов у LOD своё
+    planetModel.setSingleMaterial(planetModel.indexCount);
+    planetGpuLod = lod;
+    std::cout << "Модель планеты на LOD " << lod << " (" << indices.size() / 3
+              << " треугольников)" << std::endl;
+    return true;
+}
+
+// LOD модели - грубейший из требуемых бюджетом памяти и регулятором качества
+bool applyPlanetLod() {
+    int lod = std::min(planetLodCount - 1, std::max(planetMemoryLod, planetQualityLod));
+    return lod == planetGpuLod || setPlanetGpuLod(lod);
+}
+
+// Бюджету GPU не хватает: модель на LOD грубее, чем сейчас
+bool coarsenPlanetForBudget() {
+    if (planetGpuLod + 1 >= planetLodCount) return false;
+    planetMemoryLod = planetGpuLod + 1;
+    return applyPlanetLod();
+}
+
+// Освободить копии данных, уже загруженных на GPU. Модель планеты растеризует
+// отсечение перекрытых тел, поэтому её копия остаётся, пока отсечение включено,
+// если только не force
+void releaseCpuCopyData(bool force) {
+    std::vector<float>().swap(orbitVertices);
+    ResourceRegistry::shared().untrack(orbitCpuResource);
+
+    if (!planetModel.hasCpuCopy()) return;
+    if (occlusionCulling && !force) {
+        std::cout << "Копия модели планеты на CPU оставлена для отсечения перекрытых тел" << std::endl;
+        return;
+    }
+    if (occlusionCulling) {
+        occlusionCulling = false;
+        std::cout << "Бюджет CPU: отсечение перекрытых тел выключено, копия модели освобождена" << std::endl;
+    }
+    planetModel.releaseCpuCopy();
+}
+
+// Привести память к бюджетам: на CPU - отказ от копий, на GPU - сначала
+// уровни текстур (от самой большой), затем более грубый LOD модели
+void enforceMemoryBudgets() {
+    ResourceRegistry& registry = ResourceRegistry::shared();
+
+    static bool cpuWarned = false;
+    if (registry.overBudget(MEMORY_CPU)) {
+        if (planetModel.hasCpuCopy() || !orbitVertices.empty()) {
+            releaseCpuCopyData(true);
+            memoryDemotions++;
+        }
+        if (registry.overBudget(MEMORY_CPU) && !cpuWarned) {
+            std::cerr << "Бюджет CPU превышен, освобождать больше нечего" << std::endl;
+            cpuWarned = true;
+        }
+    }
+
+    static bool gpuWarned = false;
+    while (registry.overBudget(MEMORY_GPU)) {
+        ManagedTexture* largest = nullptr;
+        for (ManagedTexture& managed : managedTextures) {
+            if (managed.levels < 2 || std::max(managed.width, managed.height) <= MIN_DEMOTED_TEXTURE_SIZE) continue;
+            if (!largest || size_t(managed.width) * managed.height > size_t(largest->width) * largest->height) {
+                largest = &managed;
+            }
+        }
+        if ((largest && demoteTexture(*largest)) || coarsenPlanetForBudget()) {
+            memoryDemotions++;
+            continue;
+        }
+        if (!gpuWarned) {
+            std::cerr << "Бюджет GPU превышен, ужимать больше нечего" << std::endl;
+            gpuWarned = true;
+        }
+        break;
+    }
+}
+
+// =====================================================
+// РЕГУЛЯТОР КАЧЕСТВА: ступени рычагов
+// =====================================================
+
+// Ступени регулятора -> настройки отрисовки и LOD модели
+void applyQualityLevels() {
+    farField.thresholdPixels = baseImpostorPixels * float(1 << frameGovernor.getLevel(QUALITY_IMPOSTORS));
+    orbitTolerancePixels = baseOrbitTolerance * float(1 << frameGovernor.getLevel(QUALITY_ORBITS));
+    if (msaaAvailable) {
+        // Число сэмплов задаётся при создании окна, на ходу его можно только выключить
+        if (frameGovernor.getLevel(QUALITY_MSAA) > 0) {
+            glDisable(GL_MULTISAMPLE);
+        } else {
+            glEnable(GL_MULTISAMPLE);
+        }
+    }
+    planetQualityLod = frameGovernor.getLevel(QUALITY_LOD);
+    applyPlanetLod();
+}
+
+// Шагов симуляции в этом кадре
+int currentSubsteps() {
+    return std::max(1, simulationSubsteps >> frameGovernor.getLevel(QUALITY_SUBSTEPS));
+}
+
+// Ступени рычагов - по тому, что доступно в этом запуске. fixedSimulation -
+// идёт запись или воспроизведение ввода: шаг симуляции не должен зависеть
+// от скорости кадров, иначе воспроизведение разойдётся с записью
+void initFrameGovernor(double targetFps, bool fixedSimulation) {
+    GovernorSettings settings;
+    settings.targetSeconds = 1.0 / std::max(1.0, targetFps);
+
+    int maxLevels[QUALITY_LEVER_COUNT] = {};
+    maxLevels[QUALITY_MSAA] = msaaAvailable ? 1 : 0;
+    maxLevels[QUALITY_IMPOSTORS] = farField.enabled && impostorsReady ? GOVERNOR_SCALE_LEVELS : 0;
+    maxLevels[QUALITY_LOD] = planetLodCount - 1;
+    maxLevels[QUALITY_ORBITS] = GOVERNOR_SCALE_LEVELS;
+    if (!fixedSimulation) {
+        for (int substeps = simulationSubsteps; substeps > 1; substeps /= 2) maxLevels[QUALITY_SUBSTEPS]++;
+    } else if (simulationSubsteps > 1) {
+        std::cout << "Регулятор качества: запись или воспроизведение ввода - подшаги симуляции не меняются"
+                  << std::endl;
+    }
+    frameGovernor.configure(settings, maxLevels);
+
+    std::printf("Регулятор качества: цель %.2f мс, ступеней:", settings.targetSeconds * 1000.0);
+    for (uint32_t lever = 0; lever < QUALITY_LEVER_COUNT; lever++) {
+        std::printf(" %s %d", qualityLeverName(static_cast<QualityLever>(lever)), maxLevels[lever]);
+    }
+    std::printf("\n");
+}
+
+// Раз в кадр после отрисовки; true - ступень изменилась
+bool updateFrameGovernor(double frameSeconds, double cpuSeconds) {
+    if (!governorEnabled) return false;
+
+    GovernorDecision decision;
+    if (!frameGovernor.update(frameSeconds, cpuSeconds, frameGpuClock.poll(), decision)) return false;
 
-    updateInstanceBuffer();    
-    initOrbits();
+    applyQualityLevels();
+    std::printf("Качество %s: %s, ступень %d (%s; CPU %.2f мс, GPU %.2f мс, цель %.2f мс)\n",
+                decision.downgrade ? "понижено" : "повышено", qualityLeverName(decision.lever), decision.level,
+                decision.gpuBound ? "упор в GPU" : "упор в CPU", decision.cpuSeconds * 1000.0,
+                decision.gpuSeconds * 1000.0, frameGovernor.getTarget() * 1000.0);
+    return true;
 }
 
 // =====================================================
@@ -380,13 +1261,40 @@ void initModelsAndSystem() {
 // =====================================================
 
 void render(float width, float height) {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
     glm::mat4 view = camera->getViewMatrix();
     glm::mat4 projection = camera->getProjectionMatrix(width / height);
 
+    // 0. Работа CPU над кадром - до первой отрисовки, чтобы замер GPU
+    // регулятора качества не включал простой GPU, пока CPU готовит кадр
+    const bool drawImpostors = farField.enabled && impostorsReady;
+    if (instancedShader) {
+        if (clusteredLighting) {
+            PROFILE_SCOPE("buildLightClusters");
+            updateClusteredLights(view, projection);
+        }
+
+        const std::vector<uint32_t>* visible = nullptr;
+        if (occlusionCulling) {
+            cullOccludedBodies(view, projection);
+            visible = &visibleBodies;
+        }
+
+        if (drawImpostors) {
+            updateFarFieldInstances(view, projection, height, visible);
+        } else {
+            updateInstanceBuffer(visible);
+        }
+    }
+
+    if (governorEnabled) frameGpuClock.begin();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
     // 1. Рисуем орбиты 
-    renderOrbits(view, projection);
+    {
+        PROFILE_SCOPE("renderOrbits");
+        GPU_PROFILE_SCOPE(gpuTimer, "renderOrbits");
+        renderOrbits(view, projection, height);
+    }
 
     // 2. Рисуем планеты
     if (!instancedShader) return;
@@ -399,76 +1307,158 @@ void render(float width, float height) {
     instancedShader->setMat4("view", view);
     instancedShader->setMat4("projection", projection);
     instancedShader->setVec3("lightPos", lightPos);
+    if (clusteredLighting) {
+        bindClusteredLights(width, height);
+    }
 
-    updateInstanceBuffer();
-
-    // Рисуем все инстансы за один вызов
+    // Все инстансы - по вызову на материал: отрезки индексов идут по
+    // материалам, текстура и цвет меняются только между вызовами
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, planetTexture);
     instancedShader->setInt("textureSampler", 0);
 
-    glBindVertexArray(instanceVAO);
-    glDrawElementsInstanced(GL_TRIANGLES,
-                           planetModel.indexCount,
-                           GL_UNSIGNED_INT,
-                           0,
-                           instanceCount);
-    glBindVertexArray(0);
+    {
+        PROFILE_SCOPE("drawInstanced");
+        GPU_PROFILE_SCOPE(gpuTimer, "drawInstanced");
+        glBindVertexArray(instanceVAO);
+        for (const OBJSubmesh& submesh : planetModel.submeshes) {
+            const OBJMaterial& material = planetModel.materials[submesh.material];
+            GLuint texture = submesh.material < materialTextures.size() ? materialTextures[submesh.material] : 0;
+            glBindTexture(GL_TEXTURE_2D, texture != 0 ? texture : planetTexture);
+            instancedShader->setVec3("materialColor", material.diffuse);
+            glDrawElementsInstanced(GL_TRIANGLES,
+                                   submesh.indexCount,
+                                   GL_UNSIGNED_INT,
+                                   (void*)(submesh.firstIndex * sizeof(GLuint)),
+                                   instanceCount);
+            frameCounters.drawCalls++;
+        }
+        glBindVertexArray(0);
+    }
 
     glBindTexture(GL_TEXTURE_2D, 0);
+    if (clusteredLighting) {
+        unbindClusteredLights();
+    }
     glUseProgram(0);
+
+    // 3. Дальние тела - импосторы
+    if (drawImpostors) {
+        PROFILE_SCOPE("drawImpostors");
+        GPU_PROFILE_SCOPE(gpuTimer, "drawImpostors");
+        impostorRenderer.render(farFieldSplit.impostors.data(), farFieldSplit.impostors.size(),
+                                view, projection, camera->position, lightPos);
+        if (!farFieldSplit.impostors.empty()) {
+            frameCounters.drawCalls++;
+            frameCounters.uploadBytes += farFieldSplit.impostors.size() * sizeof(ImpostorInstance);
+        }
+    }
+
+    // 4. Пояс астероидов - один вызов, без буфера инстансов
+    if (beltReady) {
+        PROFILE_SCOPE("drawBelt");
+        GPU_PROFILE_SCOPE(gpuTimer, "drawBelt");
+        beltRenderer.render(asteroidBelt, static_cast<float>(solarSystem->getTime()),
+                            view, projection, lightPos);
+        frameCounters.drawCalls++;
+    }
+
+    // 5. Следы орбит - полупрозрачные, поэтому последними
+    if (showOrbits && trailRenderer.isActive()) {
+        PROFILE_SCOPE("renderTrails");
+        GPU_PROFILE_SCOPE(gpuTimer, "renderTrails");
+        trailRenderer.render(view, projection);
+        frameCounters.drawCalls++;
+    }
 }
 
 // =====================================================
 // УПРАВЛЕНИЕ КАМЕРОЙ И ОРБИТАМИ
 // =====================================================
 
-void handleInput(float deltaTime) {
-    float moveSpeed = 5.0f * deltaTime;
-    float rotateSpeed = 50.0f * deltaTime;
+// Опрос клавиатуры в маску InputKey
+InputFrame pollInput(float deltaTime) {
+    static const struct {
+        sf::Keyboard::Key key;
+        InputKey bit;
+    } bindings[] = {
+        {sf::Keyboard::W,        INPUT_FORWARD},
+        {sf::Keyboard::S,        INPUT_BACKWARD},
+        {sf::Keyboard::A,        INPUT_LEFT},
+        {sf::Keyboard::D,        INPUT_RIGHT},
+        {sf::Keyboard::Space,    INPUT_UP},
+        {sf::Keyboard::LControl, INPUT_DOWN},
+        {sf::Keyboard::Up,       INPUT_PITCH_UP},
+        {sf::Keyboard::Down,     INPUT_PITCH_DOWN},
+        {sf::Keyboard::Left,     INPUT_YAW_LEFT},
+        {sf::Keyboard::Right,    INPUT_YAW_RIGHT},
+        {sf::Keyboard::O,        INPUT_TOGGLE_ORBITS},
+        {sf::Keyboard::R,        INPUT_RESET_CAMERA},
+        {sf::Keyboard::P,        INPUT_TOGGLE_PROFILE},
+        {sf::Keyboard::F5,       INPUT_SAVE_CHECKPOINT},
+        {sf::Keyboard::F9,       INPUT_LOAD_CHECKPOINT},
+        {sf::Keyboard::C,        INPUT_TOGGLE_CULLING},
+    };
+
+    InputFrame input;
+    input.deltaTime = deltaTime;
+    for (const auto& binding : bindings) {
+        if (sf::Keyboard::isKeyPressed(binding.key)) {
+            input.keys |= binding.bit;
+        }
+    }
+    return input;
+}
+
+// Разовые действия: кадр с ними не считается установившимся
+const uint16_t INPUT_ONE_SHOT_KEYS = INPUT_TOGGLE_ORBITS | INPUT_RESET_CAMERA | INPUT_TOGGLE_PROFILE |
+                                     INPUT_SAVE_CHECKPOINT | INPUT_LOAD_CHECKPOINT | INPUT_TOGGLE_CULLING;
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) {
+void handleInput(const InputFrame& input) {
+    float moveSpeed = 5.0f * input.deltaTime;
+    float rotateSpeed = 50.0f * input.deltaTime;
+
+    if (input.pressed(INPUT_FORWARD)) {
         camera->moveForward(moveSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) {
+    if (input.pressed(INPUT_BACKWARD)) {
         camera->moveBackward(moveSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) {
+    if (input.pressed(INPUT_LEFT)) {
         camera->moveLeft(moveSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) {
+    if (input.pressed(INPUT_RIGHT)) {
         camera->moveRight(moveSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
+    if (input.pressed(INPUT_UP)) {
         camera->moveUp(moveSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::LControl)) {
+    if (input.pressed(INPUT_DOWN)) {
         camera->moveDown(moveSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up)) {
+    if (input.pressed(INPUT_PITCH_UP)) {
         camera->rotatePitch(rotateSpeed);  
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down)) {
+    if (input.pressed(INPUT_PITCH_DOWN)) {
         camera->rotatePitch(-rotateSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left)) {
+    if (input.pressed(INPUT_YAW_LEFT)) {
         camera->rotateYaw(-rotateSpeed);
     }
 
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right)) {
+    if (input.pressed(INPUT_YAW_RIGHT)) {
         camera->rotateYaw(rotateSpeed);
     }
 
     static bool oKeyPressed = false;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::O)) {
+    if (input.pressed(INPUT_TOGGLE_ORBITS)) {
         if (!oKeyPressed) {
             showOrbits = !showOrbits;
             std::cout << "Орбиты: " << (showOrbits ? "ВКЛ" : "ВЫКЛ") << std::endl;
@@ -478,8 +1468,20 @@ void handleInput(float deltaTime) {
         oKeyPressed = false;
     }
 
+    static bool pKeyPressed = false;
+    if (input.pressed(INPUT_TOGGLE_PROFILE)) {
+        if (!pKeyPressed) {
+            Profiler& profiler = Profiler::instance();
+            profiler.setEnabled(!profiler.isEnabled());
+            std::cout << "Профилировщик: " << (profiler.isEnabled() ? "ВКЛ" : "ВЫКЛ") << std::endl;
+            pKeyPressed = true;
+        }
+    } else {
+        pKeyPressed = false;
+    }
+
     static bool rKeyPressed = false;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::R)) {
+    if (input.pressed(INPUT_RESET_CAMERA)) {
         if (!rKeyPressed) {
             delete camera;
             camera = new Camera(glm::vec3(0.0f, 10.0f, 30.0f));
@@ -489,9 +1491,87 @@ void handleInput(float deltaTime) {
     } else {
         rKeyPressed = false;
     }
+
+    static bool cKeyPressed = false;
+    if (input.pressed(INPUT_TOGGLE_CULLING)) {
+        if (!cKeyPressed) {
+            if (!occlusionCulling && !planetModel.hasCpuCopy()) {
+                std::cout << "Отсечение перекрытых тел недоступно: копия модели на CPU освобождена" << std::endl;
+            } else {
+                occlusionCulling = !occlusionCulling;
+                std::cout << "Отсечение перекрытых тел: " << (occlusionCulling ? "ВКЛ" : "ВЫКЛ") << std::endl;
+            }
+            cKeyPressed = true;
+        }
+    } else {
+        cKeyPressed = false;
+    }
+
+    static bool f5KeyPressed = false;
+    if (input.pressed(INPUT_SAVE_CHECKPOINT)) {
+        if (!f5KeyPressed) {
+            checkpoints.saveFull(*solarSystem);
+            f5KeyPressed = true;
+        }
+    } else {
+        f5KeyPressed = false;
+    }
+
+    static bool f9KeyPressed = false;
+    if (input.pressed(INPUT_LOAD_CHECKPOINT)) {
+        if (!f9KeyPressed) {
+            if (checkpoints.restore(*solarSystem)) {
+                initOrbits();
+                resetLightBodies();
+                if (releaseCpuCopies) releaseCpuCopyData(false);
+            }
+            f9KeyPressed = true;
+        }
+    } else {
+        f9KeyPressed = false;
+    }
+}
+
+// Перевести сцену в другой формат без создания окна
+int exportScene() {
+    SolarSystem system;
+    SceneLoadStats stats;
+    if (appOptions.galaxyBodies > 0) {
+        generateSolarSystem(system);
+    } else if (!loadScene(appOptions.scenePath, system, &stats)) {
+        return 1;
+    } else {
+        std::cout << "Прочитано " << stats.bodyCount << " тел за " << stats.seconds * 1000.0 << " мс ("
+                  << stats.bodiesPerSecond() / 1e6 << " Mтел/с, "
+                  << stats.megabytesPerSecond() << " МБ/с)" << std::endl;
+    }
+
+    if (!saveScene(appOptions.exportScenePath, system)) {
+        return 1;
+    }
+
+    std::cout << "Сцена сохранена: " << appOptions.exportScenePath << std::endl;
+    return 0;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    const auto launchTime = std::chrono::steady_clock::now();
+
+    if (!parseAppOptions(argc, argv, appOptions) || appOptions.showHelp) {
+        printUsage(argv[0]);
+        return appOptions.showHelp ? 0 : 1;
+    }
+
+    if (!appOptions.exportScenePath.empty()) {
+        return exportScene();
+    }
+
+    InputPlayer inputPlayer;
+    const bool isReplay = !appOptions.replayPath.empty();
+    if (isReplay && !inputPlayer.open(appOptions.replayPath)) {
+        return 1;
+    }
+
     sf::ContextSettings settings;
     settings.depthBits = 24;
     settings.stencilBits = 8;
@@ -502,7 +1582,8 @@ int main() {
 
     sf::RenderWindow window(sf::VideoMode(1200, 800), "Solar System - Инстанцированный рендеринг",
                            sf::Style::Default, settings);
-    window.setVerticalSyncEnabled(true);
+    // При быстром воспроизведении кадры не ждут обновления экрана
+    window.setVerticalSyncEnabled(!(isReplay && appOptions.replayFast));
     window.setActive(true);
 
     glewExperimental = GL_TRUE;
@@ -511,14 +1592,70 @@ int main() {
         return -1;
     }
 
+    Profiler& profiler = Profiler::instance();
+    profiler.setEnabled(appOptions.profile);
+    profiler.setTraceCapture(!appOptions.tracePath.empty());
+    profiler.setSummaryInterval(appOptions.profileInterval);
+
     std::cout << "=== СОЛНЕЧНАЯ СИСТЕМА ===" << std::endl;
     std::cout << std::endl;
 
-    initGL();
-    initShaders();
-    initModelsAndSystem();
+    occlusionCulling = !appOptions.noOcclusion;
+    farField.enabled = !appOptions.noImpostors;
+    farField.thresholdPixels = appOptions.impostorPixels;
+    orbitTolerancePixels = appOptions.orbitTolerancePixels;
+    baseImpostorPixels = farField.thresholdPixels;
+    baseOrbitTolerance = orbitTolerancePixels;
+    simulationSubsteps = static_cast<int>(std::max(1u, appOptions.substeps));
+    governorEnabled = appOptions.governor;
+    msaaAvailable = window.getSettings().antialiasingLevel > 0;
+    trailLength = appOptions.trailLength;
+    if (appOptions.noSpecular) shaderFeatures &= ~SHADER_SPECULAR;
+    if (appOptions.noTexture) shaderFeatures &= ~SHADER_TEXTURED;
+    if (appOptions.compactInstances) shaderFeatures |= SHADER_COMPACT_INSTANCES;
+    clusteredLighting = appOptions.clusteredLights;
+    if (clusteredLighting) shaderFeatures |= SHADER_CLUSTERED_LIGHTS;
+    asteroidBelt.count = appOptions.beltCount;
+    asteroidBelt.seed = appOptions.beltSeed;
+    checkpoints.configure(appOptions.checkpointPath, appOptions.checkpointInterval);
+    releaseCpuCopies = appOptions.releaseCpuCopies;
+    ResourceRegistry::shared().setBudget(MEMORY_GPU, appOptions.gpuBudgetBytes);
+    ResourceRegistry::shared().setBudget(MEMORY_CPU, appOptions.cpuBudgetBytes);
+
+    initStartup();
+    if (releaseCpuCopies) releaseCpuCopyData(false);
+    enforceMemoryBudgets();
+    if (governorEnabled) initFrameGovernor(appOptions.targetFps, isReplay || !appOptions.recordPath.empty());
     camera = new Camera(glm::vec3(0.0f, 10.0f, 30.0f));
 
+    if (!appOptions.metricsEndpoint.empty() && metricsServer.start(appOptions.metricsEndpoint)) {
+        const std::string& endpoint = metricsServer.getEndpoint();
+        if (endpoint.compare(0, 5, "unix:") == 0) {
+            std::cout << "Метрики: curl --unix-socket " << endpoint.substr(5) << " http://localhost/metrics" << std::endl;
+        } else {
+            std::cout << "Метрики: http://" << (endpoint.find(':') == std::string::npos ? "127.0.0.1:" : "")
+                      << endpoint << "/metrics" << std::endl;
+        }
+    }
+
+    InputRecorder inputRecorder;
+    if (!appOptions.recordPath.empty()) {
+        inputRecorder.open(appOptions.recordPath, solarSystem->getBodyCount());
+    }
+    if (isReplay) {
+        if (inputPlayer.getBodyCount() != solarSystem->getBodyCount()) {
+            std::cerr << "Внимание: запись сделана на сцене из " << inputPlayer.getBodyCount()
+                      << " тел, сейчас " << solarSystem->getBodyCount() << std::endl;
+        }
+        std::cout << "Воспроизведение " << appOptions.replayPath << ": "
+                  << inputPlayer.getFrameCount() << " кадров"
+                  << (appOptions.replayFast ? " (максимальная скорость)" : "") << std::endl;
+    }
+    // Запас под историю кадров, чтобы она не росла посреди сессии
+    std::vector<float> frameSeconds;
+    frameSeconds.reserve(isReplay ? inputPlayer.getFrameCount() : FRAME_HISTORY_RESERVE);
+    SteadyFrameChecker allocationChecker;
+
     std::cout << std::endl;
     std::cout << "  УПРАВЛЕНИЕ:" << std::endl;
     std::cout << "  W/A/S/D - движение вперёд/назад/влево/вправо" << std::endl;
@@ -526,6 +1663,11 @@ int main() {
     std::cout << "  СТРЕЛКИ - повороты камеры" << std::endl;
     std::cout << "  O - показать/скрыть орбиты" << std::endl;
     std::cout << "  R - сбросить камеру в начальную позицию" << std::endl;
+    std::cout << "  P - включить/выключить профилировщик" << std::endl;
+    std::cout << "  C - включить/выключить отсечение перекрытых тел" << std::endl;
+    std::cout << "  Левая кнопка мыши - выбрать тело" << std::endl;
+    std::cout << "  F5/F9 - сохранить/восстановить снимок симуляции" << std::endl;
+    std::cout << "  M - отчёт о памяти ресурсов" << std::endl;
     std::cout << "  ESC - выход" << std::endl;
     std::cout << std::endl;
 
@@ -534,38 +1676,232 @@ int main() {
     float frameTime = 0.0f;
     int frameCount = 0;
 
+    // Время кадров отдельно с отсечением и без - для сравнения при переключении на C
+    double culledFrameSeconds[2] = {0.0, 0.0};
+    size_t culledFrameCount[2] = {0, 0};
+    bool previousFrameCulled = occlusionCulling;
+
     while (running && window.isOpen()) {
+        allocationChecker.beginFrame();
+        frameArena.reset();
+        frameCounters = FrameCounters();
+        bool eventfulFrame = false;
+
         sf::Event event;
         while (window.pollEvent(event)) {
+            eventfulFrame = true;
+
             if (event.type == sf::Event::Closed ||
                 (event.type == sf::Event::KeyPressed &&
                  event.key.code == sf::Keyboard::Escape)) {
                 running = false;
             }
             
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::M) {
+                std::cout << ResourceRegistry::shared().formatReport();
+            }
+
             if (event.type == sf::Event::Resized) {
                 glViewport(0, 0, event.size.width, event.size.height);
             }
+
+            if (event.type == sf::Event::MouseButtonPressed &&
+                event.mouseButton.button == sf::Mouse::Left) {
+                pickBodyAt(event.mouseButton.x, event.mouseButton.y,
+                           window.getSize().x, window.getSize().y);
+            }
         }
 
         float deltaTime = clock.restart().asSeconds();
+        auto workStart = std::chrono::steady_clock::now();
         frameTime += deltaTime;
         frameCount++;
 
-        handleInput(deltaTime);
-        solarSystem->update(deltaTime * 10.0f);
+        // Первый кадр ещё не отрисован - его время не считаем
+        if (frameCount > 1) {
+            frameSeconds.push_back(deltaTime);
+            culledFrameSeconds[previousFrameCulled] += deltaTime;
+            culledFrameCount[previousFrameCulled]++;
+        }
+
+        InputFrame input;
+        if (isReplay) {
+            if (!inputPlayer.next(input)) {
+                break;
+            }
+        } else {
+            input = pollInput(deltaTime);
+        }
+        inputRecorder.record(input);
+        eventfulFrame |= (input.keys & INPUT_ONE_SHOT_KEYS) != 0;
 
-        render(window.getSize().x, window.getSize().y);
+        profiler.beginFrame();
 
+        {
+            PROFILE_SCOPE("handleInput");
+            handleInput(input);
+        }
+        auto tickStart = std::chrono::steady_clock::now();
+        {
+            PROFILE_SCOPE("SolarSystem::update");
+            const int substeps = currentSubsteps();
+            for (int step = 0; step < substeps; step++) {
+                solarSystem->update(input.deltaTime * 10.0f / substeps);
+            }
+        }
+        double tickSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tickStart).count();
+        {
+            PROFILE_SCOPE("collisions");
+            detectCollisions();
+        }
+        {
+            PROFILE_SCOPE("pushTrails");
+            size_t uploadedBefore = trailRenderer.getTotalUploadBytes();
+            trailRenderer.push(solarSystem->getBodies());
+            frameCounters.uploadBytes += trailRenderer.getTotalUploadBytes() - uploadedBefore;
+        }
+        {
+            PROFILE_SCOPE("checkpoints");
+            eventfulFrame |= checkpoints.update(*solarSystem, input.deltaTime);
+        }
+        {
+            PROFILE_SCOPE("render");
+            // Начало замера GPU - внутри render(), перед первой отрисовкой
+            render(window.getSize().x, window.getSize().y);
+            if (governorEnabled) frameGpuClock.end();
+        }
+        previousFrameCulled = occlusionCulling;
+
+        // Работа кадра на CPU - без ожидания vsync в display()
+        double workSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - workStart).count();
         window.display();
+
+        if (frameCount == 1) {
+            double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+            std::printf("Первый кадр через %.1f мс после запуска\n", millis);
+        }
+
+        gpuTimer.poll();
+        profiler.endFrame();
+        eventfulFrame |= updateFrameGovernor(deltaTime, workSeconds);
+        enforceMemoryBudgets();
+        publishFrameMetrics(deltaTime, tickSeconds);
+        allocationChecker.endFrame(eventfulFrame);
+    }
+
+    if (frameCount > 0 && frameTime > 0.0f) {
+        std::cout << "Кадров: " << frameCount << ", средний FPS: "
+                  << frameCount / frameTime << std::endl;
+    }
+    if (occlusionTotals.frames > 0) {
+        double frames = static_cast<double>(occlusionTotals.frames);
+        std::printf("Отсечение: в среднем %.0f из %.0f тел перекрыто, %.0f за экраном, %.3f мс на кадр\n",
+                    occlusionTotals.occluded / frames, occlusionTotals.tested / frames,
+                    occlusionTotals.frustumCulled / frames, occlusionTotals.seconds / frames * 1000.0);
     }
+    if (farFieldTotals.frames > 0) {
+        double frames = static_cast<double>(farFieldTotals.frames);
+        std::printf("Дальние тела: в среднем %.0f мешей, %.0f импосторов, %.0f в переходе\n",
+                    farFieldTotals.meshes / frames, farFieldTotals.impostors / frames,
+                    farFieldTotals.crossfading / frames);
+    }
+    if (lightingTotals.frames > 0) {
+        double frames = static_cast<double>(lightingTotals.frames);
+        std::printf("Кластерное освещение: в среднем %.0f источников, %.0f в кадре, %.1f на кластер; "
+                    "максимум %zu на кластер, обрезано списков %.1f за кадр, %.3f мс на кадр\n",
+                    lightingTotals.lights / frames, lightingTotals.visibleLights / frames,
+                    lightingTotals.references / frames / CLUSTER_COUNT, lightingTotals.maxPerCluster,
+                    lightingTotals.overflowClusters / frames, lightingTotals.seconds / frames * 1000.0);
+    }
+    if (collisionTotals.frames > 0) {
+        double frames = static_cast<double>(collisionTotals.frames);
+        std::printf("Пересечения тел: в среднем %.0f кандидатов, %.0f пар (максимум %zu), "
+                    "широкая фаза %.3f мс, узкая %.3f мс, полных сортировок %zu\n",
+                    collisionTotals.candidates / frames, collisionTotals.contacts / frames,
+                    collisionTotals.maxContacts, collisionTotals.broadphaseSeconds / frames * 1000.0,
+                    collisionTotals.narrowSeconds / frames * 1000.0, collisionTotals.rebuilds);
+    }
+    if (orbitTotals.orbits > 0) {
+        std::printf("Орбиты: в среднем %.1f отрезков на орбиту (допуск %.2f пикс.), %.0f на кадр\n",
+                    double(orbitTotals.segments) / orbitTotals.orbits, orbitTolerancePixels,
+                    double(orbitTotals.segments) / orbitTotals.frames);
+    }
+    if (trailRenderer.getPushCount() > 0) {
+        std::printf("Следы: %.1f МБ на GPU, %.1f КБ отправлено за кадр (%zu байт на тело)\n",
+                    trailRenderer.getMemoryBytes() / (1024.0 * 1024.0),
+                    trailRenderer.getTotalUploadBytes() / 1024.0 / trailRenderer.getPushCount(),
+                    sizeof(glm::vec3));
+    }
+    for (int culled = 1; culled >= 0; culled--) {
+        if (culledFrameCount[culled] > 0) {
+            std::printf("Среднее время кадра %s отсечения: %.3f мс (%zu кадров)\n",
+                        culled ? "с" : "без",
+                        culledFrameSeconds[culled] / culledFrameCount[culled] * 1000.0,
+                        culledFrameCount[culled]);
+        }
+    }
+    if (allocationTrackingAvailable() && allocationChecker.getFrames() > 0) {
+        std::printf("Выделения памяти: %.1f за кадр в среднем; установившихся кадров %zu, "
+                    "из них с выделениями %zu (%llu выделений, %llu байт)\n",
+                    double(allocationChecker.getTotalAllocations()) / allocationChecker.getFrames(),
+                    allocationChecker.getSteadyFrames(), allocationChecker.getAllocatingFrames(),
+                    static_cast<unsigned long long>(allocationChecker.getSteadyAllocations()),
+                    static_cast<unsigned long long>(allocationChecker.getSteadyBytes()));
+    }
+    if (governorEnabled) {
+        std::printf("Регулятор качества: %zu понижений, %zu повышений; в конце ступени",
+                    frameGovernor.getDowngrades(), frameGovernor.getUpgrades());
+        for (uint32_t lever = 0; lever < QUALITY_LEVER_COUNT; lever++) {
+            std::printf(" %s %d", qualityLeverName(static_cast<QualityLever>(lever)),
+                        frameGovernor.getLevel(static_cast<QualityLever>(lever)));
+        }
+        std::printf("\n");
+    }
+    if (memoryDemotions > 0) {
+        std::printf("Бюджеты памяти: %zu понижений качества, LOD модели %d\n", memoryDemotions, planetGpuLod);
+    }
+    if (appOptions.memoryReport) {
+        std::cout << ResourceRegistry::shared().formatReport();
+    }
+    if (isReplay) {
+        printFrameTimeSummary(summarizeFrameTimes(frameSeconds));
+    }
+    if (!appOptions.frameTimesPath.empty()) {
+        writeFrameTimes(appOptions.frameTimesPath, frameSeconds);
+    }
+    inputRecorder.close();
+    if (metricsServer.isRunning()) {
+        std::printf("Метрики: %llu запросов\n", static_cast<unsigned long long>(metricsServer.getScrapes()));
+        metricsServer.stop();
+    }
+    if (profiler.isEnabled()) {
+        profiler.printSummary();
+    }
+    if (!appOptions.tracePath.empty()) {
+        profiler.exportChromeTrace(appOptions.tracePath);
+    }
+    gpuTimer.release();
+    frameGpuClock.release();
+    impostorRenderer.release();
+    beltRenderer.release();
+    releaseTextureBuffer(lightDataBuffer);
+    releaseTextureBuffer(clusterRangeBuffer);
+    releaseTextureBuffer(clusterLightBuffer);
+    trailRenderer.release();
 
     delete instancedShader;
+    delete occlusionCuller;
+    delete bodyPicker;
+    delete collisionDetector;
     delete camera;
     delete solarSystem;
     glDeleteTextures(1, &sunTexture);
     glDeleteTextures(1, &planetTexture);
+    for (GLuint texture : materialTextures) {
+        if (texture != 0) glDeleteTextures(1, &texture);
+    }
     glDeleteBuffers(1, &instanceVBO);
+    glDeleteBuffers(1, &instanceDissolveVBO);
     glDeleteVertexArrays(1, &instanceVAO);
     
     glDeleteProgram(orbitShaderProgram);
@@ -575,5 +1911,24 @@ int main() {
     window.close();
     std::cout << "✅ Программа завершена" << std::endl;
 
+    // --check-allocations: ненулевой код, если установившийся кадр обращался к куче
+    if (appOptions.checkAllocations) {
+        if (!allocationTrackingAvailable()) {
+            std::cerr << "Проверка выделений недоступна: соберите с -DSOLAR_ALLOC_TRACKING=ON" << std::endl;
+            return 1;
+        }
+        if (allocationChecker.getSteadyFrames() == 0) {
+            std::cerr << "Проверка выделений: ни одного установившегося кадра" << std::endl;
+            return 1;
+        }
+        if (!allocationChecker.passed()) {
+            std::cerr << "Проверка выделений не пройдена: " << allocationChecker.getAllocatingFrames()
+                      << " установившихся кадров обращались к куче" << std::endl;
+            return 1;
+        }
+        std::cout << "Проверка выделений пройдена: " << allocationChecker.getSteadyFrames()
+                  << " установившихся кадров без выделений" << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
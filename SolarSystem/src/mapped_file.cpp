@@ -0,0 +1,110 @@
+#include "mapped_file.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOLAR_HAS_MMAP 1
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+#ifdef SOLAR_HAS_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Не получилось открыть файл: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        std::cerr << "Файл пуст или недоступен: " << filename << std::endl;
+        return false;
+    }
+
+    void* ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        std::cerr << "Ошибка mmap: " << filename << std::endl;
+        return false;
+    }
+
+    bytes = static_cast<const unsigned char*>(ptr);
+    length = static_cast<size_t>(st.st_size);
+    mapped = true;
+    return true;
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "Не получилось открыть файл: " << filename << std::endl;
+        return false;
+    }
+
+    std::streamsize fileSize = file.tellg();
+    if (fileSize <= 0) {
+        std::cerr << "Файл пуст: " << filename << std::endl;
+        return false;
+    }
+
+    unsigned char* buffer = new unsigned char[static_cast<size_t>(fileSize)];
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer), fileSize);
+
+    bytes = buffer;
+    length = static_cast<size_t>(fileSize);
+    mapped = false;
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+    if (bytes == nullptr) return;
+
+#ifdef SOLAR_HAS_MMAP
+    if (mapped) {
+        munmap(const_cast<unsigned char*>(bytes), length);
+    }
+#endif
+    if (!mapped) {
+        delete[] bytes;
+    }
+
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+void MappedFile::adviseSequential() const {
+#ifdef SOLAR_HAS_MMAP
+    if (mapped) {
+        madvise(const_cast<unsigned char*>(bytes), length, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+void MappedFile::releaseRange(size_t offset, size_t rangeLength) const {
+#ifdef SOLAR_HAS_MMAP
+    if (!mapped || offset >= length) return;
+
+    // madvise работает только с границами страниц
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = std::min(offset + rangeLength, length) / page * page;
+    if (end > begin) {
+        madvise(const_cast<unsigned char*>(bytes) + begin, end - begin, MADV_DONTNEED);
+    }
+#else
+    (void)offset;
+    (void)rangeLength;
+#endif
+}
@@ -0,0 +1,267 @@
+#include "mesh_bvh.h"
+#include "obj_loader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+struct Bounds {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    void grow(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    void grow(const Bounds& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+    float area() const {
+        glm::vec3 e = max - min;
+        if (e.x < 0.0f) return 0.0f;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+};
+
+struct Bin {
+    Bounds bounds;
+    uint32_t count = 0;
+};
+
+// Пересечение луча с AABB; возвращает вход или +inf при промахе
+inline float intersectBounds(const glm::vec3& origin, const glm::vec3& inverseDirection,
+                             const glm::vec3& boundsMin, const glm::vec3& boundsMax, float maxDistance) {
+    glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+    glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+} // namespace
+
+void MeshBVH::build(const SoftMesh& mesh) {
+    auto start = std::chrono::steady_clock::now();
+
+    nodes.clear();
+    triangles.clear();
+    stats = MeshBVHStats();
+
+    size_t count = mesh.indexCount / 3;
+    if (count == 0) return;
+
+    std::vector<Bounds> triangleBounds(count);
+    std::vector<glm::vec3> centroids(count);
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3& a = mesh.vertices[mesh.indices[i * 3]].position;
+        const glm::vec3& b = mesh.vertices[mesh.indices[i * 3 + 1]].position;
+        const glm::vec3& c = mesh.vertices[mesh.indices[i * 3 + 2]].position;
+        triangleBounds[i].grow(a);
+        triangleBounds[i].grow(b);
+        triangleBounds[i].grow(c);
+        centroids[i] = (a + b + c) * (1.0f / 3.0f);
+        order[i] = static_cast<uint32_t>(i);
+    }
+
+    nodes.reserve(count * 2);
+    nodes.push_back(Node{glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<uint32_t>(count)});
+
+    struct Task {
+        uint32_t node;
+        uint32_t depth;
+    };
+    std::vector<Task> stack = {{0, 1}};
+
+    while (!stack.empty()) {
+        Task task = stack.back();
+        stack.pop_back();
+
+        uint32_t first = nodes[task.node].leftFirst;
+        uint32_t triangleCount = nodes[task.node].triangleCount;
+
+        Bounds bounds, centroidBounds;
+        for (uint32_t i = first; i < first + triangleCount; i++) {
+            bounds.grow(triangleBounds[order[i]]);
+            centroidBounds.grow(centroids[order[i]]);
+        }
+        nodes[task.node].boundsMin = bounds.min;
+        nodes[task.node].boundsMax = bounds.max;
+        stats.maxDepth = std::max<size_t>(stats.maxDepth, task.depth);
+
+        // Лучшее разбиение по SAH среди BUILD_BINS корзин на каждой оси
+        float leafCost = triangleCount * bounds.area();
+        float bestCost = std::numeric_limits<float>::max();
+        int bestAxis = -1;
+        int bestSplit = 0;
+
+        if (triangleCount > MAX_LEAF_TRIANGLES && task.depth < MAX_DEPTH) {
+            for (int axis = 0; axis < 3; axis++) {
+                float lo = centroidBounds.min[axis];
+                float hi = centroidBounds.max[axis];
+                if (hi <= lo) continue;
+
+                Bin bins[BUILD_BINS];
+                float scale = BUILD_BINS / (hi - lo);
+                for (uint32_t i = first; i < first + triangleCount; i++) {
+                    int bin = std::min(BUILD_BINS - 1, static_cast<int>((centroids[order[i]][axis] - lo) * scale));
+                    bins[bin].count++;
+                    bins[bin].bounds.grow(triangleBounds[order[i]]);
+                }
+
+                // Площади и числа слева и справа от каждой границы
+                float leftArea[BUILD_BINS - 1], rightArea[BUILD_BINS - 1];
+                uint32_t leftCount[BUILD_BINS - 1], rightCount[BUILD_BINS - 1];
+                Bounds leftBounds, rightBounds;
+                uint32_t leftSum = 0, rightSum = 0;
+                for (int i = 0; i < BUILD_BINS - 1; i++) {
+                    leftSum += bins[i].count;
+                    leftBounds.grow(bins[i].bounds);
+                    leftCount[i] = leftSum;
+                    leftArea[i] = leftBounds.area();
+
+                    rightSum += bins[BUILD_BINS - 1 - i].count;
+                    rightBounds.grow(bins[BUILD_BINS - 1 - i].bounds);
+                    rightCount[BUILD_BINS - 2 - i] = rightSum;
+                    rightArea[BUILD_BINS - 2 - i] = rightBounds.area();
+                }
+
+                for (int i = 0; i < BUILD_BINS - 1; i++) {
+                    if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+                    float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = i;
+                    }
+                }
+            }
+        }
+
+        if (bestAxis < 0 || bestCost >= leafCost) {
+            stats.leaves++;
+            stats.maxLeafTriangles = std::max<size_t>(stats.maxLeafTriangles, triangleCount);
+            continue;
+        }
+
+        float lo = centroidBounds.min[bestAxis];
+        float scale = BUILD_BINS / (centroidBounds.max[bestAxis] - lo);
+        auto middle = std::partition(order.begin() + first, order.begin() + first + triangleCount,
+                                     [&](uint32_t t) {
+            int bin = std::min(BUILD_BINS - 1, static_cast<int>((centroids[t][bestAxis] - lo) * scale));
+            return bin <= bestSplit;
+        });
+        uint32_t leftTriangles = static_cast<uint32_t>(middle - (order.begin() + first));
+
+        uint32_t left = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(Node{glm::vec3(0.0f), first, glm::vec3(0.0f), leftTriangles});
+        nodes.push_back(Node{glm::vec3(0.0f), first + leftTriangles, glm::vec3(0.0f), triangleCount - leftTriangles});
+        nodes[task.node].leftFirst = left;
+        nodes[task.node].triangleCount = 0;
+
+        stack.push_back({left, task.depth + 1});
+        stack.push_back({left + 1, task.depth + 1});
+    }
+
+    triangles.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t t = order[i];
+        const glm::vec3& a = mesh.vertices[mesh.indices[t * 3]].position;
+        const glm::vec3& b = mesh.vertices[mesh.indices[t * 3 + 1]].position;
+        const glm::vec3& c = mesh.vertices[mesh.indices[t * 3 + 2]].position;
+        triangles[i] = Triangle{a, b - a, c - a, t};
+    }
+
+    nodes.shrink_to_fit();
+    stats.nodes = nodes.size();
+    stats.buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool MeshBVH::intersect(const glm::vec3& origin, const glm::vec3& direction,
+                        float maxDistance, MeshHit& hit) const {
+    if (nodes.empty()) return false;
+
+    // Деление на ноль даёт inf нужного знака - слэбы остаются корректными
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float best = maxDistance;
+    bool found = false;
+
+    if (intersectBounds(origin, inverseDirection, nodes[0].boundsMin, nodes[0].boundsMax, best) ==
+        std::numeric_limits<float>::infinity()) {
+        return false;
+    }
+
+    // На каждом уровне в стек кладётся не больше одного узла
+    uint32_t stack[MAX_DEPTH];
+    size_t stackSize = 0;
+    uint32_t current = 0;
+
+    while (true) {
+        const Node& node = nodes[current];
+        if (node.triangleCount > 0) {
+            for (uint32_t i = node.leftFirst; i < node.leftFirst + node.triangleCount; i++) {
+                const Triangle& tri = triangles[i];
+                glm::vec3 p = glm::cross(direction, tri.edge2);
+                float det = glm::dot(tri.edge1, p);
+                if (std::fabs(det) < 1e-12f) continue;
+
+                float inverseDet = 1.0f / det;
+                glm::vec3 s = origin - tri.v0;
+                float u = glm::dot(s, p) * inverseDet;
+                if (u < 0.0f || u > 1.0f) continue;
+
+                glm::vec3 q = glm::cross(s, tri.edge1);
+                float v = glm::dot(direction, q) * inverseDet;
+                if (v < 0.0f || u + v > 1.0f) continue;
+
+                float t = glm::dot(tri.edge2, q) * inverseDet;
+                if (t > 0.0f && t < best) {
+                    best = t;
+                    hit.distance = t;
+                    hit.triangle = tri.original;
+                    hit.u = u;
+                    hit.v = v;
+                    found = true;
+                }
+            }
+        } else {
+            uint32_t nearChild = node.leftFirst;
+            uint32_t farChild = nearChild + 1;
+            float nearDistance = intersectBounds(origin, inverseDirection,
+                                                 nodes[nearChild].boundsMin, nodes[nearChild].boundsMax, best);
+            float farDistance = intersectBounds(origin, inverseDirection,
+                                                nodes[farChild].boundsMin, nodes[farChild].boundsMax, best);
+            if (farDistance < nearDistance) {
+                std::swap(nearChild, farChild);
+                std::swap(nearDistance, farDistance);
+            }
+
+            if (nearDistance != std::numeric_limits<float>::infinity()) {
+                if (farDistance != std::numeric_limits<float>::infinity()) {
+                    stack[stackSize++] = farChild;
+                }
+                current = nearChild;
+                continue;
+            }
+        }
+
+        // Следующий узел со стека, если он ещё может быть ближе найденного
+        bool next = false;
+        while (stackSize > 0) {
+            uint32_t candidate = stack[--stackSize];
+            if (intersectBounds(origin, inverseDirection, nodes[candidate].boundsMin,
+                                nodes[candidate].boundsMax, best) != std::numeric_limits<float>::infinity()) {
+                current = candidate;
+                next = true;
+                break;
+            }
+        }
+        if (!next) break;
+    }
+    return found;
+}
@@ -0,0 +1,232 @@
+#include "mesh_optimizer.h"
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+// Параметры оценки вершин по Форсайту ("Linear-Speed Vertex Cache Optimisation")
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+const unsigned int NO_TRIANGLE = ~0u;
+
+float vertexScore(int cachePosition, unsigned int activeTriangles) {
+    if (activeTriangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // Вершины только что выданного треугольника - фиксированная оценка,
+        // иначе убывает к концу кэша
+        if (cachePosition < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+    // Вершины с малым числом оставшихся треугольников - раньше, чтобы не висели
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(activeTriangles), -VALENCE_BOOST_POWER);
+    return score;
+}
+
+} // namespace
+
+float averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount, size_t cacheSize) {
+    if (indices.size() < 3) return 0.0f;
+
+    // FIFO: вершина в кэше, если добавлена не раньше, чем cacheSize промахов назад
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    size_t misses = 0;
+    for (unsigned int index : indices) {
+        if (insertedAt[index] == 0 || misses - insertedAt[index] + 1 > cacheSize) {
+            misses++;
+            insertedAt[index] = misses;
+        }
+    }
+    return static_cast<float>(misses) / (indices.size() / 3);
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return;
+
+    // Треугольники каждой вершины; активные - в начале её отрезка
+    std::vector<unsigned int> activeCount(vertexCount, 0);
+    for (unsigned int index : indices) {
+        activeCount[index]++;
+    }
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + activeCount[v];
+    }
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> filled(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            adjacency[offsets[v] + filled[v]++] = static_cast<unsigned int>(t);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> scores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        scores[v] = vertexScore(-1, activeCount[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+    unsigned int best = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+        if (triangleScores[t] > triangleScores[best]) best = static_cast<unsigned int>(t);
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    while (best != NO_TRIANGLE) {
+        const unsigned int* triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best] = 1;
+
+        // Убрать треугольник из активных у его вершин
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = triangle[k];
+            unsigned int* begin = &adjacency[offsets[v]];
+            unsigned int* last = begin + activeCount[v] - 1;
+            for (unsigned int* it = begin; it <= last; it++) {
+                if (*it == best) {
+                    std::swap(*it, *last);
+                    break;
+                }
+            }
+            activeCount[v]--;
+        }
+
+        // Вершины треугольника - в начало кэша, остальные сдвигаются
+        nextCache.assign(triangle, triangle + 3);
+        for (unsigned int v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                nextCache.push_back(v);
+            }
+        }
+        for (unsigned int v : cache) {
+            cachePosition[v] = -1;
+        }
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < VERTEX_CACHE_SIZE ? static_cast<int>(i) : -1;
+            scores[v] = vertexScore(cachePosition[v], activeCount[v]);
+        }
+
+        // Пересчитать треугольники вершин кэша, лучший из них - следующий
+        best = NO_TRIANGLE;
+        float bestScore = -1.0f;
+        for (unsigned int v : nextCache) {
+            for (unsigned int i = 0; i < activeCount[v]; i++) {
+                unsigned int t = adjacency[offsets[v] + i];
+                float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+
+        if (nextCache.size() > VERTEX_CACHE_SIZE) nextCache.resize(VERTEX_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // Кэш ничего не даёт - следующий невыданный треугольник по порядку
+        if (best == NO_TRIANGLE) {
+            while (scanCursor < triangleCount && emitted[scanCursor]) scanCursor++;
+            if (scanCursor < triangleCount) best = static_cast<unsigned int>(scanCursor);
+        }
+    }
+
+    indices.swap(output);
+}
+
+float simplifyByClustering(const std::vector<OBJVertex>& vertices, const std::vector<unsigned int>& indices,
+                           unsigned gridResolution,
+                           std::vector<OBJVertex>& outVertices, std::vector<unsigned int>& outIndices) {
+    outVertices.clear();
+    outIndices.clear();
+    if (vertices.empty()) return 0.0f;
+
+    glm::vec3 lower = vertices[0].position;
+    glm::vec3 upper = vertices[0].position;
+    for (const OBJVertex& vertex : vertices) {
+        lower = glm::min(lower, vertex.position);
+        upper = glm::max(upper, vertex.position);
+    }
+    glm::vec3 extent = upper - lower;
+    float cellSize = std::max(std::max(extent.x, extent.y), extent.z) / std::max(1u, gridResolution);
+    if (cellSize <= 0.0f) cellSize = 1.0f;
+
+    struct Cluster {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec2 texCoord = glm::vec2(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);
+        unsigned int count = 0;
+    };
+    std::unordered_map<uint64_t, unsigned int> clusterIds;
+    std::vector<Cluster> clusters;
+    std::vector<unsigned int> vertexCluster(vertices.size());
+
+    const uint64_t cells = gridResolution + 1;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const OBJVertex& vertex = vertices[i];
+        glm::vec3 cell = (vertex.position - lower) / cellSize;
+
+        // Полусфера нормали по главной оси: противоположные стороны тонкой
+        // детали не сливаются в одну вершину с нулевой нормалью
+        glm::vec3 n = vertex.normal;
+        glm::vec3 a = glm::abs(n);
+        uint64_t side = a.x >= a.y && a.x >= a.z ? (n.x < 0.0f ? 1 : 0)
+                      : a.y >= a.z ? (n.y < 0.0f ? 3 : 2)
+                      : (n.z < 0.0f ? 5 : 4);
+
+        uint64_t key = static_cast<uint64_t>(cell.x) +
+                       cells * (static_cast<uint64_t>(cell.y) +
+                                cells * (static_cast<uint64_t>(cell.z) + cells * side));
+        auto inserted = clusterIds.emplace(key, static_cast<unsigned int>(clusters.size()));
+        if (inserted.second) clusters.emplace_back();
+
+        Cluster& cluster = clusters[inserted.first->second];
+        cluster.position += vertex.position;
+        cluster.texCoord += vertex.texCoord;
+        cluster.normal += vertex.normal;
+        cluster.count++;
+        vertexCluster[i] = inserted.first->second;
+    }
+
+    outVertices.resize(clusters.size());
+    for (size_t i = 0; i < clusters.size(); i++) {
+        const Cluster& cluster = clusters[i];
+        float weight = 1.0f / cluster.count;
+        outVertices[i].position = cluster.position * weight;
+        outVertices[i].texCoord = cluster.texCoord * weight;
+        float length = glm::length(cluster.normal);
+        outVertices[i].normal = length > 0.0f ? cluster.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    outIndices.reserve(indices.size());
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        unsigned int a = vertexCluster[indices[t]];
+        unsigned int b = vertexCluster[indices[t + 1]];
+        unsigned int c = vertexCluster[indices[t + 2]];
+        if (a == b || b == c || a == c) continue;
+        outIndices.push_back(a);
+        outIndices.push_back(b);
+        outIndices.push_back(c);
+    }
+    return cellSize;
+}
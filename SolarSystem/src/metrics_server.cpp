@@ -0,0 +1,312 @@
+#include "metrics_server.h"
+#include "allocation_tracker.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SOLAR_HAS_SOCKETS 1
+#endif
+
+namespace {
+
+// Период проверки флага остановки, пока нет подключений
+const int ACCEPT_POLL_MS = 200;
+// Запрос длиннее - не наш клиент
+const size_t MAX_REQUEST_BYTES = 8192;
+const int CLIENT_TIMEOUT_SECONDS = 1;
+
+void appendFormat(std::string& out, const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0) out.append(line, std::min<size_t>(static_cast<size_t>(length), sizeof(line) - 1));
+}
+
+void appendMetric(std::string& out, const char* name, const char* type, const char* help, double value) {
+    appendFormat(out, "# HELP %s %s\n# TYPE %s %s\n%s %.10g\n", name, help, name, type, name, value);
+}
+
+} // namespace
+
+void recordFrameTime(MetricsSnapshot& metrics, double seconds) {
+    size_t bucket = 0;
+    while (bucket < FRAME_TIME_BUCKET_COUNT && seconds > FRAME_TIME_BUCKETS[bucket]) bucket++;
+    metrics.frameTimeBuckets[bucket]++;
+    metrics.frames++;
+    metrics.frameSecondsSum += seconds;
+    metrics.lastFrameSeconds = seconds;
+}
+
+std::string formatPrometheusMetrics(const MetricsSnapshot& metrics, uint64_t scrapes) {
+    std::string out;
+    out.reserve(4096);
+
+    // Корзины гистограммы в Prometheus накопительные
+    out += "# HELP solar_frame_seconds Время кадра.\n# TYPE solar_frame_seconds histogram\n";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < FRAME_TIME_BUCKET_COUNT; i++) {
+        cumulative += metrics.frameTimeBuckets[i];
+        appendFormat(out, "solar_frame_seconds_bucket{le=\"%g\"} %llu\n", FRAME_TIME_BUCKETS[i],
+                     static_cast<unsigned long long>(cumulative));
+    }
+    cumulative += metrics.frameTimeBuckets[FRAME_TIME_BUCKET_COUNT];
+    appendFormat(out, "solar_frame_seconds_bucket{le=\"+Inf\"} %llu\n", static_cast<unsigned long long>(cumulative));
+    appendFormat(out, "solar_frame_seconds_sum %.10g\n", metrics.frameSecondsSum);
+    appendFormat(out, "solar_frame_seconds_count %llu\n", static_cast<unsigned long long>(metrics.frames));
+
+    appendMetric(out, "solar_frames_total", "counter", "Отрисовано кадров.", double(metrics.frames));
+    appendMetric(out, "solar_last_frame_seconds", "gauge", "Время последнего кадра.", metrics.lastFrameSeconds);
+    appendMetric(out, "solar_draw_calls", "gauge", "Вызовов отрисовки в последнем кадре.", double(metrics.drawCalls));
+    appendMetric(out, "solar_draw_calls_total", "counter", "Вызовов отрисовки всего.", double(metrics.drawCallsTotal));
+    appendMetric(out, "solar_upload_bytes", "gauge", "Байт загружено на GPU в последнем кадре.",
+                 double(metrics.uploadBytes));
+    appendMetric(out, "solar_upload_bytes_total", "counter", "Байт загружено на GPU всего.",
+                 double(metrics.uploadBytesTotal));
+
+    appendMetric(out, "solar_bodies", "gauge", "Тел в сцене.", double(metrics.bodies));
+    appendMetric(out, "solar_bodies_visible", "gauge", "Тел после отсечения.", double(metrics.visibleBodies));
+    appendMetric(out, "solar_bodies_occluded", "gauge", "Тел перекрыто другими.", double(metrics.occludedBodies));
+    appendMetric(out, "solar_bodies_frustum_culled", "gauge", "Тел за экраном.", double(metrics.frustumCulledBodies));
+    appendMetric(out, "solar_mesh_instances", "gauge", "Тел, нарисованных мешем.", double(metrics.meshInstances));
+    appendMetric(out, "solar_impostors", "gauge", "Тел, нарисованных импостором.", double(metrics.impostors));
+    appendMetric(out, "solar_lights", "gauge", "Источников света в кадре.", double(metrics.lights));
+    appendMetric(out, "solar_collision_contacts", "gauge", "Пар пересекающихся тел.",
+                 double(metrics.collisionContacts));
+    appendMetric(out, "solar_orbit_segments", "gauge", "Отрезков во всех орбитах в последнем кадре.",
+                 double(metrics.orbitSegments));
+    appendMetric(out, "solar_memory_gpu_bytes", "gauge", "Байт в буферах и текстурах на GPU.",
+                 double(metrics.gpuMemoryBytes));
+    appendMetric(out, "solar_memory_cpu_bytes", "gauge", "Байт в копиях данных на CPU.",
+                 double(metrics.cpuMemoryBytes));
+    appendMetric(out, "solar_memory_demotions_total", "counter", "Понижений качества из-за бюджетов памяти.",
+                 double(metrics.memoryDemotions));
+
+    out += "# HELP solar_quality_level Ступень рычага регулятора качества (0 - полное качество).\n"
+           "# TYPE solar_quality_level gauge\n";
+    for (uint32_t lever = 0; lever < QUALITY_LEVER_COUNT; lever++) {
+        appendFormat(out, "solar_quality_level{lever=\"%s\"} %llu\n", qualityLeverName(static_cast<QualityLever>(lever)),
+                     static_cast<unsigned long long>(metrics.qualityLevels[lever]));
+    }
+    appendMetric(out, "solar_governor_enabled", "gauge", "Регулятор качества включён.",
+                 metrics.governorEnabled ? 1.0 : 0.0);
+    appendMetric(out, "solar_governor_cpu_seconds", "gauge", "Сглаженная работа кадра на CPU.",
+                 metrics.governorCpuSeconds);
+    appendMetric(out, "solar_governor_gpu_seconds", "gauge", "Сглаженная работа кадра на GPU.",
+                 metrics.governorGpuSeconds);
+    appendMetric(out, "solar_quality_downgrades_total", "counter", "Понижений качества регулятором.",
+                 double(metrics.qualityDowngrades));
+    appendMetric(out, "solar_quality_upgrades_total", "counter", "Повышений качества регулятором.",
+                 double(metrics.qualityUpgrades));
+
+    appendMetric(out, "solar_simulation_ticks_total", "counter", "Шагов симуляции.", double(metrics.simulationTicks));
+    appendMetric(out, "solar_simulation_tick_seconds_total", "counter", "Время CPU на шаги симуляции.",
+                 metrics.simulationTickSeconds);
+    appendMetric(out, "solar_simulation_time", "gauge", "Время внутри симуляции.", metrics.simulationTime);
+
+    appendMetric(out, "solar_orbits_visible", "gauge", "Орбиты показаны (1) или скрыты (0).",
+                 metrics.orbitsVisible ? 1.0 : 0.0);
+    appendMetric(out, "solar_occlusion_enabled", "gauge", "Отсечение перекрытых тел включено.",
+                 metrics.occlusionEnabled ? 1.0 : 0.0);
+    appendMetric(out, "solar_metrics_scrapes_total", "counter", "Ответов на /metrics.", double(scrapes));
+    return out;
+}
+
+// ==============================
+// MetricsServer
+// ==============================
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::publish(const MetricsSnapshot& metrics) {
+    buffers[back] = metrics;
+    back = ready.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+const MetricsSnapshot& MetricsServer::latest() {
+    if (ready.load(std::memory_order_acquire) & FRESH) {
+        front = ready.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    }
+    return buffers[front];
+}
+
+#ifdef SOLAR_HAS_SOCKETS
+
+bool MetricsServer::start(const std::string& address) {
+    stop();
+    endpoint = address;
+
+    if (address.compare(0, 5, "unix:") == 0) {
+        socketPath = address.substr(5);
+        sockaddr_un local = {};
+        local.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(local.sun_path)) {
+            std::cerr << "Метрики: недопустимый путь сокета: " << socketPath << std::endl;
+            return false;
+        }
+        std::memcpy(local.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        // Сокет от прошлого запуска, упавшего без уборки
+        ::unlink(socketPath.c_str());
+        listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenSocket < 0 || ::bind(listenSocket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+            std::cerr << "Метрики: не получилось открыть сокет " << socketPath << ": "
+                      << std::strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+    } else {
+        std::string host = "127.0.0.1";
+        std::string port = address;
+        size_t colon = address.rfind(':');
+        if (colon != std::string::npos) {
+            host = address.substr(0, colon);
+            port = address.substr(colon + 1);
+        }
+        char* end = nullptr;
+        unsigned long portNumber = std::strtoul(port.c_str(), &end, 10);
+        if (host != "127.0.0.1" && host != "localhost") {
+            std::cerr << "Метрики: доступны только на localhost, а не на " << host << std::endl;
+            return false;
+        }
+        if (port.empty() || *end != '\0' || portNumber == 0 || portNumber > 65535) {
+            std::cerr << "Метрики: неверный порт: " << port << std::endl;
+            return false;
+        }
+
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(static_cast<uint16_t>(portNumber));
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        listenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listenSocket >= 0) {
+            ::setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (listenSocket < 0 || ::bind(listenSocket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+            std::cerr << "Метрики: не получилось занять порт " << portNumber << ": "
+                      << std::strerror(errno) << std::endl;
+            stop();
+            return false;
+        }
+    }
+
+    if (::listen(listenSocket, 8) != 0) {
+        std::cerr << "Метрики: listen: " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    stopping.store(false);
+    thread = std::thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    stopping.store(true);
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (listenSocket >= 0) {
+        ::close(listenSocket);
+        listenSocket = -1;
+    }
+    if (!socketPath.empty()) {
+        ::unlink(socketPath.c_str());
+        socketPath.clear();
+    }
+}
+
+void MetricsServer::serve() {
+    // Ответы клиентам собираются вне кадра и в проверку кадра не входят
+    excludeThreadFromAllocationCounts();
+    while (!stopping.load()) {
+        pollfd listener = {listenSocket, POLLIN, 0};
+        if (::poll(&listener, 1, ACCEPT_POLL_MS) <= 0) continue;
+
+        int client = ::accept(listenSocket, nullptr, nullptr);
+        if (client < 0) continue;
+        handleClient(client);
+        ::close(client);
+    }
+}
+
+void MetricsServer::handleClient(int client) {
+    // Медленный клиент не должен держать сервер дольше таймаута
+    timeval timeout = {CLIENT_TIMEOUT_SECONDS, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    int noSignal = 1;
+    ::setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+
+    std::string request;
+    char chunk[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        ssize_t received = ::recv(client, chunk, sizeof(chunk), 0);
+        if (received <= 0) break;
+        request.append(chunk, static_cast<size_t>(received));
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 14, "GET /metrics?") == 0) {
+        uint64_t served = scrapes.fetch_add(1, std::memory_order_relaxed) + 1;
+        body = formatPrometheusMetrics(latest(), served);
+    } else if (request.compare(0, 4, "GET ") == 0) {
+        status = "404 Not Found";
+        body = "metrics: /metrics\n";
+    } else {
+        status = "400 Bad Request";
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+                           "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t written = ::send(client, response.data() + sent, response.size() - sent, flags);
+        if (written <= 0) break;
+        sent += static_cast<size_t>(written);
+    }
+}
+
+#else
+
+bool MetricsServer::start(const std::string& address) {
+    endpoint = address;
+    std::cerr << "Метрики: сервер доступен только на POSIX-системах" << std::endl;
+    return false;
+}
+
+void MetricsServer::stop() {
+}
+
+void MetricsServer::serve() {
+}
+
+void MetricsServer::handleClient(int) {
+}
+
+#endif
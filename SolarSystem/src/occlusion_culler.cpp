@@ -0,0 +1,338 @@
+#include "occlusion_culler.h"
+#include "obj_loader.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_SSE 1
+#endif
+
+namespace {
+
+// Тел на один кусок при параллельной проверке
+const size_t CULL_CHUNK = 4096;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Ближе ближней плоскости - треугольник не растеризуется (консервативно)
+bool isInFrontOfNearPlane(const glm::vec4& clip) {
+    return clip.w > 1e-5f && clip.z >= -clip.w;
+}
+
+} // namespace
+
+float meshBoundingRadius(const SoftMesh& mesh) {
+    float radius = 0.0f;
+    for (size_t i = 0; i < mesh.vertexCount; i++) {
+        radius = std::max(radius, glm::length(mesh.vertices[i].position));
+    }
+    return radius;
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height, ThreadPool& pool)
+    : width((std::max(width, 4) + 3) & ~3), height(std::max(height, 1)), pool(pool) {
+    int levelWidth = this->width;
+    int levelHeight = this->height;
+    while (true) {
+        Level level;
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.depth.assign(static_cast<size_t>(levelWidth) * levelHeight, 1.0f);
+        levels.push_back(std::move(level));
+
+        if (levelWidth == 1 && levelHeight == 1) break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& view, const glm::mat4& projection) {
+    this->view = view;
+    this->projection = projection;
+    viewProjection = projection * view;
+
+    std::fill(levels[0].depth.begin(), levels[0].depth.end(), 1.0f);
+    stats = OcclusionStats();
+}
+
+// ==============================
+// Растеризация перекрывающих объектов
+// ==============================
+void OcclusionCuller::addOccluder(const SoftMesh& mesh, const glm::mat4& model) {
+    auto start = std::chrono::steady_clock::now();
+
+    glm::mat4 mvp = viewProjection * model;
+    clipVertices.resize(mesh.vertexCount);
+    for (size_t i = 0; i < mesh.vertexCount; i++) {
+        clipVertices[i] = mvp * glm::vec4(mesh.vertices[i].position, 1.0f);
+    }
+
+    for (size_t i = 0; i + 2 < mesh.indexCount; i += 3) {
+        rasterizeTriangle(clipVertices[mesh.indices[i]],
+                          clipVertices[mesh.indices[i + 1]],
+                          clipVertices[mesh.indices[i + 2]]);
+    }
+
+    stats.occluders++;
+    stats.occluderTriangles += mesh.indexCount / 3;
+    stats.rasterSeconds += secondsSince(start);
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    if (!isInFrontOfNearPlane(a) || !isInFrontOfNearPlane(b) || !isInFrontOfNearPlane(c)) return;
+
+    const glm::vec4* verts[3] = {&a, &b, &c};
+    glm::vec2 screen[3];
+    float z[3];
+    for (int i = 0; i < 3; i++) {
+        float invW = 1.0f / verts[i]->w;
+        screen[i] = glm::vec2((verts[i]->x * invW * 0.5f + 0.5f) * width,
+                              (0.5f - verts[i]->y * invW * 0.5f) * height);
+        z[i] = verts[i]->z * invW * 0.5f + 0.5f;
+    }
+
+    // Та же ориентация, что в SoftRasterizer: площадь > 0 - передняя грань
+    float area = (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y) -
+                 (screen[2].y - screen[0].y) * (screen[1].x - screen[0].x);
+    if (!(area > 0.0f)) return;
+
+    int minX = std::max(0, static_cast<int>(std::floor(std::min({screen[0].x, screen[1].x, screen[2].x}))));
+    int minY = std::max(0, static_cast<int>(std::floor(std::min({screen[0].y, screen[1].y, screen[2].y}))));
+    int maxX = std::min(width - 1, static_cast<int>(std::ceil(std::max({screen[0].x, screen[1].x, screen[2].x}))));
+    int maxY = std::min(height - 1, static_cast<int>(std::ceil(std::max({screen[0].y, screen[1].y, screen[2].y}))));
+    if (minX > maxX || minY > maxY) return;
+
+    // Ребро i противолежит вершине i; глубина - барицентрическая смесь, линейная на экране
+    float edgeA[3], edgeB[3], edgeC[3];
+    for (int i = 0; i < 3; i++) {
+        const glm::vec2& p = screen[(i + 1) % 3];
+        const glm::vec2& q = screen[(i + 2) % 3];
+        edgeA[i] = q.y - p.y;
+        edgeB[i] = p.x - q.x;
+        edgeC[i] = p.y * q.x - p.x * q.y;
+    }
+    float invArea = 1.0f / area;
+    float zA = (edgeA[0] * z[0] + edgeA[1] * z[1] + edgeA[2] * z[2]) * invArea;
+    float zB = (edgeB[0] * z[0] + edgeB[1] * z[1] + edgeB[2] * z[2]) * invArea;
+    float zC = (edgeC[0] * z[0] + edgeC[1] * z[1] + edgeC[2] * z[2]) * invArea;
+
+    std::vector<float>& depth = levels[0].depth;
+    minX &= ~3;
+
+#ifdef OCCLUSION_SSE
+    const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vzA = _mm_set1_ps(zA);
+#endif
+
+    for (int y = minY; y <= maxY; y++) {
+        float py = y + 0.5f;
+        float rowTerm[3];
+        for (int e = 0; e < 3; e++) {
+            rowTerm[e] = edgeB[e] * py + edgeC[e];
+        }
+        float zRow = zB * py + zC;
+        float* row = depth.data() + static_cast<size_t>(y) * width;
+
+        for (int x = minX; x <= maxX; x += 4) {
+#ifdef OCCLUSION_SSE
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int e = 0; e < 3; e++) {
+                __m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[e]), px), _mm_set1_ps(rowTerm[e]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(value, zero));
+            }
+            if (_mm_movemask_ps(inside) == 0) continue;
+
+            __m128 pixelZ = _mm_add_ps(_mm_mul_ps(vzA, px), _mm_set1_ps(zRow));
+            __m128 old = _mm_loadu_ps(row + x);
+            __m128 nearer = _mm_min_ps(old, pixelZ);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+#else
+            for (int lane = 0; lane < 4; lane++) {
+                float px = x + lane + 0.5f;
+                bool inside = true;
+                for (int e = 0; e < 3; e++) {
+                    inside = inside && edgeA[e] * px + rowTerm[e] >= 0.0f;
+                }
+                if (inside) {
+                    row[x + lane] = std::min(row[x + lane], zA * px + zRow);
+                }
+            }
+#endif
+        }
+    }
+}
+
+// ==============================
+// Пирамида
+// ==============================
+void OcclusionCuller::buildPyramid() {
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t l = 1; l < levels.size(); l++) {
+        const Level& src = levels[l - 1];
+        Level& dst = levels[l];
+
+        for (int y = 0; y < dst.height; y++) {
+            int y0 = 2 * y;
+            int y1 = std::min(y0 + 1, src.height - 1);
+            const float* row0 = src.depth.data() + static_cast<size_t>(y0) * src.width;
+            const float* row1 = src.depth.data() + static_cast<size_t>(y1) * src.width;
+            float* out = dst.depth.data() + static_cast<size_t>(y) * dst.width;
+
+            for (int x = 0; x < dst.width; x++) {
+                int x0 = 2 * x;
+                int x1 = std::min(x0 + 1, src.width - 1);
+                out[x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+            }
+        }
+    }
+
+    stats.pyramidSeconds += secondsSince(start);
+}
+
+// ==============================
+// Проверка сфер
+// ==============================
+OcclusionCuller::SphereResult OcclusionCuller::testSphere(const glm::vec3& center, float radius) const {
+    // clip линеен по точке пространства камеры: углы описанного куба и ближайшая
+    // точка сферы (камера смотрит вдоль -Z) - это центр плюс столбцы проекции
+    glm::vec4 clipCenter = viewProjection * glm::vec4(center, 1.0f);
+    glm::vec4 dx = projection[0] * radius;
+    glm::vec4 dy = projection[1] * radius;
+    glm::vec4 dz = projection[2] * radius;
+
+    glm::vec4 nearest = clipCenter + dz;
+    if (!isInFrontOfNearPlane(nearest)) return SPHERE_VISIBLE;
+    float nearestDepth = nearest.z / nearest.w * 0.5f + 0.5f;
+
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    for (int corner = 0; corner < 8; corner++) {
+        float sx = corner & 1 ? 1.0f : -1.0f;
+        float sy = corner & 2 ? 1.0f : -1.0f;
+        float sz = corner & 4 ? 1.0f : -1.0f;
+
+        float w = clipCenter.w + sx * dx.w + sy * dy.w + sz * dz.w;
+        if (w <= 1e-5f) return SPHERE_VISIBLE;
+
+        float invW = 1.0f / w;
+        float x = (clipCenter.x + sx * dx.x + sy * dy.x + sz * dz.x) * invW;
+        float y = (clipCenter.y + sx * dx.y + sy * dy.y + sz * dz.y) * invW;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+
+    if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) return SPHERE_OFFSCREEN;
+
+    // В пиксели буфера (ось Y вниз, как при растеризации)
+    int x0 = std::max(0, static_cast<int>(std::floor((minX * 0.5f + 0.5f) * width)));
+    int x1 = std::min(width - 1, static_cast<int>(std::floor((maxX * 0.5f + 0.5f) * width)));
+    int y0 = std::max(0, static_cast<int>(std::floor((0.5f - maxY * 0.5f) * height)));
+    int y1 = std::min(height - 1, static_cast<int>(std::floor((0.5f - minY * 0.5f) * height)));
+
+    // Уровень, на котором прямоугольник укладывается в 2x2 texels
+    int extent = std::max(x1 - x0, y1 - y0) + 1;
+    size_t level = 0;
+    while ((1 << level) < extent && level + 1 < levels.size()) {
+        level++;
+    }
+
+    const Level& hiz = levels[level];
+    float farthest = 0.0f;
+    for (int y = y0 >> level; y <= (y1 >> level); y++) {
+        const float* row = hiz.depth.data() + static_cast<size_t>(y) * hiz.width;
+        for (int x = x0 >> level; x <= (x1 >> level); x++) {
+            farthest = std::max(farthest, row[x]);
+        }
+    }
+
+    return nearestDepth > farthest ? SPHERE_OCCLUDED : SPHERE_VISIBLE;
+}
+
+bool OcclusionCuller::isSphereVisible(const glm::vec3& center, float radius) const {
+    return testSphere(center, radius) == SPHERE_VISIBLE;
+}
+
+const std::vector<uint32_t>& OcclusionCuller::selectOccluders(const std::vector<CelestialBody>& bodies,
+                                                              float meshRadius, size_t maxCount,
+                                                              float minScreenFraction) {
+    // Экранный размер ~ радиус / расстояние * projection[1][1]
+    std::vector<std::pair<float, uint32_t>>& candidates = occluderCandidates;
+    candidates.clear();
+    for (size_t i = 0; i < bodies.size(); i++) {
+        const CelestialBody& body = bodies[i];
+        glm::vec4 viewCenter = view * glm::vec4(body.getOrbitPosition(), 1.0f);
+        float distance = -viewCenter.z;
+        if (distance <= 0.0f) continue;
+
+        float screenFraction = meshRadius * body.scale / distance * projection[1][1];
+        if (screenFraction >= minScreenFraction) {
+            candidates.push_back({screenFraction, static_cast<uint32_t>(i)});
+        }
+    }
+
+    size_t count = std::min(maxCount, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    occluders.clear();
+    for (size_t i = 0; i < count; i++) {
+        occluders.push_back(candidates[i].second);
+    }
+    return occluders;
+}
+
+void OcclusionCuller::cullBodies(const std::vector<CelestialBody>& bodies, float meshRadius,
+                                 std::vector<uint32_t>& visible) {
+    auto start = std::chrono::steady_clock::now();
+
+    size_t chunkCount = (bodies.size() + CULL_CHUNK - 1) / CULL_CHUNK;
+    chunkCounts.assign(chunkCount + 1, 0);
+    results.resize(bodies.size());
+
+    // Проход 1: проверка и число видимых в каждом куске
+    pool.parallelFor(chunkCount, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t chunk = begin; chunk < end; chunk++) {
+            size_t first = chunk * CULL_CHUNK;
+            size_t last = std::min(first + CULL_CHUNK, bodies.size());
+            size_t count = 0;
+            for (size_t i = first; i < last; i++) {
+                const CelestialBody& body = bodies[i];
+                SphereResult result = testSphere(body.getOrbitPosition(), meshRadius * body.scale);
+                results[i] = static_cast<uint8_t>(result);
+                count += result == SPHERE_VISIBLE;
+            }
+            chunkCounts[chunk + 1] = count;
+        }
+    });
+
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        chunkCounts[chunk + 1] += chunkCounts[chunk];
+    }
+
+    // Проход 2: каждый кусок пишет свои индексы со своего смещения
+    visible.resize(chunkCounts[chunkCount]);
+    pool.parallelFor(chunkCount, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t chunk = begin; chunk < end; chunk++) {
+            size_t first = chunk * CULL_CHUNK;
+            size_t last = std::min(first + CULL_CHUNK, bodies.size());
+            uint32_t* out = visible.data() + chunkCounts[chunk];
+            for (size_t i = first; i < last; i++) {
+                if (results[i] == SPHERE_VISIBLE) *out++ = static_cast<uint32_t>(i);
+            }
+        }
+    });
+
+    stats.tested = bodies.size();
+    stats.occluded = std::count(results.begin(), results.end(), static_cast<uint8_t>(SPHERE_OCCLUDED));
+    stats.frustumCulled = bodies.size() - visible.size() - stats.occluded;
+    stats.testSeconds += secondsSince(start);
+}
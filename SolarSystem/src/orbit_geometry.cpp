@@ -0,0 +1,70 @@
+#include "orbit_geometry.h"
+#include <algorithm>
+#include <cmath>
+
+std::vector<float> createOrbitCircle(float radius, int segments) {
+    std::vector<float> vertices;
+    vertices.reserve((segments + 1) * 3);
+    for (int i = 0; i <= segments; i++) {
+        float angle = (i / (float)segments) * 2.0f * 3.14159265f;
+        vertices.push_back(radius * std::cos(angle));  
+        vertices.push_back(0.0f);                      
+        vertices.push_back(radius * std::sin(angle));  
+    }
+    return vertices;
+}
+
+glm::vec3 orbitColor(size_t bodyIndex) {
+    static const glm::vec3 colors[] = {
+        glm::vec3(1.0f, 0.5f, 0.0f),  
+        glm::vec3(0.0f, 0.8f, 1.0f),  
+        glm::vec3(0.0f, 1.0f, 0.5f),  
+        glm::vec3(1.0f, 0.0f, 0.5f),  
+        glm::vec3(0.5f, 0.0f, 1.0f),  
+        glm::vec3(1.0f, 1.0f, 0.0f),  
+        glm::vec3(1.0f, 0.8f, 0.0f),  
+    };
+    const size_t colorCount = sizeof(colors) / sizeof(colors[0]);
+
+    return colors[(bodyIndex + colorCount - 1) % colorCount];
+}
+
+void buildOrbitLevels(std::vector<float>& vertices, std::vector<OrbitLevel>& levels) {
+    vertices.clear();
+    levels.clear();
+    for (int level = 0; level < ORBIT_LEVEL_COUNT; level++) {
+        std::vector<float> circle = createOrbitCircle(1.0f, ORBIT_MIN_SEGMENTS << level);
+        levels.push_back({static_cast<int>(vertices.size() / 3), static_cast<int>(circle.size() / 3)});
+        vertices.insert(vertices.end(), circle.begin(), circle.end());
+    }
+}
+
+float orbitRadiusPixels(const glm::vec3& center, float radius, const glm::vec3& cameraPosition,
+                        float focalPixels) {
+    glm::vec3 offset = cameraPosition - center;
+    float planar = std::sqrt(offset.x * offset.x + offset.z * offset.z);
+    float distance = std::sqrt((planar - radius) * (planar - radius) + offset.y * offset.y);
+
+    // Камера на самой орбите - нужна самая подробная окружность
+    if (distance <= radius * 1e-6f) return 1e30f;
+    return radius / distance * focalPixels;
+}
+
+int orbitSegmentsForError(float radiusPixels, float tolerancePixels) {
+    if (tolerancePixels <= 0.0f) return ORBIT_MIN_SEGMENTS << (ORBIT_LEVEL_COUNT - 1);
+    if (radiusPixels <= tolerancePixels) return ORBIT_MIN_SEGMENTS;
+
+    // Стрелка дуги из 1/n окружности: r * (1 - cos(pi / n)) <= tolerance.
+    // В double: для больших орбит 1 - tolerance / r неотличимо от 1 во float
+    double halfAngle = std::acos(1.0 - double(tolerancePixels) / radiusPixels);
+    double segments = std::ceil(3.14159265358979 / halfAngle);
+    return static_cast<int>(std::min(segments, 1e9));
+}
+
+int orbitLevelForSegments(int segments) {
+    int level = 0;
+    while (level + 1 < ORBIT_LEVEL_COUNT && (ORBIT_MIN_SEGMENTS << level) < segments) {
+        level++;
+    }
+    return level;
+}
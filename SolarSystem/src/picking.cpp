@@ -0,0 +1,94 @@
+#include "picking.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PickRay screenRay(const Camera& camera, float x, float y, float width, float height) {
+    glm::mat4 inverseViewProjection =
+        glm::inverse(camera.getProjectionMatrix(width / height) * camera.getViewMatrix());
+
+    float ndcX = 2.0f * x / width - 1.0f;
+    float ndcY = 1.0f - 2.0f * y / height;
+    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    nearPoint /= nearPoint.w;
+    farPoint /= farPoint.w;
+
+    PickRay ray;
+    ray.origin = glm::vec3(nearPoint);
+    ray.direction = glm::normalize(glm::vec3(farPoint - nearPoint));
+    return ray;
+}
+
+namespace {
+
+const size_t BROADPHASE_GRAIN = 8192;
+
+} // namespace
+
+BodyPicker::BodyPicker(ThreadPool& pool)
+    : pool(pool), workerCandidates(pool.threadCount()) {
+}
+
+PickResult BodyPicker::pick(const std::vector<CelestialBody>& bodies, const MeshBVH& mesh,
+                            float meshRadius, const PickRay& ray) {
+    PickResult result;
+    candidates.clear();
+    for (auto& list : workerCandidates) {
+        list.clear();
+    }
+
+    // Широкая фаза: луч против сферы, радиус и центр - как у инстанса
+    const CelestialBody* source = bodies.data();
+    pool.parallelFor(bodies.size(), BROADPHASE_GRAIN, [&](size_t begin, size_t end, size_t worker) {
+        std::vector<Candidate>& list = workerCandidates[worker];
+        for (size_t i = begin; i < end; i++) {
+            const CelestialBody& body = source[i];
+            float radius = meshRadius * body.scale;
+            glm::vec3 toCenter = body.getOrbitPosition() - ray.origin;
+            float along = glm::dot(toCenter, ray.direction);
+            float distance2 = glm::dot(toCenter, toCenter) - along * along;
+            if (distance2 > radius * radius) continue;
+
+            float half = std::sqrt(radius * radius - distance2);
+            if (along + half < 0.0f) continue;
+            list.push_back({std::max(along - half, 0.0f), static_cast<uint32_t>(i)});
+        }
+    });
+    for (const auto& list : workerCandidates) {
+        candidates.insert(candidates.end(), list.begin(), list.end());
+    }
+    result.candidates = candidates.size();
+    if (candidates.empty()) return result;
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                  return a.enter < b.enter || (a.enter == b.enter && a.body < b.body);
+              });
+
+    // Узкая фаза по BVH в координатах меша
+    float best = std::numeric_limits<float>::max();
+    for (const Candidate& candidate : candidates) {
+        if (candidate.enter >= best) break;
+
+        glm::mat4 inverseModel = glm::inverse(bodies[candidate.body].getModelMatrix());
+        glm::vec3 localOrigin = glm::vec3(inverseModel * glm::vec4(ray.origin, 1.0f));
+        glm::vec3 localDirection = glm::vec3(inverseModel * glm::vec4(ray.direction, 0.0f));
+
+        MeshHit hit;
+        result.meshTests++;
+        if (mesh.intersect(localOrigin, localDirection, best, hit)) {
+            best = hit.distance;
+            result.hit = true;
+            result.body = candidate.body;
+            result.distance = hit.distance;
+            result.triangle = hit.triangle;
+        }
+    }
+
+    if (result.hit) {
+        result.point = ray.origin + ray.direction * result.distance;
+    }
+    return result;
+}
@@ -0,0 +1,219 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// Ограничение истории трассы: ~5 минут при 60 FPS и десятке замеров в кадре
+const size_t MAX_TRACE_EVENTS = 200000;
+
+void writeJsonString(std::ostream& out, const char* str) {
+    out << '"';
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') out << '\\';
+        out << *str;
+    }
+    out << '"';
+}
+
+} // namespace
+
+// ==============================
+// ProfileRing
+// ==============================
+ProfileRing::ProfileRing(size_t capacityPow2)
+    : slots(capacityPow2), mask(capacityPow2 - 1) {
+    for (size_t i = 0; i < slots.size(); i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool ProfileRing::push(const ProfileEvent& event) {
+    uint64_t index = writeIndex.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = slots[index & mask];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(index);
+
+        if (diff == 0) {
+            if (writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) {
+                slot.event = event;
+                slot.sequence.store(index + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // Читатель не успевает - теряем замер, но не ждём
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            index = writeIndex.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool ProfileRing::pop(ProfileEvent& event) {
+    Slot& slot = slots[readIndex & mask];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != readIndex + 1) return false;
+
+    event = slot.event;
+    slot.sequence.store(readIndex + mask + 1, std::memory_order_release);
+    readIndex++;
+    return true;
+}
+
+// ==============================
+// Profiler
+// ==============================
+Profiler::Profiler() : ring(1 << 14) {
+}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t Profiler::currentThreadId() {
+    static std::atomic<uint32_t> nextId{1};
+    thread_local uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void Profiler::beginFrame() {
+    if (!isEnabled()) return;
+
+    frameStartNs = nowNs();
+    if (intervalStartNs == 0) intervalStartNs = frameStartNs;
+}
+
+void Profiler::endFrame() {
+    if (!isEnabled() || frameStartNs == 0) return;
+
+    uint64_t now = nowNs();
+    uint64_t frameNs = now - frameStartNs;
+    record("frame", frameStartNs, frameNs);
+
+    intervalFrames++;
+    intervalFrameNs += frameNs;
+    intervalMaxFrameNs = std::max(intervalMaxFrameNs, frameNs);
+    frameIndex++;
+
+    collect();
+
+    if (summaryInterval > 0.0 && (now - intervalStartNs) * 1e-9 >= summaryInterval) {
+        printSummary();
+    }
+}
+
+void Profiler::record(const char* name, uint64_t startNs, uint64_t durationNs, ProfileTrack track) {
+    ProfileEvent event;
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    event.threadId = track == ProfileTrack::GPU ? 0 : currentThreadId();
+    event.frame = frameIndex;
+    event.track = track;
+    ring.push(event);
+}
+
+Profiler::ScopeStats& Profiler::statsFor(const char* name, ProfileTrack track) {
+    // Областей единицы - линейного поиска достаточно
+    for (auto& scope : scopes) {
+        if (scope.track == track && (scope.name == name || std::strcmp(scope.name, name) == 0)) {
+            return scope;
+        }
+    }
+    scopes.push_back(ScopeStats{name, track});
+    return scopes.back();
+}
+
+void Profiler::collect() {
+    ProfileEvent event;
+    while (ring.pop(event)) {
+        ScopeStats& stats = statsFor(event.name, event.track);
+        stats.calls++;
+        stats.totalNs += event.durationNs;
+        stats.maxNs = std::max(stats.maxNs, event.durationNs);
+
+        if (captureTrace && trace.size() < MAX_TRACE_EVENTS) {
+            trace.push_back(event);
+        }
+    }
+}
+
+void Profiler::printSummary() {
+    collect();
+    if (intervalFrames == 0) return;
+
+    double seconds = (nowNs() - intervalStartNs) * 1e-9;
+    double avgFrameMs = intervalFrameNs * 1e-6 / intervalFrames;
+
+    std::printf("=== Профиль: %llu кадров за %.1f с, %.1f FPS, кадр %.2f мс (макс %.2f мс) ===\n",
+                static_cast<unsigned long long>(intervalFrames), seconds,
+                intervalFrames / seconds, avgFrameMs, intervalMaxFrameNs * 1e-6);
+
+    for (const auto& scope : scopes) {
+        if (scope.calls == 0) continue;
+        std::printf("  %-4s %-24s %8.3f мс/кадр  %8.3f мс макс  %6llu вызовов\n",
+                    scope.track == ProfileTrack::GPU ? "GPU" : "CPU", scope.name,
+                    scope.totalNs * 1e-6 / intervalFrames, scope.maxNs * 1e-6,
+                    static_cast<unsigned long long>(scope.calls));
+    }
+
+    if (ring.droppedCount() > 0) {
+        std::printf("  потеряно замеров: %llu\n",
+                    static_cast<unsigned long long>(ring.droppedCount()));
+    }
+
+    for (auto& scope : scopes) {
+        scope.calls = 0;
+        scope.totalNs = 0;
+        scope.maxNs = 0;
+    }
+    intervalStartNs = nowNs();
+    intervalFrames = 0;
+    intervalFrameNs = 0;
+    intervalMaxFrameNs = 0;
+}
+
+bool Profiler::exportChromeTrace(const std::string& filename) {
+    collect();
+
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Не получилось создать файл трассы: " << filename << std::endl;
+        return false;
+    }
+
+    uint64_t baseNs = trace.empty() ? 0 : trace.front().startNs;
+    for (const auto& event : trace) baseNs = std::min(baseNs, event.startNs);
+
+    // GPU-замеры идут отдельным процессом, чтобы не перекрываться с CPU
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    char buffer[128];
+    for (const auto& event : trace) {
+        file << ",\n{\"name\":";
+        writeJsonString(file, event.name);
+        std::snprintf(buffer, sizeof(buffer),
+                      ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{\"frame\":%u}}",
+                      (event.startNs - baseNs) * 1e-3, event.durationNs * 1e-3,
+                      event.track == ProfileTrack::GPU ? 2 : 1, event.threadId, event.frame);
+        file << buffer;
+    }
+    file << "\n]}\n";
+
+    std::cout << "Трасса сохранена: " << filename << " (" << trace.size() << " событий)" << std::endl;
+    return file.good();
+}
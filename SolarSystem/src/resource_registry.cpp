@@ -0,0 +1,132 @@
+#include "resource_registry.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+const char* KIND_NAMES[] = {"буфер", "текстура", "копия CPU"};
+const char* DOMAIN_NAMES[] = {"GPU", "CPU"};
+
+double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+MemoryDomain resourceDomain(ResourceKind kind) {
+    return kind == RESOURCE_CPU_MIRROR ? MEMORY_CPU : MEMORY_GPU;
+}
+
+size_t mipChainBytes(uint32_t width, uint32_t height, uint32_t bytesPerTexel, uint32_t levels) {
+    size_t bytes = 0;
+    for (uint32_t level = 0; levels == 0 || level < levels; level++) {
+        bytes += size_t(width) * height * bytesPerTexel;
+        if (width == 1 && height == 1) break;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    return bytes;
+}
+
+void ResourceRegistry::track(ResourceId& id, const char* name, ResourceKind kind, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id == NO_RESOURCE || id >= records.size() || !records[id].live) {
+        // Свободная запись от освобождённого ресурса, иначе новая
+        id = 0;
+        while (id < records.size() && records[id].live) id++;
+        if (id == records.size()) records.emplace_back();
+
+        ResourceRecord& record = records[id];
+        record.name = name;
+        record.kind = kind;
+        record.bytes = 0;
+        record.live = true;
+    }
+
+    ResourceRecord& record = records[id];
+    MemoryDomain domain = resourceDomain(record.kind);
+    totals[domain] = totals[domain] - record.bytes + bytes;
+    peaks[domain] = std::max(peaks[domain], totals[domain]);
+    record.bytes = bytes;
+}
+
+void ResourceRegistry::untrack(ResourceId& id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id < records.size() && records[id].live) {
+        ResourceRecord& record = records[id];
+        totals[resourceDomain(record.kind)] -= record.bytes;
+        record.bytes = 0;
+        record.live = false;
+    }
+    id = NO_RESOURCE;
+}
+
+size_t ResourceRegistry::totalBytes(MemoryDomain domain) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals[domain];
+}
+
+size_t ResourceRegistry::peakBytes(MemoryDomain domain) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peaks[domain];
+}
+
+void ResourceRegistry::setBudget(MemoryDomain domain, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budgets[domain] = bytes;
+}
+
+size_t ResourceRegistry::getBudget(MemoryDomain domain) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budgets[domain];
+}
+
+bool ResourceRegistry::overBudget(MemoryDomain domain) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budgets[domain] > 0 && totals[domain] > budgets[domain];
+}
+
+std::vector<ResourceRecord> ResourceRegistry::snapshot() const {
+    std::vector<ResourceRecord> live;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const ResourceRecord& record : records) {
+            if (record.live) live.push_back(record);
+        }
+    }
+    std::stable_sort(live.begin(), live.end(), [](const ResourceRecord& a, const ResourceRecord& b) {
+        return a.bytes > b.bytes;
+    });
+    return live;
+}
+
+std::string ResourceRegistry::formatReport() const {
+    std::string out = "Память ресурсов:\n";
+    char line[512];
+    for (const ResourceRecord& record : snapshot()) {
+        std::snprintf(line, sizeof(line), "  %-3s %-10s %10.3f МБ  %s\n", DOMAIN_NAMES[resourceDomain(record.kind)],
+                      KIND_NAMES[record.kind], megabytes(record.bytes), record.name.c_str());
+        out += line;
+    }
+    for (uint32_t domain = 0; domain < MEMORY_DOMAIN_COUNT; domain++) {
+        MemoryDomain memory = static_cast<MemoryDomain>(domain);
+        size_t budget = getBudget(memory);
+        std::snprintf(line, sizeof(line), "  Итого %s: %.3f МБ, пик %.3f МБ", DOMAIN_NAMES[domain],
+                      megabytes(totalBytes(memory)), megabytes(peakBytes(memory)));
+        out += line;
+        if (budget > 0) {
+            std::snprintf(line, sizeof(line), ", бюджет %.3f МБ%s", megabytes(budget),
+                          overBudget(memory) ? " - ПРЕВЫШЕН" : "");
+            out += line;
+        }
+        out += "\n";
+    }
+    return out;
+}
+
+// Не разрушается: глобальные объекты (модель планеты) освобождают ресурсы
+// уже после выхода из main, и реестр должен быть ещё жив
+ResourceRegistry& ResourceRegistry::shared() {
+    static ResourceRegistry* registry = new ResourceRegistry();
+    return *registry;
+}
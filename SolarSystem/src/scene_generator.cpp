@@ -0,0 +1,162 @@
+#include "scene_generator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const size_t SYSTEM_GRAIN = 1024;
+const float TWO_PI = 6.28318531f;
+const float ARM_TWIST = TWO_PI;             // поворот рукава от центра до края диска
+const float MIN_ORBIT_RADIUS = 4.0f;
+const float SYSTEM_EXTENT = 0.4f;           // внешняя орбита - доля расстояния между системами
+const float INNER_SPEED = 3.0f;             // градусы за единицу времени на MIN_ORBIT_RADIUS у звезды массы 1
+
+// Потоки случайных чисел: системы - 0.. , скопления и размеры систем - отдельно
+const uint64_t STREAM_SIZES = ~0ull;
+const uint64_t STREAM_CLUSTERS = ~0ull - 1;
+
+// splitmix64: состояние - счётчик, поэтому поток задаётся одним числом
+uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+class GalaxyRandom {
+public:
+    GalaxyRandom(uint64_t seed, uint64_t stream) : state(mix64(seed ^ mix64(stream))) {}
+
+    uint64_t nextBits() {
+        state += 0x9e3779b97f4a7c15ull;
+        return mix64(state);
+    }
+
+    // [0, 1) из 24 бит
+    float next() { return static_cast<float>(nextBits() >> 40) * (1.0f / 16777216.0f); }
+    float range(float low, float high) { return low + (high - low) * next(); }
+    uint32_t below(uint32_t count) { return static_cast<uint32_t>((nextBits() >> 32) * count >> 32); }
+
+    // Нормальное распределение (Бокс - Мюллер)
+    float gaussian() {
+        float u = 1.0f - next();
+        return std::sqrt(-2.0f * std::log(u)) * std::cos(TWO_PI * next());
+    }
+
+private:
+    uint64_t state;
+};
+
+CelestialBody makeGalaxyBody(const glm::vec3& center) {
+    CelestialBody body;
+    body.orbitRadius = 0.0f;
+    body.orbitSpeed = 0.0f;
+    body.rotationSpeed = 0.0f;
+    body.scale = 1.0f;
+    body.orbitAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+    body.orbitCenter = center;
+    return body;
+}
+
+// Звезда и planets планет с центром в center
+void buildStarSystem(GalaxyRandom& random, const glm::vec3& center, uint32_t planets,
+                     float outerRadius, CelestialBody* out) {
+    float mass = 0.3f + 2.7f * random.next() * random.next();
+    CelestialBody star = makeGalaxyBody(center);
+    star.rotationSpeed = random.range(0.2f, 1.0f);
+    star.scale = 8.0f + 4.0f * std::sqrt(mass);
+    star.currentRotationAngle = random.range(0.0f, 360.0f);
+    out[0] = star;
+    if (planets == 0) return;
+
+    // Шаг орбит не больше такого, при котором последняя остаётся внутри outerRadius
+    float firstRadius = MIN_ORBIT_RADIUS * random.range(1.0f, 1.5f);
+    float maxStep = planets > 1 ? std::pow(outerRadius / firstRadius, 1.0f / (planets - 1)) : 2.0f;
+    float step = std::min(random.range(1.25f, 1.7f), std::max(1.05f, maxStep));
+    float speedScale = INNER_SPEED * std::sqrt(mass);
+
+    float radius = firstRadius;
+    for (uint32_t k = 0; k < planets; k++) {
+        CelestialBody planet = makeGalaxyBody(center);
+        planet.orbitRadius = radius * random.range(0.92f, 1.08f);
+        float ratio = MIN_ORBIT_RADIUS / planet.orbitRadius;
+        planet.orbitSpeed = speedScale * ratio * std::sqrt(ratio);
+        planet.rotationSpeed = random.range(0.5f, 4.0f);
+        float size = random.next();
+        planet.scale = 1.0f + 6.0f * size * size * size;
+        planet.currentOrbitAngle = random.range(0.0f, 360.0f);
+        planet.currentRotationAngle = random.range(0.0f, 360.0f);
+        out[1 + k] = planet;
+        radius *= step;
+    }
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+void generateGalaxy(const GalaxyParams& params, SolarSystem& system, ThreadPool& pool, GalaxyStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    system.clear();
+    if (params.bodyCount == 0) return;
+    const uint32_t minPlanets = std::min(params.minPlanets, params.maxPlanets);
+
+    // Размеры систем - последовательно, это дёшево; последняя обрезается до bodyCount
+    std::vector<size_t> firstBody;
+    {
+        GalaxyRandom random(params.seed, STREAM_SIZES);
+        size_t total = 0;
+        while (total < params.bodyCount) {
+            firstBody.push_back(total);
+            total += 1 + minPlanets + random.below(params.maxPlanets - minPlanets + 1);
+        }
+        firstBody.push_back(params.bodyCount);
+    }
+    const size_t systemCount = firstBody.size() - 1;
+
+    // Скопления - по рукавам диска, плотнее к центру
+    const uint32_t clusterCount = params.clusterCount > 0
+        ? params.clusterCount
+        : std::max(1u, static_cast<uint32_t>(std::sqrt(static_cast<double>(systemCount))));
+    const float galaxyRadius = params.systemSpacing * std::sqrt(static_cast<float>(systemCount));
+    const float clusterRadius = 0.5f * params.systemSpacing * std::sqrt(float(systemCount) / clusterCount);
+    const uint32_t arms = std::max(1u, params.arms);
+
+    std::vector<glm::vec3> clusterCenters(clusterCount);
+    {
+        GalaxyRandom random(params.seed, STREAM_CLUSTERS);
+        for (uint32_t c = 0; c < clusterCount; c++) {
+            float r = galaxyRadius * (0.05f + 0.95f * std::sqrt(random.next()));
+            float angle = (c % arms) * TWO_PI / arms + ARM_TWIST * r / galaxyRadius + 0.3f * random.gaussian();
+            float height = random.gaussian() * params.thickness * galaxyRadius * 0.5f;
+            clusterCenters[c] = glm::vec3(r * std::cos(angle), height, r * std::sin(angle));
+        }
+    }
+
+    std::vector<CelestialBody>& bodies = system.getBodies();
+    bodies.resize(params.bodyCount);
+
+    const float outerRadius = std::max(MIN_ORBIT_RADIUS * 1.5f, SYSTEM_EXTENT * params.systemSpacing);
+    pool.parallelFor(systemCount, SYSTEM_GRAIN, [&](size_t begin, size_t end, size_t) {
+        for (size_t s = begin; s < end; s++) {
+            GalaxyRandom random(params.seed, s);
+            const glm::vec3& cluster = clusterCenters[random.below(clusterCount)];
+            glm::vec3 offset(random.gaussian(), random.gaussian() * params.thickness * 4.0f, random.gaussian());
+            size_t first = firstBody[s];
+            uint32_t planets = static_cast<uint32_t>(firstBody[s + 1] - first - 1);
+            buildStarSystem(random, cluster + offset * clusterRadius, planets, outerRadius, &bodies[first]);
+        }
+    });
+
+    if (stats) {
+        stats->clusters = clusterCount;
+        stats->systems = systemCount;
+        stats->bodies = params.bodyCount;
+        stats->radius = galaxyRadius;
+        stats->seconds = secondsSince(start);
+    }
+}
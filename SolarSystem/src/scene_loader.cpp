@@ -0,0 +1,379 @@
+#include "scene_loader.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace {
+
+const char SCENE_MAGIC[4] = {'S', 'S', 'C', 'N'};
+const size_t SCENE_COLUMN_ALIGN = 64;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+CelestialBody makeBody() {
+    CelestialBody body;
+    body.orbitRadius = 0.0f;
+    body.orbitSpeed = 0.0f;
+    body.rotationSpeed = 0.0f;
+    body.scale = 1.0f;
+    body.orbitAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+    body.orbitCenter = glm::vec3(0.0f);
+    return body;
+}
+
+// =====================================================
+// Текстовый формат
+// =====================================================
+
+bool streamSceneText(const std::string& filename, const SceneChunkCallback& callback,
+                     size_t chunkSize, SceneLoadStats& stats) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Не получилось открыть файл сцены: " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<CelestialBody> chunk;
+    chunk.reserve(chunkSize);
+
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        stats.bytesRead += line.size() + 1;
+
+        const char* cursor = line.c_str();
+        while (*cursor == ' ' || *cursor == '\t') cursor++;
+        if (*cursor == '\0' || *cursor == '#' || *cursor == '\r') continue;
+
+        if (std::strncmp(cursor, "body", 4) != 0) {
+            std::cerr << filename << ":" << lineNumber << ": неизвестная запись" << std::endl;
+            continue;
+        }
+        cursor += 4;
+
+        // strtof быстрее istringstream на миллионах строк
+        float values[7] = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f};
+        int parsed = 0;
+        for (; parsed < 7; parsed++) {
+            char* end = nullptr;
+            float value = std::strtof(cursor, &end);
+            if (end == cursor) break;
+            values[parsed] = value;
+            cursor = end;
+        }
+
+        if (parsed < 4) {
+            std::cerr << filename << ":" << lineNumber
+                      << ": ожидается минимум 4 числа" << std::endl;
+            continue;
+        }
+
+        CelestialBody body = makeBody();
+        body.orbitRadius = values[0];
+        body.orbitSpeed = values[1];
+        body.rotationSpeed = values[2];
+        body.scale = values[3];
+        body.orbitCenter = glm::vec3(values[4], values[5], values[6]);
+        chunk.push_back(body);
+
+        if (chunk.size() == chunkSize) {
+            callback(chunk.data(), chunk.size());
+            stats.bodyCount += chunk.size();
+            chunk.clear();
+        }
+    }
+
+    if (!chunk.empty()) {
+        callback(chunk.data(), chunk.size());
+        stats.bodyCount += chunk.size();
+    }
+
+    return true;
+}
+
+// =====================================================
+// Бинарный колоночный формат
+// =====================================================
+
+bool streamSceneBinary(const std::string& filename, const SceneChunkCallback& callback,
+                       size_t chunkSize, SceneLoadStats& stats) {
+    MappedFile file;
+    if (!file.open(filename)) return false;
+
+    if (file.size() < sizeof(SceneFileHeader)) {
+        std::cerr << "Файл сцены повреждён: " << filename << std::endl;
+        return false;
+    }
+
+    SceneFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, SCENE_MAGIC, 4) != 0) {
+        std::cerr << "Неверная сигнатура файла сцены: " << filename << std::endl;
+        return false;
+    }
+    if (header.version > SCENE_BINARY_VERSION) {
+        std::cerr << "Неподдерживаемая версия сцены " << header.version
+                  << ": " << filename << std::endl;
+        return false;
+    }
+
+    // Сравнение через деление: произведение из заголовка может переполниться
+    if (header.columnCount > (file.size() - sizeof(SceneFileHeader)) / sizeof(SceneColumnDesc)) {
+        std::cerr << "Таблица колонок выходит за пределы файла: " << filename << std::endl;
+        return false;
+    }
+    size_t tableEnd = sizeof(SceneFileHeader) + header.columnCount * sizeof(SceneColumnDesc);
+    // Каждому телу нужно хотя бы одно значение колонки - иначе файл без
+    // знакомых колонок выдал бы сколько угодно тел по умолчанию
+    if (header.bodyCount > (file.size() - tableEnd) / sizeof(float)) {
+        std::cerr << "Число тел " << header.bodyCount << " не помещается в файл сцены: " << filename << std::endl;
+        return false;
+    }
+
+    const float* columns[SCENE_COLUMN_COUNT] = {};
+    for (uint32_t i = 0; i < header.columnCount; i++) {
+        SceneColumnDesc desc;
+        std::memcpy(&desc, file.data() + sizeof(SceneFileHeader) + i * sizeof(SceneColumnDesc),
+                    sizeof(desc));
+
+        // Незнакомые колонки (из более новых версий) пропускаем
+        if (desc.id >= SCENE_COLUMN_COUNT || desc.elementSize != sizeof(float)) continue;
+
+        if (desc.offset % alignof(float) != 0 || desc.offset > file.size() ||
+            header.bodyCount > (file.size() - desc.offset) / sizeof(float)) {
+            std::cerr << "Колонка " << desc.id << " выходит за пределы файла: "
+                      << filename << std::endl;
+            return false;
+        }
+        columns[desc.id] = reinterpret_cast<const float*>(file.data() + desc.offset);
+    }
+
+    file.adviseSequential();
+
+    std::vector<CelestialBody> chunk(std::min<uint64_t>(chunkSize, header.bodyCount));
+    stats.bytesRead += tableEnd;
+
+    for (uint64_t first = 0; first < header.bodyCount; first += chunkSize) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(chunkSize, header.bodyCount - first));
+
+        for (size_t i = 0; i < count; i++) {
+            chunk[i] = makeBody();
+        }
+
+        // Колонка за колонкой - последовательный доступ к каждой
+        for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+            const float* src = columns[column];
+            if (src == nullptr) continue;
+
+            src += first;
+            for (size_t i = 0; i < count; i++) {
+                *sceneColumnField(chunk[i], column) = src[i];
+            }
+
+            size_t offset = reinterpret_cast<const unsigned char*>(src) - file.data();
+            file.releaseRange(offset, count * sizeof(float));
+            stats.bytesRead += count * sizeof(float);
+        }
+
+        callback(chunk.data(), count);
+        stats.bodyCount += count;
+    }
+
+    return true;
+}
+
+} // namespace
+
+float sceneColumnValue(const CelestialBody& body, uint32_t column) {
+    switch (column) {
+        case SCENE_COL_ORBIT_RADIUS:   return body.orbitRadius;
+        case SCENE_COL_ORBIT_SPEED:    return body.orbitSpeed;
+        case SCENE_COL_ROTATION_SPEED: return body.rotationSpeed;
+        case SCENE_COL_SCALE:          return body.scale;
+        case SCENE_COL_CENTER_X:       return body.orbitCenter.x;
+        case SCENE_COL_CENTER_Y:       return body.orbitCenter.y;
+        case SCENE_COL_CENTER_Z:       return body.orbitCenter.z;
+        case SCENE_COL_ORBIT_ANGLE:    return body.currentOrbitAngle;
+        case SCENE_COL_ROTATION_ANGLE: return body.currentRotationAngle;
+    }
+    return 0.0f;
+}
+
+float* sceneColumnField(CelestialBody& body, uint32_t column) {
+    switch (column) {
+        case SCENE_COL_ORBIT_RADIUS:   return &body.orbitRadius;
+        case SCENE_COL_ORBIT_SPEED:    return &body.orbitSpeed;
+        case SCENE_COL_ROTATION_SPEED: return &body.rotationSpeed;
+        case SCENE_COL_SCALE:          return &body.scale;
+        case SCENE_COL_CENTER_X:       return &body.orbitCenter.x;
+        case SCENE_COL_CENTER_Y:       return &body.orbitCenter.y;
+        case SCENE_COL_CENTER_Z:       return &body.orbitCenter.z;
+        case SCENE_COL_ORBIT_ANGLE:    return &body.currentOrbitAngle;
+        case SCENE_COL_ROTATION_ANGLE: return &body.currentRotationAngle;
+    }
+    return nullptr;
+}
+
+bool isBinarySceneFile(const std::string& filename) {
+    return endsWith(filename, ".sscn");
+}
+
+bool streamScene(const std::string& filename, const SceneChunkCallback& callback,
+                 size_t chunkSize, SceneLoadStats* stats) {
+    if (chunkSize == 0) chunkSize = SCENE_DEFAULT_CHUNK;
+
+    SceneLoadStats local;
+    auto start = std::chrono::steady_clock::now();
+
+    bool ok = isBinarySceneFile(filename)
+        ? streamSceneBinary(filename, callback, chunkSize, local)
+        : streamSceneText(filename, callback, chunkSize, local);
+
+    local.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats) *stats = local;
+    return ok;
+}
+
+bool loadScene(const std::string& filename, SolarSystem& system, SceneLoadStats* stats) {
+    system.clear();
+
+    // Для бинарного файла число тел известно заранее. Заголовок ещё не
+    // проверен, поэтому резерв - не больше, чем тел может поместиться в файл
+    if (isBinarySceneFile(filename)) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        uint64_t fileBytes = static_cast<uint64_t>(std::max<std::streamoff>(0, file.tellg()));
+        file.seekg(0);
+        SceneFileHeader header;
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+            std::memcmp(header.magic, SCENE_MAGIC, 4) == 0 && header.bodyCount <= fileBytes / sizeof(float)) {
+            system.reserve(static_cast<size_t>(header.bodyCount));
+        }
+    }
+
+    return streamScene(filename,
+        [&system](const CelestialBody* bodies, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                system.addBody(bodies[i]);
+            }
+        },
+        SCENE_DEFAULT_CHUNK, stats);
+}
+
+bool saveSceneText(const std::string& filename, const SolarSystem& system) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Не получилось создать файл сцены: " << filename << std::endl;
+        return false;
+    }
+
+    // Столько знаков, чтобы strtof при загрузке вернул то же число
+    file.precision(std::numeric_limits<float>::max_digits10);
+    file << "# orbitRadius orbitSpeed rotationSpeed scale [cx cy cz]\n";
+    for (const auto& body : system.getBodies()) {
+        file << "body " << body.orbitRadius << ' ' << body.orbitSpeed << ' '
+             << body.rotationSpeed << ' ' << body.scale;
+        if (body.orbitCenter != glm::vec3(0.0f)) {
+            file << ' ' << body.orbitCenter.x << ' ' << body.orbitCenter.y
+                 << ' ' << body.orbitCenter.z;
+        }
+        file << '\n';
+    }
+
+    return file.good();
+}
+
+bool saveSceneBinary(const std::string& filename, const SolarSystem& system) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Не получилось создать файл сцены: " << filename << std::endl;
+        return false;
+    }
+
+    const auto& bodies = system.getBodies();
+
+    SceneFileHeader header = {};
+    std::memcpy(header.magic, SCENE_MAGIC, 4);
+    header.version = SCENE_BINARY_VERSION;
+    header.bodyCount = bodies.size();
+    header.columnCount = SCENE_COLUMN_COUNT;
+
+    const size_t columnBytes = bodies.size() * sizeof(float);
+    size_t offset = alignUp(sizeof(header) + SCENE_COLUMN_COUNT * sizeof(SceneColumnDesc),
+                            SCENE_COLUMN_ALIGN);
+
+    std::vector<SceneColumnDesc> table(SCENE_COLUMN_COUNT);
+    for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+        table[column].id = column;
+        table[column].elementSize = sizeof(float);
+        table[column].offset = offset;
+        offset = alignUp(offset + columnBytes, SCENE_COLUMN_ALIGN);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()),
+               table.size() * sizeof(SceneColumnDesc));
+
+    // Колонки пишутся кусками, чтобы не держать копию всей сцены
+    std::vector<float> buffer(std::min(bodies.size(), SCENE_DEFAULT_CHUNK));
+    const char padding[SCENE_COLUMN_ALIGN] = {};
+
+    for (uint32_t column = 0; column < SCENE_COLUMN_COUNT; column++) {
+        size_t position = static_cast<size_t>(file.tellp());
+        file.write(padding, table[column].offset - position);
+
+        for (size_t first = 0; first < bodies.size(); first += buffer.size()) {
+            size_t count = std::min(buffer.size(), bodies.size() - first);
+            for (size_t i = 0; i < count; i++) {
+                buffer[i] = sceneColumnValue(bodies[first + i], column);
+            }
+            file.write(reinterpret_cast<const char*>(buffer.data()), count * sizeof(float));
+        }
+    }
+
+    return file.good();
+}
+
+bool saveScene(const std::string& filename, const SolarSystem& system) {
+    return isBinarySceneFile(filename) ? saveSceneBinary(filename, system)
+                                       : saveSceneText(filename, system);
+}
+
+void buildDefaultScene(SolarSystem& system) {
+    system.clear();
+
+    CelestialBody sun = makeBody();
+    sun.orbitRadius = 0.0f;
+    sun.orbitSpeed = 0.0f;
+    sun.rotationSpeed = 0.5f;
+    sun.scale = 15.0f;
+    system.addBody(sun);
+
+    float radii[] = {4.0f, 6.0f, 8.0f, 10.0f, 13.0f, 16.0f};
+    float speeds[] = {3.0f, 2.0f, 1.5f, 1.2f, 0.8f, 0.5f};
+    float rotations[] = {4.0f, 3.0f, 2.5f, 2.0f, 1.5f, 1.0f};
+    float scales[] = {5.3f, 5.1f, 5.6f, 6.4f, 4.2f, 4.8f};
+
+    for (int i = 0; i < 6; i++) {
+        CelestialBody planet = makeBody();
+        planet.orbitRadius = radii[i];
+        planet.orbitSpeed = speeds[i];
+        planet.rotationSpeed = rotations[i];
+        planet.scale = scales[i];
+        system.addBody(planet);
+    }
+}
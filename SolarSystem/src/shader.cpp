@@ -1,12 +1,20 @@
 #include "shader.h"
-#include <iostream>
+#include "shader_cache.h"
 
 const char* vertexShaderSource = R"(
 #version 330 core
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texCoord;
 layout(location = 2) in vec3 normal;
+#ifdef COMPACT_INSTANCES
+// Первые три строки аффинной матрицы инстанса, четвёртая всегда (0, 0, 0, 1)
+layout(location = 3) in vec4 instanceRow0;
+layout(location = 4) in vec4 instanceRow1;
+layout(location = 5) in vec4 instanceRow2;
+#else
 layout(location = 3) in mat4 instanceMatrix; // Матрица инстанса (занимает 4 атрибута)
+#endif
+layout(location = 7) in float instanceDissolve; // Переход к импостору: 0 - меш целиком
 
 uniform mat4 view;
 uniform mat4 projection;
@@ -15,14 +23,25 @@ uniform vec3 lightPos;
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
+flat out float Dissolve;
+#ifdef CLUSTERED_LIGHTS
+out float ViewDepth;
+#endif
 
 void main() {
+#ifdef COMPACT_INSTANCES
+    mat4 instanceMatrix = transpose(mat4(instanceRow0, instanceRow1, instanceRow2, vec4(0.0, 0.0, 0.0, 1.0)));
+#endif
     vec4 worldPos = instanceMatrix * vec4(position, 1.0);
     gl_Position = projection * view * worldPos;
     
     TexCoord = texCoord;
     FragPos = worldPos.xyz;
     Normal = mat3(transpose(inverse(instanceMatrix))) * normal;
+    Dissolve = instanceDissolve;
+#ifdef CLUSTERED_LIGHTS
+    ViewDepth = -(view * worldPos).z;
+#endif
 }
 )";
 
@@ -31,37 +50,103 @@ const char* fragmentShaderSource = R"(
 in vec2 TexCoord;
 in vec3 Normal;
 in vec3 FragPos;
+flat in float Dissolve;
 
 uniform sampler2D textureSampler;
+uniform vec3 materialColor;             // Kd материала отрезка
 uniform vec3 lightPos;
 
+#ifdef CLUSTERED_LIGHTS
+in float ViewDepth;
+
+uniform samplerBuffer lightData;        // два texel на источник: позиция и радиус, цвет
+uniform usamplerBuffer clusterRanges;   // на кластер: смещение и число источников
+uniform usamplerBuffer clusterLights;   // номера источников подряд
+uniform ivec3 clusterGrid;
+uniform vec2 viewportSize;
+uniform vec2 clusterDepth;              // ближняя плоскость и срезов на единицу log(глубины)
+#endif
+
 out vec4 FragColor;
 
+// Порог Байера 4x4 для плавного перехода меш/импостор
+float ditherThreshold(vec2 fragCoord) {
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                      3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    ivec2 p = ivec2(fragCoord) & 3;
+    return (bayer[p.y * 4 + p.x] + 0.5) / 16.0;
+}
+
+// Фонг без амбиентной части для одного направления на источник
+vec3 shadeLight(vec3 norm, vec3 lightDir, vec3 albedo) {
+    // Диффузное освещение
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * albedo;
+
+#ifdef SPECULAR
+    // Спекулярное освещение
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(-FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+    vec3 specular = specularStrength * spec * vec3(1.0);
+#else
+    vec3 specular = vec3(0.0);
+#endif
+    return diffuse + specular;
+}
+
+#ifdef CLUSTERED_LIGHTS
+// Сумма источников кластера фрагмента; вклад плавно гаснет к радиусу источника
+vec3 clusteredLighting(vec3 norm, vec3 albedo) {
+    float slice = log(max(ViewDepth, clusterDepth.x) / clusterDepth.x) * clusterDepth.y;
+    ivec3 cell = ivec3(vec3(gl_FragCoord.xy / viewportSize * vec2(clusterGrid.xy), slice));
+    cell = clamp(cell, ivec3(0), clusterGrid - 1);
+    int cluster = (cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x;
+
+    uvec2 range = texelFetch(clusterRanges, cluster).xy;
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(clusterLights, int(range.x + i)).r);
+        vec4 positionRange = texelFetch(lightData, light * 2);
+        vec3 color = texelFetch(lightData, light * 2 + 1).rgb;
+
+        vec3 toLight = positionRange.xyz - FragPos;
+        float ratio = length(toLight) / positionRange.w;
+        float falloff = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+        result += shadeLight(norm, normalize(toLight), albedo) * color * (falloff * falloff);
+    }
+    return result;
+}
+#endif
+
 void main() {
+    // Остальные пиксели рисует импостор
+    if (Dissolve + ditherThreshold(gl_FragCoord.xy) >= 1.0) discard;
+
+#ifdef TEXTURED
     // Получаем цвет текстуры
     vec4 texColor = texture(textureSampler, TexCoord);
     if (texColor.a < 0.1) discard;
+#else
+    vec4 texColor = vec4(0.8, 0.8, 0.8, 1.0);
+#endif
+    texColor.rgb *= materialColor;
     
     // Фонговое освещение
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
     
     // Амбиентное освещение
     float ambientStrength = 0.4;
     vec3 ambient = ambientStrength * texColor.rgb;
     
-    // Диффузное освещение
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * texColor.rgb;
-    
-    // Спекулярное освещение
-    float specularStrength = 0.5;
-    vec3 viewDir = normalize(-FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-    vec3 specular = specularStrength * spec * vec3(1.0);
+#ifdef CLUSTERED_LIGHTS
+    vec3 lighting = clusteredLighting(norm, texColor.rgb);
+#else
+    vec3 lighting = shadeLight(norm, normalize(lightPos - FragPos), texColor.rgb);
+#endif
     
-    vec3 result = ambient + diffuse + specular;
+    vec3 result = ambient + lighting;
     FragColor = vec4(result, texColor.a);
 }
 )";
@@ -72,9 +157,10 @@ const char* orbitVertexShader = R"(
         
         uniform mat4 view;
         uniform mat4 projection;
+        uniform vec4 orbit;     // центр и радиус; position - точка единичной окружности
         
         void main() {
-            gl_Position = projection * view * vec4(position, 1.0);
+            gl_Position = projection * view * vec4(orbit.xyz + position * orbit.w, 1.0);
         }
     )";
     
@@ -88,25 +174,20 @@ const char* orbitFragmentShader = R"(
         }
     )";
 
-InstancedShader::InstancedShader() {
-    unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-    
-    unsigned int fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-    
-    programID = glCreateProgram();
-    glAttachShader(programID, vertex);
-    glAttachShader(programID, fragment);
-    glLinkProgram(programID);
-    checkCompileErrors(programID, "PROGRAM");
-    
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+std::string shaderFeatureDefines(uint32_t features) {
+    std::string defines;
+    if (features & SHADER_SPECULAR) defines += "#define SPECULAR\n";
+    if (features & SHADER_TEXTURED) defines += "#define TEXTURED\n";
+    if (features & SHADER_COMPACT_INSTANCES) defines += "#define COMPACT_INSTANCES\n";
+    if (features & SHADER_CLUSTERED_LIGHTS) defines += "#define CLUSTERED_LIGHTS\n";
+    return defines;
+}
+
+InstancedShader::InstancedShader(ProgramCache& cache, uint32_t features) : features(features) {
+    // Имя файла в кэше различает варианты, ключ всё равно содержит defines
+    std::string name = "instanced_" + std::to_string(features);
+    programID = cache.build(name.c_str(), vertexShaderSource, fragmentShaderSource,
+                            shaderFeatureDefines(features));
 }
 
 InstancedShader::~InstancedShader() {
@@ -117,40 +198,19 @@ void InstancedShader::use() const {
     glUseProgram(programID);
 }
 
-void InstancedShader::setMat4(const std::string& name, const glm::mat4& mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(programID, name.c_str()), 
+void InstancedShader::setMat4(const char* name, const glm::mat4& mat) const {
+    glUniformMatrix4fv(glGetUniformLocation(programID, name), 
                       1, GL_FALSE, &mat[0][0]);
 }
 
-void InstancedShader::setVec3(const std::string& name, const glm::vec3& vec) const {
-    glUniform3fv(glGetUniformLocation(programID, name.c_str()), 1, &vec[0]);
+void InstancedShader::setVec3(const char* name, const glm::vec3& vec) const {
+    glUniform3fv(glGetUniformLocation(programID, name), 1, &vec[0]);
 }
 
-void InstancedShader::setFloat(const std::string& name, float value) const {
-    glUniform1f(glGetUniformLocation(programID, name.c_str()), value);
+void InstancedShader::setFloat(const char* name, float value) const {
+    glUniform1f(glGetUniformLocation(programID, name), value);
 }
 
-void InstancedShader::setInt(const std::string& name, int value) const {
-    glUniform1i(glGetUniformLocation(programID, name.c_str()), value);
+void InstancedShader::setInt(const char* name, int value) const {
+    glUniform1i(glGetUniformLocation(programID, name), value);
 }
-
-void InstancedShader::checkCompileErrors(GLuint shader, const std::string& type) {
-    int success;
-    char infoLog[1024];
-    
-    if (type != "PROGRAM") {
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-            std::cerr << "Ошибка компиляции " << type << " шейдера:" << std::endl
-                     << infoLog << std::endl;
-        }
-    } else {
-        glGetProgramiv(shader, GL_LINK_STATUS, &success);
-        if (!success) {
-            glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-            std::cerr << "Ошибка линкования программы:" << std::endl
-                     << infoLog << std::endl;
-        }
-    }
-}
\ No newline at end of file
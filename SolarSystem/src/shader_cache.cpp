@@ -0,0 +1,236 @@
+#include "shader_cache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const char PROGRAM_MAGIC[4] = {'S', 'P', 'R', 'G'};
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;                // binaryFormat из glGetProgramBinary
+    uint32_t length;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// FNV-1a, 64 бита
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t hashString(uint64_t hash, const std::string& text) {
+    // Длина тоже в хэше: "ab"+"c" и "a"+"bc" дают разные ключи
+    uint64_t length = text.size();
+    hash = hashBytes(hash, &length, sizeof(length));
+    return hashBytes(hash, text.data(), text.size());
+}
+
+std::string glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+GLuint compileStage(GLenum type, const std::string& source, const char* name) {
+    GLuint shader = glCreateShader(type);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+        std::cerr << "Ошибка компиляции " << (type == GL_VERTEX_SHADER ? "вертексного" : "фрагментного")
+                  << " шейдера " << name << ":\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+std::string injectDefines(const char* source, const std::string& defines) {
+    std::string text = source;
+    if (defines.empty()) return text;
+
+    size_t version = text.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : text.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return defines + text;
+    }
+    text.insert(lineEnd + 1, defines);
+    return text;
+}
+
+void ProgramCache::init(const std::string& cacheDirectory) {
+    enabled = false;
+    directory = cacheDirectory;
+    stats = ProgramCacheStats();
+    if (directory.empty()) return;
+
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    if (formats == 0) {
+        std::cout << "Драйвер не сохраняет бинарники программ, кэш шейдеров выключен" << std::endl;
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Не получилось создать папку кэша шейдеров " << directory << ": "
+                  << error.message() << std::endl;
+        return;
+    }
+
+    driver = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+    enabled = true;
+}
+
+GLuint ProgramCache::build(const char* name, const char* vertexSource, const char* fragmentSource,
+                           const std::string& defines) {
+    std::string vertexText = injectDefines(vertexSource, defines);
+    std::string fragmentText = injectDefines(fragmentSource, defines);
+
+    std::string path;
+    uint64_t key = 0;
+    if (enabled) {
+        key = hashString(hashString(hashString(14695981039346656037ull, driver), vertexText), fragmentText);
+        char file[64];
+        std::snprintf(file, sizeof(file), "_%016llx.bin", static_cast<unsigned long long>(key));
+        path = (std::filesystem::path(directory) / (std::string(name) + file)).string();
+
+        auto start = std::chrono::steady_clock::now();
+        GLuint program = load(path, key);
+        if (program != 0) {
+            stats.hits++;
+            stats.loadSeconds += secondsSince(start);
+            return program;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GLuint vertex = compileStage(GL_VERTEX_SHADER, vertexText, name);
+    GLuint fragment = compileStage(GL_FRAGMENT_SHADER, fragmentText, name);
+    if (vertex == 0 || fragment == 0) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    if (enabled) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cerr << "Ошибка линковки шейдера " << name << ":\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    stats.misses++;
+    stats.compileSeconds += secondsSince(start);
+    if (enabled) {
+        store(path, key, program);
+    }
+    return program;
+}
+
+GLuint ProgramCache::load(const std::string& path, uint64_t key) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return 0;
+
+    ProgramFileHeader header;
+    std::vector<char> binary;
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                 std::memcmp(header.magic, PROGRAM_MAGIC, 4) == 0 &&
+                 header.version == PROGRAM_CACHE_VERSION && header.key == key && header.length > 0;
+    if (valid) {
+        binary.resize(header.length);
+        valid = std::fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    std::fclose(file);
+    if (!valid) {
+        stats.rejected++;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Драйвер обновился без смены GL_VERSION или формат больше не поддерживается
+        glDeleteProgram(program);
+        stats.rejected++;
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::store(const std::string& path, uint64_t key, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    ProgramFileHeader header = {};
+    std::memcpy(header.magic, PROGRAM_MAGIC, 4);
+    header.version = PROGRAM_CACHE_VERSION;
+    header.key = key;
+    header.format = format;
+    header.length = static_cast<uint32_t>(length);
+
+    // Через временный файл: параллельный запуск не прочитает половину бинарника
+    std::string tempName = path + ".tmp";
+    FILE* file = std::fopen(tempName.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Не получилось записать кэш шейдера " << path << std::endl;
+        return;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(binary.data(), 1, header.length, file) == header.length;
+    written = std::fclose(file) == 0 && written;
+
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(tempName, path, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(tempName, error);
+        std::cerr << "Не получилось записать кэш шейдера " << path << std::endl;
+    }
+}
@@ -0,0 +1,256 @@
+#include "sim_stream.h"
+#include "allocation_tracker.h"
+#include "thread_pool.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <zlib.h>
+
+namespace {
+
+const size_t CAPTURE_GRAIN = 16384;
+const size_t POSITION_FLOATS = 3;
+const size_t MATRIX_FLOATS = 12;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+size_t simFrameSize(size_t bodyCount, uint32_t flags) {
+    size_t floats = 0;
+    if (flags & SIM_STREAM_POSITIONS) floats += POSITION_FLOATS;
+    if (flags & SIM_STREAM_MATRICES) floats += MATRIX_FLOATS;
+    return bodyCount * floats * sizeof(float);
+}
+
+void captureSimFrame(const SolarSystem& system, uint32_t flags, unsigned char* out, ThreadPool& pool) {
+    const std::vector<CelestialBody>& bodies = system.getBodies();
+    const size_t count = bodies.size();
+    unsigned char* positions = (flags & SIM_STREAM_POSITIONS) ? out : nullptr;
+    unsigned char* matrices = nullptr;
+    if (flags & SIM_STREAM_MATRICES) {
+        matrices = out + (positions ? count * POSITION_FLOATS * sizeof(float) : 0);
+    }
+
+    pool.parallelFor(count, CAPTURE_GRAIN, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            const CelestialBody& body = bodies[i];
+            if (positions) {
+                glm::vec3 position = body.getOrbitPosition();
+                float values[POSITION_FLOATS] = {position.x, position.y, position.z};
+                std::memcpy(positions + i * sizeof(values), values, sizeof(values));
+            }
+            if (matrices) {
+                // Построчно: строка r - m[0][r], m[1][r], m[2][r], m[3][r]
+                glm::mat4 model = body.getModelMatrix();
+                float values[MATRIX_FLOATS];
+                for (int row = 0; row < 3; row++) {
+                    for (int column = 0; column < 4; column++) {
+                        values[row * 4 + column] = model[column][row];
+                    }
+                }
+                std::memcpy(matrices + i * sizeof(values), values, sizeof(values));
+            }
+        }
+    });
+}
+
+// ==============================
+// SimStreamWriter
+// ==============================
+SimStreamWriter::~SimStreamWriter() {
+    close();
+}
+
+bool SimStreamWriter::open(const std::string& filename, size_t bodyCount, uint32_t stride, uint32_t flags,
+                           float deltaTime, int compressionLevel) {
+    close();
+
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Не получилось создать файл: " << filename << std::endl;
+        return false;
+    }
+
+    SimStreamHeader header = {};
+    std::memcpy(header.magic, "SSIM", 4);
+    header.version = SIM_STREAM_VERSION;
+    header.bodyCount = bodyCount;
+    header.stride = stride;
+    header.flags = flags;
+    header.deltaTime = deltaTime;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::cerr << "Ошибка записи: " << filename << std::endl;
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    frameSize = simFrameSize(bodyCount, flags);
+    level = compressionLevel;
+    for (Slot& slot : slots) {
+        slot.data.resize(frameSize);
+        slot.queued = false;
+    }
+    current = 0;
+    next = 0;
+    closing = false;
+    failed = false;
+    stats = SimStreamStats();
+    stats.compressedBytes = sizeof(header);
+
+    writer = std::thread(&SimStreamWriter::writerLoop, this);
+    return true;
+}
+
+bool SimStreamWriter::close() {
+    if (!file) return !failed;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    queuedChanged.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    if (std::fclose(file) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+    return !failed;
+}
+
+unsigned char* SimStreamWriter::acquireFrame() {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    queuedChanged.wait(lock, [this] { return !slots[current].queued; });
+    stats.stallSeconds += secondsSince(start);
+    return slots[current].data.data();
+}
+
+void SimStreamWriter::submitFrame(uint64_t step, double time) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot& slot = slots[current];
+        slot.step = step;
+        slot.time = time;
+        slot.queued = true;
+        current ^= 1;
+    }
+    queuedChanged.notify_all();
+}
+
+void SimStreamWriter::writerLoop() {
+    // Сжатие и запись идут параллельно кадрам и в проверку кадра не входят
+    excludeThreadFromAllocationCounts();
+    std::vector<unsigned char> compressed;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        // Кадры отдаются по очереди в слоты 0, 1, 0, ... - и пишутся в том же порядке
+        queuedChanged.wait(lock, [this] { return slots[next].queued || closing; });
+        if (!slots[next].queued) break;
+
+        Slot& slot = slots[next];
+        lock.unlock();
+        bool written = !failed && writeFrame(slot, compressed);
+        lock.lock();
+
+        failed = failed || !written;
+        slot.queued = false;
+        next ^= 1;
+        queuedChanged.notify_all();
+    }
+}
+
+bool SimStreamWriter::writeFrame(const Slot& slot, std::vector<unsigned char>& compressed) {
+    auto start = std::chrono::steady_clock::now();
+    uLongf compressedSize = compressBound(static_cast<uLong>(frameSize));
+    compressed.resize(compressedSize);
+    int result = compress2(compressed.data(), &compressedSize, slot.data.data(), static_cast<uLong>(frameSize), level);
+    double compressSeconds = secondsSince(start);
+    if (result != Z_OK) {
+        std::cerr << "Ошибка сжатия кадра " << slot.step << ": " << result << std::endl;
+        return false;
+    }
+
+    start = std::chrono::steady_clock::now();
+    SimFrameHeader frame;
+    frame.step = slot.step;
+    frame.time = slot.time;
+    frame.rawSize = frameSize;
+    frame.compressedSize = compressedSize;
+    bool written = std::fwrite(&frame, sizeof(frame), 1, file) == 1 &&
+                   std::fwrite(compressed.data(), 1, compressedSize, file) == compressedSize;
+    double writeSeconds = secondsSince(start);
+    if (!written) {
+        std::cerr << "Ошибка записи кадра " << slot.step << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.frames++;
+    stats.rawBytes += frameSize;
+    stats.compressedBytes += sizeof(frame) + compressedSize;
+    stats.compressSeconds += compressSeconds;
+    stats.writeSeconds += writeSeconds;
+    return true;
+}
+
+// ==============================
+// SimStreamReader
+// ==============================
+SimStreamReader::~SimStreamReader() {
+    close();
+}
+
+bool SimStreamReader::open(const std::string& filename) {
+    close();
+    file = std::fopen(filename.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Не получилось открыть файл: " << filename << std::endl;
+        return false;
+    }
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "SSIM", 4) != 0 ||
+        header.version != SIM_STREAM_VERSION) {
+        std::cerr << "Не поток состояний или другая версия: " << filename << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SimStreamReader::close() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+bool SimStreamReader::readFrame(SimFrameHeader& frame, std::vector<unsigned char>& data) {
+    if (!file || std::fread(&frame, sizeof(frame), 1, file) != 1) return false;
+
+    size_t expected = simFrameSize(static_cast<size_t>(header.bodyCount), header.flags);
+    if (frame.rawSize != expected || frame.compressedSize > compressBound(static_cast<uLong>(expected))) {
+        std::cerr << "Повреждённый кадр " << frame.step << std::endl;
+        return false;
+    }
+
+    compressed.resize(static_cast<size_t>(frame.compressedSize));
+    if (std::fread(compressed.data(), 1, compressed.size(), file) != compressed.size()) {
+        std::cerr << "Файл обрывается на кадре " << frame.step << std::endl;
+        return false;
+    }
+
+    data.resize(expected);
+    uLongf size = static_cast<uLongf>(expected);
+    if (uncompress(data.data(), &size, compressed.data(), static_cast<uLong>(compressed.size())) != Z_OK ||
+        size != expected) {
+        std::cerr << "Не распаковывается кадр " << frame.step << std::endl;
+        return false;
+    }
+    return true;
+}
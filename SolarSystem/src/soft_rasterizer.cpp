@@ -0,0 +1,476 @@
+#include "soft_rasterizer.h"
+#include "obj_loader.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFT_RASTER_SSE 1
+#endif
+
+namespace {
+
+// Сколько треугольников обрабатывается за один проход вершины-корзины-тайлы
+const size_t MAX_BATCH_TRIANGLES = 1 << 18;
+
+uint32_t packColor(glm::vec3 rgb) {
+    rgb = glm::clamp(rgb, 0.0f, 1.0f);
+    uint32_t r = static_cast<uint32_t>(rgb.x * 255.0f + 0.5f);
+    uint32_t g = static_cast<uint32_t>(rgb.y * 255.0f + 0.5f);
+    uint32_t b = static_cast<uint32_t>(rgb.z * 255.0f + 0.5f);
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+glm::vec4 unpackColor(uint32_t texel) {
+    return glm::vec4(texel & 0xFF, (texel >> 8) & 0xFF, (texel >> 16) & 0xFF, texel >> 24) / 255.0f;
+}
+
+glm::vec3 reflect(glm::vec3 incident, glm::vec3 normal) {
+    return incident - 2.0f * glm::dot(normal, incident) * normal;
+}
+
+// Освещение из fragmentShaderSource
+glm::vec3 shadePhong(glm::vec3 texColor, glm::vec3 normal, glm::vec3 fragPos, glm::vec3 lightPos) {
+    glm::vec3 norm = glm::normalize(normal);
+    glm::vec3 lightDir = glm::normalize(lightPos - fragPos);
+
+    float ambientStrength = 0.4f;
+    glm::vec3 ambient = ambientStrength * texColor;
+
+    float diff = std::max(glm::dot(norm, lightDir), 0.0f);
+    glm::vec3 diffuse = diff * texColor;
+
+    float specularStrength = 0.5f;
+    glm::vec3 viewDir = glm::normalize(-fragPos);
+    glm::vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = std::pow(std::max(glm::dot(viewDir, reflectDir), 0.0f), 32.0f);
+    glm::vec3 specular = specularStrength * spec * glm::vec3(1.0f);
+
+    return ambient + diffuse + specular;
+}
+
+} // namespace
+
+// ==============================
+// SoftTexture
+// ==============================
+glm::vec4 SoftTexture::sample(glm::vec2 uv) const {
+    if (width == 0 || height == 0) return glm::vec4(1.0f);
+
+    float x = uv.x * width - 0.5f;
+    float y = uv.y * height - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    float tx = x - fx;
+    float ty = y - fy;
+
+    auto wrap = [](int value, int size) {
+        value %= size;
+        return value < 0 ? value + size : value;
+    };
+
+    int x0 = wrap(static_cast<int>(fx), width);
+    int y0 = wrap(static_cast<int>(fy), height);
+    int x1 = wrap(x0 + 1, width);
+    int y1 = wrap(y0 + 1, height);
+
+    glm::vec4 c00 = unpackColor(texels[y0 * width + x0]);
+    glm::vec4 c10 = unpackColor(texels[y0 * width + x1]);
+    glm::vec4 c01 = unpackColor(texels[y1 * width + x0]);
+    glm::vec4 c11 = unpackColor(texels[y1 * width + x1]);
+
+    return glm::mix(glm::mix(c00, c10, tx), glm::mix(c01, c11, tx), ty);
+}
+
+SoftTexture SoftTexture::solid(glm::vec3 rgb) {
+    SoftTexture texture;
+    texture.width = 4;
+    texture.height = 4;
+    texture.texels.assign(16, packColor(rgb));
+    return texture;
+}
+
+// ==============================
+// SoftRasterizer
+// ==============================
+SoftRasterizer::SoftRasterizer(int width, int height, ThreadPool& pool)
+    : view(1.0f), projection(1.0f), viewProjection(1.0f), pool(pool) {
+    resize(width, height);
+
+    workerTriangles.resize(pool.threadCount());
+    workerBins.resize(pool.threadCount());
+}
+
+void SoftRasterizer::resize(int newWidth, int newHeight) {
+    width = std::max(1, newWidth);
+    height = std::max(1, newHeight);
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    color.assign(static_cast<size_t>(width) * height, 0);
+    depth.assign(static_cast<size_t>(width) * height, 1.0f);
+}
+
+void SoftRasterizer::clear(glm::vec3 clearColor) {
+    std::fill(color.begin(), color.end(), packColor(clearColor));
+    std::fill(depth.begin(), depth.end(), 1.0f);
+}
+
+void SoftRasterizer::setCamera(const glm::mat4& newView, const glm::mat4& newProjection) {
+    view = newView;
+    projection = newProjection;
+    viewProjection = projection * view;
+}
+
+void SoftRasterizer::drawLineStrip(const float* points, size_t count, glm::vec3 lineColor) {
+    auto start = std::chrono::steady_clock::now();
+    const uint32_t packed = packColor(lineColor);
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        glm::vec4 a = viewProjection * glm::vec4(points[i * 3], points[i * 3 + 1], points[i * 3 + 2], 1.0f);
+        glm::vec4 b = viewProjection * glm::vec4(points[i * 3 + 3], points[i * 3 + 4], points[i * 3 + 5], 1.0f);
+
+        // Отсечение ближней плоскостью z = -w
+        float da = a.z + a.w;
+        float db = b.z + b.w;
+        if (da < 0.0f && db < 0.0f) continue;
+        if (da < 0.0f) a = glm::mix(a, b, da / (da - db));
+        if (db < 0.0f) b = glm::mix(b, a, db / (db - da));
+
+        float ax = (a.x / a.w * 0.5f + 0.5f) * width;
+        float ay = (0.5f - a.y / a.w * 0.5f) * height;
+        float bx = (b.x / b.w * 0.5f + 0.5f) * width;
+        float by = (0.5f - b.y / b.w * 0.5f) * height;
+
+        float steps = std::ceil(std::max(std::fabs(bx - ax), std::fabs(by - ay)));
+        if (steps > 4.0f * (width + height)) continue;   // вырожденная проекция
+
+        int stepCount = std::max(1, static_cast<int>(steps));
+        for (int s = 0; s <= stepCount; s++) {
+            float t = s / static_cast<float>(stepCount);
+            int x = static_cast<int>(ax + (bx - ax) * t);
+            int y = static_cast<int>(ay + (by - ay) * t);
+            if (x >= 0 && x < width && y >= 0 && y < height) {
+                color[static_cast<size_t>(y) * width + x] = packed;
+            }
+        }
+        stats.linesDrawn++;
+    }
+
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SoftRasterizer::drawMeshInstanced(const SoftMesh& mesh, const glm::mat4* instances,
+                                       size_t instanceCount, const SoftTexture& texture,
+                                       glm::vec3 lightPos) {
+    if (mesh.vertexCount == 0 || mesh.indexCount < 3 || instanceCount == 0) return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    const size_t trianglesPerInstance = mesh.indexCount / 3;
+    const size_t batchInstances = std::max<size_t>(1, MAX_BATCH_TRIANGLES / trianglesPerInstance);
+    const size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+    const size_t workers = pool.threadCount();
+
+    for (auto& bins : workerBins) bins.resize(tileCount);
+    std::vector<size_t> workerPixels(workers, 0);
+
+    for (size_t first = 0; first < instanceCount; first += batchInstances) {
+        const size_t count = std::min(batchInstances, instanceCount - first);
+
+        // 1. Вершины: мир, нормали (transpose(inverse(model))), клип-пространство
+        clipVertices.resize(count * mesh.vertexCount);
+        pool.parallelFor(count, 16, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                const glm::mat4& model = instances[first + i];
+                glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+                ClipVertex* out = &clipVertices[i * mesh.vertexCount];
+
+                for (size_t v = 0; v < mesh.vertexCount; v++) {
+                    const OBJVertex& src = mesh.vertices[v];
+                    glm::vec4 world = model * glm::vec4(src.position, 1.0f);
+                    out[v].world = glm::vec3(world);
+                    out[v].clip = viewProjection * world;
+                    out[v].normal = normalMatrix * src.normal;
+                    out[v].uv = src.texCoord;
+                }
+            }
+        });
+
+        // 2. Отсечение, настройка и раскладка по корзинам тайлов
+        for (size_t w = 0; w < workers; w++) {
+            workerTriangles[w].clear();
+            for (auto& bin : workerBins[w]) bin.clear();
+        }
+
+        pool.parallelFor(count, std::max<size_t>(1, 4096 / trianglesPerInstance),
+                         [&](size_t begin, size_t end, size_t worker) {
+            for (size_t i = begin; i < end; i++) {
+                const ClipVertex* verts = &clipVertices[i * mesh.vertexCount];
+                for (size_t t = 0; t + 2 < mesh.indexCount; t += 3) {
+                    clipAndSetup(verts[mesh.indices[t]], verts[mesh.indices[t + 1]],
+                                 verts[mesh.indices[t + 2]], worker);
+                }
+            }
+        });
+
+        // 3. Растеризация тайлов
+        pool.parallelFor(tileCount, 1, [&](size_t begin, size_t end, size_t worker) {
+            for (size_t tile = begin; tile < end; tile++) {
+                rasterizeTile(tile, texture, lightPos, workerPixels[worker]);
+            }
+        });
+
+        stats.trianglesSubmitted += count * trianglesPerInstance;
+        for (size_t w = 0; w < workers; w++) {
+            stats.trianglesBinned += workerTriangles[w].size();
+        }
+    }
+
+    for (size_t pixels : workerPixels) stats.pixelsShaded += pixels;
+    stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SoftRasterizer::clipAndSetup(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c,
+                                  size_t worker) {
+    const ClipVertex* input[3] = {&a, &b, &c};
+    float distance[3];
+    int insideCount = 0;
+
+    for (int i = 0; i < 3; i++) {
+        distance[i] = input[i]->clip.z + input[i]->clip.w;
+        if (distance[i] >= 0.0f) insideCount++;
+    }
+
+    // Целиком за ближней плоскостью
+    if (insideCount == 0) return;
+
+    // Грубая отбраковка по боковым плоскостям: все вершины по одну сторону
+    for (int axis = 0; axis < 2; axis++) {
+        bool allLess = true, allGreater = true;
+        for (int i = 0; i < 3; i++) {
+            const glm::vec4& p = input[i]->clip;
+            allLess = allLess && p[axis] < -p.w;
+            allGreater = allGreater && p[axis] > p.w;
+        }
+        if (allLess || allGreater) return;
+    }
+
+    if (insideCount == 3) {
+        setupTriangle(a, b, c, worker);
+        return;
+    }
+
+    // Сазерленд-Ходжмен по плоскости z + w = 0: получается 3 или 4 вершины
+    auto lerp = [](const ClipVertex& p, const ClipVertex& q, float t) {
+        ClipVertex r;
+        r.clip = glm::mix(p.clip, q.clip, t);
+        r.world = glm::mix(p.world, q.world, t);
+        r.normal = glm::mix(p.normal, q.normal, t);
+        r.uv = glm::mix(p.uv, q.uv, t);
+        return r;
+    };
+
+    ClipVertex polygon[4];
+    int polygonSize = 0;
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        if (distance[i] >= 0.0f) polygon[polygonSize++] = *input[i];
+        if ((distance[i] >= 0.0f) != (distance[j] >= 0.0f)) {
+            float t = distance[i] / (distance[i] - distance[j]);
+            polygon[polygonSize++] = lerp(*input[i], *input[j], t);
+        }
+    }
+
+    for (int i = 1; i + 1 < polygonSize; i++) {
+        setupTriangle(polygon[0], polygon[i], polygon[i + 1], worker);
+    }
+}
+
+void SoftRasterizer::setupTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c,
+                                   size_t worker) {
+    const ClipVertex* verts[3] = {&a, &b, &c};
+    SetupTriangle tri;
+    glm::vec2 screen[3];
+
+    for (int i = 0; i < 3; i++) {
+        const glm::vec4& clip = verts[i]->clip;
+        float invW = 1.0f / clip.w;
+        screen[i] = glm::vec2((clip.x * invW * 0.5f + 0.5f) * width,
+                              (0.5f - clip.y * invW * 0.5f) * height);
+        tri.z[i] = clip.z * invW * 0.5f + 0.5f;
+        tri.invW[i] = invW;
+        tri.uvOverW[i] = verts[i]->uv * invW;
+        tri.normalOverW[i] = verts[i]->normal * invW;
+        tri.worldOverW[i] = verts[i]->world * invW;
+    }
+
+    // Положительная площадь - против часовой стрелки в NDC (GL_BACK отбрасывается)
+    float area = (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y) -
+                 (screen[2].y - screen[0].y) * (screen[1].x - screen[0].x);
+    if (!(area > 0.0f)) return;
+
+    float minX = std::min({screen[0].x, screen[1].x, screen[2].x});
+    float maxX = std::max({screen[0].x, screen[1].x, screen[2].x});
+    float minY = std::min({screen[0].y, screen[1].y, screen[2].y});
+    float maxY = std::max({screen[0].y, screen[1].y, screen[2].y});
+
+    tri.minX = std::max(0, static_cast<int>(std::floor(minX)));
+    tri.minY = std::max(0, static_cast<int>(std::floor(minY)));
+    tri.maxX = std::min(width - 1, static_cast<int>(std::ceil(maxX)));
+    tri.maxY = std::min(height - 1, static_cast<int>(std::ceil(maxY)));
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) return;
+
+    // Ребро i противолежит вершине i: E(p) = A*x + B*y + C, внутри E > 0
+    for (int i = 0; i < 3; i++) {
+        const glm::vec2& p = screen[(i + 1) % 3];
+        const glm::vec2& q = screen[(i + 2) % 3];
+        tri.edgeA[i] = q.y - p.y;
+        tri.edgeB[i] = p.x - q.x;
+        tri.edgeC[i] = p.y * q.x - p.x * q.y;
+        tri.topLeft[i] = tri.edgeA[i] > 0.0f || (tri.edgeA[i] == 0.0f && tri.edgeB[i] > 0.0f);
+    }
+    tri.invArea = 1.0f / area;
+
+    std::vector<SetupTriangle>& triangles = workerTriangles[worker];
+    uint32_t index = static_cast<uint32_t>(triangles.size());
+    triangles.push_back(tri);
+
+    std::vector<std::vector<uint32_t>>& bins = workerBins[worker];
+    for (int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ty++) {
+        for (int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; tx++) {
+            bins[static_cast<size_t>(ty) * tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftRasterizer::rasterizeTile(size_t tile, const SoftTexture& texture, glm::vec3 lightPos,
+                                   size_t& pixelsShaded) {
+    int x0 = static_cast<int>(tile % tilesX) * TILE_SIZE;
+    int y0 = static_cast<int>(tile / tilesX) * TILE_SIZE;
+    int x1 = std::min(width, x0 + TILE_SIZE) - 1;
+    int y1 = std::min(height, y0 + TILE_SIZE) - 1;
+
+    // Порядок потоков фиксирован, поэтому результат не зависит от планирования
+    for (size_t worker = 0; worker < workerBins.size(); worker++) {
+        const std::vector<SetupTriangle>& triangles = workerTriangles[worker];
+        for (uint32_t index : workerBins[worker][tile]) {
+            rasterizeTriangle(triangles[index], x0, y0, x1, y1, texture, lightPos, pixelsShaded);
+        }
+    }
+}
+
+void SoftRasterizer::rasterizeTriangle(const SetupTriangle& tri, int x0, int y0, int x1, int y1,
+                                       const SoftTexture& texture, glm::vec3 lightPos,
+                                       size_t& pixelsShaded) {
+    int startX = std::max(x0, tri.minX);
+    int endX = std::min(x1, tri.maxX);
+    int startY = std::max(y0, tri.minY);
+    int endY = std::min(y1, tri.maxY);
+
+#ifdef SOFT_RASTER_SSE
+    const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 edgeA[3], topLeftMask[3];
+    for (int e = 0; e < 3; e++) {
+        edgeA[e] = _mm_set1_ps(tri.edgeA[e]);
+        topLeftMask[e] = _mm_castsi128_ps(_mm_set1_epi32(tri.topLeft[e] ? -1 : 0));
+    }
+#endif
+
+    for (int y = startY; y <= endY; y++) {
+        const float py = y + 0.5f;
+        float rowTerm[3];
+        for (int e = 0; e < 3; e++) {
+            rowTerm[e] = tri.edgeB[e] * py + tri.edgeC[e];
+        }
+
+        for (int x = startX; x <= endX; x += 4) {
+            float w[3][4];
+            int mask;
+
+#ifdef SOFT_RASTER_SSE
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int e = 0; e < 3; e++) {
+                __m128 value = _mm_add_ps(_mm_mul_ps(edgeA[e], px), _mm_set1_ps(rowTerm[e]));
+                // Правило верхнего-левого ребра: на таких рёбрах E = 0 считается внутри
+                __m128 edgeInside = _mm_or_ps(_mm_cmpgt_ps(value, zero),
+                                              _mm_and_ps(_mm_cmpeq_ps(value, zero), topLeftMask[e]));
+                inside = _mm_and_ps(inside, edgeInside);
+                _mm_storeu_ps(w[e], value);
+            }
+            mask = _mm_movemask_ps(inside);
+#else
+            mask = 0;
+            for (int lane = 0; lane < 4; lane++) {
+                bool inside = true;
+                for (int e = 0; e < 3; e++) {
+                    w[e][lane] = tri.edgeA[e] * (x + lane + 0.5f) + rowTerm[e];
+                    inside = inside && (w[e][lane] > 0.0f || (w[e][lane] == 0.0f && tri.topLeft[e]));
+                }
+                if (inside) mask |= 1 << lane;
+            }
+#endif
+            // Хвост строки за пределами диапазона
+            if (endX - x < 3) mask &= (1 << (endX - x + 1)) - 1;
+            if (mask == 0) continue;
+
+            for (int lane = 0; lane < 4; lane++) {
+                if (!(mask & (1 << lane))) continue;
+
+                const float b0 = w[0][lane] * tri.invArea;
+                const float b1 = w[1][lane] * tri.invArea;
+                const float b2 = w[2][lane] * tri.invArea;
+
+                const size_t pixel = static_cast<size_t>(y) * width + x + lane;
+                const float z = b0 * tri.z[0] + b1 * tri.z[1] + b2 * tri.z[2];
+                if (!(z < depth[pixel])) continue;   // GL_LESS
+
+                // Перспективно-корректная интерполяция
+                const float invW = 1.0f / (b0 * tri.invW[0] + b1 * tri.invW[1] + b2 * tri.invW[2]);
+                glm::vec2 uv = (tri.uvOverW[0] * b0 + tri.uvOverW[1] * b1 + tri.uvOverW[2] * b2) * invW;
+
+                glm::vec4 texColor = texture.sample(uv);
+                if (texColor.w < 0.1f) continue;   // discard - глубина не пишется
+
+                glm::vec3 normal = (tri.normalOverW[0] * b0 + tri.normalOverW[1] * b1 +
+                                    tri.normalOverW[2] * b2) * invW;
+                glm::vec3 fragPos = (tri.worldOverW[0] * b0 + tri.worldOverW[1] * b1 +
+                                     tri.worldOverW[2] * b2) * invW;
+
+                depth[pixel] = z;
+                color[pixel] = packColor(shadePhong(glm::vec3(texColor), normal, fragPos, lightPos));
+                pixelsShaded++;
+            }
+        }
+    }
+}
+
+bool SoftRasterizer::writePPM(const std::string& filename) const {
+    FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        std::fprintf(stderr, "Не получилось создать файл: %s\n", filename.c_str());
+        return false;
+    }
+
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+    std::vector<unsigned char> row(static_cast<size_t>(width) * 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t pixel = color[static_cast<size_t>(y) * width + x];
+            row[x * 3] = pixel & 0xFF;
+            row[x * 3 + 1] = (pixel >> 8) & 0xFF;
+            row[x * 3 + 2] = (pixel >> 16) & 0xFF;
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
@@ -1,4 +1,5 @@
 #include "solar_system.h"
+#include "thread_pool.h"
 #include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -41,6 +42,12 @@ void CelestialBody::update(float deltaTime) {
 // ==============================
 // SolarSystem
 // ==============================
+namespace {
+
+const size_t UPDATE_GRAIN = 16384;
+
+} // namespace
+
 SolarSystem::SolarSystem() {
 }
 
@@ -52,15 +59,27 @@ void SolarSystem::update(float deltaTime) {
     for (auto& body : bodies) {
         body.update(deltaTime);
     }
+    time += deltaTime;
+}
+
+void SolarSystem::update(float deltaTime, ThreadPool& pool) {
+    CelestialBody* target = bodies.data();
+    pool.parallelFor(bodies.size(), UPDATE_GRAIN, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            target[i].update(deltaTime);
+        }
+    });
+    time += deltaTime;
 }
 
 std::vector<glm::mat4> SolarSystem::getModelMatrices() const {
-    std::vector<glm::mat4> matrices;
-    matrices.reserve(bodies.size());
+    std::vector<glm::mat4> matrices(bodies.size());
+    writeModelMatrices(matrices.data());
+    return matrices;
+}
 
-    for (const auto& body : bodies) {
-        matrices.push_back(body.getModelMatrix());
+void SolarSystem::writeModelMatrices(glm::mat4* out) const {
+    for (size_t i = 0; i < bodies.size(); i++) {
+        out[i] = bodies[i].getModelMatrix();
     }
-
-    return matrices;
-}
\ No newline at end of file
+}
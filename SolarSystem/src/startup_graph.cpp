@@ -0,0 +1,125 @@
+#include "startup_graph.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+
+namespace {
+
+const size_t NO_STAGE = static_cast<size_t>(-1);
+
+double secondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double>(to - from).count();
+}
+
+} // namespace
+
+StartupGraph::StageId StartupGraph::add(const char* name, StageThread thread,
+                                        std::initializer_list<StageId> dependencies,
+                                        std::function<void()> work) {
+    StageId id = stages.size();
+    Stage stage;
+    stage.work = std::move(work);
+    stage.remaining = dependencies.size();
+    stages.push_back(std::move(stage));
+
+    // Зависимости только на уже добавленные стадии - циклов быть не может
+    for (StageId dependency : dependencies) {
+        assert(dependency < id);
+        stages[dependency].dependents.push_back(id);
+    }
+
+    StageTiming timing;
+    timing.name = name;
+    timing.thread = thread;
+    timings.push_back(timing);
+    return id;
+}
+
+void StartupGraph::run(ThreadPool& pool) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t finished = 0;
+    size_t mainLeft = std::count_if(timings.begin(), timings.end(), [](const StageTiming& timing) {
+        return timing.thread == StageThread::MAIN;
+    });
+    const bool singleThread = pool.threadCount() == 1;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Готовая стадия для потока worker; порядок добавления - приоритет
+    auto pick = [&](size_t worker) -> StageId {
+        if (worker == 0) {
+            for (StageId id = 0; id < stages.size(); id++) {
+                if (!stages[id].started && stages[id].remaining == 0 && timings[id].thread == StageThread::MAIN) {
+                    return id;
+                }
+            }
+            if (!singleThread && mainLeft > 0) return NO_STAGE;
+        }
+        for (StageId id = 0; id < stages.size(); id++) {
+            if (!stages[id].started && stages[id].remaining == 0 && timings[id].thread == StageThread::ANY) {
+                return id;
+            }
+        }
+        return NO_STAGE;
+    };
+
+    pool.runOnAll([&](size_t worker) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            if (finished == stages.size()) return;
+
+            StageId id = pick(worker);
+            if (id == NO_STAGE) {
+                changed.wait(lock);
+                continue;
+            }
+            stages[id].started = true;
+            lock.unlock();
+
+            auto stageStart = std::chrono::steady_clock::now();
+            stages[id].work();
+            auto stageEnd = std::chrono::steady_clock::now();
+
+            lock.lock();
+            StageTiming& timing = timings[id];
+            timing.worker = worker;
+            timing.startSeconds = secondsBetween(start, stageStart);
+            timing.seconds = secondsBetween(stageStart, stageEnd);
+
+            finished++;
+            if (timing.thread == StageThread::MAIN) mainLeft--;
+            for (StageId dependent : stages[id].dependents) {
+                stages[dependent].remaining--;
+            }
+            changed.notify_all();
+        }
+    });
+
+    wallSeconds = secondsBetween(start, std::chrono::steady_clock::now());
+}
+
+void StartupGraph::printReport() const {
+    std::vector<const StageTiming*> order;
+    double total = 0.0;
+    for (const StageTiming& timing : timings) {
+        order.push_back(&timing);
+        total += timing.seconds;
+    }
+    std::sort(order.begin(), order.end(), [](const StageTiming* a, const StageTiming* b) {
+        return a->startSeconds < b->startSeconds;
+    });
+
+    std::printf("Запуск по стадиям (мс):\n");
+    std::printf("  стадия, поток (GL/CPU), номер потока, начало, длительность\n");
+    for (const StageTiming* timing : order) {
+        std::printf("  %-26s %-5s %6zu %9.1f %9.1f\n", timing->name.c_str(),
+                    timing->thread == StageThread::MAIN ? "GL" : "CPU", timing->worker,
+                    timing->startSeconds * 1000.0, timing->seconds * 1000.0);
+    }
+    std::printf("  сумма стадий %.1f мс, по часам %.1f мс (параллельность x%.2f)\n",
+                total * 1000.0, wallSeconds * 1000.0, wallSeconds > 0.0 ? total / wallSeconds : 1.0);
+}
@@ -0,0 +1,139 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace {
+
+// Пул, задачу которого выполняет этот поток, и номер потока в нём
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+// Отмечает поток на время задачи; вложенные задачи восстанавливают внешнюю
+class JobScope {
+public:
+    JobScope(const ThreadPool* pool, size_t worker) : savedPool(currentPool), savedWorker(currentWorker) {
+        currentPool = pool;
+        currentWorker = worker;
+    }
+    ~JobScope() {
+        currentPool = savedPool;
+        currentWorker = savedWorker;
+    }
+
+private:
+    const ThreadPool* savedPool;
+    size_t savedWorker;
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 1; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    uint64_t seenGeneration = 0;
+
+    for (;;) {
+        const FunctionRef<void(size_t)>* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+
+            seenGeneration = generation;
+            job = currentJob;
+        }
+
+        {
+            JobScope scope(this, index);
+            (*job)(index);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+bool ThreadPool::insideJob() const {
+    return currentPool == this;
+}
+
+void ThreadPool::runOnAll(FunctionRef<void(size_t worker)> job) {
+    if (workers.empty()) {
+        JobScope scope(this, 0);
+        job(0);
+        return;
+    }
+    // Остальные потоки заняты внешней задачей - выполняем только здесь
+    if (insideJob()) {
+        job(currentWorker);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentJob = &job;
+        pending = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    {
+        JobScope scope(this, 0);
+        job(0);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return pending == 0; });
+    currentJob = nullptr;
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain,
+                             FunctionRef<void(size_t, size_t, size_t)> body) {
+    if (count == 0) return;
+    grain = std::max<size_t>(1, grain);
+
+    // Мелкую работу не раздаём - синхронизация дороже
+    if (workers.empty() || count <= grain) {
+        body(0, count, insideJob() ? currentWorker : 0);
+        return;
+    }
+    if (insideJob()) {
+        body(0, count, currentWorker);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    runOnAll([&](size_t worker) {
+        for (;;) {
+            size_t begin = next.fetch_add(grain, std::memory_order_relaxed);
+            if (begin >= count) break;
+            body(begin, std::min(count, begin + grain), worker);
+        }
+    });
+}
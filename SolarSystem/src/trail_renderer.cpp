@@ -0,0 +1,219 @@
+#include "trail_renderer.h"
+#include "orbit_geometry.h"
+#include "thread_pool.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <iostream>
+
+namespace {
+
+const char* trailVertexShader = R"(
+#version 330 core
+uniform samplerBuffer history;
+uniform samplerBuffer colors;
+uniform mat4 view;
+uniform mat4 projection;
+uniform int bodyCount;
+uniform int historyLength;
+uniform int head;
+uniform int filled;
+
+out vec4 TrailColor;
+
+// RGB32F для texture buffer только с GL 4.0, поэтому R32F и три выборки
+vec3 fetchVec3(samplerBuffer source, int index) {
+    return vec3(texelFetch(source, index * 3).r,
+                texelFetch(source, index * 3 + 1).r,
+                texelFetch(source, index * 3 + 2).r);
+}
+
+void main() {
+    // Вершина 0 - последний отсчёт, дальше - всё более старые
+    int age = gl_VertexID;
+    int slot = (head - age + historyLength) % historyLength;
+    vec3 position = fetchVec3(history, slot * bodyCount + gl_InstanceID);
+
+    float fade = 1.0 - float(age) / float(max(filled - 1, 1));
+    TrailColor = vec4(fetchVec3(colors, gl_InstanceID), fade * 0.8);
+
+    gl_Position = projection * view * vec4(position, 1.0);
+}
+)";
+
+const char* trailFragmentShader = R"(
+#version 330 core
+in vec4 TrailColor;
+out vec4 FragColor;
+
+void main() {
+    FragColor = TrailColor;
+}
+)";
+
+const size_t PUSH_GRAIN = 16384;
+
+} // namespace
+
+TrailRenderer::~TrailRenderer() {
+    release();
+}
+
+bool TrailRenderer::init() {
+    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &trailVertexShader, NULL);
+    glCompileShader(vertex);
+
+    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment, 1, &trailFragmentShader, NULL);
+    glCompileShader(fragment);
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetProgramInfoLog(program, 1024, NULL, infoLog);
+        std::cerr << "Ошибка линковки шейдера следов:\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &historyBuffer);
+    glGenBuffers(1, &colorBuffer);
+    glGenTextures(1, &historyTexture);
+    glGenTextures(1, &colorTexture);
+    return true;
+}
+
+bool TrailRenderer::reset(size_t count, size_t length, size_t budgetBytes) {
+    bodyCount = historyLength = 0;
+    head = filled = 0;
+    if (program == 0 || count == 0 || length < 2) return false;
+
+    size_t bytes = count * length * sizeof(glm::vec3);
+    if (bytes > budgetBytes) {
+        std::cerr << "Следы отключены: " << count << " тел x " << length << " отсчётов = "
+                  << bytes / (1024 * 1024) << " МБ, больше бюджета "
+                  << budgetBytes / (1024 * 1024) << " МБ" << std::endl;
+        return false;
+    }
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if (bytes / sizeof(float) > static_cast<size_t>(maxTexels)) {
+        std::cerr << "Следы отключены: " << bytes / sizeof(float)
+                  << " чисел больше GL_MAX_TEXTURE_BUFFER_SIZE = " << maxTexels << std::endl;
+        return false;
+    }
+
+    // Содержимое не задаём: читаются только записанные слоты (filled)
+    glBindBuffer(GL_TEXTURE_BUFFER, historyBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, bytes, NULL, GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, historyTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, historyBuffer);
+
+    std::vector<glm::vec3> colors(count);
+    for (size_t i = 0; i < count; i++) {
+        colors[i] = orbitColor(i);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, colorBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, count * sizeof(glm::vec3), colors.data(), GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, colorTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, colorBuffer);
+
+    ResourceRegistry& registry = ResourceRegistry::shared();
+    registry.track(historyResource, "следы: история положений", RESOURCE_BUFFER, bytes);
+    registry.track(colorResource, "следы: цвета", RESOURCE_BUFFER, count * sizeof(glm::vec3));
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    staging.resize(count);
+    bodyCount = count;
+    historyLength = length;
+    head = length - 1;
+    return true;
+}
+
+void TrailRenderer::push(const std::vector<CelestialBody>& bodies) {
+    lastUploadBytes = 0;
+    if (!isActive() || bodies.size() != bodyCount) return;
+
+    const CelestialBody* source = bodies.data();
+    glm::vec3* target = staging.data();
+    ThreadPool::shared().parallelFor(bodyCount, PUSH_GRAIN, [source, target](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            target[i] = source[i].getOrbitPosition();
+        }
+    });
+
+    head = (head + 1) % historyLength;
+    if (filled < historyLength) filled++;
+
+    size_t bytes = bodyCount * sizeof(glm::vec3);
+    glBindBuffer(GL_TEXTURE_BUFFER, historyBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, head * bytes, bytes, staging.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    lastUploadBytes = bytes;
+    totalUploadBytes += bytes;
+    pushCount++;
+}
+
+void TrailRenderer::render(const glm::mat4& view, const glm::mat4& projection) {
+    if (!isActive() || filled < 2) return;
+
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(program, "bodyCount"), static_cast<GLint>(bodyCount));
+    glUniform1i(glGetUniformLocation(program, "historyLength"), static_cast<GLint>(historyLength));
+    glUniform1i(glGetUniformLocation(program, "head"), static_cast<GLint>(head));
+    glUniform1i(glGetUniformLocation(program, "filled"), static_cast<GLint>(filled));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, historyTexture);
+    glUniform1i(glGetUniformLocation(program, "history"), 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, colorTexture);
+    glUniform1i(glGetUniformLocation(program, "colors"), 1);
+
+    // Полупрозрачные линии поверх непрозрачной сцены, глубину не пишут
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, static_cast<GLsizei>(filled), static_cast<GLsizei>(bodyCount));
+    glBindVertexArray(0);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glUseProgram(0);
+}
+
+void TrailRenderer::release() {
+    if (program != 0) glDeleteProgram(program);
+    if (vao != 0) glDeleteVertexArrays(1, &vao);
+    if (historyBuffer != 0) glDeleteBuffers(1, &historyBuffer);
+    if (colorBuffer != 0) glDeleteBuffers(1, &colorBuffer);
+    if (historyTexture != 0) glDeleteTextures(1, &historyTexture);
+    if (colorTexture != 0) glDeleteTextures(1, &colorTexture);
+    ResourceRegistry::shared().untrack(historyResource);
+    ResourceRegistry::shared().untrack(colorResource);
+    program = vao = historyBuffer = colorBuffer = historyTexture = colorTexture = 0;
+    bodyCount = historyLength = 0;
+    head = filled = 0;
+}
@@ -0,0 +1,514 @@
+#include "allocation_tracker.h"
+#include "checkpoint.h"
+#include "compiled_asset.h"
+#include "frame_arena.h"
+#include "input_recorder.h"
+#include "obj_loader.h"
+#include "scene_generator.h"
+#include "scene_loader.h"
+#include "solar_system.h"
+#include "startup_graph.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// =====================================================
+// Регрессионные проверки без окна и GL-контекста
+// =====================================================
+//
+// Каждая проверка - функция, возвращающая false при ошибке; CHECK печатает
+// место и условие. solar_tests [имя] - только проверки с этим именем.
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "  %s:%d: не выполнено %s\n", __FILE__, __LINE__, #condition); \
+            return false;                                                             \
+        }                                                                             \
+    } while (0)
+
+namespace {
+
+std::filesystem::path testDir() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "solar_tests";
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+bool sameBodies(const SolarSystem& a, const SolarSystem& b) {
+    const std::vector<CelestialBody>& left = a.getBodies();
+    const std::vector<CelestialBody>& right = b.getBodies();
+    if (left.size() != right.size()) return false;
+    for (size_t i = 0; i < left.size(); i++) {
+        if (std::memcmp(&left[i].orbitCenter, &right[i].orbitCenter, sizeof(left[i].orbitCenter)) != 0 ||
+            left[i].orbitRadius != right[i].orbitRadius || left[i].scale != right[i].scale) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Галактика больше SYSTEM_GRAIN систем из стадии графа: parallelFor того же
+// пула внутри runOnAll не должен ждать занятых потоков
+bool galaxyInStartupStage() {
+    ThreadPool pool(4);
+    GalaxyParams params;
+    params.bodyCount = 100000;
+    params.seed = 7;
+
+    SolarSystem staged;
+    GalaxyStats stats;
+    StartupGraph graph;
+    StartupGraph::StageId first = graph.add("first", StageThread::ANY, {}, [] {});
+    graph.add("galaxy", StageThread::ANY, {first}, [&] { generateGalaxy(params, staged, pool, &stats); });
+    graph.add("main", StageThread::MAIN, {}, [] {});
+    graph.run(pool);
+    CHECK(stats.systems > 1024);
+    CHECK(staged.getBodyCount() == params.bodyCount);
+
+    // Вне графа - параллельно; результат тот же
+    SolarSystem direct;
+    generateGalaxy(params, direct, pool);
+    CHECK(sameBodies(staged, direct));
+    return true;
+}
+
+// Единственный usemtl ссылается не на первый материал библиотеки
+bool objSingleMaterialNotFirst() {
+    std::filesystem::path dir = testDir();
+    writeFile(dir / "single.mtl",
+              "newmtl Unused\nKd 1 0 0\n"
+              "newmtl Blue\nKd 0 0 1\n");
+    writeFile(dir / "single.obj",
+              "mtllib single.mtl\n"
+              "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\n"
+              "usemtl Blue\n"
+              "f 1 2 3\nf 2 4 3\n");
+
+    OBJModel model;
+    CHECK(model.parse((dir / "single.obj").string()));
+    CHECK(model.submeshes.size() == 1);
+    const OBJSubmesh& submesh = model.submeshes[0];
+    CHECK(submesh.material < model.materials.size());
+    CHECK(model.materials[submesh.material].name == "Blue");
+    CHECK(model.materials[submesh.material].diffuse.z == 1.0f);
+    CHECK(model.materials[submesh.material].diffuse.x == 0.0f);
+    CHECK(submesh.firstIndex == 0 && submesh.indexCount == 6);
+    return true;
+}
+
+// Модель с материалами MTL не сводится к одному белому материалу .smesh
+bool objUsesMaterials() {
+    std::filesystem::path dir = testDir();
+    writeFile(dir / "plain.obj",
+              "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+              "f 1 2 3\n");
+    writeFile(dir / "pair.mtl",
+              "newmtl Red\nKd 1 0 0\n"
+              "newmtl White\nKd 1 1 1\n");
+    writeFile(dir / "pair.obj",
+              "mtllib pair.mtl\n"
+              "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\n"
+              "usemtl White\nf 1 2 3\n"
+              "usemtl Red\nf 2 4 3\n");
+    writeFile(dir / "tinted.mtl", "newmtl Blue\nKd 0 0 1\n");
+    writeFile(dir / "tinted.obj",
+              "mtllib tinted.mtl\n"
+              "v 0 0 0\nv 1 0 0\nv 0 1 0\n"
+              "usemtl Blue\nf 1 2 3\n");
+
+    OBJModel plain, pair, tinted;
+    CHECK(plain.parse((dir / "plain.obj").string()));
+    CHECK(!plain.usesMaterials());
+    CHECK(pair.parse((dir / "pair.obj").string()));
+    CHECK(pair.usesMaterials());
+    CHECK(tinted.parse((dir / "tinted.obj").string()));
+    CHECK(tinted.usesMaterials());
+    return true;
+}
+
+// bodyCount из заголовка такой, что offset + bodyCount * 4 переполняется
+// и проходит наивную проверку границ колонки
+bool sceneColumnBoundsOverflow() {
+    SolarSystem source;
+    buildDefaultScene(source);
+    std::filesystem::path path = testDir() / "overflow.sscn";
+    CHECK(saveSceneBinary(path.string(), source));
+
+    const uint64_t craftedCount = (1ull << 62) + 1;
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offsetof(SceneFileHeader, bodyCount));
+        file.write(reinterpret_cast<const char*>(&craftedCount), sizeof(craftedCount));
+        CHECK(file.good());
+    }
+
+    SolarSystem loaded;
+    CHECK(!loadScene(path.string(), loaded));
+    CHECK(loaded.getBodyCount() == 0);
+    return true;
+}
+
+// Ошибка записи по интервалу - не «снимок записан», и таймер не сбрасывается
+bool checkpointIntervalWriteFailure() {
+    SolarSystem system;
+    buildDefaultScene(system);
+    std::filesystem::path dir = testDir() / "checkpoint_missing";
+    std::filesystem::remove_all(dir);
+
+    CheckpointManager checkpoints;
+    checkpoints.configure((dir / "interval.sckp").string(), 1.0);
+    CHECK(!checkpoints.update(system, 0.5f));
+    CHECK(!checkpoints.update(system, 0.6f));   // папки нет - запись не удалась
+
+    std::filesystem::create_directories(dir);
+    CHECK(checkpoints.update(system, 0.0f));    // интервал уже истёк
+    CHECK(!checkpoints.update(system, 0.0f));
+    return true;
+}
+
+// Число тел и значений колонки такие, что offset + count * 4 переполняется
+bool checkpointColumnBoundsOverflow() {
+    SolarSystem system;
+    buildDefaultScene(system);
+    std::filesystem::path path = testDir() / "overflow.sckp";
+    CHECK(saveCheckpoint(path.string(), system, 1));
+
+    const uint64_t craftedCount = 1ull << 62;
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offsetof(CheckpointHeader, bodyCount));
+        file.write(reinterpret_cast<const char*>(&craftedCount), sizeof(craftedCount));
+        // Во всех колонках, иначе снимок отвергнет несовпадение числа значений
+        CheckpointHeader header;
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        for (uint32_t i = 0; i < header.columnCount; i++) {
+            file.seekp(sizeof(CheckpointHeader) + i * sizeof(CheckpointColumnDesc) +
+                       offsetof(CheckpointColumnDesc, count));
+            file.write(reinterpret_cast<const char*>(&craftedCount), sizeof(craftedCount));
+        }
+        CHECK(file.good() && header.columnCount > 0);
+    }
+
+    CheckpointReader reader;
+    CHECK(!reader.open(path.string()));
+    return true;
+}
+
+// Квадрат из двух треугольников: LOD 0 - оба, LOD 1 - один
+CompiledMesh makeCompiledQuad() {
+    std::vector<OBJVertex> vertices(4);
+    const float corners[4][2] = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vertices[i].position = glm::vec3(corners[i][0], corners[i][1], 0.0f);
+        vertices[i].texCoord = glm::vec2(corners[i][0], corners[i][1]);
+        vertices[i].normal = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    CompiledMesh mesh = {};
+    mesh.header.quantization = computeQuantization(vertices);
+    for (const OBJVertex& vertex : vertices) {
+        mesh.vertices.push_back(quantizeVertex(vertex, mesh.header.quantization));
+    }
+    mesh.header.flags = COMPILED_MESH_SINGLE_MATERIAL;
+    mesh.indices = {0, 1, 2, 1, 3, 2, 0, 1, 2};
+    mesh.lods.push_back(CompiledMeshLod{0, 4, 0, 6, 0.0f, 1.0f});
+    mesh.lods.push_back(CompiledMeshLod{0, 3, 6, 3, 0.5f, 1.0f});
+    return mesh;
+}
+
+// Значение по смещению в уже записанном файле
+template <typename T>
+void patchFile(const std::filesystem::path& path, size_t offset, T value) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool compiledMeshRoundTrip() {
+    CompiledMesh source = makeCompiledQuad();
+    std::filesystem::path path = testDir() / "quad.smesh";
+    CHECK(writeCompiledMesh(path.string(), source));
+
+    CompiledMesh loaded;
+    CHECK(readCompiledMesh(path.string(), loaded));
+    CHECK(loaded.lods.size() == 2 && loaded.header.indexSize == 2);
+    CHECK(loaded.header.flags == COMPILED_MESH_SINGLE_MATERIAL);
+    CHECK(loaded.indices == source.indices);
+    CHECK(std::memcmp(loaded.vertices.data(), source.vertices.data(),
+                      source.vertices.size() * sizeof(QuantizedVertex)) == 0);
+
+    std::vector<OBJVertex> vertices;
+    std::vector<unsigned int> indices;
+    unpackCompiledLod(loaded, 1, vertices, indices);
+    CHECK(vertices.size() == 3 && indices.size() == 3);
+    return true;
+}
+
+// Повреждённые счётчики и индексы - false без исключений и чтения за границы
+bool compiledMeshCorruptHeader() {
+    std::filesystem::path path = testDir() / "corrupt.smesh";
+    CompiledMesh loaded;
+
+    CHECK(writeCompiledMesh(path.string(), makeCompiledQuad()));
+    patchFile(path, offsetof(CompiledMeshHeader, vertexCount), uint32_t(0xFFFFFFFF));
+    CHECK(!readCompiledMesh(path.string(), loaded));
+
+    CHECK(writeCompiledMesh(path.string(), makeCompiledQuad()));
+    patchFile(path, offsetof(CompiledMeshHeader, lodCount), uint32_t(0));
+    CHECK(!readCompiledMesh(path.string(), loaded));
+
+    // Индекс 3 в LOD 1 из трёх вершин
+    CompiledMesh outOfRange = makeCompiledQuad();
+    outOfRange.indices[8] = 3;
+    CHECK(writeCompiledMesh(path.string(), outOfRange));
+    CHECK(!readCompiledMesh(path.string(), loaded));
+    return true;
+}
+
+bool compiledTextureCorruptHeader() {
+    const unsigned char texels[4 * 4 * 4] = {};
+    std::vector<std::vector<unsigned char>> levels;
+    buildMipChain(texels, 4, 4, levels);
+
+    CompiledTexture texture = {};
+    texture.header.width = 4;
+    texture.header.height = 4;
+    uint32_t size = 4;
+    for (const std::vector<unsigned char>& level : levels) {
+        texture.mips.push_back(CompiledTextureMip{size, size, texture.texels.size(), level.size()});
+        texture.texels.insert(texture.texels.end(), level.begin(), level.end());
+        size = std::max(1u, size / 2);
+    }
+    std::filesystem::path path = testDir() / "corrupt.stex";
+    CompiledTexture loaded;
+    CHECK(writeCompiledTexture(path.string(), texture));
+    CHECK(readCompiledTexture(path.string(), loaded) && loaded.mips.size() == 3);
+
+    patchFile(path, offsetof(CompiledTextureHeader, mipCount), uint32_t(0));
+    CHECK(!readCompiledTexture(path.string(), loaded));
+
+    CHECK(writeCompiledTexture(path.string(), texture));
+    patchFile(path, offsetof(CompiledTextureHeader, mipCount), uint32_t(0xFFFFFFFF));
+    CHECK(!readCompiledTexture(path.string(), loaded));
+
+    // Уровень 1 не вдвое меньше базового
+    texture.mips[1].width = 1;
+    texture.mips[1].size = 1 * 2 * 4;
+    CHECK(writeCompiledTexture(path.string(), texture));
+    CHECK(!readCompiledTexture(path.string(), loaded));
+    return true;
+}
+
+// Тела без знакомых колонок - число тел ограничено размером файла
+bool sceneBodyCountWithoutColumns() {
+    std::filesystem::path path = testDir() / "no_columns.sscn";
+    SceneFileHeader header = {};
+    std::memcpy(header.magic, "SSCN", 4);
+    header.version = SCENE_BINARY_VERSION;
+    header.bodyCount = 1ull << 40;
+    header.columnCount = 0;
+    writeFile(path, std::string(reinterpret_cast<const char*>(&header), sizeof(header)));
+
+    size_t streamed = 0;
+    CHECK(!streamScene(path.string(), [&](const CelestialBody*, size_t count) { streamed += count; }));
+    CHECK(streamed == 0);
+    return true;
+}
+
+// Текст -> загрузка даёт те же float, что были сохранены
+bool sceneTextRoundTrip() {
+    SolarSystem source;
+    GalaxyParams params;
+    params.bodyCount = 500;
+    ThreadPool pool(1);
+    generateGalaxy(params, source, pool);
+    std::filesystem::path path = testDir() / "round_trip.scene";
+    CHECK(saveSceneText(path.string(), source));
+
+    SolarSystem loaded;
+    CHECK(loadScene(path.string(), loaded));
+    CHECK(loaded.getBodyCount() == source.getBodyCount());
+    for (size_t i = 0; i < source.getBodyCount(); i++) {
+        const CelestialBody& a = source.getBodies()[i];
+        const CelestialBody& b = loaded.getBodies()[i];
+        CHECK(a.orbitRadius == b.orbitRadius && a.orbitSpeed == b.orbitSpeed &&
+              a.rotationSpeed == b.rotationSpeed && a.scale == b.scale);
+        CHECK(std::memcmp(&a.orbitCenter, &b.orbitCenter, sizeof(a.orbitCenter)) == 0);
+    }
+    return true;
+}
+
+// Полный снимок без колонок с огромным числом тел отвергается до того,
+// как восстановление очистит сцену
+bool checkpointFullWithoutColumns() {
+    SolarSystem system;
+    buildDefaultScene(system);
+    const size_t bodies = system.getBodyCount();
+
+    std::filesystem::path path = testDir() / "no_columns.sckp";
+    CHECK(saveCheckpoint(path.string(), system, 1));
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        CheckpointHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        header.columnCount = 0;
+        header.bodyCount = 1ull << 60;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        CHECK(file.good());
+    }
+
+    CHECK(!restoreCheckpoint(path.string(), "", system));
+    CHECK(system.getBodyCount() == bodies);
+    return true;
+}
+
+// Запись ввода: заголовок, затем кадры по 6 байт (deltaTime, клавиши)
+std::string inputLog(uint64_t headerFrames, size_t frames) {
+    std::string data("SINP", 4);
+    const uint32_t version = INPUT_LOG_VERSION;
+    const uint64_t bodies = 7;
+    data.append(reinterpret_cast<const char*>(&version), 4);
+    data.append(reinterpret_cast<const char*>(&bodies), 8);
+    data.append(reinterpret_cast<const char*>(&headerFrames), 8);
+    for (size_t i = 0; i < frames; i++) {
+        const float deltaTime = 0.01f * (i + 1);
+        const uint16_t keys = static_cast<uint16_t>(i);
+        data.append(reinterpret_cast<const char*>(&deltaTime), 4);
+        data.append(reinterpret_cast<const char*>(&keys), 2);
+    }
+    return data;
+}
+
+// Число кадров в заголовке не используется для выделения памяти, и
+// запись без close() (упавшая сессия) воспроизводится целиком
+bool inputLogUntrustedFrameCount() {
+    std::filesystem::path path = testDir() / "input.sinp";
+    InputPlayer player;
+
+    writeFile(path, inputLog(0, 3));
+    CHECK(player.open(path.string()));
+    CHECK(player.getFrameCount() == 3);
+    InputFrame frame;
+    CHECK(player.next(frame) && frame.deltaTime == 0.01f && frame.keys == 0);
+
+    writeFile(path, inputLog(~0ull, 2));
+    CHECK(player.open(path.string()));
+    CHECK(player.getFrameCount() == 2);
+    return true;
+}
+
+// Установившийся кадр - обновление тел в пуле и матрицы в арене кадра -
+// не обращается к куче. Выделения фонового потока кадру не засчитываются,
+// выделения рабочих пула - засчитываются. Имеет смысл только в сборке с
+// SOLAR_ALLOC_TRACKING (solar_alloc_tests)
+bool steadyFrameAllocations() {
+    if (!allocationTrackingAvailable()) {
+        std::printf("  подсчёт выделений выключен, проверка - в solar_alloc_tests\n");
+        return true;
+    }
+
+    ThreadPool pool(4);
+    GalaxyParams params;
+    params.bodyCount = 50000;
+    params.seed = 3;
+    SolarSystem system;
+    generateGalaxy(params, system, pool);
+
+    // Фоновый поток всё время выделяет память, как запись потока симуляции
+    std::atomic<bool> stopping{false};
+    std::thread background([&] {
+        excludeThreadFromAllocationCounts();
+        while (!stopping.load()) {
+            std::vector<int> garbage(64);
+            garbage[0] = 1;
+        }
+    });
+
+    const size_t warmupFrames = 10;
+    FrameArena arena;
+    SteadyFrameChecker checker(warmupFrames);
+    for (size_t frame = 0; frame < warmupFrames + 50; frame++) {
+        checker.beginFrame();
+        arena.reset();
+        system.update(0.016f, pool);
+        glm::mat4* matrices = arena.allocateArray<glm::mat4>(system.getBodyCount());
+        system.writeModelMatrices(matrices);
+        checker.endFrame(false);
+    }
+    stopping = true;
+    background.join();
+    if (!checker.passed()) {
+        std::fprintf(stderr, "  кадров с выделениями: %zu (%llu выделений)\n", checker.getAllocatingFrames(),
+                     static_cast<unsigned long long>(checker.getSteadyAllocations()));
+    }
+    CHECK(checker.getSteadyFrames() == 50);
+    CHECK(checker.passed());
+
+    // Выделения в рабочих потоках пула видны в счётчиках кадра
+    std::vector<std::vector<int>> perJob(64);
+    AllocationCounters before = allocationCounters();
+    pool.parallelFor(perJob.size(), 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) perJob[i].resize(16);
+    });
+    CHECK((allocationCounters() - before).allocations >= perJob.size());
+    return true;
+}
+
+struct Test {
+    const char* name;
+    bool (*run)();
+};
+
+const Test TESTS[] = {
+    {"galaxyInStartupStage", galaxyInStartupStage},
+    {"objSingleMaterialNotFirst", objSingleMaterialNotFirst},
+    {"objUsesMaterials", objUsesMaterials},
+    {"sceneColumnBoundsOverflow", sceneColumnBoundsOverflow},
+    {"sceneBodyCountWithoutColumns", sceneBodyCountWithoutColumns},
+    {"sceneTextRoundTrip", sceneTextRoundTrip},
+    {"checkpointIntervalWriteFailure", checkpointIntervalWriteFailure},
+    {"checkpointColumnBoundsOverflow", checkpointColumnBoundsOverflow},
+    {"checkpointFullWithoutColumns", checkpointFullWithoutColumns},
+    {"inputLogUntrustedFrameCount", inputLogUntrustedFrameCount},
+    {"compiledMeshRoundTrip", compiledMeshRoundTrip},
+    {"compiledMeshCorruptHeader", compiledMeshCorruptHeader},
+    {"compiledTextureCorruptHeader", compiledTextureCorruptHeader},
+    {"steadyFrameAllocations", steadyFrameAllocations},
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int failed = 0;
+    int ran = 0;
+    for (const Test& test : TESTS) {
+        if (filter && std::strcmp(filter, test.name) != 0) continue;
+        bool passed = test.run();
+        std::printf("%s %s\n", passed ? "[ OK ]" : "[FAIL]", test.name);
+        failed += passed ? 0 : 1;
+        ran++;
+    }
+    if (ran == 0) {
+        std::fprintf(stderr, "Нет проверки %s\n", filter ? filter : "");
+        return 1;
+    }
+    std::printf("Проверок: %d, ошибок: %d\n", ran, failed);
+    return failed == 0 ? 0 : 1;
+}
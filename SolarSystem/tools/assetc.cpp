@@ -0,0 +1,360 @@
+// Офлайн-компилятор ассетов: OBJ -> .smesh, PNG -> .stex
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "compiled_asset.h"
+#include "mesh_optimizer.h"
+#include "obj_loader.h"
+#include "occlusion_culler.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Меняется при любой правке обработки - все выходы пересобираются
+const uint32_t ASSETC_REVISION = 2;
+
+// LOD не упрощается дальше этого числа треугольников
+const size_t MIN_LOD_TRIANGLES = 32;
+const unsigned MAX_CLUSTER_GRID = 256;
+
+struct AssetcOptions {
+    std::string inputDir;
+    std::string outputDir;
+    size_t threads = 0;
+    unsigned maxLods = 4;
+    bool force = false;
+};
+
+enum class AssetKind {
+    MESH,
+    TEXTURE,
+};
+
+enum class JobStatus {
+    BUILT,
+    SKIPPED,
+    SOURCE_ONLY,                    // .smesh не пишется, приложение читает OBJ
+    FAILED,
+};
+
+struct AssetJob {
+    fs::path input;
+    fs::path output;
+    AssetKind kind;
+
+    JobStatus status = JobStatus::FAILED;
+    size_t inputBytes = 0;
+    size_t outputBytes = 0;
+    double seconds = 0.0;
+    std::string details;
+};
+
+std::string lowerExtension(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+uint64_t settingsHash(const AssetcOptions& options) {
+    uint32_t settings[3] = {ASSETC_REVISION, options.maxLods, static_cast<uint32_t>(VERTEX_CACHE_SIZE)};
+    return hashAssetBytes(settings, sizeof(settings));
+}
+
+// Неизменившийся вход с теми же настройками пересобирать не нужно
+bool upToDate(const AssetJob& job, uint64_t sourceHash, uint64_t settings) {
+    uint64_t storedSource = 0, storedSettings = 0;
+    return readCompiledHashes(job.output.string(), storedSource, storedSettings) &&
+           storedSource == sourceHash && storedSettings == settings;
+}
+
+// Один LOD: квантование, слияние вершин, порядок под кэш и выборку
+void appendLod(CompiledMesh& mesh, const std::vector<OBJVertex>& vertices,
+               const std::vector<unsigned int>& sourceIndices, float cellSize) {
+    std::vector<QuantizedVertex> quantized(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        quantized[i] = quantizeVertex(vertices[i], mesh.header.quantization);
+    }
+    std::vector<unsigned int> indices = sourceIndices;
+    deduplicateVertices(quantized, indices);
+    optimizeVertexCache(indices, quantized.size());
+    optimizeVertexFetch(quantized, indices);
+
+    CompiledMeshLod lod;
+    lod.vertexOffset = static_cast<uint32_t>(mesh.vertices.size());
+    lod.vertexCount = static_cast<uint32_t>(quantized.size());
+    lod.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+    lod.indexCount = static_cast<uint32_t>(indices.size());
+    lod.cellSize = cellSize;
+    lod.cacheMissRatio = averageCacheMissRatio(indices, quantized.size());
+
+    mesh.vertices.insert(mesh.vertices.end(), quantized.begin(), quantized.end());
+    mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+    mesh.lods.push_back(lod);
+}
+
+bool compileMesh(AssetJob& job, const std::vector<char>& source, const AssetcOptions& options) {
+    // Слияние вершин - после квантования, здесь оно было бы квадратичным
+    OBJModel model;
+    if (!model.parse(job.input.string(), false)) {
+        job.details = "не получилось разобрать OBJ";
+        return false;
+    }
+    // Материалы в .smesh не хранятся - такую модель приложение берёт из OBJ,
+    // а оставшийся от прошлых сборок .smesh удаляется
+    if (model.usesMaterials()) {
+        std::error_code error;
+        fs::remove(job.output, error);
+        job.status = JobStatus::SOURCE_ONLY;
+        job.details = std::to_string(model.submeshes.size()) + " отрезков материалов MTL - остаётся OBJ";
+        return true;
+    }
+
+    CompiledMesh mesh;
+    mesh.header = CompiledMeshHeader();
+    mesh.header.sourceHash = hashAssetBytes(source.data(), source.size());
+    mesh.header.settingsHash = settingsHash(options);
+    mesh.header.flags = COMPILED_MESH_SINGLE_MATERIAL;
+    mesh.header.quantization = computeQuantization(model.vertices);
+    mesh.header.boundingRadius = meshBoundingRadius(SoftMesh{model.vertices.data(), model.vertices.size(),
+                                                             model.indices.data(), model.indices.size()});
+
+    float acmrBefore = averageCacheMissRatio(model.indices, model.vertices.size());
+    appendLod(mesh, model.vertices, model.indices, 0.0f);
+
+    // Каждый следующий LOD - не больше половины треугольников предыдущего;
+    // сетка кластеров мельчает, пока не уложится
+    std::vector<OBJVertex> lodVertices;
+    std::vector<unsigned int> lodIndices;
+    unsigned grid = MAX_CLUSTER_GRID;
+    size_t previousTriangles = model.indices.size() / 3;
+    while (mesh.lods.size() < options.maxLods && previousTriangles / 2 >= MIN_LOD_TRIANGLES && grid >= 2) {
+        float cellSize = simplifyByClustering(model.vertices, model.indices, grid, lodVertices, lodIndices);
+        grid /= 2;
+        if (lodIndices.size() / 3 > previousTriangles / 2) continue;
+        if (lodIndices.size() / 3 < MIN_LOD_TRIANGLES) break;
+
+        appendLod(mesh, lodVertices, lodIndices, cellSize);
+        previousTriangles = lodIndices.size() / 3;
+    }
+
+    if (!writeCompiledMesh(job.output.string(), mesh)) {
+        job.details = "ошибка записи";
+        return false;
+    }
+
+    char details[256];
+    int length = std::snprintf(details, sizeof(details), "%zu -> %u вершин, ACMR %.2f -> %.2f, LOD:",
+                               model.vertices.size(), mesh.lods[0].vertexCount, acmrBefore,
+                               mesh.lods[0].cacheMissRatio);
+    job.details.assign(details, length);
+    for (const CompiledMeshLod& lod : mesh.lods) {
+        job.details += ' ' + std::to_string(lod.indexCount / 3);
+    }
+    job.details += " тр.";
+    return true;
+}
+
+bool compileTexture(AssetJob& job, const std::vector<char>& source, const AssetcOptions& options) {
+    sf::Image image;
+    if (!image.loadFromMemory(source.data(), source.size())) {
+        job.details = "не получилось декодировать";
+        return false;
+    }
+    // Та же ориентация, что у uploadTexture в приложении
+    image.flipVertically();
+
+    std::vector<std::vector<unsigned char>> levels;
+    buildMipChain(image.getPixelsPtr(), image.getSize().x, image.getSize().y, levels);
+
+    CompiledTexture texture;
+    texture.header = CompiledTextureHeader();
+    texture.header.sourceHash = hashAssetBytes(source.data(), source.size());
+    texture.header.settingsHash = settingsHash(options);
+    texture.header.width = image.getSize().x;
+    texture.header.height = image.getSize().y;
+
+    uint32_t width = texture.header.width;
+    uint32_t height = texture.header.height;
+    for (const std::vector<unsigned char>& level : levels) {
+        CompiledTextureMip mip;
+        mip.width = width;
+        mip.height = height;
+        mip.offset = texture.texels.size();
+        mip.size = level.size();
+        texture.mips.push_back(mip);
+        texture.texels.insert(texture.texels.end(), level.begin(), level.end());
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+
+    if (!writeCompiledTexture(job.output.string(), texture)) {
+        job.details = "ошибка записи";
+        return false;
+    }
+    job.details = std::to_string(texture.header.width) + "x" + std::to_string(texture.header.height) +
+                  ", " + std::to_string(texture.mips.size()) + " уровней mip";
+    return true;
+}
+
+void runJob(AssetJob& job, const AssetcOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<char> source;
+    if (!readWholeFile(job.input.string(), source)) {
+        job.status = JobStatus::FAILED;
+        job.details = "не получилось прочитать";
+        return;
+    }
+    job.inputBytes = source.size();
+
+    uint64_t sourceHash = hashAssetBytes(source.data(), source.size());
+    if (!options.force && upToDate(job, sourceHash, settingsHash(options))) {
+        job.status = JobStatus::SKIPPED;
+    } else {
+        bool built = job.kind == AssetKind::MESH ? compileMesh(job, source, options)
+                                                  : compileTexture(job, source, options);
+        if (!built) {
+            job.status = JobStatus::FAILED;
+        } else if (job.status != JobStatus::SOURCE_ONLY) {
+            job.status = JobStatus::BUILT;
+        }
+    }
+
+    std::error_code error;
+    bool hasOutput = job.status != JobStatus::FAILED && job.status != JobStatus::SOURCE_ONLY;
+    job.outputBytes = hasOutput ? fs::file_size(job.output, error) : 0;
+    job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<AssetJob> collectJobs(const AssetcOptions& options) {
+    std::vector<AssetJob> jobs;
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(options.inputDir, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file()) continue;
+
+        std::string extension = lowerExtension(it->path());
+        AssetJob job;
+        if (extension == ".obj") {
+            job.kind = AssetKind::MESH;
+        } else if (extension == ".png") {
+            job.kind = AssetKind::TEXTURE;
+        } else {
+            continue;
+        }
+        job.input = it->path();
+        job.output = fs::path(options.outputDir) / fs::relative(it->path(), options.inputDir);
+        job.output.replace_extension(job.kind == AssetKind::MESH ? ".smesh" : ".stex");
+        jobs.push_back(job);
+    }
+    if (error) {
+        std::cerr << "Не получилось обойти " << options.inputDir << ": " << error.message() << std::endl;
+    }
+
+    // Порядок обхода каталога не определён - сортируем для стабильного отчёта
+    std::sort(jobs.begin(), jobs.end(), [](const AssetJob& a, const AssetJob& b) { return a.input < b.input; });
+    return jobs;
+}
+
+double megabytesPerSecond(size_t bytes, double seconds) {
+    return seconds > 0.0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0;
+}
+
+bool parseOptions(int argc, char** argv, AssetcOptions& options) {
+    std::vector<const char*> positional;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--threads") == 0 && hasValue) options.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--lods") == 0 && hasValue) options.maxLods = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "--force") == 0) options.force = true;
+        else if (arg[0] != '-') positional.push_back(arg);
+        else return false;
+    }
+    if (positional.size() != 2) return false;
+
+    options.inputDir = positional[0];
+    options.outputDir = positional[1];
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " <папка входа> <папка выхода> [параметры]" << std::endl;
+    std::cout << "  OBJ -> .smesh (квантование, кэш вершин, LOD), PNG -> .stex (mip)" << std::endl;
+    std::cout << "  --threads <n>      число потоков (0 - все)" << std::endl;
+    std::cout << "  --lods <n>         наибольшее число LOD, включая исходный (4)" << std::endl;
+    std::cout << "  --force            пересобрать всё, даже неизменившиеся файлы" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    AssetcOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<AssetJob> jobs = collectJobs(options);
+    if (jobs.empty()) {
+        std::cerr << "В " << options.inputDir << " нет OBJ и PNG" << std::endl;
+        return 1;
+    }
+
+    // Папки создаются заранее, чтобы потоки не создавали их наперегонки
+    for (const AssetJob& job : jobs) {
+        std::error_code error;
+        fs::create_directories(job.output.parent_path(), error);
+    }
+
+    ThreadPool pool(options.threads);
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(jobs.size(), 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; i++) {
+            runJob(jobs[i], options);
+        }
+    });
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t built = 0, skipped = 0, failed = 0;
+    size_t builtInput = 0, totalInput = 0, totalOutput = 0;
+    for (const AssetJob& job : jobs) {
+        const char* status = job.status == JobStatus::BUILT ? "собран"
+                           : job.status == JobStatus::SKIPPED ? "не изменился"
+                           : job.status == JobStatus::SOURCE_ONLY ? "только OBJ" : "ОШИБКА";
+        std::printf("  %-40s %-13s %9.1f КБ -> %9.1f КБ %8.1f мс %8.1f МБ/с  %s\n",
+                    job.input.string().c_str(), status, job.inputBytes / 1024.0, job.outputBytes / 1024.0,
+                    job.seconds * 1000.0, megabytesPerSecond(job.inputBytes, job.seconds), job.details.c_str());
+
+        totalInput += job.inputBytes;
+        totalOutput += job.outputBytes;
+        if (job.status == JobStatus::BUILT) {
+            built++;
+            builtInput += job.inputBytes;
+        } else if (job.status == JobStatus::SKIPPED || job.status == JobStatus::SOURCE_ONLY) {
+            skipped++;
+        } else {
+            failed++;
+        }
+    }
+
+    std::printf("Файлов %zu: собрано %zu, не изменилось %zu, ошибок %zu; %zu потоков\n",
+                jobs.size(), built, skipped, failed, pool.threadCount());
+    std::printf("Вход %.2f МБ, выход %.2f МБ за %.2f с: %.1f МБ/с собранного входа, %.1f файлов/с\n",
+                totalInput / (1024.0 * 1024.0), totalOutput / (1024.0 * 1024.0), wallSeconds,
+                megabytesPerSecond(builtInput, wallSeconds), wallSeconds > 0.0 ? jobs.size() / wallSeconds : 0.0);
+
+    return failed == 0 ? 0 : 1;
+}
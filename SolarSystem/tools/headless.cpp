@@ -0,0 +1,185 @@
+// Симуляция без окна и GPU: шаги с максимальной скоростью, состояния тел - в сжатый файл
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "scene_generator.h"
+#include "scene_loader.h"
+#include "sim_stream.h"
+#include "solar_system.h"
+#include "thread_pool.h"
+
+namespace {
+
+struct HeadlessOptions {
+    std::string scenePath = "scenes/default.scene";
+    size_t galaxyBodies = 0;            // > 0 - процедурная галактика вместо сцены
+    uint64_t seed = 1;
+    std::string output = "simulation.ssim";
+    long long steps = 10000;
+    int stride = 10;                    // 0 - без записи, только шаги
+    float deltaTime = 1.0f / 6.0f;      // как deltaTime * 10 при 60 FPS
+    size_t threads = 0;
+    int level = 1;
+    bool positions = true;
+    bool matrices = true;
+    bool verify = false;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double megabytes(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+bool parseOptions(int argc, char** argv, HeadlessOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--scene") == 0 && hasValue) options.scenePath = argv[++i];
+        else if (std::strcmp(arg, "--galaxy") == 0 && hasValue) options.galaxyBodies = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue) options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(arg, "--out") == 0 && hasValue) options.output = argv[++i];
+        else if (std::strcmp(arg, "--steps") == 0 && hasValue) options.steps = std::max(1LL, std::atoll(argv[++i]));
+        else if (std::strcmp(arg, "--stride") == 0 && hasValue) options.stride = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "--dt") == 0 && hasValue) options.deltaTime = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) options.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--level") == 0 && hasValue) options.level = std::min(9, std::max(0, std::atoi(argv[++i])));
+        else if (std::strcmp(arg, "--no-positions") == 0) options.positions = false;
+        else if (std::strcmp(arg, "--no-matrices") == 0) options.matrices = false;
+        else if (std::strcmp(arg, "--verify") == 0) options.verify = true;
+        else return false;
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " [параметры]" << std::endl;
+    std::cout << "  --scene <файл>     сцена (по умолчанию scenes/default.scene)" << std::endl;
+    std::cout << "  --galaxy <n>       процедурная галактика из n тел вместо сцены" << std::endl;
+    std::cout << "  --seed <n>         seed галактики (1)" << std::endl;
+    std::cout << "  --out <файл>       поток состояний .ssim (simulation.ssim)" << std::endl;
+    std::cout << "  --steps <n>        шагов симуляции (10000)" << std::endl;
+    std::cout << "  --stride <k>       записывать каждый k-й шаг (10; 0 - не писать)" << std::endl;
+    std::cout << "  --dt <t>           шаг симуляции" << std::endl;
+    std::cout << "  --threads <n>      число потоков (0 - все)" << std::endl;
+    std::cout << "  --level <0-9>      уровень сжатия zlib (1)" << std::endl;
+    std::cout << "  --no-positions     не писать положения тел" << std::endl;
+    std::cout << "  --no-matrices      не писать матрицы модели" << std::endl;
+    std::cout << "  --verify           прочитать записанный файл и сверить число кадров" << std::endl;
+}
+
+bool verifyStream(const std::string& filename, size_t expectedFrames) {
+    SimStreamReader reader;
+    if (!reader.open(filename)) return false;
+
+    SimFrameHeader frame;
+    std::vector<unsigned char> data;
+    size_t frames = 0;
+    while (reader.readFrame(frame, data)) {
+        frames++;
+    }
+    std::printf("Проверка: %zu кадров из %zu, %llu тел\n", frames, expectedFrames,
+                static_cast<unsigned long long>(reader.getHeader().bodyCount));
+    return frames == expectedFrames;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    HeadlessOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ThreadPool pool(options.threads);
+    SolarSystem system;
+    if (options.galaxyBodies > 0) {
+        GalaxyParams params;
+        params.bodyCount = options.galaxyBodies;
+        params.seed = options.seed;
+        GalaxyStats stats;
+        generateGalaxy(params, system, pool, &stats);
+        std::printf("Галактика: %zu систем в %zu скоплениях, радиус %.0f, построена за %.1f мс (%.1f Mтел/с)\n",
+                    stats.systems, stats.clusters, stats.radius, stats.seconds * 1000.0,
+                    stats.bodiesPerSecond() / 1e6);
+    } else if (!loadScene(options.scenePath, system) || system.getBodyCount() == 0) {
+        std::cerr << "Использую встроенную сцену" << std::endl;
+        buildDefaultScene(system);
+    }
+
+    uint32_t flags = 0;
+    if (options.positions) flags |= SIM_STREAM_POSITIONS;
+    if (options.matrices) flags |= SIM_STREAM_MATRICES;
+    bool recording = options.stride > 0 && flags != 0;
+
+    SimStreamWriter writer;
+    if (recording && !writer.open(options.output, system.getBodyCount(), static_cast<uint32_t>(options.stride),
+                                  flags, options.deltaTime, options.level)) {
+        return 1;
+    }
+
+    std::cout << "Сцена: " << system.getBodyCount() << " тел, " << options.steps << " шагов, потоков "
+              << pool.threadCount();
+    if (recording) {
+        std::cout << ", кадр каждые " << options.stride << " шагов, " << megabytes(writer.getFrameSize())
+                  << " МБ на кадр -> " << options.output;
+    }
+    std::cout << std::endl;
+
+    // Кадр 0 - начальное состояние, затем каждый stride-й шаг
+    double simulationSeconds = 0.0;
+    double captureSeconds = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long step = 0; step <= options.steps; step++) {
+        if (step > 0) {
+            auto tickStart = std::chrono::steady_clock::now();
+            system.update(options.deltaTime, pool);
+            simulationSeconds += secondsSince(tickStart);
+        }
+        if (recording && step % options.stride == 0) {
+            auto captureStart = std::chrono::steady_clock::now();
+            captureSimFrame(system, flags, writer.acquireFrame(), pool);
+            writer.submitFrame(static_cast<uint64_t>(step), system.getTime());
+            captureSeconds += secondsSince(captureStart);
+        }
+    }
+    double loopSeconds = secondsSince(start);
+
+    bool written = writer.close();
+    double totalSeconds = secondsSince(start);
+
+    std::printf("Шаги: %.0f шаг/с (только update: %.0f шаг/с, %.3f мкс на тело за шаг)\n",
+                options.steps / loopSeconds, options.steps / simulationSeconds,
+                simulationSeconds * 1e6 / (double(options.steps) * system.getBodyCount()));
+    if (recording) {
+        const SimStreamStats& stats = writer.getStats();
+        double writerSeconds = stats.compressSeconds + stats.writeSeconds;
+        std::printf("Запись: %zu кадров, %.1f МБ -> %.1f МБ (сжатие %.2fx)\n", stats.frames,
+                    megabytes(stats.rawBytes), megabytes(stats.compressedBytes), stats.compressionRatio());
+        std::printf("        %.1f МБ/с данных за всё время, поток записи %.1f МБ/с "
+                    "(сжатие %.2f с, диск %.2f с)\n",
+                    megabytes(stats.rawBytes) / totalSeconds,
+                    writerSeconds > 0.0 ? megabytes(stats.rawBytes) / writerSeconds : 0.0,
+                    stats.compressSeconds, stats.writeSeconds);
+        std::printf("        снимки %.2f с, ожидание буфера %.2f с, дозапись после шагов %.2f с\n",
+                    captureSeconds, stats.stallSeconds, totalSeconds - loopSeconds);
+    }
+
+    if (!written) {
+        std::cerr << "Поток состояний записан не полностью: " << options.output << std::endl;
+        return 1;
+    }
+    if (recording && options.verify) {
+        size_t expectedFrames = static_cast<size_t>(options.steps / options.stride + 1);
+        if (!verifyStream(options.output, expectedFrames)) return 1;
+    }
+    return 0;
+}
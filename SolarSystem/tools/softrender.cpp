@@ -0,0 +1,245 @@
+// Программный рендер сцены без GPU: кадры в PPM/PNG и замер производительности
+#include <SFML/Graphics.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "camera.h"
+#include "obj_loader.h"
+#include "orbit_geometry.h"
+#include "scene_loader.h"
+#include "soft_rasterizer.h"
+#include "solar_system.h"
+#include "thread_pool.h"
+
+namespace {
+
+struct SoftRenderOptions {
+    std::string scenePath = "scenes/default.scene";
+    std::string modelPath = "models/fish.obj";
+    std::string texturePath = "textures/fish.png";
+    std::string output = "frame.ppm";
+    int width = 1200;
+    int height = 800;
+    int frames = 1;
+    float deltaTime = 1.0f / 6.0f;      // как deltaTime * 10 при 60 FPS
+    size_t threads = 0;
+    bool sweep = false;
+    bool orbits = true;
+    float orbitTolerance = 0.5f;        // пикс., как --orbit-tolerance у приложения
+};
+
+SoftTexture loadTexture(const std::string& filename) {
+    sf::Image image;
+    if (!image.loadFromFile(filename)) {
+        std::cout << "Использую fallback текстуру для: " << filename << std::endl;
+        return SoftTexture::solid(glm::vec3(0.8f));
+    }
+
+    // Та же ориентация, что у loadSimpleTexture
+    image.flipVertically();
+
+    SoftTexture texture;
+    texture.width = static_cast<int>(image.getSize().x);
+    texture.height = static_cast<int>(image.getSize().y);
+    texture.texels.resize(static_cast<size_t>(texture.width) * texture.height);
+    std::memcpy(texture.texels.data(), image.getPixelsPtr(), texture.texels.size() * 4);
+    return texture;
+}
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool saveFrame(const SoftRasterizer& rasterizer, const std::string& filename) {
+    if (!endsWith(filename, ".png")) {
+        return rasterizer.writePPM(filename);
+    }
+
+    sf::Image image;
+    image.create(rasterizer.getWidth(), rasterizer.getHeight(),
+                 reinterpret_cast<const sf::Uint8*>(rasterizer.getColorBuffer()));
+    return image.saveToFile(filename);
+}
+
+// frame_%04d.ppm -> frame_0003.ppm
+std::string frameFileName(const std::string& pattern, int frame) {
+    if (pattern.find('%') == std::string::npos) return pattern;
+
+    char buffer[512];
+    std::snprintf(buffer, sizeof(buffer), pattern.c_str(), frame);
+    return buffer;
+}
+
+// Единичные окружности орбит, общие для всех кадров
+struct OrbitGeometry {
+    std::vector<float> levelVertices;
+    std::vector<OrbitLevel> levels;
+    std::vector<float> scratch;         // окружность текущей орбиты в мировых координатах
+    float tolerancePixels = 0.5f;
+};
+
+// Кадр так же, как render(): сначала орбиты без глубины, затем инстансы
+void renderFrame(SoftRasterizer& rasterizer, const SolarSystem& system, const Camera& camera,
+                 const SoftMesh& mesh, const SoftTexture& texture, OrbitGeometry* orbits) {
+    rasterizer.clear(glm::vec3(66.0f / 255.0f, 133.0f / 255.0f, 180.0f / 255.0f));
+    glm::mat4 projection = camera.getProjectionMatrix(rasterizer.getWidth() / float(rasterizer.getHeight()));
+    rasterizer.setCamera(camera.getViewMatrix(), projection);
+
+    const auto& bodies = system.getBodies();
+    if (orbits) {
+        const float focalPixels = projection[1][1] * rasterizer.getHeight() * 0.5f;
+        for (size_t i = 1; i < bodies.size(); i++) {
+            const CelestialBody& body = bodies[i];
+            if (body.orbitRadius <= 0.0f) continue;
+
+            float radiusPixels = orbitRadiusPixels(body.orbitCenter, body.orbitRadius, camera.position, focalPixels);
+            const OrbitLevel& level =
+                orbits->levels[orbitLevelForSegments(orbitSegmentsForError(radiusPixels, orbits->tolerancePixels))];
+            const float* unit = orbits->levelVertices.data() + level.first * 3;
+            orbits->scratch.resize(level.count * 3);
+            for (int v = 0; v < level.count; v++) {
+                for (int k = 0; k < 3; k++) {
+                    orbits->scratch[v * 3 + k] = body.orbitCenter[k] + unit[v * 3 + k] * body.orbitRadius;
+                }
+            }
+            rasterizer.drawLineStrip(orbits->scratch.data(), level.count, orbitColor(i));
+        }
+    }
+
+    std::vector<glm::mat4> matrices = system.getModelMatrices();
+    rasterizer.drawMeshInstanced(mesh, matrices.data(), matrices.size(), texture, glm::vec3(0.0f));
+}
+
+void printStats(const char* label, const SoftRasterStats& stats, size_t threads, int frames) {
+    std::printf("%-10s потоков %2zu: %7.2f мс/кадр, %10.3e тр/с (%9.3e на поток), "
+                "%10.3e пикс/с (%9.3e на поток)\n",
+                label, threads, stats.seconds * 1000.0 / frames,
+                stats.trianglesPerSecond(), stats.trianglesPerSecond() / threads,
+                stats.pixelsPerSecond(), stats.pixelsPerSecond() / threads);
+}
+
+bool parseOptions(int argc, char** argv, SoftRenderOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "--scene") == 0 && hasValue) options.scenePath = argv[++i];
+        else if (std::strcmp(arg, "--model") == 0 && hasValue) options.modelPath = argv[++i];
+        else if (std::strcmp(arg, "--texture") == 0 && hasValue) options.texturePath = argv[++i];
+        else if (std::strcmp(arg, "--out") == 0 && hasValue) options.output = argv[++i];
+        else if (std::strcmp(arg, "--width") == 0 && hasValue) options.width = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--height") == 0 && hasValue) options.height = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--frames") == 0 && hasValue) options.frames = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "--dt") == 0 && hasValue) options.deltaTime = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) options.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "--sweep") == 0) options.sweep = true;
+        else if (std::strcmp(arg, "--no-orbits") == 0) options.orbits = false;
+        else if (std::strcmp(arg, "--orbit-tolerance") == 0 && hasValue) options.orbitTolerance = std::atof(argv[++i]);
+        else return false;
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Использование: " << program << " [параметры]" << std::endl;
+    std::cout << "  --scene <файл>     сцена (по умолчанию scenes/default.scene)" << std::endl;
+    std::cout << "  --model <файл>     модель тел (models/fish.obj)" << std::endl;
+    std::cout << "  --texture <файл>   текстура (textures/fish.png)" << std::endl;
+    std::cout << "  --out <файл>       кадр .ppm или .png; %d - номер кадра" << std::endl;
+    std::cout << "  --width/--height   размер кадра (1200x800)" << std::endl;
+    std::cout << "  --frames <n>       число кадров симуляции" << std::endl;
+    std::cout << "  --dt <t>           шаг симуляции на кадр" << std::endl;
+    std::cout << "  --threads <n>      число потоков (0 - все)" << std::endl;
+    std::cout << "  --sweep            замер на 1, 2, 4 ... потоках, без записи кадров" << std::endl;
+    std::cout << "  --no-orbits        не рисовать орбиты" << std::endl;
+    std::cout << "  --orbit-tolerance <p> допуск орбиты на экране, пикс. (0.5)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SoftRenderOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    SolarSystem system;
+    if (!loadScene(options.scenePath, system) || system.getBodyCount() == 0) {
+        std::cerr << "Использую встроенную сцену" << std::endl;
+        buildDefaultScene(system);
+    }
+
+    OBJModel model;
+    if (!model.parse(options.modelPath)) {
+        std::cerr << "Ошибка загрузки модели: " << options.modelPath << std::endl;
+        return 1;
+    }
+
+    SoftMesh mesh;
+    mesh.vertices = model.vertices.data();
+    mesh.vertexCount = model.vertices.size();
+    mesh.indices = model.indices.data();
+    mesh.indexCount = model.indices.size();
+
+    SoftTexture texture = loadTexture(options.texturePath);
+    Camera camera(glm::vec3(0.0f, 10.0f, 30.0f));
+
+    OrbitGeometry orbitGeometry;
+    buildOrbitLevels(orbitGeometry.levelVertices, orbitGeometry.levels);
+    orbitGeometry.tolerancePixels = options.orbitTolerance;
+    OrbitGeometry* orbits = options.orbits ? &orbitGeometry : nullptr;
+
+    std::cout << "Сцена: " << system.getBodyCount() << " тел, "
+              << mesh.indexCount / 3 << " треугольников на тело, кадр "
+              << options.width << "x" << options.height << std::endl;
+
+    if (options.sweep) {
+        size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<size_t> counts;
+        for (size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+        counts.push_back(maxThreads);
+
+        for (size_t threads : counts) {
+            ThreadPool pool(threads);
+            SoftRasterizer rasterizer(options.width, options.height, pool);
+            SolarSystem frameSystem = system;
+
+            // Прогревочный кадр не считаем
+            renderFrame(rasterizer, frameSystem, camera, mesh, texture, orbits);
+            rasterizer.resetStats();
+
+            for (int frame = 0; frame < options.frames; frame++) {
+                frameSystem.update(options.deltaTime);
+                renderFrame(rasterizer, frameSystem, camera, mesh, texture, orbits);
+            }
+            printStats("sweep", rasterizer.getStats(), threads, options.frames);
+        }
+        return 0;
+    }
+
+    ThreadPool pool(options.threads);
+    SoftRasterizer rasterizer(options.width, options.height, pool);
+
+    for (int frame = 0; frame < options.frames; frame++) {
+        if (frame > 0) system.update(options.deltaTime);
+        renderFrame(rasterizer, system, camera, mesh, texture, orbits);
+
+        std::string filename = frameFileName(options.output, frame);
+        if (!saveFrame(rasterizer, filename)) {
+            std::cerr << "Не получилось сохранить кадр: " << filename << std::endl;
+            return 1;
+        }
+    }
+
+    const SoftRasterStats& stats = rasterizer.getStats();
+    printStats("итого", stats, pool.threadCount(), options.frames);
+    std::cout << "Треугольников: " << stats.trianglesSubmitted << " отправлено, "
+              << stats.trianglesBinned << " растеризовано; пикселей: "
+              << stats.pixelsShaded << std::endl;
+    return 0;
+}